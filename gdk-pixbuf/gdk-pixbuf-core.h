@@ -230,6 +230,20 @@ GdkPixbuf *gdk_pixbuf_new_from_stream_at_scale   (GInputStream   *stream,
 						  GCancellable   *cancellable,
                                                   GError        **error);
 
+typedef void (* GdkPixbufBatchFunc) (const gchar  *filename,
+                                     GdkPixbuf    *pixbuf,
+                                     const GError *error,
+                                     gpointer      user_data);
+
+void       gdk_pixbuf_new_from_files_at_size_async (const gchar * const *filenames,
+                                                    gint                 width,
+                                                    gint                 height,
+                                                    gint                 max_threads,
+                                                    GCancellable        *cancellable,
+                                                    GdkPixbufBatchFunc   callback,
+                                                    gpointer             user_data,
+                                                    GDestroyNotify       notify);
+
 gboolean   gdk_pixbuf_save_to_stream    (GdkPixbuf      *pixbuf,
                                          GOutputStream  *stream,
                                          const char     *type,
@@ -106,14 +106,44 @@ format_check (GdkPixbufModule *module, guchar *buffer, int size)
 #endif
 
 G_LOCK_DEFINE_STATIC (init_lock);
-G_LOCK_DEFINE_STATIC (threadunsafe_loader_lock);
+G_LOCK_DEFINE_STATIC (module_locks);
+
+/* Modules that are not threadsafe are serialized with a lock per
+ * module file, so that threads using different modules don't wait
+ * for each other. Formats provided by the same file share a lock.
+ * The locks are never freed, just like the modules.
+ */
+static GHashTable *module_locks = NULL;
+
+static GMutex *
+get_module_lock (GdkPixbufModule *image_module)
+{
+	const gchar *key;
+	GMutex *lock;
+
+	key = image_module->module_path ? image_module->module_path
+	                                : image_module->module_name;
+
+	G_LOCK (module_locks);
+	if (module_locks == NULL)
+		module_locks = g_hash_table_new (g_str_hash, g_str_equal);
+
+	lock = g_hash_table_lookup (module_locks, key);
+	if (lock == NULL) {
+		lock = g_mutex_new ();
+		g_hash_table_insert (module_locks, g_strdup (key), lock);
+	}
+	G_UNLOCK (module_locks);
+
+	return lock;
+}
 
 gboolean
 _gdk_pixbuf_lock (GdkPixbufModule *image_module)
 {
  	if (g_threads_got_initialized &&
 	    !(image_module->info->flags & GDK_PIXBUF_FORMAT_THREADSAFE)) {
- 		G_LOCK (threadunsafe_loader_lock);
+		g_mutex_lock (get_module_lock (image_module));
 
 		return TRUE;
  	}
@@ -125,7 +155,7 @@ void
 _gdk_pixbuf_unlock (GdkPixbufModule *image_module)
 {
 	if (!(image_module->info->flags & GDK_PIXBUF_FORMAT_THREADSAFE)) {
-		G_UNLOCK (threadunsafe_loader_lock);
+		g_mutex_unlock (get_module_lock (image_module));
 	}
 }
 
@@ -1485,6 +1515,250 @@ gdk_pixbuf_new_from_stream (GInputStream  *stream,
 	return pixbuf;
 }
 
+/* Batch loading */
+
+typedef struct {
+	gint       index;
+	GdkPixbuf *pixbuf;
+	GError    *error;
+} BatchResult;
+
+typedef struct {
+	gchar              **filenames;
+	gint                 n_files;
+	gint                 width;
+	gint                 height;
+	GCancellable        *cancellable;
+	GdkPixbufBatchFunc   callback;
+	gpointer             user_data;
+	GDestroyNotify       notify;
+
+	GThreadPool         *pool;
+	gint                 next_file;     /* without threads only */
+
+	GMutex              *mutex;         /* protects results and idle_id */
+	GQueue               results;
+	guint                idle_id;
+
+	gint                 n_delivered;
+} BatchLoad;
+
+static gint
+batch_load_default_threads (void)
+{
+#if defined (HAVE_UNISTD_H) && defined (_SC_NPROCESSORS_ONLN)
+	glong n = sysconf (_SC_NPROCESSORS_ONLN);
+
+	if (n > 0)
+		return n;
+#endif
+	return 2;
+}
+
+static BatchResult *
+batch_load_one (BatchLoad *batch,
+		gint       index)
+{
+	BatchResult *result;
+
+	result = g_slice_new0 (BatchResult);
+	result->index = index;
+
+	/* The loaders take the lock of modules that are not threadsafe */
+	if (!g_cancellable_set_error_if_cancelled (batch->cancellable, &result->error))
+		result->pixbuf = gdk_pixbuf_new_from_file_at_size (batch->filenames[index],
+								   batch->width,
+								   batch->height,
+								   &result->error);
+
+	return result;
+}
+
+static void
+batch_load_free (BatchLoad *batch)
+{
+	if (batch->pool)
+		g_thread_pool_free (batch->pool, TRUE, FALSE);
+	if (batch->mutex)
+		g_mutex_free (batch->mutex);
+	if (batch->cancellable)
+		g_object_unref (batch->cancellable);
+	if (batch->notify)
+		batch->notify (batch->user_data);
+
+	g_strfreev (batch->filenames);
+	g_free (batch);
+}
+
+/* Hands the results that are ready to the callback, in the order
+ * they were finished. Returns TRUE when all files are done.
+ */
+static gboolean
+batch_load_deliver (BatchLoad *batch)
+{
+	BatchResult *result;
+
+	while (TRUE) {
+		if (batch->mutex)
+			g_mutex_lock (batch->mutex);
+		result = g_queue_pop_head (&batch->results);
+		if (result == NULL)
+			batch->idle_id = 0;
+		if (batch->mutex)
+			g_mutex_unlock (batch->mutex);
+
+		if (result == NULL)
+			break;
+
+		if (!g_cancellable_is_cancelled (batch->cancellable))
+			batch->callback (batch->filenames[result->index],
+					 result->pixbuf,
+					 result->error,
+					 batch->user_data);
+
+		if (result->pixbuf)
+			g_object_unref (result->pixbuf);
+		if (result->error)
+			g_error_free (result->error);
+		g_slice_free (BatchResult, result);
+
+		batch->n_delivered++;
+	}
+
+	return batch->n_delivered == batch->n_files;
+}
+
+static gboolean
+batch_load_idle (gpointer data)
+{
+	BatchLoad *batch = data;
+
+	if (batch_load_deliver (batch))
+		batch_load_free (batch);
+
+	return FALSE;
+}
+
+static void
+batch_load_thread (gpointer data,
+		   gpointer user_data)
+{
+	BatchLoad *batch = user_data;
+	BatchResult *result;
+
+	result = batch_load_one (batch, GPOINTER_TO_INT (data) - 1);
+
+	/* Once the last result is queued the main loop may free the batch */
+	g_mutex_lock (batch->mutex);
+	g_queue_push_tail (&batch->results, result);
+	if (batch->idle_id == 0)
+		batch->idle_id = g_idle_add (batch_load_idle, batch);
+	g_mutex_unlock (batch->mutex);
+}
+
+/* Without threads the files are loaded one by one from the main loop */
+static gboolean
+batch_load_serial_idle (gpointer data)
+{
+	BatchLoad *batch = data;
+
+	g_queue_push_tail (&batch->results,
+			   batch_load_one (batch, batch->next_file++));
+
+	if (batch_load_deliver (batch)) {
+		batch_load_free (batch);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * gdk_pixbuf_new_from_files_at_size_async:
+ * @filenames: a %NULL-terminated array of file names, in the GLib file
+ *     name encoding
+ * @width: The width the images should have or -1 to not constrain the width
+ * @height: The height the images should have or -1 to not constrain the height
+ * @max_threads: the maximum number of threads to load with, or 0 or
+ *     less for the number of processors
+ * @cancellable: optional #GCancellable object, %NULL to ignore
+ * @callback: function to call for every loaded file
+ * @user_data: data to pass to @callback
+ * @notify: function to call with @user_data when all files are done,
+ *     or %NULL
+ *
+ * Loads a number of images in the background, each scaled to fit in
+ * the requested size like gdk_pixbuf_new_from_file_at_size() does.
+ * This is much faster than loading them one after the other when
+ * showing thumbnails for a whole directory.
+ *
+ * The images are loaded by up to @max_threads threads, and @callback
+ * is called in the default main loop for each of them, in the order
+ * in which they are finished. It gets either the pixbuf, which it
+ * must ref to keep it, or the error that occurred. Modules that are
+ * not threadsafe are only used by one thread at a time. If threads
+ * have not been initialized, the images are loaded one by one in
+ * idle handlers.
+ *
+ * When @cancellable is cancelled, files that have not been started are
+ * skipped and @callback is not called anymore. @notify is always called
+ * after the last file is done.
+ *
+ * Since: 2.20
+ **/
+void
+gdk_pixbuf_new_from_files_at_size_async (const gchar * const *filenames,
+					 gint                 width,
+					 gint                 height,
+					 gint                 max_threads,
+					 GCancellable        *cancellable,
+					 GdkPixbufBatchFunc   callback,
+					 gpointer             user_data,
+					 GDestroyNotify       notify)
+{
+	BatchLoad *batch;
+	gint i;
+
+	g_return_if_fail (filenames != NULL);
+	g_return_if_fail (width > 0 || width == -1);
+	g_return_if_fail (height > 0 || height == -1);
+	g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+	g_return_if_fail (callback != NULL);
+
+	batch = g_new0 (BatchLoad, 1);
+	batch->filenames = g_strdupv ((gchar **) filenames);
+	batch->n_files = g_strv_length (batch->filenames);
+	batch->width = width;
+	batch->height = height;
+	batch->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+	batch->callback = callback;
+	batch->user_data = user_data;
+	batch->notify = notify;
+	g_queue_init (&batch->results);
+
+	if (batch->n_files == 0) {
+		g_idle_add (batch_load_idle, batch);
+		return;
+	}
+
+	if (!g_thread_supported ()) {
+		g_idle_add (batch_load_serial_idle, batch);
+		return;
+	}
+
+	if (max_threads <= 0)
+		max_threads = batch_load_default_threads ();
+
+	batch->mutex = g_mutex_new ();
+	batch->pool = g_thread_pool_new (batch_load_thread, batch,
+					 MIN (max_threads, batch->n_files),
+					 TRUE, NULL);
+
+	/* 0 is NULL, so push the index + 1 */
+	for (i = 0; i < batch->n_files; i++)
+		g_thread_pool_push (batch->pool, GINT_TO_POINTER (i + 1), NULL);
+}
+
 static void
 info_cb (GdkPixbufLoader *loader, 
 	 int              width,
@@ -211,6 +211,11 @@ gdk_pixbuf_loader_finalize (GObject *object)
  * the image by calling gdk_pixbuf_loader_set_size() from a
  * signal handler for the ::size-prepared signal.
  *
+ * When an image is made smaller, some loaders (currently PNG and
+ * JPEG, unless the image is interlaced or progressive) reduce it
+ * row by row as it is decoded, so the full size image never has
+ * to be kept in memory.
+ *
  * Attempts to set the desired image size  are ignored after the 
  * emission of the ::size-prepared signal.
  *
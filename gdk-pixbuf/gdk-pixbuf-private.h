@@ -76,6 +76,18 @@ struct _GdkPixbufClass {
 
 };
 
+/* Downscaling while loading, without the full size image; used by the
+ * PNG and JPEG loaders
+ */
+typedef struct _GdkPixbufRowScaler GdkPixbufRowScaler;
+
+GdkPixbufRowScaler *_gdk_pixbuf_row_scaler_new  (GdkPixbuf          *dest,
+                                                 gint                src_width,
+                                                 gint                src_height);
+gint                _gdk_pixbuf_row_scaler_push (GdkPixbufRowScaler *scaler,
+                                                 const guchar       *src_row);
+void                _gdk_pixbuf_row_scaler_free (GdkPixbufRowScaler *scaler);
+
 #ifdef GDK_PIXBUF_ENABLE_BACKEND
 
 gboolean _gdk_pixbuf_lock (GdkPixbufModule *image_module);
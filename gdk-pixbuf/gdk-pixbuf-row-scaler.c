@@ -0,0 +1,301 @@
+/* GdkPixbuf library - Row streaming reduction for loaders
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* This file is built into the library for the built-in loaders and
+ * into each PNG and JPEG loader module, since symbols starting with an
+ * underscore are not exported from the library.
+ */
+
+#include "config.h"
+#include <string.h>
+#include "gdk-pixbuf-private.h"
+
+struct _GdkPixbufRowScaler
+{
+  GdkPixbuf *dest;
+  gint src_width;
+  gint src_height;
+  gint n_channels;
+  gboolean has_alpha;
+
+  gint src_y;                   /* next source row */
+  gint dest_y;                  /* destination row being accumulated */
+
+  /* Source columns contributing to each destination column */
+  gint *x_first;
+  gint *x_n;
+  gfloat *x_weights;
+
+  gfloat *row;                  /* current source row, reduced horizontally */
+  gfloat *acc;                  /* destination row being accumulated */
+};
+
+/* Creates a scaler that reduces an image of @src_width by @src_height
+ * pixels to the size of @dest as its rows are passed in one by one
+ * with _gdk_pixbuf_row_scaler_push(). Every destination pixel is the
+ * average of the source area it covers.
+ *
+ * This lets image loaders produce a downscaled image without ever
+ * holding the full size image in memory. The source rows must have the
+ * same number of channels and alpha as @dest, and @dest may not be
+ * larger than the source in either dimension.
+ *
+ * Return value: a new #GdkPixbufRowScaler, or %NULL if not enough
+ * memory could be allocated for it
+ */
+GdkPixbufRowScaler *
+_gdk_pixbuf_row_scaler_new (GdkPixbuf *dest,
+                            gint       src_width,
+                            gint       src_height)
+{
+  GdkPixbufRowScaler *scaler;
+  gint dest_width, dest_height;
+  gint x, i, k;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (dest), NULL);
+  g_return_val_if_fail (dest->bits_per_sample == 8, NULL);
+
+  dest_width = dest->width;
+  dest_height = dest->height;
+
+  g_return_val_if_fail (src_width >= dest_width && src_height >= dest_height, NULL);
+
+  scaler = g_new0 (GdkPixbufRowScaler, 1);
+  scaler->dest = g_object_ref (dest);
+  scaler->src_width = src_width;
+  scaler->src_height = src_height;
+  scaler->n_channels = dest->n_channels;
+  scaler->has_alpha = dest->has_alpha;
+
+  scaler->x_first = g_try_new (gint, dest_width);
+  scaler->x_n = g_try_new (gint, dest_width);
+  scaler->x_weights = g_try_new (gfloat, src_width + dest_width);
+  scaler->row = g_try_new (gfloat, dest_width * dest->n_channels);
+  scaler->acc = g_try_new0 (gfloat, dest_width * dest->n_channels);
+
+  if (!scaler->x_first || !scaler->x_n || !scaler->x_weights ||
+      !scaler->row || !scaler->acc)
+    {
+      _gdk_pixbuf_row_scaler_free (scaler);
+      return NULL;
+    }
+
+  /* Measured in units of 1 / (src_width * dest_width) of the image
+   * width, source column i covers [i * dest_width, (i + 1) * dest_width)
+   * and destination column x covers [x * src_width, (x + 1) * src_width).
+   */
+  k = 0;
+  for (x = 0; x < dest_width; x++)
+    {
+      gint64 start = (gint64) x * src_width;
+      gint64 end = start + src_width;
+
+      scaler->x_first[x] = start / dest_width;
+      scaler->x_n[x] = (end - 1) / dest_width - scaler->x_first[x] + 1;
+
+      for (i = scaler->x_first[x]; i < scaler->x_first[x] + scaler->x_n[x]; i++)
+        {
+          gint64 lo = MAX (start, (gint64) i * dest_width);
+          gint64 hi = MIN (end, (gint64) (i + 1) * dest_width);
+
+          scaler->x_weights[k++] = (gfloat) (hi - lo) / src_width;
+        }
+    }
+
+  return scaler;
+}
+
+/* Reduces a source row horizontally into scaler->row. With alpha the
+ * color channels are weighted by alpha.
+ */
+static void
+row_scaler_reduce_row (GdkPixbufRowScaler *scaler,
+                       const guchar       *src_row)
+{
+  const gfloat *w = scaler->x_weights;
+  gfloat *out = scaler->row;
+  gint n_channels = scaler->n_channels;
+  gint x, i;
+
+  for (x = 0; x < scaler->dest->width; x++)
+    {
+      const guchar *p = src_row + scaler->x_first[x] * n_channels;
+      gfloat r = 0, g = 0, b = 0, a = 0;
+
+      if (scaler->has_alpha)
+        {
+          for (i = 0; i < scaler->x_n[x]; i++, p += 4)
+            {
+              gfloat wa = *w++ * p[3];
+
+              r += wa * p[0];
+              g += wa * p[1];
+              b += wa * p[2];
+              a += wa;
+            }
+
+          out[3] = a;
+        }
+      else
+        {
+          for (i = 0; i < scaler->x_n[x]; i++, p += n_channels)
+            {
+              gfloat wi = *w++;
+
+              r += wi * p[0];
+              g += wi * p[1];
+              b += wi * p[2];
+            }
+
+          if (n_channels == 4)
+            out[3] = 255;
+        }
+
+      out[0] = r;
+      out[1] = g;
+      out[2] = b;
+      out += n_channels;
+    }
+}
+
+static void
+row_scaler_add_row (GdkPixbufRowScaler *scaler,
+                    gfloat              weight)
+{
+  gint n = scaler->dest->width * scaler->n_channels;
+  gint i;
+
+  for (i = 0; i < n; i++)
+    scaler->acc[i] += weight * scaler->row[i];
+}
+
+static inline guchar
+row_scaler_clamp (gfloat v)
+{
+  return v >= 254.5f ? 255 : (v <= 0 ? 0 : (guchar) (v + 0.5f));
+}
+
+static void
+row_scaler_emit_row (GdkPixbufRowScaler *scaler)
+{
+  guchar *q = scaler->dest->pixels + scaler->dest_y * scaler->dest->rowstride;
+  gfloat *acc = scaler->acc;
+  gint x;
+
+  for (x = 0; x < scaler->dest->width; x++)
+    {
+      if (scaler->has_alpha)
+        {
+          gfloat a = acc[3];
+
+          if (a > 0)
+            {
+              q[0] = row_scaler_clamp (acc[0] / a);
+              q[1] = row_scaler_clamp (acc[1] / a);
+              q[2] = row_scaler_clamp (acc[2] / a);
+            }
+          else
+            q[0] = q[1] = q[2] = 0;
+
+          q[3] = row_scaler_clamp (a);
+        }
+      else
+        {
+          q[0] = row_scaler_clamp (acc[0]);
+          q[1] = row_scaler_clamp (acc[1]);
+          q[2] = row_scaler_clamp (acc[2]);
+
+          if (scaler->n_channels == 4)
+            q[3] = 255;
+        }
+
+      q += scaler->n_channels;
+      acc += scaler->n_channels;
+    }
+}
+
+/* Adds the next row of the source image to the scaled image. Whenever
+ * this completes a row of the destination pixbuf, the index of that
+ * row is returned; since the image is only ever reduced, each source
+ * row completes at most one destination row.
+ *
+ * Return value: the destination row completed by @src_row, or -1
+ */
+gint
+_gdk_pixbuf_row_scaler_push (GdkPixbufRowScaler *scaler,
+                             const guchar       *src_row)
+{
+  gint src_height = scaler->src_height;
+  gint dest_height = scaler->dest->height;
+  gint64 lo, hi, end;
+  gint completed = -1;
+
+  g_return_val_if_fail (scaler->src_y < src_height, -1);
+
+  row_scaler_reduce_row (scaler, src_row);
+
+  /* Vertically, source row j covers [j * dest_height, (j + 1) * dest_height)
+   * and destination row y covers [y * src_height, (y + 1) * src_height).
+   */
+  lo = (gint64) scaler->src_y * dest_height;
+  hi = lo + dest_height;
+  end = (gint64) (scaler->dest_y + 1) * src_height;
+
+  if (hi <= end)
+    {
+      row_scaler_add_row (scaler, (gfloat) dest_height / src_height);
+
+      if (hi == end)
+        {
+          row_scaler_emit_row (scaler);
+          completed = scaler->dest_y++;
+          memset (scaler->acc, 0,
+                  sizeof (gfloat) * scaler->dest->width * scaler->n_channels);
+        }
+    }
+  else
+    {
+      row_scaler_add_row (scaler, (gfloat) (end - lo) / src_height);
+      row_scaler_emit_row (scaler);
+      completed = scaler->dest_y++;
+      memset (scaler->acc, 0,
+              sizeof (gfloat) * scaler->dest->width * scaler->n_channels);
+      row_scaler_add_row (scaler, (gfloat) (hi - end) / src_height);
+    }
+
+  scaler->src_y++;
+
+  return completed;
+}
+
+/* Frees @scaler. Rows that have not been completed are left as they
+ * are in the destination pixbuf.
+ */
+void
+_gdk_pixbuf_row_scaler_free (GdkPixbufRowScaler *scaler)
+{
+  g_return_if_fail (scaler != NULL);
+
+  g_object_unref (scaler->dest);
+  g_free (scaler->x_first);
+  g_free (scaler->x_n);
+  g_free (scaler->x_weights);
+  g_free (scaler->row);
+  g_free (scaler->acc);
+  g_free (scaler);
+}
@@ -458,6 +458,46 @@ gdk_pixbuf_flip (const GdkPixbuf *src,
 
   return dest;
 }
+
+/**
+ * gdk_pixbuf_set_scale_threads:
+ * @n_threads: the maximum number of threads to use, or 0 to use one
+ *   thread per processor
+ *
+ * Sets how many threads gdk_pixbuf_scale(), gdk_pixbuf_composite(),
+ * gdk_pixbuf_composite_color() and the functions built on them may
+ * use. The rows of the result are split into bands that are rendered
+ * in parallel. Passing 1 renders everything on the calling thread.
+ *
+ * Only large results are split, and only if the GLib thread system
+ * has been initialized with g_thread_init(). The output does not
+ * depend on the number of threads.
+ *
+ * Since: 2.20
+ */
+void
+gdk_pixbuf_set_scale_threads (gint n_threads)
+{
+  g_return_if_fail (n_threads >= 0);
+
+  _pixops_set_max_threads (n_threads);
+}
+
+/**
+ * gdk_pixbuf_get_scale_threads:
+ *
+ * Gets the value set with gdk_pixbuf_set_scale_threads().
+ *
+ * Returns: the maximum number of threads used for scaling and
+ *   compositing, or 0 if one thread per processor is used
+ *
+ * Since: 2.20
+ */
+gint
+gdk_pixbuf_get_scale_threads (void)
+{
+  return _pixops_get_max_threads ();
+}
 				     
 #define __GDK_PIXBUF_SCALE_C__
 #include "gdk-pixbuf-aliasdef.c"
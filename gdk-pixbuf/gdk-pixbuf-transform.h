@@ -112,6 +112,9 @@ GdkPixbuf *gdk_pixbuf_rotate_simple          (const GdkPixbuf   *src,
 				              GdkPixbufRotation  angle);
 GdkPixbuf *gdk_pixbuf_flip                   (const GdkPixbuf   *src,
 				              gboolean           horizontal);
+
+void       gdk_pixbuf_set_scale_threads      (gint n_threads);
+gint       gdk_pixbuf_get_scale_threads      (void);
 				     
 G_END_DECLS
 
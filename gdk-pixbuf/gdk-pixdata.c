@@ -899,5 +899,150 @@ gdk_pixbuf_new_from_inline (gint          data_length,
   return gdk_pixbuf_from_pixdata (&pixdata, copy_pixels, error);
 }
 
+static void
+unref_mapped_file (guchar   *pixels,
+		   gpointer  data)
+{
+  g_mapped_file_unref (data);
+}
+
+/* Checks that decoding @rle_length bytes of run-length encoded data
+ * fills an image of @image_length bytes without reading past the end,
+ * the way gdk_pixbuf_from_pixdata() decodes it
+ */
+static gboolean
+rle_data_fits (const guint8 *rle_buffer,
+	       guint64       rle_length,
+	       guint64       image_length,
+	       guint         bpp)
+{
+  guint64 pos = 0, filled = 0;
+
+  while (filled < image_length)
+    {
+      guint64 length;
+
+      if (pos >= rle_length)
+	return FALSE;
+      length = rle_buffer[pos++];
+
+      if (length & 128)
+	{
+	  length = MIN (length - 128, (image_length - filled) / bpp);
+	  if (length == 0 || rle_length - pos < bpp)
+	    return FALSE;
+	  filled += length * bpp;
+	  pos += bpp;
+	}
+      else
+	{
+	  length = MIN (length * bpp, image_length - filled);
+	  if (rle_length - pos < length)
+	    return FALSE;
+	  filled += length;
+	  pos += length;
+	}
+    }
+
+  return TRUE;
+}
+
+/**
+ * gdk_pixbuf_new_from_pixdata_file:
+ * @filename: name of a file containing a serialized #GdkPixdata, as
+ *     produced by gdk_pixdata_serialize(), in the GLib file name encoding
+ * @error: #GError return location, may be %NULL to ignore errors
+ *
+ * Creates a #GdkPixbuf from a file holding a serialized #GdkPixdata
+ * structure. The file is mapped into memory and, unless it is run-length
+ * encoded, the pixbuf uses the pixel data in the mapping directly. The
+ * file is unmapped when the pixbuf is finalized. This makes loading
+ * large precomputed images nearly free: no pixels are read or copied
+ * until they are used, and the memory is shared with all other
+ * processes mapping the same file.
+ *
+ * The pixel data of the returned pixbuf is read-only; use
+ * gdk_pixbuf_copy() to get a pixbuf that can be modified. The file
+ * should not be changed while it is mapped.
+ *
+ * Return value: A newly-created #GdkPixbuf with a reference count of 1,
+ *   or %NULL if an error occurred.
+ *
+ * Since: 2.20
+ **/
+GdkPixbuf*
+gdk_pixbuf_new_from_pixdata_file (const gchar  *filename,
+				  GError      **error)
+{
+  GMappedFile *map;
+  GdkPixdata pixdata;
+  GdkPixbuf *pixbuf;
+  guint64 length, available, needed;
+  guint bpp;
+
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  map = g_mapped_file_new (filename, FALSE, error);
+  if (!map)
+    return NULL;
+
+  length = g_mapped_file_get_length (map);
+  if (length > G_MAXUINT)
+    {
+      g_set_error_literal (error, GDK_PIXBUF_ERROR,
+			   GDK_PIXBUF_ERROR_CORRUPT_IMAGE,
+			   _("Image header corrupt"));
+      g_mapped_file_unref (map);
+      return NULL;
+    }
+
+  if (!gdk_pixdata_deserialize (&pixdata, length,
+				(const guint8 *) g_mapped_file_get_contents (map),
+				error))
+    {
+      g_mapped_file_unref (map);
+      return NULL;
+    }
+
+  /* The pixel data must be within both the file and the stated length */
+  available = MIN (length, (guint64) pixdata.length) - GDK_PIXDATA_HEADER_LENGTH;
+  bpp = (pixdata.pixdata_type & GDK_PIXDATA_COLOR_TYPE_MASK) == GDK_PIXDATA_COLOR_TYPE_RGB ? 3 : 4;
+
+  if ((pixdata.pixdata_type & GDK_PIXDATA_ENCODING_MASK) == GDK_PIXDATA_ENCODING_RLE)
+    {
+      /* The decoder trusts the runs, so a truncated file must not get to it */
+      if (!rle_data_fits (pixdata.pixel_data, available,
+			  (guint64) pixdata.rowstride * pixdata.height, bpp))
+	{
+	  g_set_error_literal (error, GDK_PIXBUF_ERROR,
+			       GDK_PIXBUF_ERROR_CORRUPT_IMAGE,
+			       _("Image pixel data corrupt"));
+	  g_mapped_file_unref (map);
+	  return NULL;
+	}
+
+      pixbuf = gdk_pixbuf_from_pixdata (&pixdata, TRUE, error);
+      g_mapped_file_unref (map);
+      return pixbuf;
+    }
+
+  /* Raw pixels are used in place, so make sure they are all there */
+  needed = (guint64) pixdata.rowstride * (pixdata.height - 1) +
+	   (guint64) pixdata.width * bpp;
+  if (pixdata.rowstride < pixdata.width * bpp || needed > available)
+    {
+      g_set_error_literal (error, GDK_PIXBUF_ERROR,
+			   GDK_PIXBUF_ERROR_CORRUPT_IMAGE,
+			   _("Image pixel data corrupt"));
+      g_mapped_file_unref (map);
+      return NULL;
+    }
+
+  return gdk_pixbuf_new_from_data (pixdata.pixel_data, GDK_COLORSPACE_RGB,
+				   bpp == 4, 8,
+				   pixdata.width, pixdata.height, pixdata.rowstride,
+				   unref_mapped_file, map);
+}
+
 #define __GDK_PIXDATA_C__
 #include "gdk-pixbuf-aliasdef.c"
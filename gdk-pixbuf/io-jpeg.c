@@ -74,6 +74,10 @@ typedef struct {
 	GdkPixbuf                *pixbuf;
 	guchar                   *dptr;   /* current position in pixbuf */
 
+	GdkPixbufRowScaler       *scaler; /* reduces decoded rows to pixbuf */
+	guchar                   *strip;  /* decoded rows when scaling */
+	gint                      strip_rowstride;
+
 	gboolean                 did_prescan;  /* are we in image data yet? */
 	gboolean                 got_header;  /* have we loaded jpeg header? */
 	gboolean                 src_initialized;/* TRUE when jpeg lib initialized */
@@ -709,6 +713,10 @@ gdk_pixbuf__jpeg_image_stop_load (gpointer data, GError **error)
         
 	if (context->pixbuf)
 		g_object_unref (context->pixbuf);
+
+	if (context->scaler)
+		_gdk_pixbuf_row_scaler_free (context->scaler);
+	g_free (context->strip);
 	
 	/* if we have an error? */
 	context->jerr.error = error;
@@ -746,10 +754,18 @@ gdk_pixbuf__jpeg_image_load_lines (JpegProgContext  *context,
         /* keep going until we've done all scanlines */
         while (cinfo->output_scanline < cinfo->output_height) {
                 lptr = lines;
-                rowptr = context->dptr;
-                for (i=0; i < cinfo->rec_outbuf_height; i++) {
-                        *lptr++ = rowptr;
-                        rowptr += context->pixbuf->rowstride;
+                if (context->scaler) {
+                        rowptr = context->strip;
+                        for (i=0; i < cinfo->rec_outbuf_height; i++) {
+                                *lptr++ = rowptr;
+                                rowptr += context->strip_rowstride;
+                        }
+                } else {
+                        rowptr = context->dptr;
+                        for (i=0; i < cinfo->rec_outbuf_height; i++) {
+                                *lptr++ = rowptr;
+                                rowptr += context->pixbuf->rowstride;
+                        }
                 }
 
                 nlines = jpeg_read_scanlines (cinfo, lines,
@@ -779,6 +795,24 @@ gdk_pixbuf__jpeg_image_load_lines (JpegProgContext  *context,
                         return FALSE;
                 }
 
+                if (context->scaler) {
+                        /* reduce the decoded rows into the pixbuf */
+                        for (i = 0; i < nlines; i++) {
+                                gint row;
+
+                                row = _gdk_pixbuf_row_scaler_push (context->scaler,
+                                                                   lines[i]);
+                                if (row >= 0 && context->updated_func)
+                                        (* context->updated_func) (context->pixbuf,
+                                                                   0,
+                                                                   row,
+                                                                   context->pixbuf->width,
+                                                                   1,
+                                                                   context->user_data);
+                        }
+                        continue;
+                }
+
                 context->dptr += nlines * context->pixbuf->rowstride;
 
                 /* send updated signal */
@@ -930,12 +964,52 @@ gdk_pixbuf__jpeg_image_load_increment (gpointer data,
 				}
 			}
 			jpeg_calc_output_dimensions (cinfo);
-			
-			context->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, 
-							  cinfo->output_components == 4 ? TRUE : FALSE,
-							  8, 
-							  cinfo->output_width,
-							  cinfo->output_height);
+
+			/* If the requested size is still smaller, reduce
+			 * the rows as they are decoded instead of keeping
+			 * the full image around for the caller to scale.
+			 * Progressive images are decoded in several passes
+			 * over the whole image, so they can't be streamed.
+			 */
+			if (context->size_func &&
+			    !cinfo->progressive_mode &&
+			    width <= cinfo->output_width &&
+			    height <= cinfo->output_height &&
+			    (width < cinfo->output_width ||
+			     height < cinfo->output_height)) {
+				gint n_channels = cinfo->output_components == 4 ? 4 : 3;
+
+				context->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
+								  n_channels == 4,
+								  8,
+								  width,
+								  height);
+				if (context->pixbuf) {
+					context->scaler = _gdk_pixbuf_row_scaler_new (context->pixbuf,
+										      cinfo->output_width,
+										      cinfo->output_height);
+					context->strip_rowstride = cinfo->output_width * n_channels;
+					/* as many rows as load_lines () reads at once */
+					context->strip = g_try_malloc (4 * context->strip_rowstride);
+				}
+
+				if (!context->scaler || !context->strip) {
+					if (context->scaler) {
+						_gdk_pixbuf_row_scaler_free (context->scaler);
+						context->scaler = NULL;
+					}
+					if (context->pixbuf) {
+						g_object_unref (context->pixbuf);
+						context->pixbuf = NULL;
+					}
+				}
+			} else {
+				context->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, 
+								  cinfo->output_components == 4 ? TRUE : FALSE,
+								  8, 
+								  cinfo->output_width,
+								  cinfo->output_height);
+			}
 
 			if (context->pixbuf == NULL) {
                                 g_set_error_literal (error,
@@ -374,6 +374,12 @@ struct _LoadContext {
 
         GdkPixbuf* pixbuf;
 
+        /* reduces the decoded rows to pixbuf when the requested size
+         * is smaller than the image, which is src_height rows high
+         */
+        GdkPixbufRowScaler *scaler;
+        gint src_height;
+
         /* row number of first row seen, or -1 if none yet seen */
 
         gint first_row_seen_in_chunk;
@@ -489,6 +495,9 @@ gdk_pixbuf__png_image_stop_load (gpointer context, GError **error)
         
         if (lc->pixbuf)
                 g_object_unref (lc->pixbuf);
+
+        if (lc->scaler)
+                _gdk_pixbuf_row_scaler_free (lc->scaler);
         
         png_destroy_read_struct(&lc->png_read_ptr, &lc->png_info_ptr, NULL);
         g_free(lc);
@@ -586,6 +595,7 @@ png_info_callback   (png_structp png_read_ptr,
         int i, num_texts;
         int color_type;
         gboolean have_alpha = FALSE;
+        gint w, h;
         
         lc = png_get_progressive_ptr(png_read_ptr);
 
@@ -604,9 +614,10 @@ png_info_callback   (png_structp png_read_ptr,
         if (color_type & PNG_COLOR_MASK_ALPHA)
                 have_alpha = TRUE;
         
+        w = width;
+        h = height;
+
         if (lc->size_func) {
-                gint w = width;
-                gint h = height;
                 (* lc->size_func) (&w, &h, lc->notify_user_data);
                 
                 if (w == 0 || h == 0) {
@@ -621,7 +632,26 @@ png_info_callback   (png_structp png_read_ptr,
                 }
         }
 
-        lc->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, have_alpha, 8, width, height);
+        lc->src_height = height;
+
+        /* Reduce the rows as they are decoded rather than keeping the
+         * full size image around for the caller to scale. Interlaced
+         * images revisit every row in later passes, so they are
+         * always loaded at full size.
+         */
+        if (w <= width && h <= height && (w < width || h < height) &&
+            png_get_interlace_type (png_read_ptr, png_info_ptr) == PNG_INTERLACE_NONE) {
+                lc->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, have_alpha, 8, w, h);
+                if (lc->pixbuf) {
+                        lc->scaler = _gdk_pixbuf_row_scaler_new (lc->pixbuf, width, height);
+                        if (lc->scaler == NULL) {
+                                g_object_unref (lc->pixbuf);
+                                lc->pixbuf = NULL;
+                        }
+                }
+        } else {
+                lc->pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, have_alpha, 8, width, height);
+        }
 
         if (lc->pixbuf == NULL) {
                 /* Failed to allocate memory */
@@ -675,7 +705,7 @@ png_row_callback   (png_structp png_read_ptr,
         if (lc->fatal_error_occurred)
                 return;
 
-        if (row_num >= lc->pixbuf->height) {
+        if (row_num >= lc->src_height) {
                 lc->fatal_error_occurred = TRUE;
                 if (lc->error && *lc->error == NULL) {
                         g_set_error_literal (lc->error,
@@ -686,6 +716,16 @@ png_row_callback   (png_structp png_read_ptr,
                 return;
         }
 
+        if (lc->scaler) {
+                gint row;
+
+                row = _gdk_pixbuf_row_scaler_push (lc->scaler, new_row);
+                if (row < 0)
+                        return;
+
+                row_num = row;
+        }
+
         if (lc->first_row_seen_in_chunk < 0) {
                 lc->first_row_seen_in_chunk = row_num;
                 lc->first_pass_seen_in_chunk = pass_num;
@@ -695,6 +735,9 @@ png_row_callback   (png_structp png_read_ptr,
         lc->last_row_seen_in_chunk = row_num;
         lc->last_pass_seen_in_chunk = pass_num;
         
+        if (lc->scaler)
+                return;
+
         old_row = lc->pixbuf->pixels + (row_num * lc->pixbuf->rowstride);
 
         png_progressive_combine_row(lc->png_read_ptr, old_row, new_row);
@@ -0,0 +1,382 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* AVX2 versions of the line functions in pixops.c. This file is
+ * compiled with AVX2_CFLAGS and only called after a runtime check.
+ */
+#include "config.h"
+#include <immintrin.h>
+
+#include "pixops-simd.h"
+
+/* Same scheme as pixops-sse2.c: 16-bit premultiplied channel values
+ * are multiplied by 16-bit weights, here four taps per 256-bit
+ * register. Filters that are two taps wide, such as the 2x2 filters
+ * used for magnification, do two rows per register. 3-channel pixels
+ * are expanded to four channels with a byte shuffle when the load
+ * does not run past the end of the source row.
+ */
+
+static PIXOPS_ALWAYS_INLINE __m128i
+load_pixels_avx2 (const guchar *q,
+		  int           n_pixels,
+		  int           src_channels,
+		  gboolean      can_overread)
+{
+  const __m128i expand = _mm_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1,
+					6, 7, 8, -1, 9, 10, 11, -1);
+
+  if (src_channels == 4)
+    {
+      if (n_pixels == 4)
+	return _mm_loadu_si128 ((const __m128i *) q);
+      else if (n_pixels == 2)
+	return _mm_loadl_epi64 ((const __m128i *) q);
+      else
+	return _mm_cvtsi32_si128 (pixops_simd_load_pixel (q, 4));
+    }
+
+  if (can_overread)
+    {
+      if (n_pixels == 4)
+	return _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) q), expand);
+      else if (n_pixels == 2)
+	return _mm_shuffle_epi8 (_mm_loadl_epi64 ((const __m128i *) q), expand);
+    }
+
+  if (n_pixels == 4)
+    return _mm_setr_epi32 (pixops_simd_load_pixel (q, 3),
+			   pixops_simd_load_pixel (q + 3, 3),
+			   pixops_simd_load_pixel (q + 6, 3),
+			   pixops_simd_load_pixel (q + 9, 3));
+  else if (n_pixels == 2)
+    return _mm_setr_epi32 (pixops_simd_load_pixel (q, 3),
+			   pixops_simd_load_pixel (q + 3, 3), 0, 0);
+  else
+    return _mm_cvtsi32_si128 (pixops_simd_load_pixel (q, 3));
+}
+
+/* Expands pixel bytes to 16-bit lanes of m * c, see pixops-sse2.c */
+static PIXOPS_ALWAYS_INLINE __m256i
+premultiply_avx2 (__m128i  px,
+		  gboolean src_has_alpha,
+		  guint32  opaque)
+{
+  const __m256i rgb_mask = _mm256_set1_epi64x (0x0000ffffffffffffLL);
+  const __m256i alpha_one = _mm256_set1_epi64x (0x0001000000000000LL);
+  __m256i p = _mm256_cvtepu8_epi16 (px);
+  __m256i c = _mm256_or_si256 (_mm256_and_si256 (p, rgb_mask), alpha_one);
+
+  if (src_has_alpha)
+    {
+      __m256i m = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (p, 0xff), 0xff);
+      return _mm256_mullo_epi16 (c, m);
+    }
+  else if (opaque != 1)
+    return _mm256_mullo_epi16 (c, _mm256_set1_epi16 (opaque));
+  else
+    return c;
+}
+
+/* Spreads up to four 16-bit weights so that each covers the four
+ * channels of its pixel in the layout produced by premultiply_avx2()
+ */
+static PIXOPS_ALWAYS_INLINE __m256i
+spread_weights_avx2 (__m128i w)
+{
+  const __m256i idx = _mm256_setr_epi32 (0, 0, 1, 1, 2, 2, 3, 3);
+  __m256i v = _mm256_permutevar8x32_epi32 (_mm256_castsi128_si256 (w), idx);
+
+  return _mm256_or_si256 (v, _mm256_slli_epi32 (v, 16));
+}
+
+static PIXOPS_ALWAYS_INLINE __m256i
+multiply_add_avx2 (__m256i acc,
+		   __m256i pc,
+		   __m256i w)
+{
+  __m256i lo = _mm256_mullo_epi16 (pc, w);
+  __m256i hi = _mm256_mulhi_epu16 (pc, w);
+
+  acc = _mm256_add_epi32 (acc, _mm256_unpacklo_epi16 (lo, hi));
+  return _mm256_add_epi32 (acc, _mm256_unpackhi_epi16 (lo, hi));
+}
+
+static PIXOPS_ALWAYS_INLINE __m128i
+accumulate_avx2 (const int    *pixel_weights,
+		 int           n_x,
+		 int           n_y,
+		 guchar      **src,
+		 int           x_scaled,
+		 int           src_channels,
+		 gboolean      src_has_alpha,
+		 guint32       opaque,
+		 int           src_width)
+{
+  __m256i acc = _mm256_setzero_si256 ();
+  int i = 0, j;
+
+  if (n_x == 2)
+    {
+      /* The weights of two consecutive rows are contiguous, and the
+       * two pixels of each row go into one half of the register.
+       */
+      gboolean can_overread = x_scaled + 2 < src_width;
+
+      for (; i + 1 < n_y; i += 2)
+	{
+	  __m128i w = _mm_loadu_si128 ((const __m128i *) (pixel_weights + 2 * i));
+	  __m128i p0 = load_pixels_avx2 (src[i] + x_scaled * src_channels, 2,
+					 src_channels, can_overread);
+	  __m128i p1 = load_pixels_avx2 (src[i + 1] + x_scaled * src_channels, 2,
+					 src_channels, can_overread);
+
+	  acc = multiply_add_avx2 (acc,
+				   premultiply_avx2 (_mm_unpacklo_epi64 (p0, p1),
+						     src_has_alpha, opaque),
+				   spread_weights_avx2 (w));
+	}
+    }
+
+  for (; i < n_y; i++)
+    {
+      const guchar *q = src[i] + x_scaled * src_channels;
+      const int *line_weights = pixel_weights + n_x * i;
+
+      /* A 16 byte load of 3-channel pixels reads 4 bytes, an 8 byte
+       * load 2 bytes, beyond the last of the pixels used.
+       */
+      for (j = 0; j + 3 < n_x; j += 4)
+	{
+	  __m128i w = _mm_loadu_si128 ((const __m128i *) (line_weights + j));
+	  __m128i px = load_pixels_avx2 (q, 4, src_channels,
+					 x_scaled + j + 5 < src_width);
+
+	  acc = multiply_add_avx2 (acc,
+				   premultiply_avx2 (px, src_has_alpha, opaque),
+				   spread_weights_avx2 (w));
+	  q += 4 * src_channels;
+	}
+
+      if (j + 1 < n_x)
+	{
+	  __m128i w = _mm_loadl_epi64 ((const __m128i *) (line_weights + j));
+	  __m128i px = load_pixels_avx2 (q, 2, src_channels,
+					 x_scaled + j + 2 < src_width);
+
+	  acc = multiply_add_avx2 (acc,
+				   premultiply_avx2 (px, src_has_alpha, opaque),
+				   spread_weights_avx2 (w));
+	  q += 2 * src_channels;
+	  j += 2;
+	}
+
+      if (j < n_x)
+	{
+	  __m128i w = _mm_cvtsi32_si128 (line_weights[j]);
+	  __m128i px = load_pixels_avx2 (q, 1, src_channels, FALSE);
+
+	  acc = multiply_add_avx2 (acc,
+				   premultiply_avx2 (px, src_has_alpha, opaque),
+				   spread_weights_avx2 (w));
+	}
+    }
+
+  return _mm_add_epi32 (_mm256_castsi256_si128 (acc),
+			_mm256_extracti128_si256 (acc, 1));
+}
+
+static PIXOPS_ALWAYS_INLINE guchar *
+line_avx2 (PixopsSimdOp  op,
+	   int          *weights,
+	   int           n_x,
+	   int           n_y,
+	   guchar       *dest,
+	   int           dest_x,
+	   guchar       *dest_end,
+	   int           dest_channels,
+	   int           dest_has_alpha,
+	   guchar      **src,
+	   int           src_channels,
+	   gboolean      src_has_alpha,
+	   int           x_init,
+	   int           x_step,
+	   int           src_width,
+	   int           check_size,
+	   guint32       color1,
+	   guint32       color2)
+{
+  const guint32 opaque = pixops_simd_opaque_alpha (op);
+  int full_taps[SUBSAMPLE];
+  guchar colors[2][3];
+  int check_shift = 0;
+  int x = x_init;
+
+  if (op == PIXOPS_SIMD_COMPOSITE_COLOR)
+    {
+      check_shift = pixops_simd_check_shift (check_size);
+      pixops_simd_split_colors (colors, color1, color2);
+    }
+
+  pixops_simd_find_full_taps (weights, n_x, n_y, full_taps);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      int phase = (x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK;
+      guint32 sums[4];
+
+      if (full_taps[phase] >= 0)
+	pixops_simd_full_tap_sums (src, x_scaled, full_taps[phase], n_x,
+				   src_channels, src_has_alpha, opaque, sums);
+      else
+	_mm_storeu_si128 ((__m128i *) sums,
+			  accumulate_avx2 (weights + phase * n_x * n_y,
+					   n_x, n_y, src, x_scaled,
+					   src_channels, src_has_alpha,
+					   opaque, src_width));
+
+      pixops_simd_store_pixel (op, dest, dest_x, dest_channels,
+			       dest_has_alpha, src_has_alpha,
+			       check_shift, (const guchar (*)[3]) colors,
+			       sums[0], sums[1], sums[2], sums[3]);
+
+      dest += dest_channels;
+      x += x_step;
+      dest_x++;
+    }
+
+  return dest;
+}
+
+guchar *
+_pixops_scale_line_avx2 (int *weights, int n_x, int n_y, guchar *dest,
+			 int dest_x, guchar *dest_end, int dest_channels,
+			 int dest_has_alpha, guchar **src, int src_channels,
+			 gboolean src_has_alpha, int x_init, int x_step,
+			 int src_width, int check_size, guint32 color1,
+			 guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_SCALE, weights, n_x, n_y, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_scale_line_22_avx2 (int *weights, int n_x, int n_y, guchar *dest,
+			    int dest_x, guchar *dest_end, int dest_channels,
+			    int dest_has_alpha, guchar **src, int src_channels,
+			    gboolean src_has_alpha, int x_init, int x_step,
+			    int src_width, int check_size, guint32 color1,
+			    guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_SCALE, weights, 2, 2, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_scale_line_22_33_avx2 (int *weights, int n_x, int n_y, guchar *dest,
+			       int dest_x, guchar *dest_end, int dest_channels,
+			       int dest_has_alpha, guchar **src,
+			       int src_channels, gboolean src_has_alpha,
+			       int x_init, int x_step, int src_width,
+			       int check_size, guint32 color1, guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_SCALE_22_33, weights, 2, 2, dest, dest_x,
+		    dest_end, 3, FALSE, src, 3, FALSE, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_avx2 (int *weights, int n_x, int n_y, guchar *dest,
+			     int dest_x, guchar *dest_end, int dest_channels,
+			     int dest_has_alpha, guchar **src,
+			     int src_channels, gboolean src_has_alpha,
+			     int x_init, int x_step, int src_width,
+			     int check_size, guint32 color1, guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_COMPOSITE, weights, n_x, n_y, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_22_avx2 (int *weights, int n_x, int n_y, guchar *dest,
+				int dest_x, guchar *dest_end,
+				int dest_channels, int dest_has_alpha,
+				guchar **src, int src_channels,
+				gboolean src_has_alpha, int x_init,
+				int x_step, int src_width, int check_size,
+				guint32 color1, guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_COMPOSITE, weights, 2, 2, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_22_4a4_avx2 (int *weights, int n_x, int n_y,
+				    guchar *dest, int dest_x,
+				    guchar *dest_end, int dest_channels,
+				    int dest_has_alpha, guchar **src,
+				    int src_channels, gboolean src_has_alpha,
+				    int x_init, int x_step, int src_width,
+				    int check_size, guint32 color1,
+				    guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_COMPOSITE_22_4A4, weights, 2, 2, dest,
+		    dest_x, dest_end, 4, FALSE, src, 4, TRUE, x_init,
+		    x_step, src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_color_avx2 (int *weights, int n_x, int n_y,
+				   guchar *dest, int dest_x, guchar *dest_end,
+				   int dest_channels, int dest_has_alpha,
+				   guchar **src, int src_channels,
+				   gboolean src_has_alpha, int x_init,
+				   int x_step, int src_width, int check_size,
+				   guint32 color1, guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_COMPOSITE_COLOR, weights, n_x, n_y, dest,
+		    dest_x, dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_color_22_avx2 (int *weights, int n_x, int n_y,
+				      guchar *dest, int dest_x,
+				      guchar *dest_end, int dest_channels,
+				      int dest_has_alpha, guchar **src,
+				      int src_channels, gboolean src_has_alpha,
+				      int x_init, int x_step, int src_width,
+				      int check_size, guint32 color1,
+				      guint32 color2)
+{
+  return line_avx2 (PIXOPS_SIMD_COMPOSITE_COLOR, weights, 2, 2, dest,
+		    dest_x, dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
@@ -16,6 +16,24 @@
  * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
  * Boston, MA 02111-1307, USA.
  */
+#ifndef PIXOPS_INTERNAL_H
+#define PIXOPS_INTERNAL_H
+
+#include <glib.h>
+
+#define SUBSAMPLE_BITS 4
+#define SUBSAMPLE (1 << SUBSAMPLE_BITS)
+#define SUBSAMPLE_MASK ((1 << SUBSAMPLE_BITS)-1)
+#define SCALE_SHIFT 16
+
+typedef guchar *(*PixopsLineFunc) (int *weights, int n_x, int n_y,
+				   guchar *dest, int dest_x, guchar *dest_end,
+				   int dest_channels, int dest_has_alpha,
+				   guchar **src, int src_channels,
+				   gboolean src_has_alpha, int x_init,
+				   int x_step, int src_width, int check_size,
+				   guint32 color1, guint32 color2);
+
 #ifdef USE_MMX
 guchar *_pixops_scale_line_22_33_mmx (guint32 weights[16][8], guchar *p, guchar *q1, guchar *q2, int x_step, guchar *p_stop, int x_init);
 guchar *_pixops_composite_line_22_4a4_mmx (guint32 weights[16][8], guchar *p, guchar *q1, guchar *q2, int x_step, guchar *p_stop, int x_init);
@@ -23,3 +41,34 @@ guchar *_pixops_composite_line_color_22_4a4_mmx (guint32 weights[16][8], guchar
 int _pixops_have_mmx (void);
 #endif
 
+/* The SSE2 and AVX2 line functions are drop-in replacements for the
+ * C line functions in pixops.c with the same name minus the suffix.
+ * They must produce bit-identical output; only the accumulation of
+ * the filter taps is vectorized, the per-pixel arithmetic that turns
+ * the sums into destination pixels is shared via pixops-simd.h.
+ *
+ * The _22 variants are specialized for a 2x2 filter but otherwise
+ * follow the general functions, for any channel/alpha combination.
+ * pixops.c only uses the SSE2 functions for 4-channel sources.
+ */
+#ifdef USE_SSE2
+guchar *_pixops_scale_line_sse2               (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_scale_line_22_sse2            (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_sse2           (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_22_sse2        (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_color_sse2     (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_color_22_sse2  (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+#endif
+
+#ifdef USE_AVX2
+guchar *_pixops_scale_line_avx2               (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_scale_line_22_avx2            (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_scale_line_22_33_avx2         (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_avx2           (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_22_avx2        (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_22_4a4_avx2    (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_color_avx2     (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+guchar *_pixops_composite_line_color_22_avx2  (int *weights, int n_x, int n_y, guchar *dest, int dest_x, guchar *dest_end, int dest_channels, int dest_has_alpha, guchar **src, int src_channels, gboolean src_has_alpha, int x_init, int x_step, int src_width, int check_size, guint32 color1, guint32 color2);
+#endif
+
+#endif /* PIXOPS_INTERNAL_H */
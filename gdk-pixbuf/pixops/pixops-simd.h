@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Helpers shared by pixops-sse2.c and pixops-avx2.c. Only included
+ * from those files, which are built with the matching -m flags.
+ */
+#ifndef PIXOPS_SIMD_H
+#define PIXOPS_SIMD_H
+
+#include <string.h>
+#include "pixops-internal.h"
+
+#ifdef __GNUC__
+#define PIXOPS_ALWAYS_INLINE __inline__ __attribute__((always_inline))
+#else
+#define PIXOPS_ALWAYS_INLINE
+#endif
+
+typedef enum {
+  PIXOPS_SIMD_SCALE,		/* scale_line () */
+  PIXOPS_SIMD_SCALE_22_33,	/* scale_line_22_33 () */
+  PIXOPS_SIMD_COMPOSITE,	/* composite_line () */
+  PIXOPS_SIMD_COMPOSITE_22_4A4,	/* composite_line_22_4a4 () */
+  PIXOPS_SIMD_COMPOSITE_COLOR	/* composite_line_color () */
+} PixopsSimdOp;
+
+/* Loads a source pixel as bytes r, g, b, a. For sources without
+ * alpha the fourth byte is undefined and must not be used.
+ */
+static PIXOPS_ALWAYS_INLINE guint32
+pixops_simd_load_pixel (const guchar *q,
+			int           src_channels)
+{
+  guint32 v;
+
+  if (src_channels == 4)
+    {
+      memcpy (&v, q, 4);
+      return GUINT32_FROM_LE (v);
+    }
+
+  return q[0] | (q[1] << 8) | (q[2] << 16);
+}
+
+/* The constant that the C line functions multiply the filter weight
+ * with for sources that have no alpha channel.
+ */
+static PIXOPS_ALWAYS_INLINE guint32
+pixops_simd_opaque_alpha (PixopsSimdOp op)
+{
+  switch (op)
+    {
+    case PIXOPS_SIMD_SCALE:
+    case PIXOPS_SIMD_SCALE_22_33:
+      return 1;
+    default:
+      return 0xff;
+    }
+}
+
+/* Turns the accumulated sums into a destination pixel, exactly the way
+ * the corresponding C line function in pixops.c does.
+ */
+static PIXOPS_ALWAYS_INLINE void
+pixops_simd_store_pixel (PixopsSimdOp  op,
+			 guchar       *dest,
+			 int           dest_x,
+			 int           dest_channels,
+			 int           dest_has_alpha,
+			 gboolean      src_has_alpha,
+			 int           check_shift,
+			 const guchar  colors[2][3],
+			 guint32       r,
+			 guint32       g,
+			 guint32       b,
+			 guint32       a)
+{
+  switch (op)
+    {
+    case PIXOPS_SIMD_SCALE:
+      if (src_has_alpha)
+	{
+	  if (a)
+	    {
+	      dest[0] = r / a;
+	      dest[1] = g / a;
+	      dest[2] = b / a;
+	      dest[3] = a >> 16;
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  dest[0] = (r + 0xffff) >> 16;
+	  dest[1] = (g + 0xffff) >> 16;
+	  dest[2] = (b + 0xffff) >> 16;
+
+	  if (dest_has_alpha)
+	    dest[3] = 0xff;
+	}
+      break;
+
+    case PIXOPS_SIMD_SCALE_22_33:
+      dest[0] = (r + 0x8000) >> 16;
+      dest[1] = (g + 0x8000) >> 16;
+      dest[2] = (b + 0x8000) >> 16;
+      break;
+
+    case PIXOPS_SIMD_COMPOSITE:
+      if (dest_has_alpha)
+	{
+	  guint32 w0 = a - (a >> 8);
+	  guint32 w1 = ((0xff0000 - a) >> 8) * dest[3];
+	  guint32 w = w0 + w1;
+
+	  if (w != 0)
+	    {
+	      dest[0] = (r - (r >> 8) + w1 * dest[0]) / w;
+	      dest[1] = (g - (g >> 8) + w1 * dest[1]) / w;
+	      dest[2] = (b - (b >> 8) + w1 * dest[2]) / w;
+	      dest[3] = w / 0xff00;
+	    }
+	  else
+	    {
+	      dest[0] = 0;
+	      dest[1] = 0;
+	      dest[2] = 0;
+	      dest[3] = 0;
+	    }
+	}
+      else
+	{
+	  dest[0] = (r + (0xff0000 - a) * dest[0]) / 0xff0000;
+	  dest[1] = (g + (0xff0000 - a) * dest[1]) / 0xff0000;
+	  dest[2] = (b + (0xff0000 - a) * dest[2]) / 0xff0000;
+	}
+      break;
+
+    case PIXOPS_SIMD_COMPOSITE_22_4A4:
+      dest[0] = ((0xff0000 - a) * dest[0] + r) >> 24;
+      dest[1] = ((0xff0000 - a) * dest[1] + g) >> 24;
+      dest[2] = ((0xff0000 - a) * dest[2] + b) >> 24;
+      dest[3] = a >> 16;
+      break;
+
+    case PIXOPS_SIMD_COMPOSITE_COLOR:
+      {
+	const guchar *c = colors[(dest_x >> check_shift) & 1];
+
+	dest[0] = ((0xff0000 - a) * c[0] + r) >> 24;
+	dest[1] = ((0xff0000 - a) * c[1] + g) >> 24;
+	dest[2] = ((0xff0000 - a) * c[2] + b) >> 24;
+
+	if (dest_has_alpha)
+	  dest[3] = 0xff;
+	else if (dest_channels == 4)
+	  dest[3] = a >> 16;
+      }
+      break;
+    }
+}
+
+/* The filter weights of a pixel are never negative and sum to at
+ * most 65536, so they all fit in 16 bits unless a single tap carries
+ * the full weight of 65536, in which case all other taps are zero.
+ * For each of the SUBSAMPLE sets of weights passed to a line function
+ * this finds that tap, or -1 if there is none.
+ */
+static PIXOPS_ALWAYS_INLINE void
+pixops_simd_find_full_taps (const int *weights,
+			    int        n_x,
+			    int        n_y,
+			    int        full_taps[SUBSAMPLE])
+{
+  int n = n_x * n_y;
+  int i, k;
+
+  for (i = 0; i < SUBSAMPLE; i++)
+    {
+      full_taps[i] = -1;
+
+      for (k = 0; k < n; k++)
+	if (weights[i * n + k] > 0xffff)
+	  full_taps[i] = k;
+    }
+}
+
+/* Computes the sums for a pixel whose only non-zero tap is tap k,
+ * which has a weight of 65536.
+ */
+static PIXOPS_ALWAYS_INLINE void
+pixops_simd_full_tap_sums (guchar      **src,
+			   int           x_scaled,
+			   int           k,
+			   int           n_x,
+			   int           src_channels,
+			   gboolean      src_has_alpha,
+			   guint32       opaque,
+			   guint32       sums[4])
+{
+  const guchar *q = src[k / n_x] + (x_scaled + k % n_x) * src_channels;
+  guint32 ta = (src_has_alpha ? q[3] : opaque) << 16;
+
+  sums[0] = ta * q[0];
+  sums[1] = ta * q[1];
+  sums[2] = ta * q[2];
+  sums[3] = ta;
+}
+
+static PIXOPS_ALWAYS_INLINE int
+pixops_simd_check_shift (int check_size)
+{
+  int check_shift = 0;
+
+  if (check_size <= 0)
+    return 0;
+
+  while (!(check_size & 1))
+    {
+      check_shift++;
+      check_size >>= 1;
+    }
+
+  return check_shift;
+}
+
+static PIXOPS_ALWAYS_INLINE void
+pixops_simd_split_colors (guchar  colors[2][3],
+			  guint32 color1,
+			  guint32 color2)
+{
+  colors[0][0] = (color1 & 0xff0000) >> 16;
+  colors[0][1] = (color1 & 0xff00) >> 8;
+  colors[0][2] = color1 & 0xff;
+  colors[1][0] = (color2 & 0xff0000) >> 16;
+  colors[1][1] = (color2 & 0xff00) >> 8;
+  colors[1][2] = color2 & 0xff;
+}
+
+#endif /* PIXOPS_SIMD_H */
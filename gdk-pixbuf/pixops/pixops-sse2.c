@@ -0,0 +1,307 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* SSE2 versions of the line functions in pixops.c. This file is
+ * compiled with SSE2_CFLAGS and only called after a runtime check.
+ */
+#include "config.h"
+#include <emmintrin.h>
+
+#include "pixops-simd.h"
+
+/* Each filter tap contributes w * (r, g, b, 1) * m to the sums, where
+ * w is the filter weight and m is the source alpha, or a constant for
+ * sources without alpha. The C code computes this as (m * w) * c in
+ * wrapping 32-bit arithmetic; we compute w * (m * c) instead, which
+ * gives the same result since every product fits in 32 bits.
+ *
+ * m * c always fits in 16 bits, and so does w unless a single tap
+ * carries the full weight of 65536, see pixops_simd_find_full_taps().
+ * The products are formed with 16-bit multiplies, two taps per
+ * register; pixels with a full-weight tap are handled separately.
+ */
+
+/* Expands 8 bytes of two 4-channel pixels into 16-bit lanes of m * c */
+static PIXOPS_ALWAYS_INLINE __m128i
+premultiply_sse2 (__m128i  p,
+		  gboolean src_has_alpha,
+		  guint32  opaque)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i rgb_mask = _mm_set_epi16 (0, -1, -1, -1, 0, -1, -1, -1);
+  const __m128i alpha_one = _mm_set_epi16 (1, 0, 0, 0, 1, 0, 0, 0);
+  __m128i c;
+
+  p = _mm_unpacklo_epi8 (p, zero);
+  c = _mm_or_si128 (_mm_and_si128 (p, rgb_mask), alpha_one);
+
+  if (src_has_alpha)
+    {
+      __m128i m = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (p, 0xff), 0xff);
+      return _mm_mullo_epi16 (c, m);
+    }
+  else if (opaque != 1)
+    return _mm_mullo_epi16 (c, _mm_set1_epi16 (opaque));
+  else
+    return c;
+}
+
+/* Multiplies two taps' worth of 16-bit values by their 16-bit weights
+ * and adds both 32-bit results to acc.
+ */
+static PIXOPS_ALWAYS_INLINE __m128i
+multiply_add_sse2 (__m128i acc,
+		   __m128i pc,
+		   __m128i w)
+{
+  __m128i lo = _mm_mullo_epi16 (pc, w);
+  __m128i hi = _mm_mulhi_epu16 (pc, w);
+
+  acc = _mm_add_epi32 (acc, _mm_unpacklo_epi16 (lo, hi));
+  return _mm_add_epi32 (acc, _mm_unpackhi_epi16 (lo, hi));
+}
+
+/* Loads two pixels as r0 g0 b0 a0 r1 g1 b1 a1. For 3-channel sources
+ * an 8 byte load is only done if can_overread says that the two bytes
+ * following the second pixel are still part of the row.
+ */
+static PIXOPS_ALWAYS_INLINE __m128i
+load_pixels_sse2 (const guchar *q,
+		  int           src_channels,
+		  gboolean      can_overread)
+{
+  if (src_channels == 4)
+    return _mm_loadl_epi64 ((const __m128i *) q);
+
+  if (can_overread)
+    {
+      const __m128i rgb0 = _mm_set_epi32 (0, 0, 0, 0x00ffffff);
+      const __m128i rgb1 = _mm_set_epi32 (0, 0, 0x00ffffff, 0);
+      __m128i p = _mm_loadl_epi64 ((const __m128i *) q);
+
+      return _mm_or_si128 (_mm_and_si128 (p, rgb0),
+			   _mm_and_si128 (_mm_slli_epi64 (p, 8), rgb1));
+    }
+
+  return _mm_unpacklo_epi32 (_mm_cvtsi32_si128 (pixops_simd_load_pixel (q, 3)),
+			     _mm_cvtsi32_si128 (pixops_simd_load_pixel (q + 3, 3)));
+}
+
+static PIXOPS_ALWAYS_INLINE __m128i
+accumulate_sse2 (const int    *pixel_weights,
+		 int           n_x,
+		 int           n_y,
+		 guchar      **src,
+		 int           x_scaled,
+		 int           src_channels,
+		 gboolean      src_has_alpha,
+		 guint32       opaque,
+		 int           src_width)
+{
+  __m128i acc = _mm_setzero_si128 ();
+  gboolean can_overread = x_scaled + n_x < src_width;
+  int i, j;
+
+  for (i = 0; i < n_y; i++)
+    {
+      const guchar *q = src[i] + x_scaled * src_channels;
+      const int *line_weights = pixel_weights + n_x * i;
+
+      for (j = 0; j + 1 < n_x; j += 2)
+	{
+	  __m128i w = _mm_loadl_epi64 ((const __m128i *) (line_weights + j));
+
+	  /* (w0, w0, w0, w0, w1, w1, w1, w1) */
+	  w = _mm_shufflelo_epi16 (w, _MM_SHUFFLE (2, 2, 0, 0));
+	  w = _mm_unpacklo_epi32 (w, w);
+
+	  acc = multiply_add_sse2 (acc,
+				   premultiply_sse2 (load_pixels_sse2 (q, src_channels,
+									 can_overread),
+						     src_has_alpha, opaque),
+				   w);
+	  q += 2 * src_channels;
+	}
+
+      if (j < n_x)
+	{
+	  __m128i p = _mm_cvtsi32_si128 (pixops_simd_load_pixel (q, src_channels));
+	  __m128i w = _mm_set_epi16 (0, 0, 0, 0,
+				     line_weights[j], line_weights[j],
+				     line_weights[j], line_weights[j]);
+
+	  acc = multiply_add_sse2 (acc,
+				   premultiply_sse2 (p, src_has_alpha, opaque),
+				   w);
+	}
+    }
+
+  return acc;
+}
+
+static PIXOPS_ALWAYS_INLINE guchar *
+line_sse2 (PixopsSimdOp  op,
+	   int          *weights,
+	   int           n_x,
+	   int           n_y,
+	   guchar       *dest,
+	   int           dest_x,
+	   guchar       *dest_end,
+	   int           dest_channels,
+	   int           dest_has_alpha,
+	   guchar      **src,
+	   int           src_channels,
+	   gboolean      src_has_alpha,
+	   int           x_init,
+	   int           x_step,
+	   int           src_width,
+	   int           check_size,
+	   guint32       color1,
+	   guint32       color2)
+{
+  const guint32 opaque = pixops_simd_opaque_alpha (op);
+  int full_taps[SUBSAMPLE];
+  guchar colors[2][3];
+  int check_shift = 0;
+  int x = x_init;
+
+  if (op == PIXOPS_SIMD_COMPOSITE_COLOR)
+    {
+      check_shift = pixops_simd_check_shift (check_size);
+      pixops_simd_split_colors (colors, color1, color2);
+    }
+
+  pixops_simd_find_full_taps (weights, n_x, n_y, full_taps);
+
+  while (dest < dest_end)
+    {
+      int x_scaled = x >> SCALE_SHIFT;
+      int phase = (x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK;
+      guint32 sums[4];
+
+      if (full_taps[phase] >= 0)
+	pixops_simd_full_tap_sums (src, x_scaled, full_taps[phase], n_x,
+				   src_channels, src_has_alpha, opaque, sums);
+      else
+	_mm_storeu_si128 ((__m128i *) sums,
+			  accumulate_sse2 (weights + phase * n_x * n_y,
+					   n_x, n_y, src, x_scaled,
+					   src_channels, src_has_alpha,
+					   opaque, src_width));
+
+      pixops_simd_store_pixel (op, dest, dest_x, dest_channels,
+			       dest_has_alpha, src_has_alpha,
+			       check_shift, (const guchar (*)[3]) colors,
+			       sums[0], sums[1], sums[2], sums[3]);
+
+      dest += dest_channels;
+      x += x_step;
+      dest_x++;
+    }
+
+  return dest;
+}
+
+guchar *
+_pixops_scale_line_sse2 (int *weights, int n_x, int n_y, guchar *dest,
+			 int dest_x, guchar *dest_end, int dest_channels,
+			 int dest_has_alpha, guchar **src, int src_channels,
+			 gboolean src_has_alpha, int x_init, int x_step,
+			 int src_width, int check_size, guint32 color1,
+			 guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_SCALE, weights, n_x, n_y, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_scale_line_22_sse2 (int *weights, int n_x, int n_y, guchar *dest,
+			    int dest_x, guchar *dest_end, int dest_channels,
+			    int dest_has_alpha, guchar **src, int src_channels,
+			    gboolean src_has_alpha, int x_init, int x_step,
+			    int src_width, int check_size, guint32 color1,
+			    guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_SCALE, weights, 2, 2, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_sse2 (int *weights, int n_x, int n_y, guchar *dest,
+			     int dest_x, guchar *dest_end, int dest_channels,
+			     int dest_has_alpha, guchar **src,
+			     int src_channels, gboolean src_has_alpha,
+			     int x_init, int x_step, int src_width,
+			     int check_size, guint32 color1, guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_COMPOSITE, weights, n_x, n_y, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_22_sse2 (int *weights, int n_x, int n_y, guchar *dest,
+				int dest_x, guchar *dest_end,
+				int dest_channels, int dest_has_alpha,
+				guchar **src, int src_channels,
+				gboolean src_has_alpha, int x_init,
+				int x_step, int src_width, int check_size,
+				guint32 color1, guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_COMPOSITE, weights, 2, 2, dest, dest_x,
+		    dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_color_sse2 (int *weights, int n_x, int n_y,
+				   guchar *dest, int dest_x, guchar *dest_end,
+				   int dest_channels, int dest_has_alpha,
+				   guchar **src, int src_channels,
+				   gboolean src_has_alpha, int x_init,
+				   int x_step, int src_width, int check_size,
+				   guint32 color1, guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_COMPOSITE_COLOR, weights, n_x, n_y, dest,
+		    dest_x, dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
+
+guchar *
+_pixops_composite_line_color_22_sse2 (int *weights, int n_x, int n_y,
+				      guchar *dest, int dest_x,
+				      guchar *dest_end, int dest_channels,
+				      int dest_has_alpha, guchar **src,
+				      int src_channels, gboolean src_has_alpha,
+				      int x_init, int x_step, int src_width,
+				      int check_size, guint32 color1,
+				      guint32 color2)
+{
+  return line_sse2 (PIXOPS_SIMD_COMPOSITE_COLOR, weights, 2, 2, dest,
+		    dest_x, dest_end, dest_channels, dest_has_alpha, src,
+		    src_channels, src_has_alpha, x_init, x_step,
+		    src_width, check_size, color1, color2);
+}
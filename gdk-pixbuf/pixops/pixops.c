@@ -22,15 +22,13 @@
 #include "config.h"
 #include <math.h>
 #include <glib.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 #include "pixops.h"
 #include "pixops-internal.h"
 
-#define SUBSAMPLE_BITS 4
-#define SUBSAMPLE (1 << SUBSAMPLE_BITS)
-#define SUBSAMPLE_MASK ((1 << SUBSAMPLE_BITS)-1)
-#define SCALE_SHIFT 16
-
 static void
 _pixops_scale_real (guchar        *dest_buf,
                     int            render_x0,
@@ -67,13 +65,6 @@ struct _PixopsFilter
   double overall_alpha;
 }; 
 
-typedef guchar *(*PixopsLineFunc) (int *weights, int n_x, int n_y,
-				   guchar *dest, int dest_x, guchar *dest_end,
-				   int dest_channels, int dest_has_alpha,
-				   guchar **src, int src_channels,
-				   gboolean src_has_alpha, int x_init,
-				   int x_step, int src_width, int check_size,
-				   guint32 color1, guint32 color2);
 typedef void (*PixopsPixelFunc)   (guchar *dest, int dest_x, int dest_channels,
 				   int dest_has_alpha, int src_has_alpha,
 				   int check_size, guint32 color1,
@@ -233,6 +224,49 @@ _pixops_use_medialib ()
 }
 #endif
 
+static volatile gint cpu_features_mask = -1;
+
+static guint
+pixops_detect_cpu_features (void)
+{
+  guint features = 0;
+
+  if (g_getenv ("GDK_PIXOPS_DISABLE_SIMD"))
+    return 0;
+
+#if defined (USE_SSE2) || defined (USE_AVX2)
+  __builtin_cpu_init ();
+#endif
+#ifdef USE_SSE2
+  if (__builtin_cpu_supports ("sse2"))
+    features |= PIXOPS_CPU_SSE2;
+#endif
+#ifdef USE_AVX2
+  if (__builtin_cpu_supports ("avx2"))
+    features |= PIXOPS_CPU_AVX2;
+#endif
+
+  return features;
+}
+
+guint
+_pixops_get_cpu_features (void)
+{
+  static volatile gsize detected = 0;
+
+  /* Stored off by one since g_once_init_leave() needs a non-zero value */
+  if (g_once_init_enter (&detected))
+    g_once_init_leave (&detected, pixops_detect_cpu_features () + 1);
+
+  return (detected - 1) & (guint) g_atomic_int_get (&cpu_features_mask);
+}
+
+void
+_pixops_set_cpu_features (guint features)
+{
+  g_atomic_int_set (&cpu_features_mask, (gint) features);
+}
+
 static int
 get_check_shift (int check_size)
 {
@@ -1222,149 +1256,359 @@ make_filter_table (PixopsFilter *filter)
   return weights;
 }
 
+/* Everything pixops_process_rows() needs to render a range of
+ * destination rows. It is only read while rendering, so bands of rows
+ * can be processed concurrently.
+ */
+typedef struct
+{
+  guchar         *dest_buf;
+  int             render_x0;
+  int             render_y0;
+  int             render_x1;
+  int             dest_rowstride;
+  int             dest_channels;
+  gboolean        dest_has_alpha;
+  const guchar   *src_buf;
+  int             src_width;
+  int             src_height;
+  int             src_rowstride;
+  int             src_channels;
+  gboolean        src_has_alpha;
+  int             check_x;
+  int             check_y;
+  int             check_size;
+  guint32         color1;
+  guint32         color2;
+  PixopsFilter   *filter;
+  PixopsLineFunc  line_func;
+  PixopsPixelFunc pixel_func;
+
+  int            *filter_weights;
+  int             x_step;
+  int             y_step;
+  int             y_offset;
+  int             check_shift;
+  int             scaled_x_offset;
+  int             run_end_index;
+} PixopsProcess;
+
 static void
-pixops_process (guchar         *dest_buf,
-		int             render_x0,
-		int             render_y0,
-		int             render_x1,
-		int             render_y1,
-		int             dest_rowstride,
-		int             dest_channels,
-		gboolean        dest_has_alpha,
-		const guchar   *src_buf,
-		int             src_width,
-		int             src_height,
-		int             src_rowstride,
-		int             src_channels,
-		gboolean        src_has_alpha,
-		double          scale_x,
-		double          scale_y,
-		int             check_x,
-		int             check_y,
-		int             check_size,
-		guint32         color1,
-		guint32         color2,
-		PixopsFilter   *filter,
-		PixopsLineFunc  line_func,
-		PixopsPixelFunc pixel_func)
+pixops_process_rows (const PixopsProcess *p,
+		     int                  row_start,
+		     int                  row_end)
 {
+  PixopsFilter *filter = p->filter;
+  guchar **line_bufs = g_new (guchar *, filter->y.n);
   int i, j;
   int x, y;			/* X and Y position in source (fixed_point) */
-  
-  guchar **line_bufs = g_new (guchar *, filter->y.n);
-  int *filter_weights = make_filter_table (filter);
-
-  int x_step = (1 << SCALE_SHIFT) / scale_x; /* X step in source (fixed point) */
-  int y_step = (1 << SCALE_SHIFT) / scale_y; /* Y step in source (fixed point) */
-
-  int check_shift = check_size ? get_check_shift (check_size) : 0;
-
-  int scaled_x_offset = floor (filter->x.offset * (1 << SCALE_SHIFT));
-
-  /* Compute the index where we run off the end of the source buffer. The
-   * furthest source pixel we access at index i is:
-   *
-   *  ((render_x0 + i) * x_step + scaled_x_offset) >> SCALE_SHIFT + filter->x.n - 1
-   *
-   * So, run_end_index is the smallest i for which this pixel is src_width,
-   * i.e, for which:
-   *
-   *  (i + render_x0) * x_step >= ((src_width - filter->x.n + 1) << SCALE_SHIFT) - scaled_x_offset
-   *
-   */
-#define MYDIV(a,b) ((a) > 0 ? (a) / (b) : ((a) - (b) + 1) / (b))    /* Division so that -1/5 = -1 */
-  
-  int run_end_x = (((src_width - filter->x.n + 1) << SCALE_SHIFT) - scaled_x_offset);
-  int run_end_index = MYDIV (run_end_x + x_step - 1, x_step) - render_x0;
-  run_end_index = MIN (run_end_index, render_x1 - render_x0);
 
-  y = render_y0 * y_step + floor (filter->y.offset * (1 << SCALE_SHIFT));
-  for (i = 0; i < (render_y1 - render_y0); i++)
+  y = p->render_y0 * p->y_step + p->y_offset + row_start * p->y_step;
+  for (i = row_start; i < row_end; i++)
     {
       int dest_x;
       int y_start = y >> SCALE_SHIFT;
       int x_start;
-      int *run_weights = filter_weights +
+      int *run_weights = p->filter_weights +
                          ((y >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) *
                          filter->x.n * filter->y.n * SUBSAMPLE;
       guchar *new_outbuf;
       guint32 tcolor1, tcolor2;
       
-      guchar *outbuf = dest_buf + dest_rowstride * i;
-      guchar *outbuf_end = outbuf + dest_channels * (render_x1 - render_x0);
+      guchar *outbuf = p->dest_buf + p->dest_rowstride * i;
+      guchar *outbuf_end = outbuf + p->dest_channels * (p->render_x1 - p->render_x0);
 
-      if (((i + check_y) >> check_shift) & 1)
+      if (((i + p->check_y) >> p->check_shift) & 1)
 	{
-	  tcolor1 = color2;
-	  tcolor2 = color1;
+	  tcolor1 = p->color2;
+	  tcolor2 = p->color1;
 	}
       else
 	{
-	  tcolor1 = color1;
-	  tcolor2 = color2;
+	  tcolor1 = p->color1;
+	  tcolor2 = p->color2;
 	}
 
       for (j=0; j<filter->y.n; j++)
 	{
 	  if (y_start <  0)
-	    line_bufs[j] = (guchar *)src_buf;
-	  else if (y_start < src_height)
-	    line_bufs[j] = (guchar *)src_buf + src_rowstride * y_start;
+	    line_bufs[j] = (guchar *)p->src_buf;
+	  else if (y_start < p->src_height)
+	    line_bufs[j] = (guchar *)p->src_buf + p->src_rowstride * y_start;
 	  else
-	    line_bufs[j] = (guchar *)src_buf + src_rowstride * (src_height - 1);
+	    line_bufs[j] = (guchar *)p->src_buf + p->src_rowstride * (p->src_height - 1);
 
 	  y_start++;
 	}
 
-      dest_x = check_x;
-      x = render_x0 * x_step + scaled_x_offset;
+      dest_x = p->check_x;
+      x = p->render_x0 * p->x_step + p->scaled_x_offset;
       x_start = x >> SCALE_SHIFT;
 
       while (x_start < 0 && outbuf < outbuf_end)
 	{
 	  process_pixel (run_weights + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * (filter->x.n * filter->y.n), filter->x.n, filter->y.n,
-			 outbuf, dest_x, dest_channels, dest_has_alpha,
-			 line_bufs, src_channels, src_has_alpha,
-			 x >> SCALE_SHIFT, src_width,
-			 check_size, tcolor1, tcolor2, pixel_func);
+			 outbuf, dest_x, p->dest_channels, p->dest_has_alpha,
+			 line_bufs, p->src_channels, p->src_has_alpha,
+			 x >> SCALE_SHIFT, p->src_width,
+			 p->check_size, tcolor1, tcolor2, p->pixel_func);
 	  
-	  x += x_step;
+	  x += p->x_step;
 	  x_start = x >> SCALE_SHIFT;
 	  dest_x++;
-	  outbuf += dest_channels;
+	  outbuf += p->dest_channels;
 	}
 
-      new_outbuf = (*line_func) (run_weights, filter->x.n, filter->y.n,
-				 outbuf, dest_x, dest_buf + dest_rowstride *
-				 i + run_end_index * dest_channels,
-				 dest_channels, dest_has_alpha,
-				 line_bufs, src_channels, src_has_alpha,
-				 x, x_step, src_width, check_size, tcolor1,
-				 tcolor2);
+      new_outbuf = (*p->line_func) (run_weights, filter->x.n, filter->y.n,
+				    outbuf, dest_x, p->dest_buf + p->dest_rowstride *
+				    i + p->run_end_index * p->dest_channels,
+				    p->dest_channels, p->dest_has_alpha,
+				    line_bufs, p->src_channels, p->src_has_alpha,
+				    x, p->x_step, p->src_width, p->check_size,
+				    tcolor1, tcolor2);
 
-      dest_x += (new_outbuf - outbuf) / dest_channels;
+      dest_x += (new_outbuf - outbuf) / p->dest_channels;
 
-      x = (dest_x - check_x + render_x0) * x_step + scaled_x_offset;
+      x = (dest_x - p->check_x + p->render_x0) * p->x_step + p->scaled_x_offset;
       outbuf = new_outbuf;
 
       while (outbuf < outbuf_end)
 	{
 	  process_pixel (run_weights + ((x >> (SCALE_SHIFT - SUBSAMPLE_BITS)) & SUBSAMPLE_MASK) * (filter->x.n * filter->y.n), filter->x.n, filter->y.n,
-			 outbuf, dest_x, dest_channels, dest_has_alpha,
-			 line_bufs, src_channels, src_has_alpha,
-			 x >> SCALE_SHIFT, src_width,
-			 check_size, tcolor1, tcolor2, pixel_func);
+			 outbuf, dest_x, p->dest_channels, p->dest_has_alpha,
+			 line_bufs, p->src_channels, p->src_has_alpha,
+			 x >> SCALE_SHIFT, p->src_width,
+			 p->check_size, tcolor1, tcolor2, p->pixel_func);
 	  
-	  x += x_step;
+	  x += p->x_step;
 	  dest_x++;
-	  outbuf += dest_channels;
+	  outbuf += p->dest_channels;
 	}
 
-      y += y_step;
+      y += p->y_step;
     }
 
   g_free (line_bufs);
-  g_free (filter_weights);
+}
+
+/* Parallel processing: the destination rows are split into horizontal
+ * bands, one per thread. The calling thread renders the first band and
+ * the others go to a shared thread pool. Each band has its own
+ * line_bufs; the filter table is computed once and shared.
+ */
+#define PARALLEL_MIN_PIXELS (512 * 512)	/* smallest area worth splitting */
+#define PARALLEL_MIN_ROWS   16		/* smallest band */
+
+typedef struct
+{
+  const PixopsProcess *process;
+  GMutex *lock;
+  GCond *done;
+  int pending;
+} PixopsJob;
+
+typedef struct
+{
+  PixopsJob *job;
+  int row_start;
+  int row_end;
+} PixopsBand;
+
+static volatile gint max_threads = 0;
+static GThreadPool *band_pool = NULL;
+G_LOCK_DEFINE_STATIC (band_pool);
+
+void
+_pixops_set_max_threads (int n_threads)
+{
+  g_atomic_int_set (&max_threads, MAX (n_threads, 0));
+}
+
+int
+_pixops_get_max_threads (void)
+{
+  return g_atomic_int_get (&max_threads);
+}
+
+static int
+pixops_get_n_threads (void)
+{
+  static volatile gsize n_processors = 0;
+  int n_threads = g_atomic_int_get (&max_threads);
+
+  if (n_threads > 0)
+    return n_threads;
+
+  if (g_once_init_enter (&n_processors))
+    {
+      long n = 1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+      n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+      g_once_init_leave (&n_processors, MAX (n, 1));
+    }
+
+  return n_processors;
+}
+
+static void
+pixops_process_band (gpointer data,
+		     gpointer user_data)
+{
+  PixopsBand *band = data;
+  PixopsJob *job = band->job;
+
+  pixops_process_rows (job->process, band->row_start, band->row_end);
+
+  g_mutex_lock (job->lock);
+  if (--job->pending == 0)
+    g_cond_signal (job->done);
+  g_mutex_unlock (job->lock);
+}
+
+/* Returns FALSE if the rows could not be handed out to other threads,
+ * in which case nothing has been rendered.
+ */
+static gboolean
+pixops_process_parallel (const PixopsProcess *process,
+			 int                  n_rows,
+			 int                  n_bands)
+{
+  PixopsBand *bands;
+  PixopsJob job;
+  GThreadPool *pool;
+  int k;
+
+  G_LOCK (band_pool);
+  if (!band_pool)
+    band_pool = g_thread_pool_new (pixops_process_band, NULL,
+				   n_bands - 1, FALSE, NULL);
+  else if (g_thread_pool_get_max_threads (band_pool) < n_bands - 1)
+    g_thread_pool_set_max_threads (band_pool, n_bands - 1, NULL);
+  pool = band_pool;
+  G_UNLOCK (band_pool);
+
+  if (!pool)
+    return FALSE;
+
+  job.process = process;
+  job.lock = g_mutex_new ();
+  job.done = g_cond_new ();
+  job.pending = n_bands;
+
+  bands = g_new (PixopsBand, n_bands);
+  for (k = 0; k < n_bands; k++)
+    {
+      bands[k].job = &job;
+      bands[k].row_start = (n_rows * k) / n_bands;
+      bands[k].row_end = (n_rows * (k + 1)) / n_bands;
+    }
+
+  for (k = 1; k < n_bands; k++)
+    g_thread_pool_push (pool, &bands[k], NULL);
+
+  pixops_process_band (&bands[0], NULL);
+
+  g_mutex_lock (job.lock);
+  while (job.pending > 0)
+    g_cond_wait (job.done, job.lock);
+  g_mutex_unlock (job.lock);
+
+  g_mutex_free (job.lock);
+  g_cond_free (job.done);
+  g_free (bands);
+
+  return TRUE;
+}
+
+static void
+pixops_process (guchar         *dest_buf,
+		int             render_x0,
+		int             render_y0,
+		int             render_x1,
+		int             render_y1,
+		int             dest_rowstride,
+		int             dest_channels,
+		gboolean        dest_has_alpha,
+		const guchar   *src_buf,
+		int             src_width,
+		int             src_height,
+		int             src_rowstride,
+		int             src_channels,
+		gboolean        src_has_alpha,
+		double          scale_x,
+		double          scale_y,
+		int             check_x,
+		int             check_y,
+		int             check_size,
+		guint32         color1,
+		guint32         color2,
+		PixopsFilter   *filter,
+		int            *filter_weights,
+		PixopsLineFunc  line_func,
+		PixopsPixelFunc pixel_func)
+{
+  PixopsProcess process;
+  int n_rows = render_y1 - render_y0;
+  int n_bands = 1;
+
+  int x_step = (1 << SCALE_SHIFT) / scale_x; /* X step in source (fixed point) */
+  int scaled_x_offset = floor (filter->x.offset * (1 << SCALE_SHIFT));
+
+  /* Compute the index where we run off the end of the source buffer. The
+   * furthest source pixel we access at index i is:
+   *
+   *  ((render_x0 + i) * x_step + scaled_x_offset) >> SCALE_SHIFT + filter->x.n - 1
+   *
+   * So, run_end_index is the smallest i for which this pixel is src_width,
+   * i.e, for which:
+   *
+   *  (i + render_x0) * x_step >= ((src_width - filter->x.n + 1) << SCALE_SHIFT) - scaled_x_offset
+   *
+   */
+#define MYDIV(a,b) ((a) > 0 ? (a) / (b) : ((a) - (b) + 1) / (b))    /* Division so that -1/5 = -1 */
+  
+  int run_end_x = (((src_width - filter->x.n + 1) << SCALE_SHIFT) - scaled_x_offset);
+  int run_end_index = MYDIV (run_end_x + x_step - 1, x_step) - render_x0;
+  run_end_index = MIN (run_end_index, render_x1 - render_x0);
+
+  process.dest_buf = dest_buf;
+  process.render_x0 = render_x0;
+  process.render_y0 = render_y0;
+  process.render_x1 = render_x1;
+  process.dest_rowstride = dest_rowstride;
+  process.dest_channels = dest_channels;
+  process.dest_has_alpha = dest_has_alpha;
+  process.src_buf = src_buf;
+  process.src_width = src_width;
+  process.src_height = src_height;
+  process.src_rowstride = src_rowstride;
+  process.src_channels = src_channels;
+  process.src_has_alpha = src_has_alpha;
+  process.check_x = check_x;
+  process.check_y = check_y;
+  process.check_size = check_size;
+  process.color1 = color1;
+  process.color2 = color2;
+  process.filter = filter;
+  process.line_func = line_func;
+  process.pixel_func = pixel_func;
+
+  process.filter_weights = filter_weights;
+  process.x_step = x_step;
+  process.y_step = (1 << SCALE_SHIFT) / scale_y; /* Y step in source (fixed point) */
+  process.y_offset = floor (filter->y.offset * (1 << SCALE_SHIFT));
+  process.check_shift = check_size ? get_check_shift (check_size) : 0;
+  process.scaled_x_offset = scaled_x_offset;
+  process.run_end_index = run_end_index;
+
+  if (g_thread_supported () &&
+      (render_x1 - render_x0) * n_rows >= PARALLEL_MIN_PIXELS)
+    n_bands = CLAMP (n_rows / PARALLEL_MIN_ROWS, 1, pixops_get_n_threads ());
+
+  if (n_bands < 2 || !pixops_process_parallel (&process, n_rows, n_bands))
+    pixops_process_rows (&process, 0, n_rows);
 }
 
 /* Compute weights for reconstruction by replication followed by
@@ -1576,6 +1820,212 @@ make_weights (PixopsFilter     *filter,
     }
 }
 
+/* Cache of filters and their filter tables. Building them is a
+ * noticeable part of the cost of small scales, and icons and
+ * thumbnails tend to be scaled by the same few factors over and over.
+ * Entries are kept in most recently used order and are reference
+ * counted, since another thread may evict an entry that is in use.
+ * Tables larger than the whole cache are built for one use only. Two
+ * threads missing on the same filter at once may both add it; the
+ * unused copy simply ages out.
+ */
+#define FILTER_CACHE_SIZE (1024 * 1024)	/* bytes of filter tables */
+
+typedef struct _PixopsCachedFilter PixopsCachedFilter;
+
+struct _PixopsCachedFilter
+{
+  PixopsInterpType interp_type;
+  double scale_x;
+  double scale_y;
+
+  PixopsFilter filter;
+  int *table;			/* from make_filter_table () */
+  gsize size;
+
+  int ref_count;
+  gboolean in_cache;
+};
+
+static GQueue filter_cache = G_QUEUE_INIT;
+static gsize filter_cache_size = 0;
+static guint filter_cache_hits = 0;
+static guint filter_cache_misses = 0;
+G_LOCK_DEFINE_STATIC (filter_cache);
+
+static void
+pixops_cached_filter_free (PixopsCachedFilter *cached)
+{
+  g_free (cached->filter.x.weights);
+  g_free (cached->filter.y.weights);
+  g_free (cached->table);
+  g_free (cached);
+}
+
+/* Called with the lock held */
+static void
+pixops_filter_cache_evict (gsize needed)
+{
+  while (filter_cache.length > 0 &&
+	 filter_cache_size + needed > FILTER_CACHE_SIZE)
+    {
+      PixopsCachedFilter *cached = g_queue_pop_tail (&filter_cache);
+
+      filter_cache_size -= cached->size;
+      cached->in_cache = FALSE;
+
+      if (cached->ref_count == 0)
+	pixops_cached_filter_free (cached);
+    }
+}
+
+/* Returns the filter for the given parameters together with its filter
+ * table. Release it with pixops_filter_cache_release() when done.
+ */
+static PixopsCachedFilter *
+pixops_filter_cache_lookup (PixopsInterpType interp_type,
+			    double           scale_x,
+			    double           scale_y,
+			    double           overall_alpha)
+{
+  PixopsCachedFilter *cached;
+  GList *l;
+
+  G_LOCK (filter_cache);
+
+  for (l = filter_cache.head; l; l = l->next)
+    {
+      cached = l->data;
+
+      if (cached->interp_type == interp_type &&
+	  cached->scale_x == scale_x &&
+	  cached->scale_y == scale_y &&
+	  cached->filter.overall_alpha == overall_alpha)
+	{
+	  if (l != filter_cache.head)
+	    {
+	      g_queue_unlink (&filter_cache, l);
+	      g_queue_push_head_link (&filter_cache, l);
+	    }
+
+	  cached->ref_count++;
+	  filter_cache_hits++;
+	  G_UNLOCK (filter_cache);
+
+	  return cached;
+	}
+    }
+
+  filter_cache_misses++;
+  G_UNLOCK (filter_cache);
+
+  /* Built outside of the lock, large tables take a while */
+  cached = g_new (PixopsCachedFilter, 1);
+  cached->interp_type = interp_type;
+  cached->scale_x = scale_x;
+  cached->scale_y = scale_y;
+  cached->filter.overall_alpha = overall_alpha;
+  make_weights (&cached->filter, interp_type, scale_x, scale_y);
+  cached->table = make_filter_table (&cached->filter);
+  cached->size = sizeof (int) * SUBSAMPLE * SUBSAMPLE *
+                 cached->filter.x.n * cached->filter.y.n;
+  cached->ref_count = 1;
+  cached->in_cache = FALSE;
+
+  if (cached->size <= FILTER_CACHE_SIZE)
+    {
+      G_LOCK (filter_cache);
+      pixops_filter_cache_evict (cached->size);
+      g_queue_push_head (&filter_cache, cached);
+      filter_cache_size += cached->size;
+      cached->in_cache = TRUE;
+      G_UNLOCK (filter_cache);
+    }
+
+  return cached;
+}
+
+static void
+pixops_filter_cache_release (PixopsCachedFilter *cached)
+{
+  gboolean free_it;
+
+  G_LOCK (filter_cache);
+  free_it = --cached->ref_count == 0 && !cached->in_cache;
+  G_UNLOCK (filter_cache);
+
+  if (free_it)
+    pixops_cached_filter_free (cached);
+}
+
+void
+_pixops_get_filter_cache_stats (guint *hits,
+				guint *misses)
+{
+  G_LOCK (filter_cache);
+  if (hits)
+    *hits = filter_cache_hits;
+  if (misses)
+    *misses = filter_cache_misses;
+  G_UNLOCK (filter_cache);
+}
+
+void
+_pixops_clear_filter_cache (void)
+{
+  G_LOCK (filter_cache);
+  pixops_filter_cache_evict (FILTER_CACHE_SIZE + 1);
+  filter_cache_hits = 0;
+  filter_cache_misses = 0;
+  G_UNLOCK (filter_cache);
+}
+
+/* Replaces a C line function with its SSE2 or AVX2 counterpart, when
+ * the CPU supports it. The MMX functions are left alone. With SSE2
+ * only two taps fit in a register, which does not pay off against the
+ * C code for 3-channel sources and for the 2x2 composite onto 4-channel
+ * destinations, so those keep using the C functions.
+ */
+static PixopsLineFunc
+pixops_simd_line_func (PixopsLineFunc line_func,
+		       PixopsFilter  *filter,
+		       int            src_channels)
+{
+#if defined (USE_SSE2) || defined (USE_AVX2)
+  guint features = _pixops_get_cpu_features ();
+  gboolean is_22 = filter->x.n == 2 && filter->y.n == 2;
+
+#ifdef USE_AVX2
+  if (features & PIXOPS_CPU_AVX2)
+    {
+      if (line_func == scale_line)
+	return is_22 ? _pixops_scale_line_22_avx2 : _pixops_scale_line_avx2;
+      if (line_func == scale_line_22_33)
+	return _pixops_scale_line_22_33_avx2;
+      if (line_func == composite_line)
+	return is_22 ? _pixops_composite_line_22_avx2 : _pixops_composite_line_avx2;
+      if (line_func == composite_line_22_4a4)
+	return _pixops_composite_line_22_4a4_avx2;
+      if (line_func == composite_line_color)
+	return is_22 ? _pixops_composite_line_color_22_avx2 : _pixops_composite_line_color_avx2;
+    }
+#endif
+#ifdef USE_SSE2
+  if ((features & PIXOPS_CPU_SSE2) && src_channels == 4)
+    {
+      if (line_func == scale_line)
+	return is_22 ? _pixops_scale_line_22_sse2 : _pixops_scale_line_sse2;
+      if (line_func == composite_line)
+	return is_22 ? _pixops_composite_line_22_sse2 : _pixops_composite_line_sse2;
+      if (line_func == composite_line_color)
+	return is_22 ? _pixops_composite_line_color_22_sse2 : _pixops_composite_line_color_sse2;
+    }
+#endif
+#endif
+
+  return line_func;
+}
+
 static void
 _pixops_composite_color_real (guchar          *dest_buf,
 			      int              render_x0,
@@ -1601,7 +2051,8 @@ _pixops_composite_color_real (guchar          *dest_buf,
 			      guint32          color1,
 			      guint32          color2)
 {
-  PixopsFilter filter;
+  PixopsCachedFilter *cached;
+  PixopsFilter *filter;
   PixopsLineFunc line_func;
   
 #ifdef USE_MMX
@@ -1626,26 +2077,28 @@ _pixops_composite_color_real (guchar          *dest_buf,
       return;
     }
   
-  filter.overall_alpha = overall_alpha / 255.;
-  make_weights (&filter, interp_type, scale_x, scale_y);
+  cached = pixops_filter_cache_lookup (interp_type, scale_x, scale_y,
+				       overall_alpha / 255.);
+  filter = &cached->filter;
 
 #ifdef USE_MMX
-  if (filter.x.n == 2 && filter.y.n == 2 &&
+  if (filter->x.n == 2 && filter->y.n == 2 &&
       dest_channels == 4 && src_channels == 4 &&
       src_has_alpha && !dest_has_alpha && found_mmx)
     line_func = composite_line_color_22_4a4_mmx_stub;
   else
 #endif
     line_func = composite_line_color;
+
+  line_func = pixops_simd_line_func (line_func, filter, src_channels);
   
   pixops_process (dest_buf, render_x0, render_y0, render_x1, render_y1,
 		  dest_rowstride, dest_channels, dest_has_alpha,
 		  src_buf, src_width, src_height, src_rowstride, src_channels,
 		  src_has_alpha, scale_x, scale_y, check_x, check_y, check_size, color1, color2,
-		  &filter, line_func, composite_pixel_color);
+		  filter, cached->table, line_func, composite_pixel_color);
 
-  g_free (filter.x.weights);
-  g_free (filter.y.weights);
+  pixops_filter_cache_release (cached);
 }
 
 void
@@ -1753,7 +2206,8 @@ _pixops_composite_real (guchar          *dest_buf,
 			PixopsInterpType interp_type,
 			int              overall_alpha)
 {
-  PixopsFilter filter;
+  PixopsCachedFilter *cached;
+  PixopsFilter *filter;
   PixopsLineFunc line_func;
   
 #ifdef USE_MMX
@@ -1776,10 +2230,11 @@ _pixops_composite_real (guchar          *dest_buf,
       return;
     }
   
-  filter.overall_alpha = overall_alpha / 255.;
-  make_weights (&filter, interp_type, scale_x, scale_y);
+  cached = pixops_filter_cache_lookup (interp_type, scale_x, scale_y,
+				       overall_alpha / 255.);
+  filter = &cached->filter;
 
-  if (filter.x.n == 2 && filter.y.n == 2 && dest_channels == 4 &&
+  if (filter->x.n == 2 && filter->y.n == 2 && dest_channels == 4 &&
       src_channels == 4 && src_has_alpha && !dest_has_alpha)
     {
 #ifdef USE_MMX
@@ -1791,15 +2246,16 @@ _pixops_composite_real (guchar          *dest_buf,
     }
   else
     line_func = composite_line;
+
+  line_func = pixops_simd_line_func (line_func, filter, src_channels);
   
   pixops_process (dest_buf, render_x0, render_y0, render_x1, render_y1,
 		  dest_rowstride, dest_channels, dest_has_alpha,
 		  src_buf, src_width, src_height, src_rowstride, src_channels,
 		  src_has_alpha, scale_x, scale_y, 0, 0, 0, 0, 0, 
-		  &filter, line_func, composite_pixel);
+		  filter, cached->table, line_func, composite_pixel);
 
-  g_free (filter.x.weights);
-  g_free (filter.y.weights);
+  pixops_filter_cache_release (cached);
 }
 
 void
@@ -2159,7 +2615,8 @@ _pixops_scale_real (guchar        *dest_buf,
 		    double         scale_y,
 		    PixopsInterpType  interp_type)
 {
-  PixopsFilter filter;
+  PixopsCachedFilter *cached;
+  PixopsFilter *filter;
   PixopsLineFunc line_func;
 
 #ifdef USE_MMX
@@ -2183,10 +2640,10 @@ _pixops_scale_real (guchar        *dest_buf,
       return;
     }
   
-  filter.overall_alpha = 1.0;
-  make_weights (&filter, interp_type, scale_x, scale_y);
+  cached = pixops_filter_cache_lookup (interp_type, scale_x, scale_y, 1.0);
+  filter = &cached->filter;
 
-  if (filter.x.n == 2 && filter.y.n == 2 && dest_channels == 3 && src_channels == 3)
+  if (filter->x.n == 2 && filter->y.n == 2 && dest_channels == 3 && src_channels == 3)
     {
 #ifdef USE_MMX
       if (found_mmx)
@@ -2197,15 +2654,16 @@ _pixops_scale_real (guchar        *dest_buf,
     }
   else
     line_func = scale_line;
+
+  line_func = pixops_simd_line_func (line_func, filter, src_channels);
   
   pixops_process (dest_buf, render_x0, render_y0, render_x1, render_y1,
 		  dest_rowstride, dest_channels, dest_has_alpha,
 		  src_buf, src_width, src_height, src_rowstride, src_channels,
 		  src_has_alpha, scale_x, scale_y, 0, 0, 0, 0, 0,
-		  &filter, line_func, scale_pixel);
+		  filter, cached->table, line_func, scale_pixel);
 
-  g_free (filter.x.weights);
-  g_free (filter.y.weights);
+  pixops_filter_cache_release (cached);
 }
 
 void
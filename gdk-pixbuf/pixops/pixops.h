@@ -29,6 +29,35 @@ typedef enum {
 	PIXOPS_INTERP_HYPER
 } PixopsInterpType;
 
+/* SIMD instruction sets the line functions can use */
+typedef enum {
+	PIXOPS_CPU_SSE2 = 1 << 0,
+	PIXOPS_CPU_AVX2 = 1 << 1
+} PixopsCpuFeatures;
+
+/* Returns the PixopsCpuFeatures that are compiled in, supported by
+ * the CPU and not disabled with GDK_PIXOPS_DISABLE_SIMD or
+ * _pixops_set_cpu_features()
+ */
+guint _pixops_get_cpu_features (void);
+
+/* Restricts the SIMD code paths to features; used for testing */
+void  _pixops_set_cpu_features (guint features);
+
+/* Sets the maximum number of threads used to render large results,
+ * or 0 for one per processor
+ */
+void  _pixops_set_max_threads  (int n_threads);
+int   _pixops_get_max_threads  (void);
+
+/* Filter tables are cached between calls; these give the number of
+ * lookups that found a cached table and the number that had to build
+ * one, and empty the cache and reset the counters.
+ */
+void  _pixops_get_filter_cache_stats (guint *hits,
+				      guint *misses);
+void  _pixops_clear_filter_cache     (void);
+
 /* Scale src_buf from src_width / src_height by factors scale_x, scale_y
  * and composite the portion corresponding to
  * render_x, render_y, render_width, render_height in the new
@@ -0,0 +1,135 @@
+/* Tests for the filter table cache in pixops.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+#include "config.h"
+#include <glib.h>
+#include <string.h>
+
+#include "pixops.h"
+
+#define SRC_SIZE 200
+
+static guchar *src_buf;
+
+static guchar *
+scale (double           factor,
+       PixopsInterpType interp_type)
+{
+  int size = MAX (1, SRC_SIZE * factor);
+  guchar *dest_buf = g_malloc0 (size * size * 4);
+
+  _pixops_scale (dest_buf, size, size, size * 4, 4, TRUE,
+                 src_buf, SRC_SIZE, SRC_SIZE, SRC_SIZE * 4, 4, TRUE,
+                 0, 0, size, size, 0, 0, factor, factor, interp_type);
+
+  return dest_buf;
+}
+
+static void
+assert_stats (guint hits,
+              guint misses)
+{
+  guint h, m;
+
+  _pixops_get_filter_cache_stats (&h, &m);
+  g_assert_cmpuint (h, ==, hits);
+  g_assert_cmpuint (m, ==, misses);
+}
+
+static void
+test_cache_hits (void)
+{
+  _pixops_clear_filter_cache ();
+  assert_stats (0, 0);
+
+  g_free (scale (0.5, PIXOPS_INTERP_BILINEAR));
+  assert_stats (0, 1);
+
+  g_free (scale (0.5, PIXOPS_INTERP_BILINEAR));
+  assert_stats (1, 1);
+
+  /* Other factors and other filters are separate entries */
+  g_free (scale (0.25, PIXOPS_INTERP_BILINEAR));
+  assert_stats (1, 2);
+
+  g_free (scale (0.5, PIXOPS_INTERP_HYPER));
+  assert_stats (1, 3);
+
+  g_free (scale (0.5, PIXOPS_INTERP_BILINEAR));
+  g_free (scale (0.25, PIXOPS_INTERP_BILINEAR));
+  g_free (scale (0.5, PIXOPS_INTERP_HYPER));
+  assert_stats (4, 3);
+
+  /* Nearest neighbour scaling has no filter */
+  g_free (scale (0.5, PIXOPS_INTERP_NEAREST));
+  assert_stats (4, 3);
+}
+
+static void
+test_cache_clear (void)
+{
+  guchar *before, *after;
+
+  _pixops_clear_filter_cache ();
+
+  before = scale (0.3, PIXOPS_INTERP_TILES);
+  g_free (scale (0.3, PIXOPS_INTERP_TILES));
+  assert_stats (1, 1);
+
+  _pixops_clear_filter_cache ();
+  assert_stats (0, 0);
+
+  /* The table is built again, and gives the same result */
+  after = scale (0.3, PIXOPS_INTERP_TILES);
+  assert_stats (0, 1);
+
+  g_assert (memcmp (before, after, 60 * 60 * 4) == 0);
+
+  g_free (before);
+  g_free (after);
+}
+
+static void
+test_cache_oversized (void)
+{
+  _pixops_clear_filter_cache ();
+
+  /* 103 x 103 taps take more than the whole cache, so the table
+   * is built for each call and never kept.
+   */
+  g_free (scale (0.01, PIXOPS_INTERP_HYPER));
+  g_free (scale (0.01, PIXOPS_INTERP_HYPER));
+  assert_stats (0, 2);
+}
+
+int
+main (int argc, char **argv)
+{
+  int i;
+
+  g_test_init (&argc, &argv, NULL);
+
+  src_buf = g_malloc (SRC_SIZE * SRC_SIZE * 4);
+  for (i = 0; i < SRC_SIZE * SRC_SIZE * 4; i++)
+    src_buf[i] = g_test_rand_int_range (0, 256);
+
+  g_test_add_func ("/pixops/filter-cache/hits", test_cache_hits);
+  g_test_add_func ("/pixops/filter-cache/clear", test_cache_clear);
+  g_test_add_func ("/pixops/filter-cache/oversized", test_cache_oversized);
+
+  return g_test_run ();
+}
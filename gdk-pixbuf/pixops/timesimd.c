@@ -0,0 +1,278 @@
+/*
+ * Copyright (C) 2000 Red Hat, Inc
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Runs every scale/composite operation once with the plain C line
+ * functions and once for each SIMD instruction set, checks that the
+ * results are bit-identical and prints the timings side by side.
+ * Exits with a non-zero status if any result differs.
+ */
+#include "config.h"
+#include <glib.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "pixops.h"
+
+#define ITERS 10
+
+typedef enum {
+  OP_SCALE,
+  OP_COMPOSITE,
+  OP_COMPOSITE_COLOR
+} Op;
+
+static const char *op_names[] = { "scale", "composite", "composite color" };
+static const char *interp_names[] = { "NEAREST", "TILES", "BILINEAR", "HYPER" };
+
+static const struct {
+  guint       features;
+  const char *name;
+} feature_sets[] = {
+  { 0,               "C" },
+  { PIXOPS_CPU_SSE2, "SSE2" },
+  { PIXOPS_CPU_AVX2, "AVX2" }
+};
+
+static GTimeVal start_time;
+
+static void
+start_timing (void)
+{
+  g_get_current_time (&start_time);
+}
+
+static double
+stop_timing (void)
+{
+  GTimeVal stop_time;
+
+  g_get_current_time (&stop_time);
+  if (stop_time.tv_usec < start_time.tv_usec)
+    {
+      stop_time.tv_usec += 1000000;
+      stop_time.tv_sec -= 1;
+    }
+
+  return (stop_time.tv_sec - start_time.tv_sec) * 1000. +
+         (stop_time.tv_usec - start_time.tv_usec) / 1000.;
+}
+
+static void
+fill_random (guchar *buf, int len)
+{
+  int i;
+
+  for (i = 0; i < len; i++)
+    buf[i] = g_random_int () & 0xff;
+}
+
+static void
+run_op (Op            op,
+	guchar       *dest_buf,
+	int           dest_width,
+	int           dest_height,
+	int           dest_rowstride,
+	int           dest_channels,
+	int           dest_has_alpha,
+	const guchar *src_buf,
+	int           src_width,
+	int           src_height,
+	int           src_rowstride,
+	int           src_channels,
+	int           src_has_alpha,
+	int           interp_type)
+{
+  double scale_x = (double)dest_width / src_width;
+  double scale_y = (double)dest_height / src_height;
+
+  switch (op)
+    {
+    case OP_SCALE:
+      _pixops_scale (dest_buf, dest_width, dest_height, dest_rowstride,
+		     dest_channels, dest_has_alpha, src_buf, src_width,
+		     src_height, src_rowstride, src_channels, src_has_alpha,
+		     0, 0, dest_width, dest_height, 0, 0, scale_x, scale_y,
+		     interp_type);
+      break;
+    case OP_COMPOSITE:
+      _pixops_composite (dest_buf, dest_width, dest_height, dest_rowstride,
+			 dest_channels, dest_has_alpha, src_buf, src_width,
+			 src_height, src_rowstride, src_channels,
+			 src_has_alpha, 0, 0, dest_width, dest_height, 0, 0,
+			 scale_x, scale_y, interp_type, 200);
+      break;
+    case OP_COMPOSITE_COLOR:
+      _pixops_composite_color (dest_buf, dest_width, dest_height,
+			       dest_rowstride, dest_channels, dest_has_alpha,
+			       src_buf, src_width, src_height, src_rowstride,
+			       src_channels, src_has_alpha, 0, 0, dest_width,
+			       dest_height, 0, 0, scale_x, scale_y,
+			       interp_type, 200, 0, 0, 16,
+			       0xaaaaaa, 0x555555);
+      break;
+    }
+}
+
+static gboolean
+test_sizes (int src_width, int src_height, int dest_width, int dest_height)
+{
+  gboolean success = TRUE;
+  guint available = _pixops_get_cpu_features ();
+  int src_index, dest_index;
+  int filter_level;
+  int k;
+  Op op;
+
+  printf ("Scaling from (%d, %d) to (%d, %d)\n\n", src_width, src_height, dest_width, dest_height);
+  printf ("\t\t\t\t\t\t\tbest msecs of %d\n", ITERS);
+  printf ("src\tdest\tfilter\t\top\t\t");
+  for (k = 0; k < G_N_ELEMENTS (feature_sets); k++)
+    printf ("%s\t", feature_sets[k].name);
+  printf ("\n");
+
+  for (src_index = 0; src_index < 3; src_index++)
+    for (dest_index = 0; dest_index < 3; dest_index++)
+      {
+	int src_channels = (src_index == 0) ? 3 : 4;
+	int src_has_alpha = (src_index == 2);
+	int dest_channels = (dest_index == 0) ? 3 : 4;
+	int dest_has_alpha = (dest_index == 2);
+
+	int src_rowstride = (src_channels*src_width + 3) & ~3;
+	int dest_rowstride = (dest_channels *dest_width + 3) & ~3;
+	int dest_size = dest_rowstride * dest_height;
+
+	guchar *src_buf, *dest_init, *dest_ref, *dest_buf;
+
+	src_buf = g_malloc (src_rowstride * src_height);
+	fill_random (src_buf, src_rowstride * src_height);
+
+	dest_init = g_malloc (dest_size);
+	fill_random (dest_init, dest_size);
+	dest_ref = g_malloc (dest_size);
+	dest_buf = g_malloc (dest_size);
+
+	/* NEAREST does not go through the line functions */
+	for (filter_level = PIXOPS_INTERP_TILES; filter_level <= PIXOPS_INTERP_HYPER; filter_level++)
+	  for (op = OP_SCALE; op <= OP_COMPOSITE_COLOR; op++)
+	    {
+	      int i;
+
+	      if (op == OP_SCALE && src_has_alpha && !dest_has_alpha)
+		continue;
+
+	      printf ("%d%s\t%d%s\t%-8s\t%-16s",
+		      src_channels, src_has_alpha ? "a" : "",
+		      dest_channels, dest_has_alpha ? "a" : "",
+		      interp_names[filter_level], op_names[op]);
+
+	      for (k = 0; k < G_N_ELEMENTS (feature_sets); k++)
+		{
+		  guint features = feature_sets[k].features;
+		  guchar *buf = (k == 0) ? dest_ref : dest_buf;
+		  double msecs, best;
+
+		  if ((available & features) != features)
+		    {
+		      printf ("-\t");
+		      continue;
+		    }
+
+		  _pixops_set_cpu_features (features);
+
+		  memcpy (buf, dest_init, dest_size);
+		  run_op (op, buf, dest_width, dest_height, dest_rowstride,
+			  dest_channels, dest_has_alpha, src_buf, src_width,
+			  src_height, src_rowstride, src_channels,
+			  src_has_alpha, filter_level);
+
+		  if (k != 0 && memcmp (dest_ref, dest_buf, dest_size) != 0)
+		    {
+		      printf ("MISMATCH\t");
+		      success = FALSE;
+		      continue;
+		    }
+
+		  /* Best of ITERS, to be less sensitive to other load.
+		   * Composite reads the destination, so keep the
+		   * reference intact.
+		   */
+		  best = -1;
+		  for (i = 0; i < ITERS; i++)
+		    {
+		      start_timing ();
+		      run_op (op, dest_buf, dest_width, dest_height,
+			      dest_rowstride, dest_channels, dest_has_alpha,
+			      src_buf, src_width, src_height, src_rowstride,
+			      src_channels, src_has_alpha, filter_level);
+		      msecs = stop_timing ();
+
+		      if (best < 0 || msecs < best)
+			best = msecs;
+		    }
+
+		  printf ("%.2f\t", best);
+		}
+	      printf ("\n");
+	    }
+
+	g_free (src_buf);
+	g_free (dest_init);
+	g_free (dest_ref);
+	g_free (dest_buf);
+      }
+
+  printf ("\n");
+  _pixops_set_cpu_features (~0);
+
+  return success;
+}
+
+int main (int argc, char **argv)
+{
+  gboolean success = TRUE;
+
+  g_random_set_seed (42);
+
+  if (argc == 5)
+    {
+      success = test_sizes (atoi (argv[1]), atoi (argv[2]),
+			    atoi (argv[3]), atoi (argv[4]));
+    }
+  else if (argc == 1)
+    {
+      /* Magnification uses the 2x2 filters, minification the general ones */
+      success &= test_sizes (343, 343, 711, 711);
+      success &= test_sizes (1024, 768, 160, 120);
+    }
+  else
+    {
+      fprintf (stderr, "Usage: timesimd [src_width src_height dest_width dest_height]\n");
+      exit(1);
+    }
+
+  if (!success)
+    {
+      fprintf (stderr, "SIMD results differ from the C implementation\n");
+      return 1;
+    }
+
+  return 0;
+}
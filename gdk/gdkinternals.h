@@ -86,7 +86,8 @@ typedef enum {
   GDK_DEBUG_MULTIHEAD	  = 1 <<12,
   GDK_DEBUG_XINERAMA	  = 1 <<13,
   GDK_DEBUG_DRAW	  = 1 <<14,
-  GDK_DEBUG_EVENTLOOP     = 1 <<15
+  GDK_DEBUG_EVENTLOOP     = 1 <<15,
+  GDK_DEBUG_REGIONS       = 1 <<16
 } GdkDebugFlag;
 
 #ifndef GDK_DISABLE_DEPRECATED
@@ -254,6 +255,7 @@ struct _GdkWindowObject
   guint32 clip_tag;
   GdkRegion *clip_region; /* Clip region (wrt toplevel) in window coords */
   GdkRegion *clip_region_with_children; /* Clip region in window coords */
+  GdkRectangle parent_rect; /* Area in the parent at the last clip region update */
   GdkCursor *cursor;
   gint8 toplevel_window_type;
   guint synthesize_crossing_event_queued : 1;
@@ -664,6 +666,12 @@ GdkWindow *_gdk_window_get_input_window_for_event (GdkWindow *native_window,
 						   int x, int y,
 						   gulong serial);
 GdkRegion  *_gdk_region_new_from_yxbanded_rects (GdkRectangle *rects, int n_rects);
+void        _gdk_region_intersect_rect          (GdkRegion          *region,
+						 const GdkRectangle *rect);
+void        _gdk_region_subtract_rect           (GdkRegion          *region,
+						 const GdkRectangle *rect);
+void        _gdk_region_get_alloc_stats         (guint              *n_regions,
+						 guint              *n_rects);
 
 /*****************************
  * offscreen window routines *
@@ -98,6 +98,217 @@ static void miRegionOp   (GdkRegion       *newReg,
 			  nonOverlapFunc   nonOverlap2Fn);
 static void miSetExtents (GdkRegion       *pReg);
 
+/*
+ * The boxes of a region are sorted into bands by y, and by x within a
+ * band, and all boxes of a band have the same y1 and y2. Both y1 and y2
+ * are therefore non-decreasing over the whole array, which lets the
+ * band containing a given y be found by binary search instead of
+ * walking all the boxes above it.
+ */
+
+/* Returns the first box in [first, end) whose band ends below y */
+static GdkRegionBox *
+miFindBand (GdkRegionBox *first,
+	    GdkRegionBox *end,
+	    int           y)
+{
+  while (first < end)
+    {
+      GdkRegionBox *mid = first + (end - first) / 2;
+
+      if (mid->y2 <= y)
+	first = mid + 1;
+      else
+	end = mid;
+    }
+
+  return first;
+}
+
+/* Returns the first box in [first, end) whose band starts at or
+ * below y
+ */
+static GdkRegionBox *
+miFindBandStart (GdkRegionBox *first,
+		 GdkRegionBox *end,
+		 int           y)
+{
+  while (first < end)
+    {
+      GdkRegionBox *mid = first + (end - first) / 2;
+
+      if (mid->y1 < y)
+	first = mid + 1;
+      else
+	end = mid;
+    }
+
+  return first;
+}
+
+/* Returns the first box of the band of @first that ends to the right
+ * of x, or the first box of the next band if there is none.
+ */
+static GdkRegionBox *
+miFindBoxInBand (GdkRegionBox *first,
+		 GdkRegionBox *end,
+		 int           x)
+{
+  int y1 = first->y1;
+
+  while (first < end)
+    {
+      GdkRegionBox *mid = first + (end - first) / 2;
+
+      if (mid->y1 == y1 && mid->x2 <= x)
+	first = mid + 1;
+      else
+	end = mid;
+    }
+
+  return first;
+}
+
+/* Sets up @band as a view of the bands of @region that overlap
+ * [y1, y2). It shares the boxes of @region and must not be modified.
+ */
+static void
+miBandView (const GdkRegion *region,
+	    int              y1,
+	    int              y2,
+	    GdkRegion       *band)
+{
+  GdkRegionBox *end = region->rects + region->numRects;
+  GdkRegionBox *first, *last;
+
+  first = miFindBand (region->rects, end, y1);
+  last = miFindBandStart (first, end, y2);
+
+  band->rects = first;
+  band->numRects = band->size = last - first;
+  band->extents = region->extents;
+  if (band->numRects)
+    {
+      band->extents.y1 = first->y1;
+      band->extents.y2 = (last - 1)->y2;
+    }
+}
+
+#ifdef G_ENABLE_DEBUG
+static guint n_region_allocs = 0;
+guint _gdk_region_n_rects_allocs = 0;
+#define NOTE_REGION_ALLOC() (n_region_allocs++)
+#else
+#define NOTE_REGION_ALLOC()
+#endif
+
+/*
+ * miRegionOp() builds its result in a scratch array and copies it
+ * back into the destination afterwards, so that the destination can
+ * keep its own array when the result fits. The most recently released
+ * scratch array is kept around for the next operation instead of
+ * going back to malloc every time.
+ */
+#define SCRATCH_MAX_SIZE 4096
+
+G_LOCK_DEFINE_STATIC (scratch);
+static GdkRegionBox *scratch_rects = NULL;
+static long          scratch_size = 0;
+
+static GdkRegionBox *
+miScratchAlloc (long  min_size,
+		long *size)
+{
+  GdkRegionBox *rects = NULL;
+
+  G_LOCK (scratch);
+  if (scratch_rects && scratch_size >= min_size)
+    {
+      rects = scratch_rects;
+      *size = scratch_size;
+      scratch_rects = NULL;
+      scratch_size = 0;
+    }
+  G_UNLOCK (scratch);
+
+  if (!rects)
+    {
+      rects = g_new (GdkRegionBox, min_size);
+      *size = min_size;
+      NOTE_RECTS_ALLOC ();
+    }
+
+  return rects;
+}
+
+/* Releases @rects, which must have been allocated with g_new(),
+ * keeping it as scratch space if it is bigger than the current one
+ */
+static void
+miScratchFree (GdkRegionBox *rects,
+	       long          size)
+{
+  if (size <= SCRATCH_MAX_SIZE)
+    {
+      G_LOCK (scratch);
+      if (size > scratch_size)
+	{
+	  GdkRegionBox *tmp = scratch_rects;
+
+	  scratch_rects = rects;
+	  scratch_size = size;
+	  rects = tmp;
+	}
+      G_UNLOCK (scratch);
+    }
+
+  g_free (rects);
+}
+
+/* Sets up @region as a single rectangle region that lives on the stack */
+static void
+miRegionFromRect (GdkRegion          *region,
+		  const GdkRectangle *rect)
+{
+  region->rects = &region->extents;
+  region->size = 1;
+
+  if (rect->width <= 0 || rect->height <= 0)
+    {
+      region->numRects = 0;
+      region->extents.x1 = 0;
+      region->extents.y1 = 0;
+      region->extents.x2 = 0;
+      region->extents.y2 = 0;
+    }
+  else
+    {
+      region->numRects = 1;
+      region->extents.x1 = rect->x;
+      region->extents.y1 = rect->y;
+      region->extents.x2 = rect->x + rect->width;
+      region->extents.y2 = rect->y + rect->height;
+    }
+}
+
+/* Returns the number of regions and rectangle arrays allocated since
+ * the last call, for GDK_DEBUG=regions
+ */
+void
+_gdk_region_get_alloc_stats (guint *n_regions,
+			     guint *n_rects)
+{
+#ifdef G_ENABLE_DEBUG
+  *n_regions = n_region_allocs;
+  *n_rects = _gdk_region_n_rects_allocs;
+  n_region_allocs = 0;
+  _gdk_region_n_rects_allocs = 0;
+#else
+  *n_regions = 0;
+  *n_rects = 0;
+#endif
+}
+
 /**
  * gdk_region_new:
  *
@@ -111,6 +322,7 @@ gdk_region_new (void)
   GdkRegion *temp;
 
   temp = g_slice_new (GdkRegion);
+  NOTE_REGION_ALLOC ();
 
   temp->numRects = 0;
   temp->rects = &temp->extents;
@@ -131,8 +343,10 @@ _gdk_region_new_from_yxbanded_rects (GdkRectangle *rects,
   int i;
 
   temp = g_slice_new (GdkRegion);
+  NOTE_REGION_ALLOC ();
 
   temp->rects = g_new (GdkRegionBox, num_rects);
+  NOTE_RECTS_ALLOC ();
   temp->size = num_rects;
   temp->numRects = num_rects;
   for (i = 0; i < num_rects; i++)
@@ -167,6 +381,7 @@ gdk_region_rectangle (const GdkRectangle *rectangle)
     return gdk_region_new();
 
   temp = g_slice_new (GdkRegion);
+  NOTE_REGION_ALLOC ();
 
   temp->numRects = 1;
   temp->rects = &temp->extents;
@@ -277,18 +492,40 @@ gdk_region_union_with_rect (GdkRegion          *region,
 
   if (rect->width <= 0 || rect->height <= 0)
     return;
-    
-  tmp_region.rects = &tmp_region.extents;
-  tmp_region.numRects = 1;
-  tmp_region.extents.x1 = rect->x;
-  tmp_region.extents.y1 = rect->y;
-  tmp_region.extents.x2 = rect->x + rect->width;
-  tmp_region.extents.y2 = rect->y + rect->height;
-  tmp_region.size = 1;
 
+  miRegionFromRect (&tmp_region, rect);
   gdk_region_union (region, &tmp_region);
 }
 
+/* Like gdk_region_intersect() and gdk_region_subtract() with a region
+ * created by gdk_region_rectangle(), but without allocating it.
+ */
+void
+_gdk_region_intersect_rect (GdkRegion          *region,
+			    const GdkRectangle *rect)
+{
+  GdkRegion tmp_region;
+
+  g_return_if_fail (region != NULL);
+  g_return_if_fail (rect != NULL);
+
+  miRegionFromRect (&tmp_region, rect);
+  gdk_region_intersect (region, &tmp_region);
+}
+
+void
+_gdk_region_subtract_rect (GdkRegion          *region,
+			   const GdkRectangle *rect)
+{
+  GdkRegion tmp_region;
+
+  g_return_if_fail (region != NULL);
+  g_return_if_fail (rect != NULL);
+
+  miRegionFromRect (&tmp_region, rect);
+  gdk_region_subtract (region, &tmp_region);
+}
+
 /*-
  *-----------------------------------------------------------------------
  * miSetExtents --
@@ -604,8 +841,22 @@ gdk_region_intersect (GdkRegion       *source1,
       (!EXTENTCHECK(&source1->extents, &source2->extents)))
     source1->numRects = 0;
   else
-    miRegionOp (source1, source1, source2,
-    		miIntersectO, (nonOverlapFunc) NULL, (nonOverlapFunc) NULL);
+    {
+      GdkRegion band1, band2;
+      int y1, y2;
+
+      /* Only the bands where both regions overlap can contribute */
+      y1 = MAX (source1->extents.y1, source2->extents.y1);
+      y2 = MIN (source1->extents.y2, source2->extents.y2);
+      miBandView (source1, y1, y2, &band1);
+      miBandView (source2, y1, y2, &band2);
+
+      if (band1.numRects == 0 || band2.numRects == 0)
+	source1->numRects = 0;
+      else
+	miRegionOp (source1, &band1, &band2,
+		    miIntersectO, (nonOverlapFunc) NULL, (nonOverlapFunc) NULL);
+    }
     
   /*
    * Can't alter source1's extents before miRegionOp depends on the
@@ -629,6 +880,7 @@ miRegionCopy (GdkRegion       *dstrgn,
 
 	  dstrgn->rects = g_new (GdkRegionBox, rgn->numRects);
 	  dstrgn->size = rgn->numRects;
+	  NOTE_RECTS_ALLOC ();
 	}
 
       dstrgn->numRects = rgn->numRects;
@@ -833,6 +1085,9 @@ miRegionOp(GdkRegion       *newReg,
     int    	  ybot;	    	    	/* Bottom of intersection */
     int  	  ytop;	    	    	/* Top of intersection */
     GdkRegionBox *oldRects;   	    	/* Old rects for newReg */
+    long	  oldSize;		/* Size of oldRects */
+    GdkRegionBox *newRects;		/* Scratch rects for newReg */
+    long	  newSize;		/* Size of newRects */
     int	    	  prevBand;   	    	/* Index of start of
 					 * previous band in newReg */
     int	  	  curBand;    	    	/* Index of start of current
@@ -857,18 +1112,19 @@ miRegionOp(GdkRegion       *newReg,
     r2End = r2 + reg2->numRects;
     
     oldRects = newReg->rects;
+    oldSize = newReg->size;
     
     EMPTY_REGION(newReg);
 
     /*
-     * Allocate a reasonable number of rectangles for the new region. The idea
-     * is to allocate enough so the individual functions don't need to
-     * reallocate and copy the array, which is time consuming, yet we don't
-     * have to worry about using too much memory. I hope to be able to
-     * nuke the Xrealloc() at the end of this function eventually.
+     * Get a reasonable number of rectangles for the new region. The idea
+     * is to have enough so the individual functions don't need to
+     * reallocate and copy the array, which is time consuming. The
+     * scratch array may well be bigger than that, which is fine since
+     * the result is copied out of it at the end.
      */
-    newReg->size = MAX (reg1->numRects, reg2->numRects) * 2;
-    newReg->rects = g_new (GdkRegionBox, newReg->size);
+    newReg->rects = miScratchAlloc (MAX (reg1->numRects, reg2->numRects) * 2,
+				    &newReg->size);
     
     /*
      * Initialize ybot and ytop.
@@ -1043,34 +1299,44 @@ miRegionOp(GdkRegion       *newReg,
     }
 
     /*
-     * A bit of cleanup. To keep regions from growing without bound,
-     * we shrink the array of rectangles to match the new number of
-     * rectangles in the region. This never goes to 0, however...
-     *
-     * Only do this stuff if the number of rectangles allocated is more than
-     * twice the number of rectangles in the region (a simple optimization...).
+     * Move the result out of the scratch array. The regions may share
+     * their rectangles with newReg, but they are not looked at any more.
+     * To keep regions from growing without bound, an array is only kept
+     * if it is at most twice as big as the result. Empty and single
+     * rectangle results don't need an array at all; the extents are set
+     * by the callers afterwards and agree with the single rectangle.
      */
-    if (newReg->numRects < (newReg->size >> 1))
+    newRects = newReg->rects;
+    newSize = newReg->size;
+    if (newReg->numRects <= 1)
       {
 	if (REGION_NOT_EMPTY (newReg))
-	  {
-	    newReg->size = newReg->numRects;
-	    newReg->rects = g_renew (GdkRegionBox, newReg->rects, newReg->size);
-	  }
-	else
-	  {
-	    /*
-	     * No point in doing the extra work involved in an Xrealloc if
-	     * the region is empty
-	     */
-	    newReg->size = 1;
-	    g_free (newReg->rects);
-	    newReg->rects = &newReg->extents;
-	  }
+	  newReg->extents = newRects[0];
+	newReg->rects = &newReg->extents;
+	newReg->size = 1;
+	miScratchFree (newRects, newSize);
+      }
+    else if (oldRects != &newReg->extents &&
+	     newReg->numRects <= oldSize &&
+	     newReg->numRects >= (oldSize >> 1))
+      {
+	memcpy (oldRects, newRects, newReg->numRects * sizeof (GdkRegionBox));
+	miScratchFree (newRects, newSize);
+	newReg->rects = oldRects;
+	newReg->size = oldSize;
+	return;
+      }
+    else if (newReg->numRects < (newSize >> 1))
+      {
+	newReg->size = newReg->numRects;
+	newReg->rects = g_new (GdkRegionBox, newReg->size);
+	NOTE_RECTS_ALLOC ();
+	memcpy (newReg->rects, newRects, newReg->numRects * sizeof (GdkRegionBox));
+	miScratchFree (newRects, newSize);
       }
 
     if (oldRects != &newReg->extents)
-      g_free (oldRects);
+      miScratchFree (oldRects, oldSize);
 }
 
 
@@ -1622,7 +1888,8 @@ gdk_region_point_in (const GdkRegion *region,
 		     int              x,
 		     int              y)
 {
-  int i;
+  GdkRegionBox *pbox;
+  GdkRegionBox *pboxEnd;
 
   g_return_val_if_fail (region != NULL, FALSE);
 
@@ -1630,12 +1897,15 @@ gdk_region_point_in (const GdkRegion *region,
     return FALSE;
   if (!INBOX(region->extents, x, y))
     return FALSE;
-  for (i = 0; i < region->numRects; i++)
-    {
-      if (INBOX (region->rects[i], x, y))
-	return TRUE;
-    }
-  return FALSE;
+
+  pboxEnd = region->rects + region->numRects;
+  pbox = miFindBand (region->rects, pboxEnd, y);
+  if (pbox == pboxEnd || pbox->y1 > y)
+    return FALSE;
+
+  pbox = miFindBoxInBand (pbox, pboxEnd, x);
+
+  return pbox < pboxEnd && INBOX (*pbox, x, y);
 }
 
 /**
@@ -1679,13 +1949,18 @@ gdk_region_rect_in (const GdkRegion    *region,
   partIn = FALSE;
 
     /* can stop when both partOut and partIn are TRUE, or we reach prect->y2 */
-  for (pbox = region->rects, pboxEnd = pbox + region->numRects;
+  pboxEnd = region->rects + region->numRects;
+  for (pbox = miFindBand (region->rects, pboxEnd, ry);
        pbox < pboxEnd;
        pbox++)
     {
 
       if (pbox->y2 <= ry)
-	continue;	/* getting up to speed or skipping remainder of band */
+	{
+	  /* skip the remainder of the band */
+	  pbox = miFindBand (pbox, pboxEnd, ry) - 1;
+	  continue;
+	}
 
       if (pbox->y1 > ry)
 	{
@@ -1696,7 +1971,11 @@ gdk_region_rect_in (const GdkRegion    *region,
 	}
 
       if (pbox->x2 <= rx)
-	continue;		/* not far enough over yet */
+	{
+	  /* not far enough over yet */
+	  pbox = miFindBoxInBand (pbox, pboxEnd, rx) - 1;
+	  continue;
+	}
 
       if (pbox->x1 > rx)
 	{
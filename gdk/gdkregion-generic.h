@@ -83,6 +83,16 @@ struct _GdkRegion
               (idRect)->extents.y2 = (r)->y2;\
         }
 
+/*
+ *   count allocations of rectangle arrays for GDK_DEBUG=regions
+ */
+#ifdef G_ENABLE_DEBUG
+extern guint _gdk_region_n_rects_allocs;
+#define NOTE_RECTS_ALLOC() (_gdk_region_n_rects_allocs++)
+#else
+#define NOTE_RECTS_ALLOC()
+#endif
+
 #define GROWREGION(reg, nRects) {  					   \
 	  if ((nRects) == 0) {						   \
             if ((reg)->rects != &(reg)->extents) {			   \
@@ -93,9 +103,12 @@ struct _GdkRegion
 	  else if ((reg)->rects == &(reg)->extents) {                      \
             (reg)->rects = g_new (GdkRegionBox, (nRects));		   \
             (reg)->rects[0] = (reg)->extents;                              \
+            NOTE_RECTS_ALLOC ();                                           \
           }                                                                \
-          else                                                             \
+          else {                                                           \
             (reg)->rects = g_renew (GdkRegionBox, (reg)->rects, (nRects)); \
+            NOTE_RECTS_ALLOC ();                                           \
+          }                                                                \
 	  (reg)->size = (nRects);                                          \
        }				 
 
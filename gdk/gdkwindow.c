@@ -741,6 +741,15 @@ remove_child_area (GdkWindowObject *private,
       if (gdk_region_rect_in (region, &r) == GDK_OVERLAP_RECTANGLE_OUT)
 	continue;
 
+      /* Plain rectangular child, no need for a temporary region */
+      if (!child->shape &&
+	  private->window_type != GDK_WINDOW_FOREIGN &&
+	  !(for_input && child->input_shape))
+	{
+	  _gdk_region_subtract_rect (region, &r);
+	  continue;
+	}
+
       child_region = gdk_region_rectangle (&r);
 
       if (child->shape)
@@ -900,7 +909,7 @@ recompute_visible_regions_internal (GdkWindowObject *private,
 				    gboolean recalculate_siblings,
 				    gboolean recalculate_children)
 {
-  GdkRectangle r;
+  GdkRectangle r, old_parent_rect;
   GList *l;
   GdkWindowObject *child;
   GdkRegion *new_clip, *old_clip_region_with_children;
@@ -911,6 +920,20 @@ recompute_visible_regions_internal (GdkWindowObject *private,
   old_abs_x = private->abs_x;
   old_abs_y = private->abs_y;
 
+  /* The siblings were last clipped against the area the window had
+   * when its own clip region was last calculated. Every change to the
+   * position of a child window recalculates that, either together
+   * with the siblings or for all children of the parent at once.
+   */
+  old_parent_rect = private->parent_rect;
+  if (recalculate_clip)
+    {
+      private->parent_rect.x = private->x;
+      private->parent_rect.y = private->y;
+      private->parent_rect.width = private->width;
+      private->parent_rect.height = private->height;
+    }
+
   /* Update absolute position */
   if (gdk_window_has_impl (private))
     {
@@ -1050,13 +1073,24 @@ recompute_visible_regions_internal (GdkWindowObject *private,
       !gdk_window_is_toplevel (private))
     {
       /* If we moved a child window in parent or changed the stacking order, then we
-       * need to recompute the visible area of all the other children in the parent
+       * need to recompute the visible area of the other children in the parent.
+       * Only those overlapping the old or the new area of the window can
+       * have been affected, and with many children most of them are not.
        */
       for (l = private->parent->children; l; l = l->next)
 	{
 	  child = l->data;
 
-	  if (child != private)
+	  if (child == private)
+	    continue;
+
+	  r.x = child->x;
+	  r.y = child->y;
+	  r.width = child->width;
+	  r.height = child->height;
+
+	  if (gdk_rectangle_intersect (&r, &private->parent_rect, NULL) ||
+	      gdk_rectangle_intersect (&r, &old_parent_rect, NULL))
 	    recompute_visible_regions_internal (child, TRUE, FALSE, FALSE);
 	}
 
@@ -2814,7 +2848,6 @@ setup_redirect_clip (GdkWindow      *window,
   GdkWindowObject *private = (GdkWindowObject *)window;
   GdkRegion *visible_region;
   GdkRectangle dest_rect;
-  GdkRegion *tmpreg;
   GdkWindow *toplevel;
   int x_offset, y_offset;
 
@@ -2835,9 +2868,7 @@ setup_redirect_clip (GdkWindow      *window,
   dest_rect.y = -y_offset;
   dest_rect.width = private->redirect->width;
   dest_rect.height = private->redirect->height;
-  tmpreg = gdk_region_rectangle (&dest_rect);
-  gdk_region_intersect (visible_region, tmpreg);
-  gdk_region_destroy (tmpreg);
+  _gdk_region_intersect_rect (visible_region, &dest_rect);
 
   /* Compensate for the dest pos */
   x_offset += private->redirect->dest_x;
@@ -5037,6 +5068,13 @@ _gdk_window_process_updates_recurse (GdkWindow *window,
       r.width = child->width;
       r.height = child->height;
 
+      if (child->impl != private->impl && !child->shape)
+	{
+	  /* Native child, just remove area from expose region */
+	  _gdk_region_subtract_rect (expose_region, &r);
+	  continue;
+	}
+
       child_region = gdk_region_rectangle (&r);
       if (child->shape)
 	{
@@ -5359,6 +5397,17 @@ gdk_window_process_all_updates (void)
 
   _gdk_windowing_after_process_all_updates ();
 
+#ifdef G_ENABLE_DEBUG
+  if (_gdk_debug_flags & GDK_DEBUG_REGIONS)
+    {
+      guint n_regions, n_rects;
+
+      _gdk_region_get_alloc_stats (&n_regions, &n_rects);
+      g_message ("regions: %u regions and %u rectangle arrays allocated",
+		 n_regions, n_rects);
+    }
+#endif
+
   in_process_all_updates = FALSE;
 
   /* If we ignored a recursive call, schedule a
@@ -8671,7 +8720,7 @@ _gdk_window_calculate_full_clip_region (GdkWindow *window,
 {
   GdkWindowObject *private = GDK_WINDOW_OBJECT (window);
   GdkRectangle visible_rect;
-  GdkRegion *real_clip_region, *tmpreg;
+  GdkRegion *real_clip_region;
   gint x_offset, y_offset;
   GdkWindowObject *parentwin, *lastwin;
 
@@ -8740,9 +8789,7 @@ _gdk_window_calculate_full_clip_region (GdkWindow *window,
 	      visible_rect.y + visible_rect.height <= real_clip_rect.y)
 	    continue;
 
-	  tmpreg = gdk_region_rectangle (&visible_rect);
-	  gdk_region_subtract (real_clip_region, tmpreg);
-	  gdk_region_destroy (tmpreg);
+	  _gdk_region_subtract_rect (real_clip_region, &visible_rect);
 	}
 
       /* Clip to the parent */
@@ -8751,9 +8798,7 @@ _gdk_window_calculate_full_clip_region (GdkWindow *window,
       visible_rect.x += - x_offset;
       visible_rect.y += - y_offset;
 
-      tmpreg = gdk_region_rectangle (&visible_rect);
-      gdk_region_intersect (real_clip_region, tmpreg);
-      gdk_region_destroy (tmpreg);
+      _gdk_region_intersect_rect (real_clip_region, &visible_rect);
     }
 
   if (base_x_offset)
@@ -0,0 +1,132 @@
+/* region-bench.c - microbenchmark for GdkRegion queries
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Times gdk_region_point_in(), gdk_region_rect_in() and
+ * gdk_region_intersect() on regions with many bands, like the visible
+ * region of a window that is partly covered by lots of children.
+ */
+
+#include <stdlib.h>
+#include <gdk/gdk.h>
+
+#define SIZE 4096
+
+static GdkRegion *
+make_region (gint n_holes)
+{
+  GdkRectangle rect = { 0, 0, SIZE, SIZE };
+  GdkRegion *region, *hole;
+  gint i;
+
+  region = gdk_region_rectangle (&rect);
+  for (i = 0; i < n_holes; i++)
+    {
+      rect.x = g_random_int_range (0, SIZE);
+      rect.y = g_random_int_range (0, SIZE);
+      rect.width = g_random_int_range (1, 64);
+      rect.height = g_random_int_range (1, 64);
+
+      hole = gdk_region_rectangle (&rect);
+      gdk_region_subtract (region, hole);
+      gdk_region_destroy (hole);
+    }
+
+  return region;
+}
+
+static void
+random_rect (GdkRectangle *rect,
+             gint          size)
+{
+  rect->x = g_random_int_range (-size, SIZE);
+  rect->y = g_random_int_range (-size, SIZE);
+  rect->width = size;
+  rect->height = size;
+}
+
+static void
+bench (gint n_holes,
+       gint iterations)
+{
+  GdkRegion *region, *tmp;
+  GdkRectangle rect;
+  GdkRectangle *rects;
+  gint n_rects, i, count;
+  GTimer *timer;
+  gdouble point_in, rect_in, intersect;
+
+  region = make_region (n_holes);
+  gdk_region_get_rectangles (region, &rects, &n_rects);
+  g_free (rects);
+
+  timer = g_timer_new ();
+
+  count = 0;
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++)
+    count += gdk_region_point_in (region,
+                                  g_random_int_range (0, SIZE),
+                                  g_random_int_range (0, SIZE));
+  point_in = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < iterations; i++)
+    {
+      random_rect (&rect, 32);
+      count += gdk_region_rect_in (region, &rect);
+    }
+  rect_in = g_timer_elapsed (timer, NULL);
+
+  g_timer_start (timer);
+  for (i = 0; i < iterations / 10; i++)
+    {
+      random_rect (&rect, 256);
+      tmp = gdk_region_rectangle (&rect);
+      gdk_region_intersect (tmp, region);
+      count += gdk_region_empty (tmp);
+      gdk_region_destroy (tmp);
+    }
+  intersect = g_timer_elapsed (timer, NULL);
+
+  g_print ("%6d\t%8d\t%8.3f\t%8.3f\t%8.3f\n", n_holes, n_rects,
+           point_in * 1e6 / iterations,
+           rect_in * 1e6 / iterations,
+           intersect * 1e6 / (iterations / 10));
+
+  g_timer_destroy (timer);
+  gdk_region_destroy (region);
+}
+
+int
+main (int argc, char **argv)
+{
+  gint iterations = 100000;
+  gint n_holes;
+
+  if (argc > 1)
+    iterations = MAX (atoi (argv[1]), 10);
+
+  g_random_set_seed (42);
+
+  g_print ("usecs per call\n");
+  g_print ("holes\trects\t\tpoint_in\trect_in\t\tintersect\n");
+  for (n_holes = 10; n_holes <= 10000; n_holes *= 10)
+    bench (n_holes, iterations);
+
+  return 0;
+}
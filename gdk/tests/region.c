@@ -0,0 +1,483 @@
+/* region.c - checks GdkRegion and window clip regions against plain
+ * reference computations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* The region tests keep a bitmap next to each region and apply every
+ * operation to both, so the banded queries, the band clipping in
+ * gdk_region_intersect() and the reused rectangle arrays are compared
+ * with a pixel by pixel computation. The window tests move, resize,
+ * restack and hide children and compare the clip region of every
+ * child with one computed from scratch, which is what recalculating
+ * all siblings used to give.
+ */
+
+#include <string.h>
+#include <gdk/gdk.h>
+
+#define GRID 96
+
+typedef struct
+{
+  GdkRegion *region;
+  guchar     bits[GRID][GRID];
+} Shape;
+
+static void
+random_rect (GdkRectangle *rect,
+             gint          min,
+             gint          max,
+             gint          max_size)
+{
+  rect->x = g_test_rand_int_range (min, max - 1);
+  rect->y = g_test_rand_int_range (min, max - 1);
+  rect->width = g_test_rand_int_range (1, MIN (max_size, max - rect->x) + 1);
+  rect->height = g_test_rand_int_range (1, MIN (max_size, max - rect->y) + 1);
+}
+
+static gboolean
+bit (const Shape *shape,
+     gint         x,
+     gint         y)
+{
+  if (x < 0 || y < 0 || x >= GRID || y >= GRID)
+    return FALSE;
+
+  return shape->bits[y][x];
+}
+
+static void
+rasterize (GdkRegion *region,
+           guchar     bits[GRID][GRID])
+{
+  GdkRectangle *rects;
+  gint n_rects, i, x, y;
+
+  memset (bits, 0, GRID * GRID);
+
+  gdk_region_get_rectangles (region, &rects, &n_rects);
+  for (i = 0; i < n_rects; i++)
+    {
+      g_assert_cmpint (rects[i].width, >, 0);
+      g_assert_cmpint (rects[i].height, >, 0);
+      g_assert_cmpint (rects[i].x, >=, 0);
+      g_assert_cmpint (rects[i].y, >=, 0);
+      g_assert_cmpint (rects[i].x + rects[i].width, <=, GRID);
+      g_assert_cmpint (rects[i].y + rects[i].height, <=, GRID);
+
+      /* Boxes are sorted into bands and never overlap */
+      if (i > 0)
+        g_assert (rects[i].y > rects[i - 1].y ||
+                  (rects[i].y == rects[i - 1].y &&
+                   rects[i].height == rects[i - 1].height &&
+                   rects[i].x > rects[i - 1].x + rects[i - 1].width - 1));
+
+      for (y = rects[i].y; y < rects[i].y + rects[i].height; y++)
+        for (x = rects[i].x; x < rects[i].x + rects[i].width; x++)
+          {
+            g_assert (!bits[y][x]);
+            bits[y][x] = 1;
+          }
+    }
+  g_free (rects);
+}
+
+static void
+assert_shape (Shape *shape)
+{
+  guchar bits[GRID][GRID];
+  GdkRectangle extents;
+  gint x, y, x1 = GRID, y1 = GRID, x2 = 0, y2 = 0;
+
+  rasterize (shape->region, bits);
+  g_assert (memcmp (bits, shape->bits, sizeof (bits)) == 0);
+
+  for (y = 0; y < GRID; y++)
+    for (x = 0; x < GRID; x++)
+      if (bits[y][x])
+        {
+          x1 = MIN (x1, x);
+          y1 = MIN (y1, y);
+          x2 = MAX (x2, x + 1);
+          y2 = MAX (y2, y + 1);
+        }
+
+  g_assert_cmpint (gdk_region_empty (shape->region), ==, x2 == 0);
+
+  if (x2 > 0)
+    {
+      gdk_region_get_clipbox (shape->region, &extents);
+      g_assert_cmpint (extents.x, ==, x1);
+      g_assert_cmpint (extents.y, ==, y1);
+      g_assert_cmpint (extents.width, ==, x2 - x1);
+      g_assert_cmpint (extents.height, ==, y2 - y1);
+    }
+}
+
+typedef enum
+{
+  OP_UNION,
+  OP_INTERSECT,
+  OP_SUBTRACT,
+  OP_XOR,
+  N_OPS
+} Op;
+
+static void
+shape_op (Shape       *shape,
+          Op           op,
+          const Shape *other)
+{
+  gint x, y;
+
+  switch (op)
+    {
+    case OP_UNION:
+      gdk_region_union (shape->region, other->region);
+      break;
+    case OP_INTERSECT:
+      gdk_region_intersect (shape->region, other->region);
+      break;
+    case OP_SUBTRACT:
+      gdk_region_subtract (shape->region, other->region);
+      break;
+    case OP_XOR:
+      gdk_region_xor (shape->region, other->region);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  for (y = 0; y < GRID; y++)
+    for (x = 0; x < GRID; x++)
+      {
+        guchar a = shape->bits[y][x], b = other->bits[y][x];
+
+        switch (op)
+          {
+          case OP_UNION:     shape->bits[y][x] = a | b;  break;
+          case OP_INTERSECT: shape->bits[y][x] = a & b;  break;
+          case OP_SUBTRACT:  shape->bits[y][x] = a & !b; break;
+          case OP_XOR:       shape->bits[y][x] = a ^ b;  break;
+          default:           g_assert_not_reached ();
+          }
+      }
+}
+
+static void
+shape_init_rect (Shape        *shape,
+                 GdkRectangle *rect)
+{
+  gint x, y;
+
+  shape->region = gdk_region_rectangle (rect);
+  memset (shape->bits, 0, sizeof (shape->bits));
+  for (y = rect->y; y < rect->y + rect->height; y++)
+    for (x = rect->x; x < rect->x + rect->width; x++)
+      shape->bits[y][x] = 1;
+}
+
+/* A region with many bands, built from random operations */
+static void
+shape_init_random (Shape *shape,
+                   gint   n_ops)
+{
+  GdkRectangle rect;
+  Shape other;
+  gint i;
+
+  shape->region = gdk_region_new ();
+  memset (shape->bits, 0, sizeof (shape->bits));
+
+  for (i = 0; i < n_ops; i++)
+    {
+      random_rect (&rect, 0, GRID, GRID / 2);
+      shape_init_rect (&other, &rect);
+      shape_op (shape, i % 3 == 2 ? OP_SUBTRACT : OP_UNION, &other);
+      gdk_region_destroy (other.region);
+    }
+}
+
+static void
+test_region_ops (void)
+{
+  Shape shape, other;
+  GdkRectangle rect;
+  gint i;
+
+  shape.region = gdk_region_new ();
+  memset (shape.bits, 0, sizeof (shape.bits));
+
+  /* Grow and shrink the region so that the rectangle arrays are reused
+   * for results of every size, including empty and single rectangles.
+   */
+  for (i = 0; i < 2000; i++)
+    {
+      Op op = g_test_rand_int_range (0, N_OPS);
+
+      if (op == OP_INTERSECT && g_test_rand_bit ())
+        shape_init_random (&other, 12);
+      else
+        {
+          random_rect (&rect, 0, GRID, op == OP_INTERSECT ? GRID : GRID / 3);
+          shape_init_rect (&other, &rect);
+        }
+
+      shape_op (&shape, op, &other);
+      gdk_region_destroy (other.region);
+
+      assert_shape (&shape);
+    }
+
+  gdk_region_destroy (shape.region);
+}
+
+static void
+test_region_intersect (void)
+{
+  Shape a, b, a_copy;
+  gint i;
+
+  /* Regions with overlapping and disjoint extents, so that bands are
+   * dropped from either side before the bands are merged.
+   */
+  for (i = 0; i < 200; i++)
+    {
+      shape_init_random (&a, g_test_rand_int_range (1, 40));
+      shape_init_random (&b, g_test_rand_int_range (1, 40));
+
+      a_copy = a;
+      a_copy.region = gdk_region_copy (a.region);
+
+      shape_op (&a, OP_INTERSECT, &b);
+      assert_shape (&a);
+
+      shape_op (&b, OP_INTERSECT, &a_copy);
+      assert_shape (&b);
+
+      g_assert (gdk_region_equal (a.region, b.region));
+
+      gdk_region_destroy (a.region);
+      gdk_region_destroy (b.region);
+      gdk_region_destroy (a_copy.region);
+    }
+}
+
+static void
+test_region_point_in (void)
+{
+  Shape shape;
+  gint i, x, y;
+
+  for (i = 0; i < 50; i++)
+    {
+      shape_init_random (&shape, g_test_rand_int_range (1, 60));
+      assert_shape (&shape);
+
+      for (y = -2; y < GRID + 2; y++)
+        for (x = -2; x < GRID + 2; x++)
+          g_assert_cmpint (gdk_region_point_in (shape.region, x, y), ==,
+                           bit (&shape, x, y));
+
+      gdk_region_destroy (shape.region);
+    }
+}
+
+static void
+test_region_rect_in (void)
+{
+  Shape shape;
+  GdkRectangle rect;
+  GdkOverlapType expected;
+  gint i, j, x, y, n_in;
+
+  for (i = 0; i < 50; i++)
+    {
+      shape_init_random (&shape, g_test_rand_int_range (1, 60));
+
+      for (j = 0; j < 500; j++)
+        {
+          random_rect (&rect, -8, GRID + 8, j % 2 ? 4 : 40);
+
+          n_in = 0;
+          for (y = rect.y; y < rect.y + rect.height; y++)
+            for (x = rect.x; x < rect.x + rect.width; x++)
+              n_in += bit (&shape, x, y);
+
+          if (n_in == 0)
+            expected = GDK_OVERLAP_RECTANGLE_OUT;
+          else if (n_in == rect.width * rect.height)
+            expected = GDK_OVERLAP_RECTANGLE_IN;
+          else
+            expected = GDK_OVERLAP_RECTANGLE_PART;
+
+          g_assert_cmpint (gdk_region_rect_in (shape.region, &rect), ==, expected);
+        }
+
+      gdk_region_destroy (shape.region);
+    }
+}
+
+#define N_CHILDREN 30
+
+static GdkWindow *
+create_window (GdkWindow     *parent,
+               GdkWindowType  window_type,
+               gint           x,
+               gint           y,
+               gint           width,
+               gint           height)
+{
+  GdkWindowAttr attributes;
+
+  attributes.window_type = window_type;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.x = x;
+  attributes.y = y;
+  attributes.width = width;
+  attributes.height = height;
+  attributes.event_mask = 0;
+
+  return gdk_window_new (parent, &attributes, GDK_WA_X | GDK_WA_Y);
+}
+
+/* The clip region of a child without shapes is its area in the parent,
+ * clipped to the parent and without the mapped siblings above it.
+ */
+static GdkRegion *
+expected_clip (GdkWindow *parent,
+               GdkWindow *window)
+{
+  GdkRegion *clip, *tmp;
+  GdkRectangle rect;
+  GList *l;
+  gint x, y;
+
+  if (!gdk_window_is_viewable (window))
+    return gdk_region_new ();
+
+  rect.x = 0;
+  rect.y = 0;
+  gdk_drawable_get_size (parent, &rect.width, &rect.height);
+  clip = gdk_region_rectangle (&rect);
+
+  gdk_window_get_position (window, &rect.x, &rect.y);
+  gdk_drawable_get_size (window, &rect.width, &rect.height);
+  tmp = gdk_region_rectangle (&rect);
+  gdk_region_intersect (clip, tmp);
+  gdk_region_destroy (tmp);
+
+  /* Children are listed from the top of the stack */
+  for (l = gdk_window_peek_children (parent); l->data != window; l = l->next)
+    {
+      if (!gdk_window_is_visible (l->data))
+        continue;
+
+      gdk_window_get_position (l->data, &rect.x, &rect.y);
+      gdk_drawable_get_size (l->data, &rect.width, &rect.height);
+      tmp = gdk_region_rectangle (&rect);
+      gdk_region_subtract (clip, tmp);
+      gdk_region_destroy (tmp);
+    }
+
+  gdk_window_get_position (window, &x, &y);
+  gdk_region_offset (clip, -x, -y);
+
+  return clip;
+}
+
+static void
+test_window_clip (void)
+{
+  GdkWindow *toplevel, *children[N_CHILDREN], *child;
+  GdkRegion *clip, *expected;
+  GdkRectangle rect;
+  gint i, j;
+
+  toplevel = create_window (NULL, GDK_WINDOW_TEMP, 0, 0, GRID, GRID);
+  gdk_window_show (toplevel);
+
+  for (i = 0; i < N_CHILDREN; i++)
+    {
+      random_rect (&rect, -10, GRID + 10, 30);
+      children[i] = create_window (toplevel, GDK_WINDOW_CHILD,
+                                   rect.x, rect.y, rect.width, rect.height);
+      gdk_window_show (children[i]);
+    }
+
+  for (i = 0; i < 1000; i++)
+    {
+      child = children[g_test_rand_int_range (0, N_CHILDREN)];
+      random_rect (&rect, -10, GRID + 10, 30);
+
+      switch (g_test_rand_int_range (0, 7))
+        {
+        case 0:
+          gdk_window_move (child, rect.x, rect.y);
+          break;
+        case 1:
+          gdk_window_resize (child, rect.width, rect.height);
+          break;
+        case 2:
+          gdk_window_move_resize (child, rect.x, rect.y, rect.width, rect.height);
+          break;
+        case 3:
+          gdk_window_raise (child);
+          break;
+        case 4:
+          gdk_window_lower (child);
+          break;
+        case 5:
+          if (gdk_window_is_visible (child))
+            gdk_window_hide (child);
+          else
+            gdk_window_show (child);
+          break;
+        case 6:
+          gdk_window_show (child);
+          break;
+        }
+
+      for (j = 0; j < N_CHILDREN; j++)
+        {
+          clip = gdk_drawable_get_visible_region (children[j]);
+          expected = expected_clip (toplevel, children[j]);
+          g_assert (gdk_region_equal (clip, expected));
+          gdk_region_destroy (clip);
+          gdk_region_destroy (expected);
+        }
+    }
+
+  gdk_window_destroy (toplevel);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/region/ops", test_region_ops);
+  g_test_add_func ("/region/intersect", test_region_intersect);
+  g_test_add_func ("/region/point-in", test_region_point_in);
+  g_test_add_func ("/region/rect-in", test_region_rect_in);
+
+  /* The window tests need a display */
+  if (gdk_init_check (&argc, &argv))
+    g_test_add_func ("/window/child-clip", test_window_clip);
+
+  return g_test_run ();
+}
@@ -122,6 +122,10 @@ enum {
 static guint text_cell_renderer_signals [LAST_SIGNAL];
 
 #define GTK_CELL_RENDERER_TEXT_PATH "gtk-cell-renderer-text-path"
+#define GTK_CELL_RENDERER_TEXT_LAYOUT_CACHE "gtk-cell-renderer-text-layout-cache"
+
+/* Number of layouts kept for each widget */
+#define LAYOUT_CACHE_SIZE 256
 
 #define GTK_CELL_RENDERER_TEXT_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_CELL_RENDERER_TEXT, GtkCellRendererTextPrivate))
 
@@ -1359,51 +1363,256 @@ add_attr (PangoAttrList  *attr_list,
   pango_attr_list_insert (attr_list, attr);
 }
 
-static PangoLayout*
-get_layout (GtkCellRendererText *celltext,
-            GtkWidget           *widget,
-            gboolean             will_render,
-            GtkCellRendererState flags)
+/* Text cells are measured when the rows are validated, and once more
+ * when they are drawn, and the same texts are shown over and over by
+ * the cells of a column. The layouts are therefore kept in a cache on
+ * the widget, with everything that goes into their size as the key.
+ * Attributes that only change how the text is drawn are added to a
+ * copy of the layout when a cell is drawn, see get_render_layout().
+ */
+typedef struct _LayoutCacheEntry LayoutCacheEntry;
+struct _LayoutCacheEntry
 {
-  PangoAttrList *attr_list;
+  gchar *text;
+  PangoAttrList *attrs;
+  gint width;
+  PangoWrapMode wrap_mode;
+  PangoEllipsizeMode ellipsize;
+  PangoAlignment align;
+  gboolean single_paragraph;
+  guint hash;
+
   PangoLayout *layout;
-  PangoUnderline uline;
-  GtkCellRendererTextPrivate *priv;
+  GList link;
+};
 
-  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
-  
-  layout = gtk_widget_create_pango_layout (widget, celltext->text);
+typedef struct _LayoutCache LayoutCache;
+struct _LayoutCache
+{
+  GHashTable *entries;
+  GQueue lru;
+};
 
-  if (celltext->extra_attrs)
-    attr_list = pango_attr_list_copy (celltext->extra_attrs);
-  else
-    attr_list = pango_attr_list_new ();
+static guint
+layout_cache_entry_hash (gconstpointer key)
+{
+  const LayoutCacheEntry *entry = key;
+
+  return entry->hash;
+}
+
+static gboolean
+attr_lists_equal (PangoAttrList *list1,
+                  PangoAttrList *list2)
+{
+  PangoAttrIterator *iter1, *iter2;
+  GSList *attrs1, *attrs2, *l1, *l2;
+  gint start1, end1, start2, end2;
+  gboolean equal = TRUE;
 
-  pango_layout_set_single_paragraph_mode (layout, priv->single_paragraph);
+  iter1 = pango_attr_list_get_iterator (list1);
+  iter2 = pango_attr_list_get_iterator (list2);
 
-  if (will_render)
+  do
     {
-      /* Add options that affect appearance but not size */
-      
-      /* note that background doesn't go here, since it affects
-       * background_area not the PangoLayout area
-       */
-      
-      if (celltext->foreground_set
-	  && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
+      pango_attr_iterator_range (iter1, &start1, &end1);
+      pango_attr_iterator_range (iter2, &start2, &end2);
+      if (start1 != start2 || end1 != end2)
         {
-          PangoColor color;
+          equal = FALSE;
+          break;
+        }
+
+      attrs1 = pango_attr_iterator_get_attrs (iter1);
+      attrs2 = pango_attr_iterator_get_attrs (iter2);
+
+      for (l1 = attrs1, l2 = attrs2; l1 && l2; l1 = l1->next, l2 = l2->next)
+        if (!pango_attribute_equal (l1->data, l2->data))
+          break;
+
+      if (l1 || l2)
+        equal = FALSE;
+
+      g_slist_foreach (attrs1, (GFunc) pango_attribute_destroy, NULL);
+      g_slist_free (attrs1);
+      g_slist_foreach (attrs2, (GFunc) pango_attribute_destroy, NULL);
+      g_slist_free (attrs2);
+
+      if (!equal)
+        break;
 
-          color = celltext->foreground;
-          
-          add_attr (attr_list,
-                    pango_attr_foreground_new (color.red, color.green, color.blue));
+      if (pango_attr_iterator_next (iter1) != pango_attr_iterator_next (iter2))
+        {
+          equal = FALSE;
+          break;
         }
+    }
+  while (end1 != G_MAXINT);
+
+  pango_attr_iterator_destroy (iter1);
+  pango_attr_iterator_destroy (iter2);
+
+  return equal;
+}
+
+static gboolean
+layout_cache_entry_equal (gconstpointer a,
+                          gconstpointer b)
+{
+  const LayoutCacheEntry *entry1 = a;
+  const LayoutCacheEntry *entry2 = b;
+
+  return entry1->hash == entry2->hash &&
+         entry1->width == entry2->width &&
+         entry1->wrap_mode == entry2->wrap_mode &&
+         entry1->ellipsize == entry2->ellipsize &&
+         entry1->align == entry2->align &&
+         entry1->single_paragraph == entry2->single_paragraph &&
+         g_strcmp0 (entry1->text, entry2->text) == 0 &&
+         attr_lists_equal (entry1->attrs, entry2->attrs);
+}
+
+static void
+layout_cache_entry_free (LayoutCacheEntry *entry)
+{
+  g_free (entry->text);
+  pango_attr_list_unref (entry->attrs);
+  g_object_unref (entry->layout);
+  g_slice_free (LayoutCacheEntry, entry);
+}
 
-      if (celltext->strikethrough_set)
-        add_attr (attr_list,
-                  pango_attr_strikethrough_new (celltext->strikethrough));
+static void
+layout_cache_clear (LayoutCache *cache)
+{
+  LayoutCacheEntry *entry;
+
+  g_hash_table_remove_all (cache->entries);
+
+  while (cache->lru.head)
+    {
+      entry = cache->lru.head->data;
+      g_queue_unlink (&cache->lru, &entry->link);
+      layout_cache_entry_free (entry);
     }
+}
+
+static void
+layout_cache_free (LayoutCache *cache)
+{
+  layout_cache_clear (cache);
+  g_hash_table_destroy (cache->entries);
+  g_slice_free (LayoutCache, cache);
+}
+
+static LayoutCache *
+layout_cache_get (GtkWidget *widget)
+{
+  LayoutCache *cache;
+
+  cache = g_object_get_data (G_OBJECT (widget), GTK_CELL_RENDERER_TEXT_LAYOUT_CACHE);
+  if (cache)
+    return cache;
+
+  cache = g_slice_new (LayoutCache);
+  cache->entries = g_hash_table_new (layout_cache_entry_hash,
+                                     layout_cache_entry_equal);
+  g_queue_init (&cache->lru);
+
+  g_object_set_data_full (G_OBJECT (widget), GTK_CELL_RENDERER_TEXT_LAYOUT_CACHE,
+                          cache, (GDestroyNotify) layout_cache_free);
+
+  /* The layouts depend on the font and direction of the widget */
+  g_signal_connect_swapped (widget, "style-set",
+                            G_CALLBACK (layout_cache_clear), cache);
+  g_signal_connect_swapped (widget, "direction-changed",
+                            G_CALLBACK (layout_cache_clear), cache);
+  g_signal_connect_swapped (widget, "screen-changed",
+                            G_CALLBACK (layout_cache_clear), cache);
+
+  return cache;
+}
+
+static void
+layout_setup (PangoLayout            *layout,
+              const LayoutCacheEntry *key)
+{
+  pango_layout_set_single_paragraph_mode (layout, key->single_paragraph);
+  pango_layout_set_ellipsize (layout, key->ellipsize);
+  pango_layout_set_width (layout, key->width);
+  pango_layout_set_wrap (layout, key->wrap_mode);
+  pango_layout_set_alignment (layout, key->align);
+  pango_layout_set_attributes (layout, key->attrs);
+}
+
+/* Returns a new reference to a layout for @key. The attribute list
+ * of @key is taken over.
+ */
+static PangoLayout *
+layout_cache_lookup (GtkWidget        *widget,
+                     LayoutCacheEntry *key)
+{
+  LayoutCache *cache;
+  LayoutCacheEntry *entry;
+
+  cache = layout_cache_get (widget);
+
+  key->hash = key->text ? g_str_hash (key->text) : 0;
+  key->hash = key->hash * 31 + key->width;
+  key->hash = key->hash * 31 + (key->wrap_mode << 8 | key->ellipsize << 4 | key->align);
+  key->hash = key->hash * 31 + key->single_paragraph;
+
+  entry = g_hash_table_lookup (cache->entries, key);
+  if (entry)
+    {
+      pango_attr_list_unref (key->attrs);
+
+      g_queue_unlink (&cache->lru, &entry->link);
+      g_queue_push_head_link (&cache->lru, &entry->link);
+
+      return g_object_ref (entry->layout);
+    }
+
+  entry = g_slice_new (LayoutCacheEntry);
+  *entry = *key;
+  entry->text = g_strdup (key->text);
+  entry->link.data = entry;
+  entry->link.prev = entry->link.next = NULL;
+
+  entry->layout = gtk_widget_create_pango_layout (widget, entry->text);
+  layout_setup (entry->layout, entry);
+
+  g_hash_table_insert (cache->entries, entry, entry);
+  g_queue_push_head_link (&cache->lru, &entry->link);
+
+  if (cache->lru.length > LAYOUT_CACHE_SIZE)
+    {
+      LayoutCacheEntry *last = cache->lru.tail->data;
+
+      g_hash_table_remove (cache->entries, last);
+      g_queue_unlink (&cache->lru, &last->link);
+      layout_cache_entry_free (last);
+    }
+
+  return g_object_ref (entry->layout);
+}
+
+/* Fills in everything that goes into the size of the layout for the
+ * current cell data, except for the hash.
+ */
+static void
+get_layout_key (GtkCellRendererText *celltext,
+                GtkWidget           *widget,
+                LayoutCacheEntry    *key)
+{
+  PangoAttrList *attr_list;
+  GtkCellRendererTextPrivate *priv;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (celltext);
+  
+  if (celltext->extra_attrs)
+    attr_list = pango_attr_list_copy (celltext->extra_attrs);
+  else
+    attr_list = pango_attr_list_new ();
 
   add_attr (attr_list, pango_attr_font_desc_new (celltext->font));
 
@@ -1411,14 +1620,85 @@ get_layout (GtkCellRendererText *celltext,
       celltext->font_scale != 1.0)
     add_attr (attr_list, pango_attr_scale_new (celltext->font_scale));
   
+  if (priv->language_set)
+    add_attr (attr_list, pango_attr_language_new (priv->language));
+  
+  if (celltext->rise_set)
+    add_attr (attr_list, pango_attr_rise_new (celltext->rise));
+
+  key->text = celltext->text;
+  key->attrs = attr_list;
+  key->single_paragraph = priv->single_paragraph;
+
+  if (priv->ellipsize_set)
+    key->ellipsize = priv->ellipsize;
+  else
+    key->ellipsize = PANGO_ELLIPSIZE_NONE;
+
+  if (priv->wrap_width != -1)
+    {
+      key->width = priv->wrap_width * PANGO_SCALE;
+      key->wrap_mode = priv->wrap_mode;
+    }
+  else
+    {
+      key->width = -1;
+      key->wrap_mode = PANGO_WRAP_CHAR;
+    }
+
+  if (priv->align_set)
+    key->align = priv->align;
+  else
+    {
+      if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
+	key->align = PANGO_ALIGN_RIGHT;
+      else
+	key->align = PANGO_ALIGN_LEFT;
+    }
+}
+
+static PangoLayout*
+get_layout (GtkCellRendererText *celltext,
+            GtkWidget           *widget)
+{
+  LayoutCacheEntry key;
+
+  get_layout_key (celltext, widget, &key);
+
+  return layout_cache_lookup (widget, &key);
+}
+
+/* Options that affect appearance but not size. Note that background
+ * doesn't go here, since it affects background_area not the
+ * PangoLayout area.
+ */
+static GSList *
+get_render_attrs (GtkCellRendererText *celltext,
+                  GtkCellRendererState flags)
+{
+  GSList *attrs = NULL;
+  PangoUnderline uline;
+
+  if (celltext->foreground_set
+      && (flags & GTK_CELL_RENDERER_SELECTED) == 0)
+    {
+      PangoColor color;
+
+      color = celltext->foreground;
+
+      attrs = g_slist_prepend (attrs,
+                               pango_attr_foreground_new (color.red, color.green, color.blue));
+    }
+
+  if (celltext->strikethrough_set)
+    attrs = g_slist_prepend (attrs,
+                             pango_attr_strikethrough_new (celltext->strikethrough));
+
   if (celltext->underline_set)
     uline = celltext->underline_style;
   else
     uline = PANGO_UNDERLINE_NONE;
 
-  if (priv->language_set)
-    add_attr (attr_list, pango_attr_language_new (priv->language));
-  
   if ((flags & GTK_CELL_RENDERER_PRELIT) == GTK_CELL_RENDERER_PRELIT)
     {
       switch (uline)
@@ -1437,46 +1717,52 @@ get_layout (GtkCellRendererText *celltext,
     }
 
   if (uline != PANGO_UNDERLINE_NONE)
-    add_attr (attr_list, pango_attr_underline_new (celltext->underline_style));
+    attrs = g_slist_prepend (attrs,
+                             pango_attr_underline_new (celltext->underline_style));
 
-  if (celltext->rise_set)
-    add_attr (attr_list, pango_attr_rise_new (celltext->rise));
+  return g_slist_reverse (attrs);
+}
 
-  if (priv->ellipsize_set)
-    pango_layout_set_ellipsize (layout, priv->ellipsize);
-  else
-    pango_layout_set_ellipsize (layout, PANGO_ELLIPSIZE_NONE);
+/* Returns the layout to draw the cell with. The cached @layout is
+ * shared by all cells showing the same text, so the attributes that
+ * only change how the text is drawn, and the width of the cell for
+ * ellipsized text, go into a copy of it. @render_attrs is taken over.
+ */
+static PangoLayout *
+get_render_layout (PangoLayout *layout,
+                   GSList      *render_attrs,
+                   gboolean     ellipsize,
+                   gint         width)
+{
+  PangoLayout *copy;
+  PangoAttrList *attr_list;
+  GSList *l;
 
-  if (priv->wrap_width != -1)
-    {
-      pango_layout_set_width (layout, priv->wrap_width * PANGO_SCALE);
-      pango_layout_set_wrap (layout, priv->wrap_mode);
-    }
-  else
-    {
-      pango_layout_set_width (layout, -1);
-      pango_layout_set_wrap (layout, PANGO_WRAP_CHAR);
-    }
+  if (!render_attrs && !ellipsize)
+    return g_object_ref (layout);
 
-  if (priv->align_set)
-    pango_layout_set_alignment (layout, priv->align);
-  else
-    {
-      PangoAlignment align;
+  copy = pango_layout_copy (layout);
 
-      if (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL)
-	align = PANGO_ALIGN_RIGHT;
+  if (render_attrs)
+    {
+      attr_list = pango_layout_get_attributes (layout);
+      if (attr_list)
+        attr_list = pango_attr_list_copy (attr_list);
       else
-	align = PANGO_ALIGN_LEFT;
+        attr_list = pango_attr_list_new ();
+
+      for (l = render_attrs; l; l = l->next)
+        add_attr (attr_list, l->data);
+      g_slist_free (render_attrs);
 
-      pango_layout_set_alignment (layout, align);
+      pango_layout_set_attributes (copy, attr_list);
+      pango_attr_list_unref (attr_list);
     }
 
-  pango_layout_set_attributes (layout, attr_list);
+  if (ellipsize)
+    pango_layout_set_width (copy, width);
 
-  pango_attr_list_unref (attr_list);
-  
-  return layout;
+  return copy;
 }
 
 static void
@@ -1537,7 +1823,7 @@ get_size (GtkCellRenderer *cell,
   if (layout)
     g_object_ref (layout);
   else
-    layout = get_layout (celltext, widget, FALSE, 0);
+    layout = get_layout (celltext, widget);
 
   pango_layout_get_pixel_extents (layout, NULL, &rect);
 
@@ -1619,7 +1905,7 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
 
 {
   GtkCellRendererText *celltext = (GtkCellRendererText *) cell;
-  PangoLayout *layout;
+  PangoLayout *layout, *cached;
   GtkStateType state;
   gint x_offset;
   gint y_offset;
@@ -1627,8 +1913,13 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
 
   priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (cell);
 
-  layout = get_layout (celltext, widget, TRUE, flags);
-  get_size (cell, widget, cell_area, layout, &x_offset, &y_offset, NULL, NULL);
+  cached = get_layout (celltext, widget);
+  get_size (cell, widget, cell_area, cached, &x_offset, &y_offset, NULL, NULL);
+
+  layout = get_render_layout (cached, get_render_attrs (celltext, flags),
+                              priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE,
+                              (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE);
+  g_object_unref (cached);
 
   if (!cell->sensitive) 
     {
@@ -1675,12 +1966,6 @@ gtk_cell_renderer_text_render (GtkCellRenderer      *cell,
       cairo_destroy (cr);
     }
 
-  if (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE)
-    pango_layout_set_width (layout, 
-			    (cell_area->width - x_offset - 2 * cell->xpad) * PANGO_SCALE);
-  else if (priv->wrap_width == -1)
-    pango_layout_set_width (layout, -1);
-
   gtk_paint_layout (widget->style,
                     window,
                     state,
@@ -1924,5 +2209,120 @@ gtk_cell_renderer_text_set_fixed_height_from_font (GtkCellRendererText *renderer
     }
 }
 
+/* Measuring text cells away from the widget: everything that the size
+ * depends on is copied from the cell, so that the text can be shaped
+ * later, in another thread, with a #PangoContext set up like the one
+ * of the widget.
+ */
+struct _GtkCellRendererTextMeasure
+{
+  LayoutCacheEntry key;
+  gint xpad;
+  gint ypad;
+  gint fixed_width;
+  gint fixed_height;
+
+  gint width;
+  gint height;
+};
+
+/* Returns %NULL if @cell has to be measured with
+ * gtk_cell_renderer_get_size() instead.
+ */
+GtkCellRendererTextMeasure *
+_gtk_cell_renderer_text_measure_new (GtkCellRenderer *cell,
+                                     GtkWidget       *widget)
+{
+  GtkCellRendererText *celltext = (GtkCellRendererText *) cell;
+  GtkCellRendererTextMeasure *measure;
+  GtkCellRendererTextPrivate *priv;
+
+  if (GTK_CELL_RENDERER_GET_CLASS (cell)->get_size != gtk_cell_renderer_text_get_size ||
+      celltext->calc_fixed_height ||
+      (cell->width != -1 && cell->height != -1))
+    return NULL;
+
+  priv = GTK_CELL_RENDERER_TEXT_GET_PRIVATE (cell);
+
+  measure = g_slice_new (GtkCellRendererTextMeasure);
+  get_layout_key (celltext, widget, &measure->key);
+  measure->key.text = g_strdup (measure->key.text);
+  measure->key.layout = NULL;
+
+  measure->xpad = cell->xpad;
+  measure->ypad = cell->ypad;
+  measure->fixed_width = cell->width;
+  measure->fixed_height = cell->height;
+
+  /* Same as in get_size() */
+  if (measure->fixed_width == -1 && (priv->ellipsize || priv->width_chars > 0))
+    {
+      PangoContext *context;
+      PangoFontMetrics *metrics;
+      gint char_width;
+
+      context = gtk_widget_get_pango_context (widget);
+      metrics = pango_context_get_metrics (context, widget->style->font_desc, pango_context_get_language (context));
+
+      char_width = pango_font_metrics_get_approximate_char_width (metrics);
+      pango_font_metrics_unref (metrics);
+
+      measure->fixed_width = cell->xpad * 2 + (PANGO_PIXELS (char_width) * MAX (priv->width_chars, 3));
+    }
+
+  measure->width = 0;
+  measure->height = 0;
+
+  return measure;
+}
+
+/* Shapes the text with @context. This only uses @measure and @context,
+ * so it can be called from any thread.
+ */
+void
+_gtk_cell_renderer_text_measure_run (GtkCellRendererTextMeasure *measure,
+                                     PangoContext               *context)
+{
+  PangoLayout *layout;
+  PangoRectangle rect;
+
+  layout = pango_layout_new (context);
+  if (measure->key.text)
+    pango_layout_set_text (layout, measure->key.text, -1);
+  layout_setup (layout, &measure->key);
+
+  pango_layout_get_pixel_extents (layout, NULL, &rect);
+  g_object_unref (layout);
+
+  if (measure->fixed_width != -1)
+    measure->width = measure->fixed_width;
+  else
+    measure->width = measure->xpad * 2 + rect.x + rect.width;
+
+  if (measure->fixed_height != -1)
+    measure->height = measure->fixed_height;
+  else
+    measure->height = measure->ypad * 2 + rect.height;
+}
+
+void
+_gtk_cell_renderer_text_measure_get_size (GtkCellRendererTextMeasure *measure,
+                                          gint                       *width,
+                                          gint                       *height)
+{
+  if (width)
+    *width = measure->width;
+  if (height)
+    *height = measure->height;
+}
+
+void
+_gtk_cell_renderer_text_measure_free (GtkCellRendererTextMeasure *measure)
+{
+  g_free (measure->key.text);
+  pango_attr_list_unref (measure->key.attrs);
+  g_slice_free (GtkCellRendererTextMeasure, measure);
+}
+
 #define __GTK_CELL_RENDERER_TEXT_C__
 #include "gtkaliasdef.c"
@@ -0,0 +1,2147 @@
+/* gtkcolumnstore.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/**
+ * SECTION:gtkcolumnstore
+ * @title: GtkColumnStore
+ * @short_description: A list-like data structure that stores each column in one array
+ * @see_also: #GtkListStore, #GtkTreeModel
+ *
+ * The #GtkColumnStore object is a list model for use with a #GtkTreeView
+ * widget. It implements the #GtkTreeModel and #GtkTreeSortable
+ * interfaces and is used in the same way as a #GtkListStore, but it is
+ * laid out for very long lists rather than for lists that change shape
+ * a lot.
+ *
+ * Instead of allocating a chain of cells for every row, a
+ * #GtkColumnStore keeps the values of each column in one contiguous
+ * array indexed by row number. Numeric columns take exactly the size of
+ * their values, and strings are copied into a shared arena which is
+ * compacted as rows are removed or overwritten. Sorting on a column
+ * that uses the default comparison works directly on these arrays.
+ *
+ * The price for this is that inserting or removing a row in the middle
+ * of the list moves all rows after it, and that a #GtkTreeIter only
+ * stays valid until the next row is inserted before it, removed or
+ * reordered; appending rows does not invalidate existing iters. Use a
+ * #GtkTreeRowReference if you need to keep track of a row.
+ *
+ * #GtkColumnStore does not support drag and drop reordering and cannot
+ * be created from #GtkBuilder UI definitions.
+ *
+ * Since: 2.20
+ */
+
+#include "config.h"
+#include <string.h>
+#include <gobject/gvaluecollector.h>
+#include "gtkcolumnstore.h"
+#include "gtktreedatalist.h"
+#include "gtkintl.h"
+#include "gtkalias.h"
+
+/* Strings are copied into a GStringChunk; once more than half of the
+ * bytes in it belong to strings that were removed or overwritten, the
+ * live strings are copied into a fresh chunk.
+ */
+#define STRING_CHUNK_SIZE       4096
+#define STRING_COMPACT_MIN      (64 * STRING_CHUNK_SIZE)
+
+#define GTK_COLUMN_STORE_IS_SORTED(store) ((store)->priv->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+#define ITER_ROW(iter) (GPOINTER_TO_INT ((iter)->user_data))
+#define VALID_ITER(iter, store) ((iter) != NULL && (store)->priv->stamp == (iter)->stamp && ITER_ROW (iter) >= 0 && ITER_ROW (iter) < (store)->priv->n_rows)
+
+typedef enum
+{
+  COLUMN_INT,
+  COLUMN_LONG,
+  COLUMN_INT64,
+  COLUMN_FLOAT,
+  COLUMN_DOUBLE,
+  COLUMN_STRING,
+  COLUMN_POINTER
+} ColumnKind;
+
+typedef struct
+{
+  GType type;
+  GType fundamental;
+  ColumnKind kind;
+  gsize elt_size;
+  gchar *data;
+} Column;
+
+#define COLUMN_ELT(column, row) ((column)->data + (gsize) (row) * (column)->elt_size)
+
+typedef union
+{
+  gint v_int;
+  glong v_long;
+  gint64 v_int64;
+  gfloat v_float;
+  gdouble v_double;
+  gpointer v_pointer;
+} ColumnValue;
+
+struct _GtkColumnStorePrivate
+{
+  gint stamp;
+
+  Column *columns;
+  gint n_columns;
+  gint n_rows;
+  gint n_alloc;
+
+  GStringChunk *strings;
+  gsize string_bytes;
+  gsize live_string_bytes;
+
+  gint sort_column_id;
+  GtkSortType order;
+  GList *sort_list;
+
+  GtkTreeIterCompareFunc default_sort_func;
+  gpointer default_sort_data;
+  GDestroyNotify default_sort_destroy;
+};
+
+typedef struct
+{
+  GtkColumnStore *store;
+  GtkTreeIterCompareFunc func;
+  gpointer data;
+  Column *column;
+} SortData;
+
+static void         gtk_column_store_tree_model_init (GtkTreeModelIface *iface);
+static void         gtk_column_store_sortable_init   (GtkTreeSortableIface *iface);
+static void         gtk_column_store_finalize        (GObject           *object);
+static GtkTreeModelFlags gtk_column_store_get_flags  (GtkTreeModel      *tree_model);
+static gint         gtk_column_store_get_n_columns   (GtkTreeModel      *tree_model);
+static GType        gtk_column_store_get_column_type (GtkTreeModel      *tree_model,
+						      gint               index);
+static gboolean     gtk_column_store_get_iter        (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreePath       *path);
+static GtkTreePath *gtk_column_store_get_path        (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static void         gtk_column_store_get_value       (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      gint               column,
+						      GValue            *value);
+static gboolean     gtk_column_store_iter_next       (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_children   (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *parent);
+static gboolean     gtk_column_store_iter_has_child  (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gint         gtk_column_store_iter_n_children (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter);
+static gboolean     gtk_column_store_iter_nth_child  (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *parent,
+						      gint               n);
+static gboolean     gtk_column_store_iter_parent     (GtkTreeModel      *tree_model,
+						      GtkTreeIter       *iter,
+						      GtkTreeIter       *child);
+
+static void gtk_column_store_set_column_types (GtkColumnStore *column_store,
+					       gint            n_columns,
+					       GType          *types);
+static void gtk_column_store_increment_stamp  (GtkColumnStore *column_store);
+static void gtk_column_store_set_finish       (GtkColumnStore *column_store,
+					       GtkTreeIter    *iter,
+					       gboolean        emit_signal,
+					       gboolean        maybe_need_sort);
+
+/* sortable */
+static void     gtk_column_store_sort                  (GtkColumnStore         *column_store);
+static void     gtk_column_store_sort_iter_changed     (GtkColumnStore         *column_store,
+							GtkTreeIter            *iter);
+static gboolean gtk_column_store_get_sort_column_id    (GtkTreeSortable        *sortable,
+							gint                   *sort_column_id,
+							GtkSortType            *order);
+static void     gtk_column_store_set_sort_column_id    (GtkTreeSortable        *sortable,
+							gint                    sort_column_id,
+							GtkSortType             order);
+static void     gtk_column_store_set_sort_func         (GtkTreeSortable        *sortable,
+							gint                    sort_column_id,
+							GtkTreeIterCompareFunc  func,
+							gpointer                data,
+							GDestroyNotify          destroy);
+static void     gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+							GtkTreeIterCompareFunc  func,
+							gpointer                data,
+							GDestroyNotify          destroy);
+static gboolean gtk_column_store_has_default_sort_func (GtkTreeSortable        *sortable);
+
+G_DEFINE_TYPE_WITH_CODE (GtkColumnStore, gtk_column_store, G_TYPE_OBJECT,
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
+						gtk_column_store_tree_model_init)
+			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_SORTABLE,
+						gtk_column_store_sortable_init))
+
+
+static void
+gtk_column_store_class_init (GtkColumnStoreClass *class)
+{
+  GObjectClass *object_class;
+
+  object_class = (GObjectClass*) class;
+
+  object_class->finalize = gtk_column_store_finalize;
+
+  g_type_class_add_private (object_class, sizeof (GtkColumnStorePrivate));
+}
+
+static void
+gtk_column_store_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = gtk_column_store_get_flags;
+  iface->get_n_columns = gtk_column_store_get_n_columns;
+  iface->get_column_type = gtk_column_store_get_column_type;
+  iface->get_iter = gtk_column_store_get_iter;
+  iface->get_path = gtk_column_store_get_path;
+  iface->get_value = gtk_column_store_get_value;
+  iface->iter_next = gtk_column_store_iter_next;
+  iface->iter_children = gtk_column_store_iter_children;
+  iface->iter_has_child = gtk_column_store_iter_has_child;
+  iface->iter_n_children = gtk_column_store_iter_n_children;
+  iface->iter_nth_child = gtk_column_store_iter_nth_child;
+  iface->iter_parent = gtk_column_store_iter_parent;
+}
+
+static void
+gtk_column_store_sortable_init (GtkTreeSortableIface *iface)
+{
+  iface->get_sort_column_id = gtk_column_store_get_sort_column_id;
+  iface->set_sort_column_id = gtk_column_store_set_sort_column_id;
+  iface->set_sort_func = gtk_column_store_set_sort_func;
+  iface->set_default_sort_func = gtk_column_store_set_default_sort_func;
+  iface->has_default_sort_func = gtk_column_store_has_default_sort_func;
+}
+
+static void
+gtk_column_store_init (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+
+  priv = column_store->priv = G_TYPE_INSTANCE_GET_PRIVATE (column_store,
+							   GTK_TYPE_COLUMN_STORE,
+							   GtkColumnStorePrivate);
+
+  priv->stamp = g_random_int ();
+  priv->strings = g_string_chunk_new (STRING_CHUNK_SIZE);
+  priv->sort_column_id = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+}
+
+/**
+ * gtk_column_store_new:
+ * @n_columns: number of columns in the column store
+ * @Varargs: all #GType types for the columns, from first to last
+ *
+ * Creates a new column store with @n_columns columns each of the types
+ * passed in. The same types as for gtk_list_store_new() are supported.
+ *
+ * Return value: a new #GtkColumnStore
+ *
+ * Since: 2.20
+ **/
+GtkColumnStore *
+gtk_column_store_new (gint n_columns,
+		      ...)
+{
+  GtkColumnStore *retval;
+  GType *types;
+  va_list args;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  types = g_new (GType, n_columns);
+
+  va_start (args, n_columns);
+  for (i = 0; i < n_columns; i++)
+    types[i] = va_arg (args, GType);
+  va_end (args);
+
+  retval = gtk_column_store_newv (n_columns, types);
+  g_free (types);
+
+  return retval;
+}
+
+/**
+ * gtk_column_store_newv:
+ * @n_columns: number of columns in the column store
+ * @types: an array of #GType types for the columns, from first to last
+ *
+ * Non-vararg creation function.  Used primarily by language bindings.
+ *
+ * Return value: a new #GtkColumnStore
+ *
+ * Since: 2.20
+ **/
+GtkColumnStore *
+gtk_column_store_newv (gint   n_columns,
+		       GType *types)
+{
+  GtkColumnStore *retval;
+  gint i;
+
+  g_return_val_if_fail (n_columns > 0, NULL);
+
+  for (i = 0; i < n_columns; i++)
+    {
+      if (! _gtk_tree_data_list_check_type (types[i]))
+	{
+	  g_warning ("%s: Invalid type %s\n", G_STRLOC, g_type_name (types[i]));
+	  return NULL;
+	}
+    }
+
+  retval = g_object_new (GTK_TYPE_COLUMN_STORE, NULL);
+  gtk_column_store_set_column_types (retval, n_columns, types);
+
+  return retval;
+}
+
+/* Same as in gtktreedatalist.c */
+static inline GType
+get_fundamental_type (GType type)
+{
+  GType result;
+
+  result = G_TYPE_FUNDAMENTAL (type);
+
+  if (result == G_TYPE_INTERFACE)
+    {
+      if (g_type_is_a (type, G_TYPE_OBJECT))
+	result = G_TYPE_OBJECT;
+    }
+
+  return result;
+}
+
+static void
+gtk_column_store_set_column_types (GtkColumnStore *column_store,
+				   gint            n_columns,
+				   GType          *types)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  priv->n_columns = n_columns;
+  priv->columns = g_new0 (Column, n_columns);
+
+  for (i = 0; i < n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+
+      column->type = types[i];
+      column->fundamental = get_fundamental_type (types[i]);
+
+      switch (column->fundamental)
+	{
+	case G_TYPE_BOOLEAN:
+	case G_TYPE_CHAR:
+	case G_TYPE_UCHAR:
+	case G_TYPE_INT:
+	case G_TYPE_UINT:
+	case G_TYPE_ENUM:
+	case G_TYPE_FLAGS:
+	  column->kind = COLUMN_INT;
+	  column->elt_size = sizeof (gint);
+	  break;
+	case G_TYPE_LONG:
+	case G_TYPE_ULONG:
+	  column->kind = COLUMN_LONG;
+	  column->elt_size = sizeof (glong);
+	  break;
+	case G_TYPE_INT64:
+	case G_TYPE_UINT64:
+	  column->kind = COLUMN_INT64;
+	  column->elt_size = sizeof (gint64);
+	  break;
+	case G_TYPE_FLOAT:
+	  column->kind = COLUMN_FLOAT;
+	  column->elt_size = sizeof (gfloat);
+	  break;
+	case G_TYPE_DOUBLE:
+	  column->kind = COLUMN_DOUBLE;
+	  column->elt_size = sizeof (gdouble);
+	  break;
+	case G_TYPE_STRING:
+	  column->kind = COLUMN_STRING;
+	  column->elt_size = sizeof (gchar *);
+	  break;
+	default:
+	  column->kind = COLUMN_POINTER;
+	  column->elt_size = sizeof (gpointer);
+	  break;
+	}
+    }
+
+  priv->sort_list = _gtk_tree_data_list_header_new (n_columns, types);
+}
+
+/* Releases the strings, objects and boxed values held by @row,
+ * without moving any rows.
+ */
+static void
+gtk_column_store_free_row (GtkColumnStore *column_store,
+			   gint            row)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+      gpointer *elt;
+
+      if (column->kind == COLUMN_INT ||
+	  column->kind == COLUMN_LONG ||
+	  column->kind == COLUMN_INT64 ||
+	  column->kind == COLUMN_FLOAT ||
+	  column->kind == COLUMN_DOUBLE)
+	continue;
+
+      elt = (gpointer *) COLUMN_ELT (column, row);
+      if (*elt == NULL)
+	continue;
+
+      if (column->kind == COLUMN_STRING)
+	priv->live_string_bytes -= strlen (*elt) + 1;
+      else if (column->fundamental == G_TYPE_OBJECT)
+	g_object_unref (*elt);
+      else if (column->fundamental == G_TYPE_BOXED)
+	g_boxed_free (column->type, *elt);
+
+      *elt = NULL;
+    }
+}
+
+static void
+gtk_column_store_finalize (GObject *object)
+{
+  GtkColumnStore *column_store = GTK_COLUMN_STORE (object);
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  for (i = 0; i < priv->n_rows; i++)
+    gtk_column_store_free_row (column_store, i);
+
+  for (i = 0; i < priv->n_columns; i++)
+    g_free (priv->columns[i].data);
+  g_free (priv->columns);
+
+  g_string_chunk_free (priv->strings);
+
+  _gtk_tree_data_list_header_free (priv->sort_list);
+
+  if (priv->default_sort_destroy)
+    {
+      GDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+      priv->default_sort_data = NULL;
+    }
+
+  G_OBJECT_CLASS (gtk_column_store_parent_class)->finalize (object);
+}
+
+/* Copies the live strings into a new chunk once most of the old one is
+ * garbage. The pointers in the string columns change, which is fine
+ * since values are always copied out of the store.
+ */
+static void
+gtk_column_store_maybe_compact_strings (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GStringChunk *strings;
+  gint i, row;
+
+  if (priv->string_bytes < STRING_COMPACT_MIN ||
+      priv->live_string_bytes * 2 > priv->string_bytes)
+    return;
+
+  strings = g_string_chunk_new (STRING_CHUNK_SIZE);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+      gchar **elt;
+
+      if (column->kind != COLUMN_STRING)
+	continue;
+
+      elt = (gchar **) column->data;
+      for (row = 0; row < priv->n_rows; row++)
+	if (elt[row])
+	  elt[row] = g_string_chunk_insert (strings, elt[row]);
+    }
+
+  g_string_chunk_free (priv->strings);
+  priv->strings = strings;
+  priv->string_bytes = priv->live_string_bytes;
+}
+
+/* Fundamental type and column accessors */
+static GtkTreeModelFlags
+gtk_column_store_get_flags (GtkTreeModel *tree_model)
+{
+  return GTK_TREE_MODEL_LIST_ONLY;
+}
+
+static gint
+gtk_column_store_get_n_columns (GtkTreeModel *tree_model)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  return column_store->priv->n_columns;
+}
+
+static GType
+gtk_column_store_get_column_type (GtkTreeModel *tree_model,
+				  gint          index)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  g_return_val_if_fail (index < column_store->priv->n_columns, G_TYPE_INVALID);
+
+  return column_store->priv->columns[index].type;
+}
+
+static gboolean
+gtk_column_store_get_iter (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter,
+			   GtkTreePath  *path)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+  gint i;
+
+  i = gtk_tree_path_get_indices (path)[0];
+
+  if (i >= column_store->priv->n_rows)
+    return FALSE;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (i);
+
+  return TRUE;
+}
+
+static GtkTreePath *
+gtk_column_store_get_path (GtkTreeModel *tree_model,
+			   GtkTreeIter  *iter)
+{
+  GtkTreePath *path;
+
+  g_return_val_if_fail (iter->stamp == GTK_COLUMN_STORE (tree_model)->priv->stamp, NULL);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, ITER_ROW (iter));
+
+  return path;
+}
+
+static void
+gtk_column_store_get_value (GtkTreeModel *tree_model,
+			    GtkTreeIter  *iter,
+			    gint          column,
+			    GValue       *value)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+  Column *col;
+  gpointer elt;
+
+  g_return_if_fail (column < column_store->priv->n_columns);
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  col = &column_store->priv->columns[column];
+  elt = COLUMN_ELT (col, ITER_ROW (iter));
+
+  g_value_init (value, col->type);
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, *(gint *) elt);
+      break;
+    case G_TYPE_CHAR:
+      g_value_set_char (value, *(gint *) elt);
+      break;
+    case G_TYPE_UCHAR:
+      g_value_set_uchar (value, *(gint *) elt);
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, *(gint *) elt);
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, *(guint *) elt);
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, *(gint *) elt);
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, *(guint *) elt);
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, *(glong *) elt);
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, *(gulong *) elt);
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, *(gint64 *) elt);
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, *(guint64 *) elt);
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, *(gfloat *) elt);
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, *(gdouble *) elt);
+      break;
+    case G_TYPE_STRING:
+      g_value_set_string (value, *(gchar **) elt);
+      break;
+    case G_TYPE_POINTER:
+      g_value_set_pointer (value, *(gpointer *) elt);
+      break;
+    case G_TYPE_BOXED:
+      g_value_set_boxed (value, *(gpointer *) elt);
+      break;
+    case G_TYPE_OBJECT:
+      g_value_set_object (value, *(gpointer *) elt);
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) retrieved.", G_STRLOC, g_type_name (value->g_type));
+      break;
+    }
+}
+
+static gboolean
+gtk_column_store_iter_next (GtkTreeModel *tree_model,
+			    GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  g_return_val_if_fail (iter->stamp == column_store->priv->stamp, FALSE);
+
+  if (ITER_ROW (iter) + 1 >= column_store->priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->user_data = GINT_TO_POINTER (ITER_ROW (iter) + 1);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_children (GtkTreeModel *tree_model,
+				GtkTreeIter  *iter,
+				GtkTreeIter  *parent)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  /* this is a list, nodes have no children */
+  if (parent)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  if (column_store->priv->n_rows > 0)
+    {
+      iter->stamp = column_store->priv->stamp;
+      iter->user_data = GINT_TO_POINTER (0);
+      return TRUE;
+    }
+  else
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+}
+
+static gboolean
+gtk_column_store_iter_has_child (GtkTreeModel *tree_model,
+				 GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+gtk_column_store_iter_n_children (GtkTreeModel *tree_model,
+				  GtkTreeIter  *iter)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  if (iter == NULL)
+    return column_store->priv->n_rows;
+
+  g_return_val_if_fail (column_store->priv->stamp == iter->stamp, -1);
+
+  return 0;
+}
+
+static gboolean
+gtk_column_store_iter_nth_child (GtkTreeModel *tree_model,
+				 GtkTreeIter  *iter,
+				 GtkTreeIter  *parent,
+				 gint          n)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) tree_model;
+
+  iter->stamp = 0;
+
+  if (parent)
+    return FALSE;
+
+  if (n < 0 || n >= column_store->priv->n_rows)
+    return FALSE;
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (n);
+
+  return TRUE;
+}
+
+static gboolean
+gtk_column_store_iter_parent (GtkTreeModel *tree_model,
+			      GtkTreeIter  *iter,
+			      GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+/* Stores @value, which has exactly the type of @column, in @row */
+static void
+gtk_column_store_store_value (GtkColumnStore *column_store,
+			      gint            row,
+			      gint            column,
+			      GValue         *value)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  Column *col = &priv->columns[column];
+  gpointer elt = COLUMN_ELT (col, row);
+  const gchar *str;
+
+  switch (col->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      *(gint *) elt = g_value_get_boolean (value);
+      break;
+    case G_TYPE_CHAR:
+      *(gint *) elt = g_value_get_char (value);
+      break;
+    case G_TYPE_UCHAR:
+      *(gint *) elt = g_value_get_uchar (value);
+      break;
+    case G_TYPE_INT:
+      *(gint *) elt = g_value_get_int (value);
+      break;
+    case G_TYPE_UINT:
+      *(guint *) elt = g_value_get_uint (value);
+      break;
+    case G_TYPE_ENUM:
+      *(gint *) elt = g_value_get_enum (value);
+      break;
+    case G_TYPE_FLAGS:
+      *(guint *) elt = g_value_get_flags (value);
+      break;
+    case G_TYPE_LONG:
+      *(glong *) elt = g_value_get_long (value);
+      break;
+    case G_TYPE_ULONG:
+      *(gulong *) elt = g_value_get_ulong (value);
+      break;
+    case G_TYPE_INT64:
+      *(gint64 *) elt = g_value_get_int64 (value);
+      break;
+    case G_TYPE_UINT64:
+      *(guint64 *) elt = g_value_get_uint64 (value);
+      break;
+    case G_TYPE_FLOAT:
+      *(gfloat *) elt = g_value_get_float (value);
+      break;
+    case G_TYPE_DOUBLE:
+      *(gdouble *) elt = g_value_get_double (value);
+      break;
+    case G_TYPE_STRING:
+      if (*(gchar **) elt)
+	priv->live_string_bytes -= strlen (*(gchar **) elt) + 1;
+
+      str = g_value_get_string (value);
+      if (str)
+	{
+	  gsize len = strlen (str) + 1;
+
+	  *(gchar **) elt = g_string_chunk_insert_len (priv->strings, str, len - 1);
+	  priv->string_bytes += len;
+	  priv->live_string_bytes += len;
+	}
+      else
+	*(gchar **) elt = NULL;
+      break;
+    case G_TYPE_POINTER:
+      *(gpointer *) elt = g_value_get_pointer (value);
+      break;
+    case G_TYPE_OBJECT:
+      if (*(gpointer *) elt)
+	g_object_unref (*(gpointer *) elt);
+      *(gpointer *) elt = g_value_dup_object (value);
+      break;
+    case G_TYPE_BOXED:
+      if (*(gpointer *) elt)
+	g_boxed_free (col->type, *(gpointer *) elt);
+      *(gpointer *) elt = g_value_dup_boxed (value);
+      break;
+    default:
+      g_warning ("%s: Unsupported type (%s) stored.", G_STRLOC, g_type_name (G_VALUE_TYPE (value)));
+      break;
+    }
+}
+
+static gboolean
+gtk_column_store_real_set_value (GtkColumnStore *column_store,
+				 GtkTreeIter    *iter,
+				 gint            column,
+				 GValue         *value)
+{
+  GType type = column_store->priv->columns[column].type;
+  GValue real_value = {0, };
+
+  if (! g_type_is_a (G_VALUE_TYPE (value), type))
+    {
+      if (! (g_value_type_compatible (G_VALUE_TYPE (value), type) &&
+	     g_value_type_compatible (type, G_VALUE_TYPE (value))))
+	{
+	  g_warning ("%s: Unable to convert from %s to %s\n",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (type));
+	  return FALSE;
+	}
+
+      g_value_init (&real_value, type);
+      if (!g_value_transform (value, &real_value))
+	{
+	  g_warning ("%s: Unable to make conversion from %s to %s\n",
+		     G_STRLOC,
+		     g_type_name (G_VALUE_TYPE (value)),
+		     g_type_name (type));
+	  g_value_unset (&real_value);
+	  return FALSE;
+	}
+
+      gtk_column_store_store_value (column_store, ITER_ROW (iter), column, &real_value);
+      g_value_unset (&real_value);
+    }
+  else
+    gtk_column_store_store_value (column_store, ITER_ROW (iter), column, value);
+
+  gtk_column_store_maybe_compact_strings (column_store);
+
+  return TRUE;
+}
+
+/**
+ * gtk_column_store_set_value:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @column: column number to modify
+ * @value: new value for the cell
+ *
+ * Sets the data in the cell specified by @iter and @column.
+ * The type of @value must be convertible to the type of the
+ * column.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_set_value (GtkColumnStore *column_store,
+			    GtkTreeIter    *iter,
+			    gint            column,
+			    GValue         *value)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+  g_return_if_fail (column >= 0 && column < column_store->priv->n_columns);
+  g_return_if_fail (G_IS_VALUE (value));
+
+  if (gtk_column_store_real_set_value (column_store, iter, column, value))
+    gtk_column_store_set_finish (column_store, iter, TRUE, TRUE);
+}
+
+static GtkTreeIterCompareFunc
+gtk_column_store_get_compare_func (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeIterCompareFunc func = NULL;
+
+  if (GTK_COLUMN_STORE_IS_SORTED (column_store))
+    {
+      if (priv->sort_column_id != -1)
+	{
+	  GtkTreeDataSortHeader *header;
+	  header = _gtk_tree_data_list_get_header (priv->sort_list,
+						   priv->sort_column_id);
+	  g_return_val_if_fail (header != NULL, NULL);
+	  g_return_val_if_fail (header->func != NULL, NULL);
+	  func = header->func;
+	}
+      else
+	{
+	  func = priv->default_sort_func;
+	}
+    }
+
+  return func;
+}
+
+static void
+gtk_column_store_set_vector_internal (GtkColumnStore *column_store,
+				      GtkTreeIter    *iter,
+				      gboolean       *emit_signal,
+				      gboolean       *maybe_need_sort,
+				      gint           *columns,
+				      GValue         *values,
+				      gint            n_values)
+{
+  GtkTreeIterCompareFunc func;
+  gint i;
+
+  func = gtk_column_store_get_compare_func (column_store);
+  if (func != _gtk_tree_data_list_compare_func)
+    *maybe_need_sort = TRUE;
+
+  for (i = 0; i < n_values; i++)
+    {
+      *emit_signal = gtk_column_store_real_set_value (column_store,
+						      iter,
+						      columns[i],
+						      &values[i]) || *emit_signal;
+
+      if (func == _gtk_tree_data_list_compare_func &&
+	  columns[i] == column_store->priv->sort_column_id)
+	*maybe_need_sort = TRUE;
+    }
+}
+
+static void
+gtk_column_store_set_valist_internal (GtkColumnStore *column_store,
+				      GtkTreeIter    *iter,
+				      gboolean       *emit_signal,
+				      gboolean       *maybe_need_sort,
+				      va_list         var_args)
+{
+  GtkTreeIterCompareFunc func;
+  gint column;
+
+  column = va_arg (var_args, gint);
+
+  func = gtk_column_store_get_compare_func (column_store);
+  if (func != _gtk_tree_data_list_compare_func)
+    *maybe_need_sort = TRUE;
+
+  while (column != -1)
+    {
+      GValue value = { 0, };
+      gchar *error = NULL;
+
+      if (column < 0 || column >= column_store->priv->n_columns)
+	{
+	  g_warning ("%s: Invalid column number %d added to iter (remember to end your list of columns with a -1)", G_STRLOC, column);
+	  break;
+	}
+      g_value_init (&value, column_store->priv->columns[column].type);
+
+      G_VALUE_COLLECT (&value, var_args, 0, &error);
+      if (error)
+	{
+	  g_warning ("%s: %s", G_STRLOC, error);
+	  g_free (error);
+
+ 	  /* we purposely leak the value here, it might not be
+	   * in a sane state if an error condition occoured
+	   */
+	  break;
+	}
+
+      *emit_signal = gtk_column_store_real_set_value (column_store,
+						      iter,
+						      column,
+						      &value) || *emit_signal;
+
+      if (func == _gtk_tree_data_list_compare_func &&
+	  column == column_store->priv->sort_column_id)
+	*maybe_need_sort = TRUE;
+
+      g_value_unset (&value);
+
+      column = va_arg (var_args, gint);
+    }
+}
+
+static void
+gtk_column_store_set_finish (GtkColumnStore *column_store,
+			     GtkTreeIter    *iter,
+			     gboolean        emit_signal,
+			     gboolean        maybe_need_sort)
+{
+  if (maybe_need_sort && GTK_COLUMN_STORE_IS_SORTED (column_store))
+    gtk_column_store_sort_iter_changed (column_store, iter);
+  else if (emit_signal)
+    {
+      GtkTreePath *path;
+
+      path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+      gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+      gtk_tree_path_free (path);
+    }
+}
+
+/**
+ * gtk_column_store_set_valuesv:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @columns: an array of column numbers
+ * @values: an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * A variant of gtk_column_store_set_valist() which takes
+ * the columns and values as two arrays, instead of varargs.
+ * This function is mainly intended for language-bindings
+ * and in case the number of columns to change is not known
+ * until run-time.
+ *
+ * Since: 2.20
+ */
+void
+gtk_column_store_set_valuesv (GtkColumnStore *column_store,
+			      GtkTreeIter    *iter,
+			      gint           *columns,
+			      GValue         *values,
+			      gint            n_values)
+{
+  gboolean emit_signal = FALSE;
+  gboolean maybe_need_sort = FALSE;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  gtk_column_store_set_vector_internal (column_store, iter,
+					&emit_signal,
+					&maybe_need_sort,
+					columns, values, n_values);
+
+  gtk_column_store_set_finish (column_store, iter, emit_signal, maybe_need_sort);
+}
+
+/**
+ * gtk_column_store_set_valist:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter for the row being modified
+ * @var_args: va_list of column/value pairs
+ *
+ * See gtk_column_store_set(); this version takes a va_list for
+ * use by language bindings.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_set_valist (GtkColumnStore *column_store,
+			     GtkTreeIter    *iter,
+			     va_list         var_args)
+{
+  gboolean emit_signal = FALSE;
+  gboolean maybe_need_sort = FALSE;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+
+  gtk_column_store_set_valist_internal (column_store, iter,
+					&emit_signal,
+					&maybe_need_sort,
+					var_args);
+
+  gtk_column_store_set_finish (column_store, iter, emit_signal, maybe_need_sort);
+}
+
+/**
+ * gtk_column_store_set:
+ * @column_store: a #GtkColumnStore
+ * @iter: row iterator
+ * @Varargs: pairs of column number and value, terminated with -1
+ *
+ * Sets the value of one or more cells in the row referenced by @iter,
+ * in the same way as gtk_list_store_set(). Strings are copied into the
+ * store, objects are referenced and boxed values are copied.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_set (GtkColumnStore *column_store,
+		      GtkTreeIter    *iter,
+		      ...)
+{
+  va_list var_args;
+
+  va_start (var_args, iter);
+  gtk_column_store_set_valist (column_store, iter, var_args);
+  va_end (var_args);
+}
+
+/* Makes room for an empty row at @position, moving the rows after it
+ * one down, without emitting any signal.
+ */
+static void
+gtk_column_store_insert_row (GtkColumnStore *column_store,
+			     gint            position)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i;
+
+  if (priv->n_rows == priv->n_alloc)
+    {
+      priv->n_alloc = MAX (16, priv->n_alloc * 2);
+
+      for (i = 0; i < priv->n_columns; i++)
+	priv->columns[i].data = g_realloc (priv->columns[i].data,
+					   priv->n_alloc * priv->columns[i].elt_size);
+    }
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+
+      if (position < priv->n_rows)
+	g_memmove (COLUMN_ELT (column, position + 1),
+		   COLUMN_ELT (column, position),
+		   (priv->n_rows - position) * column->elt_size);
+
+      memset (COLUMN_ELT (column, position), 0, column->elt_size);
+    }
+
+  /* rows after @position moved, so iters pointing at them are stale */
+  if (position < priv->n_rows)
+    gtk_column_store_increment_stamp (column_store);
+
+  priv->n_rows++;
+}
+
+/* Moves @from to @to, shifting the rows in between by one */
+static void
+gtk_column_store_move_row (GtkColumnStore *column_store,
+			   gint            from,
+			   gint            to)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  ColumnValue tmp;
+  gint i;
+
+  if (from == to)
+    return;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+
+      memcpy (&tmp, COLUMN_ELT (column, from), column->elt_size);
+      if (from < to)
+	g_memmove (COLUMN_ELT (column, from),
+		   COLUMN_ELT (column, from + 1),
+		   (to - from) * column->elt_size);
+      else
+	g_memmove (COLUMN_ELT (column, to + 1),
+		   COLUMN_ELT (column, to),
+		   (from - to) * column->elt_size);
+      memcpy (COLUMN_ELT (column, to), &tmp, column->elt_size);
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+/**
+ * gtk_column_store_remove:
+ * @column_store: A #GtkColumnStore
+ * @iter: A valid #GtkTreeIter
+ *
+ * Removes the given row from the column store.  After being removed,
+ * @iter is set to be the next valid row, or invalidated if it pointed
+ * to the last row in @column_store.
+ *
+ * Return value: %TRUE if @iter is valid, %FALSE if not.
+ *
+ * Since: 2.20
+ **/
+gboolean
+gtk_column_store_remove (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  gint row, i;
+
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (VALID_ITER (iter, column_store), FALSE);
+
+  priv = column_store->priv;
+  row = ITER_ROW (iter);
+
+  gtk_column_store_free_row (column_store, row);
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+
+      g_memmove (COLUMN_ELT (column, row),
+		 COLUMN_ELT (column, row + 1),
+		 (priv->n_rows - row - 1) * column->elt_size);
+    }
+
+  priv->n_rows--;
+  gtk_column_store_increment_stamp (column_store);
+  gtk_column_store_maybe_compact_strings (column_store);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, row);
+  gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+  gtk_tree_path_free (path);
+
+  if (row >= priv->n_rows)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+  else
+    {
+      iter->stamp = priv->stamp;
+      iter->user_data = GINT_TO_POINTER (row);
+      return TRUE;
+    }
+}
+
+/**
+ * gtk_column_store_insert:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the new row
+ * @position: position to insert the new row
+ *
+ * Creates a new row at @position.  @iter will be changed to point to this new
+ * row.  If @position is larger than the number of rows on the list, then the
+ * new row will be appended to the list. The row will be empty after this
+ * function is called.  To fill in values, you need to call
+ * gtk_column_store_set() or gtk_column_store_set_value().
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_insert (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter,
+			 gint            position)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter != NULL);
+  g_return_if_fail (position >= 0);
+
+  if (position > column_store->priv->n_rows)
+    position = column_store->priv->n_rows;
+
+  gtk_column_store_insert_row (column_store, position);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (position);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_path_append_index (path, position);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_prepend:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the prepend row
+ *
+ * Prepends a new row to @column_store. @iter will be changed to point to
+ * this new row. The row will be empty after this function is called. To
+ * fill in values, you need to call gtk_column_store_set() or
+ * gtk_column_store_set_value().
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_prepend (GtkColumnStore *column_store,
+			  GtkTreeIter    *iter)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter != NULL);
+
+  gtk_column_store_insert (column_store, iter, 0);
+}
+
+/**
+ * gtk_column_store_append:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the appended row
+ *
+ * Appends a new row to @column_store.  @iter will be changed to point to
+ * this new row.  The row will be empty after this function is called.  To
+ * fill in values, you need to call gtk_column_store_set() or
+ * gtk_column_store_set_value().
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_append (GtkColumnStore *column_store,
+			 GtkTreeIter    *iter)
+{
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (iter != NULL);
+
+  gtk_column_store_insert (column_store, iter, column_store->priv->n_rows);
+}
+
+static void
+gtk_column_store_increment_stamp (GtkColumnStore *column_store)
+{
+  do
+    {
+      column_store->priv->stamp++;
+    }
+  while (column_store->priv->stamp == 0);
+}
+
+/**
+ * gtk_column_store_clear:
+ * @column_store: a #GtkColumnStore.
+ *
+ * Removes all rows from the column store.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_clear (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  priv = column_store->priv;
+
+  /* Removing from the end never moves the remaining rows */
+  while (priv->n_rows > 0)
+    {
+      priv->n_rows--;
+      gtk_column_store_free_row (column_store, priv->n_rows);
+
+      path = gtk_tree_path_new ();
+      gtk_tree_path_append_index (path, priv->n_rows);
+      gtk_tree_model_row_deleted (GTK_TREE_MODEL (column_store), path);
+      gtk_tree_path_free (path);
+    }
+
+  g_string_chunk_free (priv->strings);
+  priv->strings = g_string_chunk_new (STRING_CHUNK_SIZE);
+  priv->string_bytes = 0;
+  priv->live_string_bytes = 0;
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+/**
+ * gtk_column_store_iter_is_valid:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ *
+ * Checks if the given iter is a valid iter for this #GtkColumnStore.
+ *
+ * Return value: %TRUE if the iter is valid, %FALSE if the iter is invalid.
+ *
+ * Since: 2.20
+ **/
+gboolean
+gtk_column_store_iter_is_valid (GtkColumnStore *column_store,
+				GtkTreeIter    *iter)
+{
+  g_return_val_if_fail (GTK_IS_COLUMN_STORE (column_store), FALSE);
+  g_return_val_if_fail (iter != NULL, FALSE);
+
+  return VALID_ITER (iter, column_store);
+}
+
+/* Gathers every column into @new_order, where
+ * @new_order[newpos] = oldpos
+ */
+static void
+gtk_column_store_apply_order (GtkColumnStore *column_store,
+			      gint           *new_order)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  gint i, row;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+      gchar *data;
+
+      data = g_malloc (priv->n_alloc * column->elt_size);
+      for (row = 0; row < priv->n_rows; row++)
+	memcpy (data + (gsize) row * column->elt_size,
+		COLUMN_ELT (column, new_order[row]),
+		column->elt_size);
+
+      g_free (column->data);
+      column->data = data;
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+}
+
+/* Moves @from to @to and emits rows_reordered for it */
+static void
+gtk_column_store_move_to (GtkColumnStore *column_store,
+			  gint            from,
+			  gint            to)
+{
+  GtkTreePath *path;
+  gint *order;
+  gint i, n_rows;
+
+  if (from == to)
+    return;
+
+  gtk_column_store_move_row (column_store, from, to);
+
+  n_rows = column_store->priv->n_rows;
+  order = g_new (gint, n_rows);
+  for (i = 0; i < n_rows; i++)
+    order[i] = i;
+  if (from < to)
+    memmove (order + from, order + from + 1, (to - from) * sizeof (gint));
+  else
+    memmove (order + to + 1, order + to, (from - to) * sizeof (gint));
+  order[to] = from;
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, order);
+  gtk_tree_path_free (path);
+  g_free (order);
+}
+
+/**
+ * gtk_column_store_reorder:
+ * @column_store: A #GtkColumnStore.
+ * @new_order: an array of integers mapping the new position of each row
+ *      to its old position before the re-ordering,
+ *      i.e. @new_order<literal>[newpos] = oldpos</literal>.
+ *
+ * Reorders @column_store to follow the order indicated by @new_order.
+ * Note that this function only works with unsorted stores. All iters of
+ * @column_store become invalid.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_reorder (GtkColumnStore *column_store,
+			  gint           *new_order)
+{
+  GtkTreePath *path;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (!GTK_COLUMN_STORE_IS_SORTED (column_store));
+  g_return_if_fail (new_order != NULL);
+
+  gtk_column_store_apply_order (column_store, new_order);
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, new_order);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_swap:
+ * @column_store: A #GtkColumnStore.
+ * @a: A #GtkTreeIter.
+ * @b: Another #GtkTreeIter.
+ *
+ * Swaps @a and @b in @column_store. Note that this function only works
+ * with unsorted stores. Afterwards, @a and @b point to the same rows at
+ * their new positions; all other iters become invalid.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_swap (GtkColumnStore *column_store,
+		       GtkTreeIter    *a,
+		       GtkTreeIter    *b)
+{
+  GtkColumnStorePrivate *priv;
+  GtkTreePath *path;
+  ColumnValue tmp;
+  gint *order;
+  gint row_a, row_b, i;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (!GTK_COLUMN_STORE_IS_SORTED (column_store));
+  g_return_if_fail (VALID_ITER (a, column_store));
+  g_return_if_fail (VALID_ITER (b, column_store));
+
+  priv = column_store->priv;
+  row_a = ITER_ROW (a);
+  row_b = ITER_ROW (b);
+
+  if (row_a == row_b)
+    return;
+
+  for (i = 0; i < priv->n_columns; i++)
+    {
+      Column *column = &priv->columns[i];
+
+      memcpy (&tmp, COLUMN_ELT (column, row_a), column->elt_size);
+      memcpy (COLUMN_ELT (column, row_a), COLUMN_ELT (column, row_b), column->elt_size);
+      memcpy (COLUMN_ELT (column, row_b), &tmp, column->elt_size);
+    }
+
+  gtk_column_store_increment_stamp (column_store);
+
+  a->stamp = b->stamp = priv->stamp;
+  a->user_data = GINT_TO_POINTER (row_b);
+  b->user_data = GINT_TO_POINTER (row_a);
+
+  order = g_new (gint, priv->n_rows);
+  for (i = 0; i < priv->n_rows; i++)
+    order[i] = i;
+  order[row_a] = row_b;
+  order[row_b] = row_a;
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, order);
+  gtk_tree_path_free (path);
+  g_free (order);
+}
+
+/**
+ * gtk_column_store_move_before:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ * @position: A #GtkTreeIter, or %NULL.
+ *
+ * Moves @iter in @column_store to the position before @position. Note
+ * that this function only works with unsorted stores. If @position is
+ * %NULL, @iter will be moved to the end of the list. Afterwards, @iter
+ * points to the moved row; all other iters become invalid.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_move_before (GtkColumnStore *column_store,
+			      GtkTreeIter    *iter,
+			      GtkTreeIter    *position)
+{
+  gint from, to;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (!GTK_COLUMN_STORE_IS_SORTED (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+  if (position)
+    g_return_if_fail (VALID_ITER (position, column_store));
+
+  from = ITER_ROW (iter);
+  if (position)
+    to = ITER_ROW (position);
+  else
+    to = column_store->priv->n_rows;
+  if (from < to)
+    to--;
+
+  gtk_column_store_move_to (column_store, from, to);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (to);
+}
+
+/**
+ * gtk_column_store_move_after:
+ * @column_store: A #GtkColumnStore.
+ * @iter: A #GtkTreeIter.
+ * @position: A #GtkTreeIter or %NULL.
+ *
+ * Moves @iter in @column_store to the position after @position. Note
+ * that this function only works with unsorted stores. If @position is
+ * %NULL, @iter will be moved to the start of the list. Afterwards,
+ * @iter points to the moved row; all other iters become invalid.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_column_store_move_after (GtkColumnStore *column_store,
+			     GtkTreeIter    *iter,
+			     GtkTreeIter    *position)
+{
+  gint from, to;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+  g_return_if_fail (!GTK_COLUMN_STORE_IS_SORTED (column_store));
+  g_return_if_fail (VALID_ITER (iter, column_store));
+  if (position)
+    g_return_if_fail (VALID_ITER (position, column_store));
+
+  from = ITER_ROW (iter);
+  if (position)
+    to = ITER_ROW (position) + 1;
+  else
+    to = 0;
+  if (from < to)
+    to--;
+
+  gtk_column_store_move_to (column_store, from, to);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (to);
+}
+
+/* Sorting */
+static gboolean
+gtk_column_store_get_sort_data (GtkColumnStore *column_store,
+				SortData       *sort_data)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  sort_data->store = column_store;
+  sort_data->column = NULL;
+
+  if (priv->sort_column_id != -1)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (priv->sort_list,
+					       priv->sort_column_id);
+      g_return_val_if_fail (header != NULL, FALSE);
+      g_return_val_if_fail (header->func != NULL, FALSE);
+
+      sort_data->func = header->func;
+      sort_data->data = header->data;
+
+      /* The default compare function only looks at one column, which
+       * we can read directly.
+       */
+      if (header->func == _gtk_tree_data_list_compare_func &&
+	  GPOINTER_TO_INT (header->data) >= 0 &&
+	  GPOINTER_TO_INT (header->data) < priv->n_columns &&
+	  priv->columns[GPOINTER_TO_INT (header->data)].kind != COLUMN_POINTER)
+	sort_data->column = &priv->columns[GPOINTER_TO_INT (header->data)];
+    }
+  else
+    {
+      g_return_val_if_fail (priv->default_sort_func != NULL, FALSE);
+
+      sort_data->func = priv->default_sort_func;
+      sort_data->data = priv->default_sort_data;
+    }
+
+  return TRUE;
+}
+
+#define COMPARE(a, b) ((a) < (b) ? -1 : ((a) > (b) ? 1 : 0))
+
+static gint
+gtk_column_store_compare_rows (SortData *sort_data,
+			       gint      a,
+			       gint      b)
+{
+  GtkColumnStore *column_store = sort_data->store;
+  Column *column = sort_data->column;
+  gint retval;
+
+  if (column)
+    {
+      gpointer ea = COLUMN_ELT (column, a);
+      gpointer eb = COLUMN_ELT (column, b);
+      const gchar *stra, *strb;
+
+      switch (column->fundamental)
+	{
+	case G_TYPE_UINT:
+	case G_TYPE_FLAGS:
+	  retval = COMPARE (*(guint *) ea, *(guint *) eb);
+	  break;
+	case G_TYPE_ULONG:
+	  retval = COMPARE (*(gulong *) ea, *(gulong *) eb);
+	  break;
+	case G_TYPE_UINT64:
+	  retval = COMPARE (*(guint64 *) ea, *(guint64 *) eb);
+	  break;
+	default:
+	  switch (column->kind)
+	    {
+	    case COLUMN_INT:
+	      retval = COMPARE (*(gint *) ea, *(gint *) eb);
+	      break;
+	    case COLUMN_LONG:
+	      retval = COMPARE (*(glong *) ea, *(glong *) eb);
+	      break;
+	    case COLUMN_INT64:
+	      retval = COMPARE (*(gint64 *) ea, *(gint64 *) eb);
+	      break;
+	    case COLUMN_FLOAT:
+	      retval = COMPARE (*(gfloat *) ea, *(gfloat *) eb);
+	      break;
+	    case COLUMN_DOUBLE:
+	      retval = COMPARE (*(gdouble *) ea, *(gdouble *) eb);
+	      break;
+	    case COLUMN_STRING:
+	      stra = *(const gchar **) ea;
+	      strb = *(const gchar **) eb;
+	      if (stra == NULL) stra = "";
+	      if (strb == NULL) strb = "";
+	      retval = g_utf8_collate (stra, strb);
+	      break;
+	    default:
+	      g_assert_not_reached ();
+	      retval = 0;
+	      break;
+	    }
+	  break;
+	}
+    }
+  else
+    {
+      GtkTreeIter iter_a;
+      GtkTreeIter iter_b;
+
+      iter_a.stamp = column_store->priv->stamp;
+      iter_a.user_data = GINT_TO_POINTER (a);
+      iter_b.stamp = column_store->priv->stamp;
+      iter_b.user_data = GINT_TO_POINTER (b);
+
+      retval = (* sort_data->func) (GTK_TREE_MODEL (column_store),
+				    &iter_a, &iter_b, sort_data->data);
+    }
+
+  if (column_store->priv->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+
+  return retval;
+}
+
+#undef COMPARE
+
+static gint
+gtk_column_store_compare_func (gconstpointer a,
+			       gconstpointer b,
+			       gpointer      user_data)
+{
+  gint row_a = *(const gint *) a;
+  gint row_b = *(const gint *) b;
+  gint retval;
+
+  retval = gtk_column_store_compare_rows (user_data, row_a, row_b);
+
+  /* g_qsort_with_data() is not stable */
+  if (retval == 0)
+    retval = row_a < row_b ? -1 : (row_a > row_b);
+
+  return retval;
+}
+
+static void
+gtk_column_store_sort (GtkColumnStore *column_store)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  GtkTreeDataSortKeys *keys;
+  SortData sort_data;
+  GtkTreePath *path;
+  gint *new_order;
+  gint row;
+
+  if (!GTK_COLUMN_STORE_IS_SORTED (column_store) || priv->n_rows <= 1)
+    return;
+
+  if (!gtk_column_store_get_sort_data (column_store, &sort_data))
+    return;
+
+  new_order = g_new (gint, priv->n_rows);
+
+  keys = NULL;
+  if (sort_data.column)
+    keys = _gtk_tree_data_list_sort_keys_new (GTK_TREE_MODEL (column_store),
+					      sort_data.func, sort_data.data,
+					      priv->n_rows);
+  if (keys)
+    {
+      /* collation keys beat collating the strings over and over */
+      GtkTreeIter iter;
+
+      iter.stamp = priv->stamp;
+      for (row = 0; row < priv->n_rows; row++)
+	{
+	  iter.user_data = GINT_TO_POINTER (row);
+	  _gtk_tree_data_list_sort_keys_add (keys, &iter);
+	}
+
+      _gtk_tree_data_list_sort_keys_sort (keys, priv->order, new_order);
+      _gtk_tree_data_list_sort_keys_free (keys);
+    }
+  else
+    {
+      for (row = 0; row < priv->n_rows; row++)
+	new_order[row] = row;
+
+      g_qsort_with_data (new_order, priv->n_rows, sizeof (gint),
+			 gtk_column_store_compare_func, &sort_data);
+    }
+
+  gtk_column_store_apply_order (column_store, new_order);
+
+  /* Let the world know about our new order */
+  path = gtk_tree_path_new ();
+  gtk_tree_model_rows_reordered (GTK_TREE_MODEL (column_store),
+				 path, NULL, new_order);
+  gtk_tree_path_free (path);
+  g_free (new_order);
+}
+
+/* Returns the position @row should move to so that the store is sorted,
+ * counted as if @row was not in the store.
+ */
+static gint
+gtk_column_store_find_sorted_position (GtkColumnStore *column_store,
+				       SortData       *sort_data,
+				       gint            row)
+{
+  gint start, end, middle;
+
+  if (row > 0 &&
+      gtk_column_store_compare_rows (sort_data, row - 1, row) > 0)
+    {
+      start = 0;
+      end = row;
+    }
+  else if (row + 1 < column_store->priv->n_rows &&
+	   gtk_column_store_compare_rows (sort_data, row, row + 1) > 0)
+    {
+      start = row + 1;
+      end = column_store->priv->n_rows;
+    }
+  else
+    return row;
+
+  /* first row in [start, end) that sorts after @row */
+  while (start < end)
+    {
+      middle = (start + end) / 2;
+      if (gtk_column_store_compare_rows (sort_data, row, middle) < 0)
+	end = middle;
+      else
+	start = middle + 1;
+    }
+
+  return start > row ? start - 1 : start;
+}
+
+static void
+gtk_column_store_sort_iter_changed (GtkColumnStore *column_store,
+				    GtkTreeIter    *iter)
+{
+  GtkColumnStorePrivate *priv = column_store->priv;
+  SortData sort_data;
+  GtkTreePath *path;
+  gint row, new_row;
+
+  path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+  gtk_tree_model_row_changed (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+
+  if (!gtk_column_store_get_sort_data (column_store, &sort_data))
+    return;
+
+  row = ITER_ROW (iter);
+  new_row = gtk_column_store_find_sorted_position (column_store, &sort_data, row);
+
+  if (new_row != row)
+    {
+      gtk_column_store_move_to (column_store, row, new_row);
+
+      iter->stamp = priv->stamp;
+      iter->user_data = GINT_TO_POINTER (new_row);
+    }
+}
+
+static gboolean
+gtk_column_store_get_sort_column_id (GtkTreeSortable *sortable,
+				     gint            *sort_column_id,
+				     GtkSortType     *order)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+
+  if (sort_column_id)
+    * sort_column_id = column_store->priv->sort_column_id;
+  if (order)
+    * order = column_store->priv->order;
+
+  if (column_store->priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID ||
+      column_store->priv->sort_column_id == GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    return FALSE;
+
+  return TRUE;
+}
+
+static void
+gtk_column_store_set_sort_column_id (GtkTreeSortable *sortable,
+				     gint             sort_column_id,
+				     GtkSortType      order)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if ((priv->sort_column_id == sort_column_id) &&
+      (priv->order == order))
+    return;
+
+  if (sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
+    {
+      if (sort_column_id != GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+	{
+	  GtkTreeDataSortHeader *header = NULL;
+
+	  header = _gtk_tree_data_list_get_header (priv->sort_list,
+						   sort_column_id);
+
+	  /* We want to make sure that we have a function */
+	  g_return_if_fail (header != NULL);
+	  g_return_if_fail (header->func != NULL);
+	}
+      else
+	{
+	  g_return_if_fail (priv->default_sort_func != NULL);
+	}
+    }
+
+  priv->sort_column_id = sort_column_id;
+  priv->order = order;
+
+  gtk_tree_sortable_sort_column_changed (sortable);
+
+  gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_sort_func (GtkTreeSortable        *sortable,
+				gint                    sort_column_id,
+				GtkTreeIterCompareFunc  func,
+				gpointer                data,
+				GDestroyNotify          destroy)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  priv->sort_list = _gtk_tree_data_list_set_header (priv->sort_list,
+						    sort_column_id,
+						    func, data, destroy);
+
+  if (priv->sort_column_id == sort_column_id)
+    gtk_column_store_sort (column_store);
+}
+
+static void
+gtk_column_store_set_default_sort_func (GtkTreeSortable        *sortable,
+					GtkTreeIterCompareFunc  func,
+					gpointer                data,
+					GDestroyNotify          destroy)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+  GtkColumnStorePrivate *priv = column_store->priv;
+
+  if (priv->default_sort_destroy)
+    {
+      GDestroyNotify d = priv->default_sort_destroy;
+
+      priv->default_sort_destroy = NULL;
+      d (priv->default_sort_data);
+    }
+
+  priv->default_sort_func = func;
+  priv->default_sort_data = data;
+  priv->default_sort_destroy = destroy;
+
+  if (priv->sort_column_id == GTK_TREE_SORTABLE_DEFAULT_SORT_COLUMN_ID)
+    gtk_column_store_sort (column_store);
+}
+
+static gboolean
+gtk_column_store_has_default_sort_func (GtkTreeSortable *sortable)
+{
+  GtkColumnStore *column_store = (GtkColumnStore *) sortable;
+
+  return (column_store->priv->default_sort_func != NULL);
+}
+
+/* Moves a freshly filled row to its sorted position, if needed, and
+ * emits row_inserted for it.
+ */
+static void
+gtk_column_store_insert_finish (GtkColumnStore *column_store,
+				GtkTreeIter    *iter,
+				gboolean        maybe_need_sort)
+{
+  GtkTreePath *path;
+
+  /* Don't emit rows_reordered here */
+  if (maybe_need_sort && GTK_COLUMN_STORE_IS_SORTED (column_store))
+    {
+      SortData sort_data;
+      gint row, new_row;
+
+      if (gtk_column_store_get_sort_data (column_store, &sort_data))
+	{
+	  row = ITER_ROW (iter);
+	  new_row = gtk_column_store_find_sorted_position (column_store,
+							   &sort_data, row);
+	  gtk_column_store_move_row (column_store, row, new_row);
+
+	  iter->stamp = column_store->priv->stamp;
+	  iter->user_data = GINT_TO_POINTER (new_row);
+	}
+    }
+
+  /* Just emit row_inserted */
+  path = gtk_column_store_get_path (GTK_TREE_MODEL (column_store), iter);
+  gtk_tree_model_row_inserted (GTK_TREE_MODEL (column_store), path, iter);
+  gtk_tree_path_free (path);
+}
+
+/**
+ * gtk_column_store_insert_with_values:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the new row, or %NULL.
+ * @position: position to insert the new row
+ * @Varargs: pairs of column number and value, terminated with -1
+ *
+ * Creates a new row at @position and fills it with the values given
+ * to this function, like gtk_list_store_insert_with_values(). Only a
+ * row_inserted signal is emitted, at the sorted position of the row if
+ * the store is sorted; this is the fastest way to fill a
+ * #GtkColumnStore.
+ *
+ * Since: 2.20
+ */
+void
+gtk_column_store_insert_with_values (GtkColumnStore *column_store,
+				     GtkTreeIter    *iter,
+				     gint            position,
+				     ...)
+{
+  GtkTreeIter tmp_iter;
+  gboolean changed = FALSE;
+  gboolean maybe_need_sort = FALSE;
+  va_list var_args;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  if (position < 0 || position > column_store->priv->n_rows)
+    position = column_store->priv->n_rows;
+
+  gtk_column_store_insert_row (column_store, position);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (position);
+
+  va_start (var_args, position);
+  gtk_column_store_set_valist_internal (column_store, iter,
+					&changed, &maybe_need_sort,
+					var_args);
+  va_end (var_args);
+
+  gtk_column_store_insert_finish (column_store, iter, maybe_need_sort);
+}
+
+/**
+ * gtk_column_store_insert_with_valuesv:
+ * @column_store: A #GtkColumnStore
+ * @iter: An unset #GtkTreeIter to set to the new row, or %NULL.
+ * @position: position to insert the new row
+ * @columns: an array of column numbers
+ * @values: an array of GValues
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * A variant of gtk_column_store_insert_with_values() which
+ * takes the columns and values as two arrays, instead of
+ * varargs. This function is mainly intended for
+ * language-bindings.
+ *
+ * Since: 2.20
+ */
+void
+gtk_column_store_insert_with_valuesv (GtkColumnStore *column_store,
+				      GtkTreeIter    *iter,
+				      gint            position,
+				      gint           *columns,
+				      GValue         *values,
+				      gint            n_values)
+{
+  GtkTreeIter tmp_iter;
+  gboolean changed = FALSE;
+  gboolean maybe_need_sort = FALSE;
+
+  g_return_if_fail (GTK_IS_COLUMN_STORE (column_store));
+
+  if (!iter)
+    iter = &tmp_iter;
+
+  if (position < 0 || position > column_store->priv->n_rows)
+    position = column_store->priv->n_rows;
+
+  gtk_column_store_insert_row (column_store, position);
+
+  iter->stamp = column_store->priv->stamp;
+  iter->user_data = GINT_TO_POINTER (position);
+
+  gtk_column_store_set_vector_internal (column_store, iter,
+					&changed, &maybe_need_sort,
+					columns, values, n_values);
+
+  gtk_column_store_insert_finish (column_store, iter, maybe_need_sort);
+}
+
+#define __GTK_COLUMN_STORE_C__
+#include "gtkaliasdef.c"
@@ -0,0 +1,125 @@
+/* gtkcolumnstore.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#if defined(GTK_DISABLE_SINGLE_INCLUDES) && !defined (__GTK_H_INSIDE__) && !defined (GTK_COMPILATION)
+#error "Only <gtk/gtk.h> can be included directly."
+#endif
+
+#ifndef __GTK_COLUMN_STORE_H__
+#define __GTK_COLUMN_STORE_H__
+
+#include <gtk/gtktreemodel.h>
+#include <gtk/gtktreesortable.h>
+
+
+G_BEGIN_DECLS
+
+
+#define GTK_TYPE_COLUMN_STORE            (gtk_column_store_get_type ())
+#define GTK_COLUMN_STORE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_TYPE_COLUMN_STORE, GtkColumnStore))
+#define GTK_COLUMN_STORE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GTK_TYPE_COLUMN_STORE, GtkColumnStoreClass))
+#define GTK_IS_COLUMN_STORE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_TYPE_COLUMN_STORE))
+#define GTK_IS_COLUMN_STORE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GTK_TYPE_COLUMN_STORE))
+#define GTK_COLUMN_STORE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GTK_TYPE_COLUMN_STORE, GtkColumnStoreClass))
+
+typedef struct _GtkColumnStore         GtkColumnStore;
+typedef struct _GtkColumnStoreClass    GtkColumnStoreClass;
+typedef struct _GtkColumnStorePrivate  GtkColumnStorePrivate;
+
+struct _GtkColumnStore
+{
+  GObject parent;
+
+  /*< private >*/
+  GtkColumnStorePrivate *priv;
+};
+
+struct _GtkColumnStoreClass
+{
+  GObjectClass parent_class;
+
+  /* Padding for future expansion */
+  void (*_gtk_reserved1) (void);
+  void (*_gtk_reserved2) (void);
+  void (*_gtk_reserved3) (void);
+  void (*_gtk_reserved4) (void);
+};
+
+
+GType           gtk_column_store_get_type         (void) G_GNUC_CONST;
+GtkColumnStore *gtk_column_store_new              (gint            n_columns,
+						   ...);
+GtkColumnStore *gtk_column_store_newv             (gint            n_columns,
+						   GType          *types);
+
+/* NOTE: use gtk_tree_model_get to get values from a GtkColumnStore */
+
+void            gtk_column_store_set_value        (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   gint            column,
+						   GValue         *value);
+void            gtk_column_store_set              (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   ...);
+void            gtk_column_store_set_valuesv      (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   gint           *columns,
+						   GValue         *values,
+						   gint            n_values);
+void            gtk_column_store_set_valist       (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   va_list         var_args);
+gboolean        gtk_column_store_remove           (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter);
+void            gtk_column_store_insert           (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   gint            position);
+void            gtk_column_store_insert_with_values  (GtkColumnStore *column_store,
+						      GtkTreeIter    *iter,
+						      gint            position,
+						      ...);
+void            gtk_column_store_insert_with_valuesv (GtkColumnStore *column_store,
+						      GtkTreeIter    *iter,
+						      gint            position,
+						      gint           *columns,
+						      GValue         *values,
+						      gint            n_values);
+void            gtk_column_store_prepend          (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter);
+void            gtk_column_store_append           (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter);
+void            gtk_column_store_clear            (GtkColumnStore *column_store);
+gboolean        gtk_column_store_iter_is_valid    (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter);
+void            gtk_column_store_reorder          (GtkColumnStore *column_store,
+						   gint           *new_order);
+void            gtk_column_store_swap             (GtkColumnStore *column_store,
+						   GtkTreeIter    *a,
+						   GtkTreeIter    *b);
+void            gtk_column_store_move_after       (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   GtkTreeIter    *position);
+void            gtk_column_store_move_before      (GtkColumnStore *column_store,
+						   GtkTreeIter    *iter,
+						   GtkTreeIter    *position);
+
+
+G_END_DECLS
+
+
+#endif /* __GTK_COLUMN_STORE_H__ */
@@ -103,6 +103,7 @@ struct _GtkComboBoxPrivate
   guint deleted_id;
   guint reordered_id;
   guint changed_id;
+  guint reloaded_id;
   guint popup_idle_id;
   guint activate_button;
   guint32 activate_time;
@@ -316,6 +317,10 @@ static void     gtk_combo_box_model_row_changed    (GtkTreeModel     *model,
 						    GtkTreePath      *path,
 						    GtkTreeIter      *iter,
 						    gpointer          data);
+static void     gtk_combo_box_model_children_reloaded (GtkTreeModel  *model,
+						       GtkTreePath   *path,
+						       GtkTreeIter   *iter,
+						       gpointer       user_data);
 static void     gtk_combo_box_model_row_expanded   (GtkTreeModel     *model,
 						    GtkTreePath      *path,
 						    GtkTreeIter      *iter,
@@ -2434,6 +2439,8 @@ gtk_combo_box_unset_model (GtkComboBox *combo_box)
 				   priv->reordered_id);
       g_signal_handler_disconnect (priv->model,
 				   priv->changed_id);
+      g_signal_handler_disconnect (priv->model,
+				   priv->reloaded_id);
     }
 
   /* menu mode */
@@ -3315,6 +3322,41 @@ gtk_combo_box_model_row_changed (GtkTreeModel     *model,
     gtk_combo_box_menu_row_changed (model, path, iter, user_data);
 }
 
+static void
+gtk_combo_box_model_children_reloaded (GtkTreeModel *model,
+				       GtkTreePath  *path,
+				       GtkTreeIter  *iter,
+				       gpointer      user_data)
+{
+  GtkComboBox *combo_box = GTK_COMBO_BOX (user_data);
+  GtkComboBoxPrivate *priv = combo_box->priv;
+
+  /* The row reference is gone if the active row was in the level */
+  if (priv->active_row && !gtk_tree_row_reference_valid (priv->active_row))
+    {
+      gtk_tree_row_reference_free (priv->active_row);
+      priv->active_row = NULL;
+
+      if (priv->cell_view)
+	gtk_cell_view_set_displayed_row (GTK_CELL_VIEW (priv->cell_view), NULL);
+      g_signal_emit (combo_box, combo_box_signals[CHANGED], 0);
+    }
+
+  if (priv->tree_view)
+    gtk_combo_box_list_popup_resize (combo_box);
+  else if (priv->popup_widget)
+    {
+      /* The menu items point at rows that may not exist anymore,
+       * so build the menu again.
+       */
+      gtk_container_foreach (GTK_CONTAINER (priv->popup_widget),
+			     (GtkCallback)gtk_widget_destroy, NULL);
+      gtk_combo_box_menu_fill (combo_box);
+    }
+
+  gtk_combo_box_update_sensitivity (combo_box);
+}
+
 static gboolean
 list_popup_resize_idle (gpointer user_data)
 {
@@ -5063,6 +5105,10 @@ gtk_combo_box_set_model (GtkComboBox  *combo_box,
     g_signal_connect (combo_box->priv->model, "row-changed",
 		      G_CALLBACK (gtk_combo_box_model_row_changed),
 		      combo_box);
+  combo_box->priv->reloaded_id =
+    g_signal_connect (combo_box->priv->model, "children-reloaded",
+		      G_CALLBACK (gtk_combo_box_model_children_reloaded),
+		      combo_box);
       
   if (combo_box->priv->tree_view)
     {
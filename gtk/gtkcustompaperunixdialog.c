@@ -68,6 +68,7 @@ struct GtkCustomPaperUnixDialogPrivate
 
   gulong printer_inserted_tag;
   gulong printer_removed_tag;
+  gulong printer_reloaded_tag;
 
   guint request_details_tag;
   GtkPrinter *request_details_printer;
@@ -313,6 +314,7 @@ gtk_custom_paper_unix_dialog_finalize (GObject *object)
     {
       g_signal_handler_disconnect (priv->printer_list, priv->printer_inserted_tag);
       g_signal_handler_disconnect (priv->printer_list, priv->printer_removed_tag);
+      g_signal_handler_disconnect (priv->printer_list, priv->printer_reloaded_tag);
       g_object_unref (priv->printer_list);
       priv->printer_list = NULL;
     }
@@ -1146,6 +1148,9 @@ populate_dialog (GtkCustomPaperUnixDialog *dialog)
   priv->printer_removed_tag =
     g_signal_connect_swapped (priv->printer_list, "row-deleted",
 			      G_CALLBACK (update_combo_sensitivity_from_printers), dialog);
+  priv->printer_reloaded_tag =
+    g_signal_connect_swapped (priv->printer_list, "children-reloaded",
+			      G_CALLBACK (update_combo_sensitivity_from_printers), dialog);
   update_combo_sensitivity_from_printers (dialog);
 
   cell = gtk_cell_renderer_text_new ();
@@ -74,6 +74,23 @@ struct _GtkIconViewItem
   guint selected : 1;
   guint selected_before_rubberbanding : 1;
 
+  /* The size is a guess, the item has not been measured yet */
+  guint estimated : 1;
+  /* The cell boxes are placed for the current layout */
+  guint boxes_valid : 1;
+};
+
+/* The items of a row share their y range. The rows of the last layout
+ * are kept in order, so that the items in a given area or with a given
+ * index can be found without looking at the items of the other rows.
+ */
+typedef struct _GtkIconViewRow GtkIconViewRow;
+struct _GtkIconViewRow
+{
+  GList *first_item;
+  gint y, height;
+
+  guint estimated : 1;
 };
 
 typedef struct _GtkIconViewCellInfo GtkIconViewCellInfo;
@@ -115,6 +132,19 @@ struct _GtkIconViewPrivate
   GtkTreeModel *model;
   
   GList *items;
+
+  /* Rows of the last layout, and for each of them the heights of the
+   * tallest cells, n_cells per row. Empty while a change to the items
+   * is waiting for a relayout.
+   */
+  GArray *rows;
+  GArray *row_cell_heights;
+
+  /* Size of the last measured item, used for the items far from the
+   * visible area until they are measured themselves.
+   */
+  gint estimated_item_width;
+  gint estimated_item_height;
   
   GtkAdjustment *hadjustment;
   GtkAdjustment *vadjustment;
@@ -325,6 +355,8 @@ static void                 gtk_icon_view_calculate_item_size2           (GtkIco
 									  GtkIconViewItem        *item,
 									  gint                   *max_height);
 static void                 gtk_icon_view_update_rubberband              (gpointer                data);
+static void                 gtk_icon_view_ensure_cell_boxes              (GtkIconView            *icon_view,
+									  GtkIconViewItem        *item);
 static void                 gtk_icon_view_item_invalidate_size           (GtkIconViewItem        *item);
 static void                 gtk_icon_view_invalidate_sizes               (GtkIconView            *icon_view);
 static void                 gtk_icon_view_add_move_binding               (GtkBindingSet          *binding_set,
@@ -352,6 +384,13 @@ static void                 gtk_icon_view_unselect_item                  (GtkIco
 static gboolean             gtk_icon_view_select_all_between             (GtkIconView            *icon_view,
 									  GtkIconViewItem        *anchor,
 									  GtkIconViewItem        *cursor);
+static GtkIconViewItem *    gtk_icon_view_get_nth_item                   (GtkIconView            *icon_view,
+									  gint                    index);
+static guint                gtk_icon_view_find_row                       (GtkIconView            *icon_view,
+									  gint                    y);
+static gboolean             gtk_icon_view_rows_estimated                 (GtkIconView            *icon_view,
+									  gint                    y1,
+									  gint                    y2);
 static GtkIconViewItem *    gtk_icon_view_get_item_at_coords             (GtkIconView            *icon_view,
 									  gint                    x,
 									  gint                    y,
@@ -1106,6 +1145,11 @@ gtk_icon_view_init (GtkIconView *icon_view)
   icon_view->priv->pixbuf_cell = -1;  
   icon_view->priv->tooltip_column = -1;  
 
+  icon_view->priv->rows = g_array_new (FALSE, FALSE, sizeof (GtkIconViewRow));
+  icon_view->priv->row_cell_heights = g_array_new (FALSE, FALSE, sizeof (gint));
+  icon_view->priv->estimated_item_width = -1;
+  icon_view->priv->estimated_item_height = -1;
+
   GTK_WIDGET_SET_FLAGS (icon_view, GTK_CAN_FOCUS);
   
   gtk_icon_view_set_adjustments (icon_view, NULL, NULL);
@@ -1171,8 +1215,13 @@ gtk_icon_view_destroy (GtkObject *object)
 static void
 gtk_icon_view_finalize (GObject *object)
 {
+  GtkIconView *icon_view = GTK_ICON_VIEW (object);
+
   gtk_icon_view_cell_layout_clear (GTK_CELL_LAYOUT (object));
 
+  g_array_free (icon_view->priv->rows, TRUE);
+  g_array_free (icon_view->priv->row_cell_heights, TRUE);
+
   G_OBJECT_CLASS (gtk_icon_view_parent_class)->finalize (object);
 }
 
@@ -1450,7 +1499,10 @@ gtk_icon_view_allocate_children (GtkIconView *icon_view)
 	}
       else
 	{
-	  GdkRectangle *box = &child->item->box[child->cell];
+	  GdkRectangle *box;
+
+	  gtk_icon_view_ensure_cell_boxes (icon_view, child->item);
+	  box = &child->item->box[child->cell];
 
 	  allocation.x = box->x;
 	  allocation.y = box->y;
@@ -1539,15 +1591,19 @@ gtk_icon_view_expose (GtkWidget *widget,
   gint dest_index;
   GtkIconViewDropPosition dest_pos;
   GtkIconViewItem *dest_item = NULL;
+  guint row;
 
   icon_view = GTK_ICON_VIEW (widget);
 
   if (expose->window != icon_view->priv->bin_window)
     return FALSE;
 
-  /* If a layout has been scheduled, do it now so that all
+  /* If a layout has been scheduled, or items that have not been
+   * measured yet are scrolled into view, do it now so that all
    * cell view items have valid sizes before we proceed. */
-  if (icon_view->priv->layout_idle_id != 0)
+  if (icon_view->priv->layout_idle_id != 0 ||
+      gtk_icon_view_rows_estimated (icon_view, expose->area.y,
+				    expose->area.y + expose->area.height))
     gtk_icon_view_layout (icon_view);
 
   cr = gdk_cairo_create (icon_view->priv->bin_window);
@@ -1563,26 +1619,41 @@ gtk_icon_view_expose (GtkWidget *widget,
   else
     dest_index = -1;
 
-  for (icons = icon_view->priv->items; icons; icons = icons->next) 
+  /* Only the items in the rows overlapping the exposed area can need
+   * to be painted */
+  for (row = gtk_icon_view_find_row (icon_view, expose->area.y);
+       row < icon_view->priv->rows->len;
+       row++)
     {
-      GtkIconViewItem *item = icons->data;
-      GdkRectangle area;
-      
-      area.x = item->x;
-      area.y = item->y;
-      area.width = item->width;
-      area.height = item->height;
+      GtkIconViewRow *r = &g_array_index (icon_view->priv->rows, GtkIconViewRow, row);
+
+      if (r->y >= expose->area.y + expose->area.height)
+	break;
+
+      for (icons = r->first_item; icons; icons = icons->next) 
+	{
+	  GtkIconViewItem *item = icons->data;
+	  GdkRectangle area;
+
+	  if (item->row != row)
+	    break;
+
+	  area.x = item->x;
+	  area.y = item->y;
+	  area.width = item->width;
+	  area.height = item->height;
 	
-      if (gdk_region_rect_in (expose->region, &area) == GDK_OVERLAP_RECTANGLE_OUT)
-	continue;
+	  if (gdk_region_rect_in (expose->region, &area) == GDK_OVERLAP_RECTANGLE_OUT)
+	    continue;
       
-      gtk_icon_view_paint_item (icon_view, cr, item, &expose->area, 
-				icon_view->priv->bin_window,
-				item->x, item->y,
-				icon_view->priv->draw_focus); 
+	  gtk_icon_view_paint_item (icon_view, cr, item, &expose->area, 
+				    icon_view->priv->bin_window,
+				    item->x, item->y,
+				    icon_view->priv->draw_focus); 
  
-      if (dest_index == item->index)
-	dest_item = item;
+	  if (dest_index == item->index)
+	    dest_item = item;
+	}
     }
 
   if (dest_item)
@@ -2025,8 +2096,8 @@ gtk_icon_view_set_cursor (GtkIconView     *icon_view,
   gtk_icon_view_stop_editing (icon_view, TRUE);
 
   if (gtk_tree_path_get_depth (path) == 1)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_nth_item (icon_view,
+				       gtk_tree_path_get_indices(path)[0]);
   
   if (!item)
     return;
@@ -2652,6 +2723,14 @@ static void
 gtk_icon_view_adjustment_changed (GtkAdjustment *adjustment,
 				  GtkIconView   *icon_view)
 {
+  GtkAdjustment *vadjustment = icon_view->priv->vadjustment;
+
+  /* Measure the items scrolled into view before they are painted */
+  if (vadjustment &&
+      gtk_icon_view_rows_estimated (icon_view, vadjustment->value,
+				    vadjustment->value + vadjustment->page_size))
+    gtk_icon_view_queue_layout (icon_view);
+
   if (GTK_WIDGET_REALIZED (icon_view))
     {
       gdk_window_move (icon_view->priv->bin_window,
@@ -2671,7 +2750,10 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
 				 gint         item_width,
 				 gint         row,
 				 gint        *y, 
-				 gint        *maximum_width)
+				 gint        *maximum_width,
+				 gboolean     measure,
+				 gint        *widest,
+				 gboolean    *estimated)
 {
   gint focus_width;
   gint x, current_width;
@@ -2679,16 +2761,24 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
   gint col;
   gint colspan;
   gint *max_height;
+  gint n_cells;
+  gint height;
   gint i;
   gboolean rtl;
 
   rtl = gtk_widget_get_direction (GTK_WIDGET (icon_view)) == GTK_TEXT_DIR_RTL;
-  max_height = g_new0 (gint, icon_view->priv->n_cells);
+
+  n_cells = icon_view->priv->n_cells;
+  g_array_set_size (icon_view->priv->row_cell_heights, (row + 1) * n_cells);
+  max_height = &g_array_index (icon_view->priv->row_cell_heights, gint, row * n_cells);
+  for (i = 0; i < n_cells; i++)
+    max_height[i] = 0;
 
   x = 0;
   col = 0;
   items = first_item;
   current_width = 0;
+  *estimated = FALSE;
 
   gtk_widget_style_get (GTK_WIDGET (icon_view),
 			"focus-line-width", &focus_width,
@@ -2702,10 +2792,34 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
     {
       GtkIconViewItem *item = items->data;
 
-      gtk_icon_view_calculate_item_size (icon_view, item);
-      colspan = 1 + (item->width - 1) / (item_width + icon_view->priv->column_spacing);
+      if (!measure && icon_view->priv->estimated_item_width >= 0 &&
+	  (item->width == -1 || item->estimated))
+	{
+	  item->width = icon_view->priv->estimated_item_width;
+	  item->height = icon_view->priv->estimated_item_height;
+	  item->estimated = TRUE;
+	  *estimated = TRUE;
+	}
+      else
+	gtk_icon_view_calculate_item_size (icon_view, item);
 
-      item->width = colspan * item_width + (colspan - 1) * icon_view->priv->column_spacing;
+      /* A guess must not make the other items wider */
+      if (item->estimated && icon_view->priv->item_width < 0)
+	item->width = MIN (item->width, item_width);
+
+      if (icon_view->priv->item_width < 0 && item->width > item_width)
+	{
+	  /* Wider than all items measured before, the caller
+	   * will lay out again with a bigger item width */
+	  *widest = MAX (*widest, item->width);
+	  colspan = 1;
+	}
+      else
+	{
+	  colspan = 1 + (item->width - 1) / (item_width + icon_view->priv->column_spacing);
+
+	  item->width = colspan * item_width + (colspan - 1) * icon_view->priv->column_spacing;
+	}
 
       current_width += item->width;
 
@@ -2723,14 +2837,16 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
 
       x = current_width - (icon_view->priv->margin + focus_width); 
 
-      for (i = 0; i < icon_view->priv->n_cells; i++)
-	max_height[i] = MAX (max_height[i], item->box[i].height);
+      if (!item->estimated)
+	for (i = 0; i < n_cells; i++)
+	  max_height[i] = MAX (max_height[i], item->box[i].height);
 	      
       if (current_width > *maximum_width)
 	*maximum_width = current_width;
 
       item->row = row;
       item->col = col;
+      item->boxes_valid = FALSE;
 
       col += colspan;
       items = items->next;
@@ -2738,6 +2854,19 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
 
   last_item = items;
 
+  /* All items of the row are as high as the tallest cells in it;
+   * the cell boxes are placed later, by gtk_icon_view_ensure_cell_boxes()
+   */
+  height = 0;
+  for (i = 0; i < n_cells; i++)
+    {
+      if (icon_view->priv->orientation == GTK_ORIENTATION_HORIZONTAL)
+	height = MAX (height, max_height[i]);
+      else
+	height += max_height[i] + (i > 0 ? icon_view->priv->spacing : 0);
+    }
+  height += icon_view->priv->item_padding * 2;
+
   /* Now go through the row again and align the icons */
   for (items = first_item; items != last_item; items = items->next)
     {
@@ -2749,15 +2878,16 @@ gtk_icon_view_layout_single_row (GtkIconView *icon_view,
 	  item->col = col - 1 - item->col;
 	}
 
-      gtk_icon_view_calculate_item_size2 (icon_view, item, max_height);
+      if (item->estimated)
+	item->height = MAX (item->height, height);
+      else
+	item->height = height;
 
       /* We may want to readjust the new y coordinate. */
       if (item->y + item->height + focus_width + icon_view->priv->row_spacing > *y)
 	*y = item->y + item->height + focus_width + icon_view->priv->row_spacing;
     }
 
-  g_free (max_height);
-  
   return last_item;
 }
 
@@ -2793,6 +2923,8 @@ gtk_icon_view_layout (GtkIconView *icon_view)
   GtkWidget *widget;
   gint row;
   gint item_width;
+  gint widest;
+  gint visible_y1, visible_y2;
 
   if (icon_view->priv->layout_idle_id != 0)
     {
@@ -2805,6 +2937,16 @@ gtk_icon_view_layout (GtkIconView *icon_view)
 
   widget = GTK_WIDGET (icon_view);
 
+  /* Items are only measured in the rows that end up in the visible
+   * area. The others are given the size of the last measured item,
+   * and are measured once they are scrolled into view, so that the
+   * cost of a relayout doesn't grow with the number of items that
+   * have never been shown.
+   */
+  visible_y1 = icon_view->priv->vadjustment->value;
+  visible_y2 = visible_y1 + MAX (widget->allocation.height,
+				 icon_view->priv->vadjustment->page_size);
+
   item_width = icon_view->priv->item_width;
 
   if (item_width < 0)
@@ -2812,30 +2954,78 @@ gtk_icon_view_layout (GtkIconView *icon_view)
       for (icons = icon_view->priv->items; icons; icons = icons->next)
 	{
 	  GtkIconViewItem *item = icons->data;
-	  gtk_icon_view_calculate_item_size (icon_view, item);
-	  item_width = MAX (item_width, item->width);
-	}
-    }
 
+	  if (item->width != -1 && !item->estimated)
+	    item_width = MAX (item_width, item->width);
+	}
 
-  icons = icon_view->priv->items;
-  y += icon_view->priv->margin;
-  row = 0;
+      if (item_width < 0 && icon_view->priv->items)
+	{
+	  GtkIconViewItem *item = icon_view->priv->items->data;
 
-  if (icons)
-    {
-      gtk_icon_view_set_cell_data (icon_view, icons->data);
-      adjust_wrap_width (icon_view, icons->data);
+	  gtk_icon_view_calculate_item_size (icon_view, item);
+	  item_width = item->width;
+	}
     }
-  
+
   do
     {
-      icons = gtk_icon_view_layout_single_row (icon_view, icons, 
-					       item_width, row,
-					       &y, &maximum_width);
-      row++;
+      icons = icon_view->priv->items;
+      y = icon_view->priv->margin;
+      maximum_width = 0;
+      row = 0;
+      widest = item_width;
+
+      g_array_set_size (icon_view->priv->rows, 0);
+
+      if (icons)
+	{
+	  gtk_icon_view_set_cell_data (icon_view, icons->data);
+	  adjust_wrap_width (icon_view, icons->data);
+	}
+
+      while (icons)
+	{
+	  GtkIconViewRow r;
+	  gint row_maximum_width;
+	  gboolean estimated;
+
+	  r.first_item = icons;
+	  r.y = y;
+	  row_maximum_width = maximum_width;
+
+	  icons = gtk_icon_view_layout_single_row (icon_view, r.first_item,
+						   item_width, row,
+						   &y, &maximum_width,
+						   r.y < visible_y2 &&
+						   r.y + icon_view->priv->estimated_item_height > visible_y1,
+						   &widest, &estimated);
+
+	  /* The row turned out to be visible after all */
+	  if (estimated && r.y < visible_y2 && y > visible_y1)
+	    {
+	      y = r.y;
+	      maximum_width = row_maximum_width;
+	      icons = gtk_icon_view_layout_single_row (icon_view, r.first_item,
+						       item_width, row,
+						       &y, &maximum_width,
+						       TRUE, &widest, &estimated);
+	    }
+
+	  r.height = y - r.y;
+	  r.estimated = estimated;
+	  g_array_append_val (icon_view->priv->rows, r);
+
+	  row++;
+	}
+
+      /* Newly measured items may be wider than the ones before */
+      if (widest > item_width)
+	item_width = widest;
+      else
+	break;
     }
-  while (icons != NULL);
+  while (TRUE);
 
   if (maximum_width != icon_view->priv->width)
     icon_view->priv->width = maximum_width;
@@ -2883,6 +3073,8 @@ gtk_icon_view_get_cell_area (GtkIconView         *icon_view,
 			     GtkIconViewCellInfo *info,
 			     GdkRectangle        *cell_area)
 {
+  gtk_icon_view_ensure_cell_boxes (icon_view, item);
+
   g_return_if_fail (info->position < item->n_cells);
 
   if (icon_view->priv->orientation == GTK_ORIENTATION_HORIZONTAL)
@@ -2909,6 +3101,8 @@ gtk_icon_view_get_cell_box (GtkIconView         *icon_view,
 			    GtkIconViewCellInfo *info,
 			    GdkRectangle        *box)
 {
+  gtk_icon_view_ensure_cell_boxes (icon_view, item);
+
   g_return_if_fail (info->position < item->n_cells);
 
   *box = item->box[info->position];
@@ -2969,7 +3163,7 @@ gtk_icon_view_calculate_item_size (GtkIconView     *icon_view,
   gint spacing;
   GList *l;
 
-  if (item->width != -1 && item->height != -1) 
+  if (item->width != -1 && item->height != -1 && !item->estimated) 
     return;
 
   if (item->n_cells != icon_view->priv->n_cells)
@@ -3018,6 +3212,12 @@ gtk_icon_view_calculate_item_size (GtkIconView     *icon_view,
 
   item->width += icon_view->priv->item_padding * 2;
   item->height += icon_view->priv->item_padding * 2;
+
+  item->estimated = FALSE;
+  item->boxes_valid = FALSE;
+
+  icon_view->priv->estimated_item_width = item->width;
+  icon_view->priv->estimated_item_height = item->height;
 }
 
 static void
@@ -3116,11 +3316,81 @@ gtk_icon_view_calculate_item_size2 (GtkIconView     *icon_view,
   item->height += icon_view->priv->item_padding * 2;
 }
 
+/* Places the cell boxes of @item within the area the last layout gave
+ * it. Doing that for every item on each relayout would mean going
+ * through the cell renderers for items that are never looked at.
+ */
+static void
+gtk_icon_view_ensure_cell_boxes (GtkIconView     *icon_view,
+				 GtkIconViewItem *item)
+{
+  GArray *rows = icon_view->priv->rows;
+  GArray *heights = icon_view->priv->row_cell_heights;
+  gint n_cells = icon_view->priv->n_cells;
+  gint *max_height;
+  gint i;
+
+  if (item->boxes_valid)
+    return;
+
+  if (item->estimated || item->n_cells != n_cells)
+    {
+      /* The size was only a guess; it is corrected by the next layout */
+      item->width = -1;
+      gtk_icon_view_calculate_item_size (icon_view, item);
+      gtk_icon_view_queue_layout (icon_view);
+    }
+
+  if (item->row < rows->len && heights->len == rows->len * n_cells)
+    {
+      gboolean grown = FALSE;
+
+      max_height = &g_array_index (heights, gint, item->row * n_cells);
+      for (i = 0; i < n_cells; i++)
+	if (item->box[i].height > max_height[i])
+	  {
+	    max_height[i] = item->box[i].height;
+	    grown = TRUE;
+	  }
+
+      /* The other items of the row were placed with the old heights,
+       * and the rows below have to move down */
+      if (grown)
+	{
+	  GList *l;
+
+	  for (l = g_array_index (rows, GtkIconViewRow, item->row).first_item;
+	       l && ((GtkIconViewItem *)l->data)->row == item->row;
+	       l = l->next)
+	    ((GtkIconViewItem *)l->data)->boxes_valid = FALSE;
+
+	  gtk_icon_view_queue_layout (icon_view);
+	}
+
+      gtk_icon_view_calculate_item_size2 (icon_view, item, max_height);
+    }
+  else
+    {
+      max_height = g_new (gint, n_cells);
+      for (i = 0; i < n_cells; i++)
+	max_height[i] = item->box[i].height;
+
+      gtk_icon_view_calculate_item_size2 (icon_view, item, max_height);
+
+      g_free (max_height);
+    }
+
+  item->boxes_valid = TRUE;
+}
+
 static void
 gtk_icon_view_invalidate_sizes (GtkIconView *icon_view)
 {
   g_list_foreach (icon_view->priv->items,
 		  (GFunc)gtk_icon_view_item_invalidate_size, NULL);
+
+  icon_view->priv->estimated_item_width = -1;
+  icon_view->priv->estimated_item_height = -1;
 }
 
 static void
@@ -3128,6 +3398,8 @@ gtk_icon_view_item_invalidate_size (GtkIconViewItem *item)
 {
   item->width = -1;
   item->height = -1;
+  item->estimated = FALSE;
+  item->boxes_valid = FALSE;
 }
 
 static void
@@ -3336,21 +3608,14 @@ static void
 gtk_icon_view_queue_draw_path (GtkIconView *icon_view,
 			       GtkTreePath *path)
 {
-  GList *l;
+  GtkIconViewItem *item;
   gint index;
 
   index = gtk_tree_path_get_indices (path)[0];
 
-  for (l = icon_view->priv->items; l; l = l->next) 
-    {
-      GtkIconViewItem *item = l->data;
-
-      if (item->index == index)
-	{
-	  gtk_icon_view_queue_draw_item (icon_view, item);
-	  break;
-	}
-    }
+  item = gtk_icon_view_get_nth_item (icon_view, index);
+  if (item)
+    gtk_icon_view_queue_draw_item (icon_view, item);
 }
 
 static void
@@ -3396,6 +3661,91 @@ gtk_icon_view_queue_layout (GtkIconView *icon_view)
   icon_view->priv->layout_idle_id = gdk_threads_add_idle (layout_callback, icon_view);
 }
 
+/* Returns the index of the first row that ends below @y */
+static guint
+gtk_icon_view_find_row (GtkIconView *icon_view,
+			gint         y)
+{
+  GArray *rows = icon_view->priv->rows;
+  GtkIconViewRow *r;
+  guint lo, hi, mid;
+
+  lo = 0;
+  hi = rows->len;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      r = &g_array_index (rows, GtkIconViewRow, mid);
+      if (r->y + r->height > y)
+	hi = mid;
+      else
+	lo = mid + 1;
+    }
+
+  return lo;
+}
+
+/* Whether any row between @y1 and @y2 was laid out with guessed sizes */
+static gboolean
+gtk_icon_view_rows_estimated (GtkIconView *icon_view,
+			      gint         y1,
+			      gint         y2)
+{
+  GArray *rows = icon_view->priv->rows;
+  GtkIconViewRow *r;
+  guint row;
+
+  for (row = gtk_icon_view_find_row (icon_view, y1); row < rows->len; row++)
+    {
+      r = &g_array_index (rows, GtkIconViewRow, row);
+      if (r->y >= y2)
+	break;
+
+      if (r->estimated)
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+static GtkIconViewItem *
+gtk_icon_view_get_nth_item (GtkIconView *icon_view,
+			    gint         index)
+{
+  GArray *rows = icon_view->priv->rows;
+  GtkIconViewItem *item;
+  GList *list;
+  guint lo, hi, mid;
+
+  if (rows->len == 0)
+    return g_list_nth_data (icon_view->priv->items, index);
+
+  /* find the last row starting at or before @index */
+  lo = 0;
+  hi = rows->len;
+  while (hi - lo > 1)
+    {
+      mid = (lo + hi) / 2;
+      item = g_array_index (rows, GtkIconViewRow, mid).first_item->data;
+      if (item->index <= index)
+	lo = mid;
+      else
+	hi = mid;
+    }
+
+  for (list = g_array_index (rows, GtkIconViewRow, lo).first_item;
+       list; list = list->next)
+    {
+      item = list->data;
+      if (item->index == index)
+	return item;
+      if (item->index > index)
+	break;
+    }
+
+  return NULL;
+}
+
 static void
 gtk_icon_view_set_cursor_item (GtkIconView     *icon_view,
 			       GtkIconViewItem *item,
@@ -3471,16 +3821,33 @@ gtk_icon_view_get_item_at_coords (GtkIconView          *icon_view,
 				  gboolean              only_in_cell,
 				  GtkIconViewCellInfo **cell_at_pos)
 {
+  GArray *rows = icon_view->priv->rows;
   GList *items, *l;
   GdkRectangle box;
+  guint row;
 
   if (cell_at_pos)
     *cell_at_pos = NULL;
 
-  for (items = icon_view->priv->items; items; items = items->next)
+  /* Start at the first row the point can be in */
+  if (rows->len > 0)
+    {
+      row = gtk_icon_view_find_row (icon_view, y - icon_view->priv->row_spacing/2);
+      if (row == rows->len)
+	return NULL;
+
+      items = g_array_index (rows, GtkIconViewRow, row).first_item;
+    }
+  else
+    items = icon_view->priv->items;
+
+  for (; items; items = items->next)
     {
       GtkIconViewItem *item = items->data;
 
+      if (rows->len > 0 && item->y - icon_view->priv->row_spacing/2 > y)
+	break;
+
       if (x >= item->x - icon_view->priv->column_spacing/2 && x <= item->x + item->width + icon_view->priv->column_spacing/2 &&
 	  y >= item->y - icon_view->priv->row_spacing/2 && y <= item->y + item->height + icon_view->priv->row_spacing/2)
 	{
@@ -3601,7 +3968,7 @@ gtk_icon_view_row_changed (GtkTreeModel *model,
   gtk_icon_view_stop_editing (icon_view, TRUE);
   
   index = gtk_tree_path_get_indices(path)[0];
-  item = g_list_nth_data (icon_view->priv->items, index);
+  item = gtk_icon_view_get_nth_item (icon_view, index);
 
   gtk_icon_view_item_invalidate_size (item);
   gtk_icon_view_queue_layout (icon_view);
@@ -3651,6 +4018,7 @@ gtk_icon_view_row_inserted (GtkTreeModel *model,
     
   verify_items (icon_view);
 
+  g_array_set_size (icon_view->priv->rows, 0);
   gtk_icon_view_queue_layout (icon_view);
 }
 
@@ -3696,6 +4064,7 @@ gtk_icon_view_row_deleted (GtkTreeModel *model,
 
   verify_items (icon_view);  
   
+  g_array_set_size (icon_view->priv->rows, 0);
   gtk_icon_view_queue_layout (icon_view);
 
   if (emit)
@@ -3741,6 +4110,7 @@ gtk_icon_view_rows_reordered (GtkTreeModel *model,
   g_list_free (icon_view->priv->items);
   icon_view->priv->items = items;
 
+  g_array_set_size (icon_view->priv->rows, 0);
   gtk_icon_view_queue_layout (icon_view);
 
   verify_items (icon_view);  
@@ -3780,6 +4150,45 @@ gtk_icon_view_build_items (GtkIconView *icon_view)
   icon_view->priv->items = g_list_reverse (items);
 }
 
+static void
+gtk_icon_view_children_reloaded (GtkTreeModel *model,
+				 GtkTreePath  *path,
+				 GtkTreeIter  *iter,
+				 gpointer      data)
+{
+  GtkIconView *icon_view;
+  GList *list;
+  gboolean emit = FALSE;
+
+  icon_view = GTK_ICON_VIEW (data);
+
+  gtk_icon_view_stop_editing (icon_view, TRUE);
+
+  for (list = icon_view->priv->items; list; list = list->next)
+    {
+      GtkIconViewItem *item = list->data;
+
+      if (item->selected)
+	emit = TRUE;
+
+      gtk_icon_view_item_free (item);
+    }
+  g_list_free (icon_view->priv->items);
+  icon_view->priv->items = NULL;
+
+  icon_view->priv->anchor_item = NULL;
+  icon_view->priv->cursor_item = NULL;
+  icon_view->priv->last_single_clicked = NULL;
+
+  gtk_icon_view_build_items (icon_view);
+
+  g_array_set_size (icon_view->priv->rows, 0);
+  gtk_icon_view_queue_layout (icon_view);
+
+  if (emit)
+    g_signal_emit (icon_view, icon_view_signals[SELECTION_CHANGED], 0);
+}
+
 static void
 gtk_icon_view_add_move_binding (GtkBindingSet  *binding_set,
 				guint           keyval,
@@ -4355,8 +4764,8 @@ gtk_icon_view_scroll_to_path (GtkIconView *icon_view,
   g_return_if_fail (col_align >= 0.0 && col_align <= 1.0);
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_nth_item (icon_view,
+				       gtk_tree_path_get_indices(path)[0]);
   
   if (!GTK_WIDGET_REALIZED (icon_view) || !item || item->width < 0)
     {
@@ -4927,8 +5336,8 @@ gtk_icon_view_set_tooltip_cell (GtkIconView     *icon_view,
   g_return_if_fail (cell == NULL || GTK_IS_CELL_RENDERER (cell));
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-                            gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_nth_item (icon_view,
+                                       gtk_tree_path_get_indices(path)[0]);
  
   if (!item)
     return;
@@ -5154,7 +5563,9 @@ gtk_icon_view_get_visible_range (GtkIconView  *icon_view,
 {
   gint start_index = -1;
   gint end_index = -1;
+  GArray *rows;
   GList *icons;
+  guint row;
 
   g_return_val_if_fail (GTK_IS_ICON_VIEW (icon_view), FALSE);
 
@@ -5164,11 +5575,25 @@ gtk_icon_view_get_visible_range (GtkIconView  *icon_view,
 
   if (start_path == NULL && end_path == NULL)
     return FALSE;
+
+  rows = icon_view->priv->rows;
+  if (rows->len > 0)
+    {
+      row = gtk_icon_view_find_row (icon_view,
+				    (int)icon_view->priv->vadjustment->value - 1);
+      icons = row < rows->len ? g_array_index (rows, GtkIconViewRow, row).first_item : NULL;
+    }
+  else
+    icons = icon_view->priv->items;
   
-  for (icons = icon_view->priv->items; icons; icons = icons->next) 
+  for (; icons; icons = icons->next) 
     {
       GtkIconViewItem *item = icons->data;
 
+      if (rows->len > 0 &&
+	  item->y > (int) (icon_view->priv->vadjustment->value + icon_view->priv->vadjustment->page_size))
+	break;
+
       if ((item->x + item->width >= (int)icon_view->priv->hadjustment->value) &&
 	  (item->y + item->height >= (int)icon_view->priv->vadjustment->value) &&
 	  (item->x <= (int) (icon_view->priv->hadjustment->value + icon_view->priv->hadjustment->page_size)) &&
@@ -5339,12 +5764,18 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
       g_signal_handlers_disconnect_by_func (icon_view->priv->model,
 					    gtk_icon_view_rows_reordered,
 					    icon_view);
+      g_signal_handlers_disconnect_by_func (icon_view->priv->model,
+					    gtk_icon_view_children_reloaded,
+					    icon_view);
 
       g_object_unref (icon_view->priv->model);
       
       g_list_foreach (icon_view->priv->items, (GFunc)gtk_icon_view_item_free, NULL);
       g_list_free (icon_view->priv->items);
       icon_view->priv->items = NULL;
+      g_array_set_size (icon_view->priv->rows, 0);
+      icon_view->priv->estimated_item_width = -1;
+      icon_view->priv->estimated_item_height = -1;
       icon_view->priv->anchor_item = NULL;
       icon_view->priv->cursor_item = NULL;
       icon_view->priv->last_single_clicked = NULL;
@@ -5373,6 +5804,10 @@ gtk_icon_view_set_model (GtkIconView *icon_view,
 			"rows-reordered",
 			G_CALLBACK (gtk_icon_view_rows_reordered),
 			icon_view);
+      g_signal_connect (icon_view->priv->model,
+			"children-reloaded",
+			G_CALLBACK (gtk_icon_view_children_reloaded),
+			icon_view);
 
       gtk_icon_view_build_items (icon_view);
 
@@ -5748,8 +6183,8 @@ gtk_icon_view_select_path (GtkIconView *icon_view,
   g_return_if_fail (path != NULL);
 
   if (gtk_tree_path_get_depth (path) > 0)
-    item = g_list_nth_data (icon_view->priv->items,
-			    gtk_tree_path_get_indices(path)[0]);
+    item = gtk_icon_view_get_nth_item (icon_view,
+				       gtk_tree_path_get_indices(path)[0]);
 
   if (item)
     gtk_icon_view_select_item (icon_view, item);
@@ -5774,8 +6209,8 @@ gtk_icon_view_unselect_path (GtkIconView *icon_view,
   g_return_if_fail (icon_view->priv->model != NULL);
   g_return_if_fail (path != NULL);
 
-  item = g_list_nth_data (icon_view->priv->items,
-			  gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_nth_item (icon_view,
+				     gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return;
@@ -5907,8 +6342,8 @@ gtk_icon_view_path_is_selected (GtkIconView *icon_view,
   g_return_val_if_fail (icon_view->priv->model != NULL, FALSE);
   g_return_val_if_fail (path != NULL, FALSE);
   
-  item = g_list_nth_data (icon_view->priv->items,
-			  gtk_tree_path_get_indices(path)[0]);
+  item = gtk_icon_view_get_nth_item (icon_view,
+				     gtk_tree_path_get_indices(path)[0]);
 
   if (!item)
     return FALSE;
@@ -9270,6 +9705,50 @@ gtk_icon_view_accessible_model_rows_reordered (GtkTreeModel *tree_model,
   return;
 }
 
+static void
+gtk_icon_view_accessible_clear_cache (GtkIconViewAccessiblePrivate *priv)
+{
+  GtkIconViewItemAccessibleInfo *info;
+  GList *items;
+
+  items = priv->items;
+  while (items)
+    {
+      info = (GtkIconViewItemAccessibleInfo *) items->data;
+      g_object_unref (info->item);
+      g_free (items->data);
+      items = items->next;
+    }
+  g_list_free (priv->items);
+  priv->items = NULL;
+}
+
+static void
+gtk_icon_view_accessible_model_children_reloaded (GtkTreeModel *tree_model,
+                                                  GtkTreePath  *path,
+                                                  GtkTreeIter  *iter,
+                                                  gpointer      user_data)
+{
+  GtkIconViewAccessiblePrivate *priv;
+  GtkIconViewItemAccessibleInfo *info;
+  AtkObject *atk_obj;
+  GList *items;
+
+  atk_obj = gtk_widget_get_accessible (GTK_WIDGET (user_data));
+  priv = gtk_icon_view_accessible_get_priv (atk_obj);
+
+  /* The items the cached children pointed to are gone */
+  for (items = priv->items; items; items = items->next)
+    {
+      info = items->data;
+      gtk_icon_view_item_accessible_add_state (GTK_ICON_VIEW_ITEM_ACCESSIBLE (info->item),
+                                               ATK_STATE_DEFUNCT, TRUE);
+    }
+  gtk_icon_view_accessible_clear_cache (priv);
+
+  g_signal_emit_by_name (atk_obj, "visible-data-changed");
+}
+
 static void
 gtk_icon_view_accessible_disconnect_model_signals (GtkTreeModel *model,
                                                    GtkWidget *widget)
@@ -9281,6 +9760,7 @@ gtk_icon_view_accessible_disconnect_model_signals (GtkTreeModel *model,
   g_signal_handlers_disconnect_by_func (obj, (gpointer) gtk_icon_view_accessible_model_row_inserted, widget);
   g_signal_handlers_disconnect_by_func (obj, (gpointer) gtk_icon_view_accessible_model_row_deleted, widget);
   g_signal_handlers_disconnect_by_func (obj, (gpointer) gtk_icon_view_accessible_model_rows_reordered, widget);
+  g_signal_handlers_disconnect_by_func (obj, (gpointer) gtk_icon_view_accessible_model_children_reloaded, widget);
 }
 
 static void
@@ -9301,24 +9781,9 @@ gtk_icon_view_accessible_connect_model_signals (GtkIconView *icon_view)
   g_signal_connect_data (obj, "rows-reordered",
                          (GCallback) gtk_icon_view_accessible_model_rows_reordered, 
                          icon_view, NULL, G_CONNECT_AFTER);
-}
-
-static void
-gtk_icon_view_accessible_clear_cache (GtkIconViewAccessiblePrivate *priv)
-{
-  GtkIconViewItemAccessibleInfo *info;
-  GList *items;
-
-  items = priv->items;
-  while (items)
-    {
-      info = (GtkIconViewItemAccessibleInfo *) items->data;
-      g_object_unref (info->item);
-      g_free (items->data);
-      items = items->next;
-    }
-  g_list_free (priv->items);
-  priv->items = NULL;
+  g_signal_connect_data (obj, "children-reloaded",
+                         (GCallback) gtk_icon_view_accessible_model_children_reloaded,
+                         icon_view, NULL, G_CONNECT_AFTER);
 }
 
 static void
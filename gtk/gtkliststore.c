@@ -1694,6 +1694,63 @@ gtk_list_store_compare_func (GSequenceIter *a,
   return retval;
 }
 
+/* If the store is sorted with the default compare function, extracts
+ * every row's key once and sorts on those instead of comparing rows.
+ * Returns the new order, or %NULL if the rows were left untouched.
+ */
+static gint *
+gtk_list_store_sort_by_keys (GtkListStore *list_store)
+{
+  GtkTreeDataSortHeader *header;
+  GtkTreeDataSortKeys *keys;
+  GSequenceIter **ptrs;
+  GSequenceIter *ptr;
+  GtkTreeIter iter;
+  gint *new_order;
+  gint length;
+  gint i;
+
+  if (list_store->sort_column_id == -1)
+    return NULL;
+
+  header = _gtk_tree_data_list_get_header (list_store->sort_list,
+					   list_store->sort_column_id);
+  if (header == NULL)
+    return NULL;
+
+  length = g_sequence_get_length (list_store->seq);
+  keys = _gtk_tree_data_list_sort_keys_new (GTK_TREE_MODEL (list_store),
+					    header->func, header->data,
+					    length);
+  if (keys == NULL)
+    return NULL;
+
+  ptrs = g_new (GSequenceIter *, length);
+  iter.stamp = list_store->stamp;
+
+  ptr = g_sequence_get_begin_iter (list_store->seq);
+  for (i = 0; i < length; i++)
+    {
+      ptrs[i] = ptr;
+      iter.user_data = ptr;
+      _gtk_tree_data_list_sort_keys_add (keys, &iter);
+      ptr = g_sequence_iter_next (ptr);
+    }
+
+  new_order = g_new (gint, length);
+  _gtk_tree_data_list_sort_keys_sort (keys, list_store->order, new_order);
+  _gtk_tree_data_list_sort_keys_free (keys);
+
+  /* moving the rows to the end one after the other keeps iters valid */
+  ptr = g_sequence_get_end_iter (list_store->seq);
+  for (i = 0; i < length; i++)
+    g_sequence_move (ptrs[new_order[i]], ptr);
+
+  g_free (ptrs);
+
+  return new_order;
+}
+
 static void
 gtk_list_store_sort (GtkListStore *list_store)
 {
@@ -1705,12 +1762,17 @@ gtk_list_store_sort (GtkListStore *list_store)
       g_sequence_get_length (list_store->seq) <= 1)
     return;
 
-  old_positions = save_positions (list_store->seq);
+  new_order = gtk_list_store_sort_by_keys (list_store);
+  if (new_order == NULL)
+    {
+      old_positions = save_positions (list_store->seq);
 
-  g_sequence_sort_iter (list_store->seq, gtk_list_store_compare_func, list_store);
+      g_sequence_sort_iter (list_store->seq, gtk_list_store_compare_func, list_store);
+
+      new_order = generate_order (list_store->seq, old_positions);
+    }
 
   /* Let the world know about our new order */
-  new_order = generate_order (list_store->seq, old_positions);
 
   path = gtk_tree_path_new ();
   gtk_tree_model_rows_reordered (GTK_TREE_MODEL (list_store),
@@ -2040,6 +2102,87 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_append_bulk:
+ * @list_store: A #GtkListStore
+ * @n_rows: the number of rows to append
+ * @columns: an array of column numbers
+ * @values: an array of @n_values arrays, each holding the @n_rows
+ *     values of the matching column in @columns
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * Appends @n_rows rows to @list_store in one go, taking the values
+ * column by column.  If the store is sorted, the rows end up in sorted
+ * order, but the list is sorted only once.
+ *
+ * Instead of emitting a #GtkTreeModel::row-inserted signal for every
+ * row, this emits a single #GtkTreeModel::children-reloaded signal for
+ * the whole list, so that views rebuild their state in one pass.  As a
+ * consequence, row references, the selection and the cursor on rows
+ * that were already in the store are lost.  This function is meant for
+ * filling a store with many rows, not for adding a few rows to a long
+ * list.  Code that keeps its own state about the rows of the store
+ * must handle #GtkTreeModel::children-reloaded, as all the GTK+ widgets
+ * that show a model do.
+ *
+ * Since: 2.20
+ */
+void
+gtk_list_store_append_bulk (GtkListStore  *list_store,
+			    gint           n_rows,
+			    gint          *columns,
+			    GValue       **values,
+			    gint           n_values)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GSequence *seq;
+  gint row;
+  gint i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  for (i = 0; i < n_values; i++)
+    g_return_if_fail (columns[i] >= 0 && columns[i] < list_store->n_columns);
+
+  if (n_rows == 0)
+    return;
+
+  list_store->columns_dirty = TRUE;
+
+  seq = list_store->seq;
+  iter.stamp = list_store->stamp;
+
+  for (row = 0; row < n_rows; row++)
+    {
+      iter.user_data = g_sequence_append (seq, NULL);
+
+      for (i = 0; i < n_values; i++)
+	gtk_list_store_real_set_value (list_store, &iter,
+				       columns[i], &values[i][row],
+				       FALSE);
+    }
+
+  list_store->length += n_rows;
+
+  /* Nobody has seen the new order yet, so no ::rows-reordered */
+  if (GTK_LIST_STORE_IS_SORTED (list_store))
+    {
+      gint *new_order;
+
+      new_order = gtk_list_store_sort_by_keys (list_store);
+      if (new_order == NULL)
+	g_sequence_sort_iter (seq, gtk_list_store_compare_func, list_store);
+      g_free (new_order);
+    }
+
+  path = gtk_tree_path_new ();
+  gtk_tree_model_children_reloaded (GTK_TREE_MODEL (list_store), path, NULL);
+  gtk_tree_path_free (path);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
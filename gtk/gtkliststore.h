@@ -121,6 +121,11 @@ void          gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+void          gtk_list_store_append_bulk      (GtkListStore  *list_store,
+					       gint           n_rows,
+					       gint          *columns,
+					       GValue       **values,
+					       gint           n_values);
 void          gtk_list_store_prepend          (GtkListStore *list_store,
 					       GtkTreeIter  *iter);
 void          gtk_list_store_append           (GtkListStore *list_store,
@@ -0,0 +1,97 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+
+#include "gtkpangothreads.h"
+#include "gtkalias.h"
+
+static GStaticPrivate thread_font_map = G_STATIC_PRIVATE_INIT;
+
+/* Shaping text in several threads at once is only safe from Pango 1.32
+ * on. With older versions, or without threads, text is laid out in the
+ * main thread.
+ */
+gboolean
+_gtk_pango_threads_supported (void)
+{
+  static volatile gsize thread_safe = 0;
+
+  if (!g_thread_supported ())
+    return FALSE;
+
+  if (g_once_init_enter (&thread_safe))
+    g_once_init_leave (&thread_safe,
+                       pango_version_check (1, 32, 0) == NULL ? 1 : 2);
+
+  return thread_safe == 1;
+}
+
+/* The number of threads worth starting, one per online processor */
+guint
+_gtk_pango_threads_get_n_threads (void)
+{
+  static volatile gsize n_processors = 0;
+
+  if (g_once_init_enter (&n_processors))
+    {
+      long n = 1;
+
+#ifdef _SC_NPROCESSORS_ONLN
+      n = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+      g_once_init_leave (&n_processors, MAX (n, 1));
+    }
+
+  return n_processors;
+}
+
+/* Creates a context for the calling thread, with the settings taken
+ * from a context of the main thread.
+ */
+PangoContext *
+_gtk_pango_threads_context_new (gdouble                     resolution,
+                                const cairo_font_options_t *font_options,
+                                const PangoFontDescription *font_desc,
+                                PangoLanguage              *language,
+                                PangoDirection              base_dir)
+{
+  PangoFontMap *font_map;
+  PangoContext *context;
+
+  /* Font maps can't be shared between threads */
+  font_map = g_static_private_get (&thread_font_map);
+  if (font_map == NULL)
+    {
+      font_map = pango_cairo_font_map_new ();
+      g_static_private_set (&thread_font_map, font_map, g_object_unref);
+    }
+
+  context = pango_cairo_font_map_create_context (PANGO_CAIRO_FONT_MAP (font_map));
+  pango_cairo_context_set_resolution (context, resolution);
+  pango_cairo_context_set_font_options (context, font_options);
+  pango_context_set_font_description (context, font_desc);
+  pango_context_set_language (context, language);
+  pango_context_set_base_dir (context, base_dir);
+
+  return context;
+}
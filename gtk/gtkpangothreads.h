@@ -0,0 +1,41 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 1995-1997 Peter Mattis, Spencer Kimball and Josh MacDonald
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_PANGO_THREADS_H__
+#define __GTK_PANGO_THREADS_H__
+
+#include <pango/pangocairo.h>
+
+G_BEGIN_DECLS
+
+/* This is a private uninstalled header shared between GtkTreeView
+ * and GtkTextLayout, which lay out text in a thread pool
+ */
+
+gboolean      _gtk_pango_threads_supported     (void);
+guint         _gtk_pango_threads_get_n_threads (void);
+PangoContext *_gtk_pango_threads_context_new   (gdouble                     resolution,
+                                                const cairo_font_options_t *font_options,
+                                                const PangoFontDescription *font_desc,
+                                                PangoLanguage              *language,
+                                                PangoDirection              base_dir);
+
+G_END_DECLS
+
+#endif /* __GTK_PANGO_THREADS_H__ */
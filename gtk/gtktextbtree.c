@@ -1086,6 +1086,31 @@ _gtk_text_btree_delete (GtkTextIter *start,
   gtk_text_btree_resolve_bidi (start, end);
 }
 
+/* Whether @text has paragraph delimiters other than a plain '\n', that
+ * is '\r' or U+2029 PARAGRAPH SEPARATOR. If it does not, lines can be
+ * split with memchr() instead of pango_find_paragraph_boundary().
+ */
+static gboolean
+has_other_paragraph_delimiters (const gchar *text,
+                                gint         len)
+{
+  const gchar *p, *end;
+
+  if (memchr (text, '\r', len) != NULL)
+    return TRUE;
+
+  /* U+2029 is "\342\200\251" */
+  for (p = text, end = text + len;
+       (p = memchr (p, '\342', end - p)) != NULL;
+       p++)
+    {
+      if (end - p >= 3 && p[1] == '\200' && p[2] == '\251')
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
 void
 _gtk_text_btree_insert (GtkTextIter *iter,
                         const gchar *text,
@@ -1115,7 +1140,11 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   int char_count_delta;                /* change to number of chars */
   GtkTextBTree *tree;
   gint start_byte_index;
+  gint end_byte_index;
+  gint last_sol;                       /* start of the text in the last
+                                        * new line */
   GtkTextLine *start_line;
+  gboolean newlines_only;
 
   g_return_if_fail (text != NULL);
   g_return_if_fail (iter != NULL);
@@ -1123,6 +1152,8 @@ _gtk_text_btree_insert (GtkTextIter *iter,
   if (len < 0)
     len = strlen (text);
 
+  newlines_only = !has_other_paragraph_delimiters (text, len);
+
   /* extract iterator info */
   tree = _gtk_text_iter_get_btree (iter);
   line = _gtk_text_iter_get_text_line (iter);
@@ -1150,20 +1181,31 @@ _gtk_text_btree_insert (GtkTextIter *iter,
 
   eol = 0;
   sol = 0;
+  last_sol = 0;
   line_count_delta = 0;
   char_count_delta = 0;
   while (eol < len)
     {
       sol = eol;
       
-      pango_find_paragraph_boundary (text + sol,
-                                     len - sol,
-                                     &delim,
-                                     &eol);      
+      if (newlines_only)
+        {
+          const gchar *nl = memchr (text + sol, '\n', len - sol);
+
+          delim = nl ? nl - text : len;
+          eol = nl ? delim + 1 : len;
+        }
+      else
+        {
+          pango_find_paragraph_boundary (text + sol,
+                                         len - sol,
+                                         &delim,
+                                         &eol);      
 
-      /* make these relative to the start of the text */
-      delim += sol;
-      eol += sol;
+          /* make these relative to the start of the text */
+          delim += sol;
+          eol += sol;
+        }
 
       g_assert (eol >= sol);
       g_assert (delim >= sol);
@@ -1209,9 +1251,16 @@ _gtk_text_btree_insert (GtkTextIter *iter,
       seg->next = NULL;
       line = newline;
       cur_seg = NULL;
+      last_sol = eol;
       line_count_delta++;
     }
 
+  /* The inserted text ends in the last line we added to */
+  if (line == start_line)
+    end_byte_index = start_byte_index + len;
+  else
+    end_byte_index = len - last_sol;
+
   /*
    * Cleanup the starting line for the insertion, plus the ending
    * line if it's different.
@@ -1236,12 +1285,10 @@ _gtk_text_btree_insert (GtkTextIter *iter,
                                       &start,
                                       start_line,
                                       start_byte_index);
-    end = start;
-
-    /* We could almost certainly be more efficient here
-       by saving the information from the insertion loop
-       above. FIXME */
-    gtk_text_iter_forward_chars (&end, char_count_delta);
+    _gtk_text_btree_get_iter_at_line (tree,
+                                      &end,
+                                      line,
+                                      end_byte_index);
 
     DV (g_print ("invalidating due to inserting some text (%s)\n", G_STRLOC));
     _gtk_text_btree_invalidate_region (tree, &start, &end, FALSE);
@@ -4720,7 +4767,7 @@ gtk_text_line_new (void)
 {
   GtkTextLine *line;
 
-  line = g_new0(GtkTextLine, 1);
+  line = g_slice_new0 (GtkTextLine);
   line->dir_strong = PANGO_DIRECTION_NEUTRAL;
   line->dir_propagated_forward = PANGO_DIRECTION_NEUTRAL;
   line->dir_propagated_back = PANGO_DIRECTION_NEUTRAL;
@@ -4751,7 +4798,7 @@ gtk_text_line_destroy (GtkTextBTree *tree, GtkTextLine *line)
       ld = next;
     }
 
-  g_free (line);
+  g_slice_free (GtkTextLine, line);
 }
 
 static void
@@ -5429,6 +5476,97 @@ _gtk_text_btree_validate_line (GtkTextBTree     *tree,
     }
 }
 
+/**
+ * _gtk_text_btree_get_first_invalid_line:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID
+ *
+ * Finds the first line that is not wrapped for the given view,
+ * following the invalid nodes down from the root.
+ *
+ * Return value: the first invalid line, or %NULL if there is none
+ *   to be found this way
+ **/
+GtkTextLine *
+_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                        gpointer      view_id)
+{
+  GtkTextBTreeNode *node;
+  GtkTextLine *line;
+  NodeData *nd;
+
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  node = tree->root_node;
+  nd = node_data_find (node->node_data, view_id);
+  if (nd && nd->valid)
+    return NULL;
+
+  while (node->level > 0)
+    {
+      GtkTextBTreeNode *child = node->children.node;
+
+      while (child)
+        {
+          nd = node_data_find (child->node_data, view_id);
+          if (!nd || !nd->valid)
+            break;
+
+          child = child->next;
+        }
+
+      /* Node data that is merely out of date; leave it to
+       * _gtk_text_btree_validate()
+       */
+      if (child == NULL)
+        return NULL;
+
+      node = child;
+    }
+
+  for (line = node->children.line; line; line = line->next)
+    {
+      GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+      if (!ld || !ld->valid)
+        return line;
+    }
+
+  return NULL;
+}
+
+/**
+ * _gtk_text_btree_lines_wrapped:
+ * @tree: a #GtkTextBTree
+ * @view_id: view ID for the view the lines were wrapped for
+ * @lines: lines in buffer order, whose line data was filled in
+ *   outside of gtk_text_layout_wrap()
+ * @n_lines: number of lines in @lines
+ *
+ * Recomputes the view aggregates of the nodes above @lines. Runs of
+ * lines in the same node are only propagated once.
+ **/
+void
+_gtk_text_btree_lines_wrapped (GtkTextBTree  *tree,
+                               gpointer       view_id,
+                               GtkTextLine  **lines,
+                               gint           n_lines)
+{
+  GtkTextBTreeNode *last_parent = NULL;
+  gint i;
+
+  g_return_if_fail (tree != NULL);
+
+  for (i = 0; i < n_lines; i++)
+    {
+      if (lines[i]->parent == last_parent)
+        continue;
+
+      last_parent = lines[i]->parent;
+      gtk_text_btree_node_check_valid_upward (last_parent, view_id);
+    }
+}
+
 static void
 gtk_text_btree_node_remove_view (BTreeView *view, GtkTextBTreeNode *node, gpointer view_id)
 {
@@ -5723,12 +5861,23 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
        * then split off all but the first MIN_CHILDREN into a separate
        * GtkTextBTreeNode following the original one.  Then repeat until the
        * GtkTextBTreeNode has a decent size.
+       *
+       * A node that got many children at once, as after inserting a
+       * large text, is cut into full nodes of MAX_CHILDREN instead, so
+       * the tree is built bottom-up with half as many nodes.
        */
 
       if (node->num_children > MAX_CHILDREN)
         {
           while (1)
             {
+              int keep;
+
+              if (node->num_children > 2 * MAX_CHILDREN)
+                keep = MAX_CHILDREN;
+              else
+                keep = MIN_CHILDREN;
+
               /*
                * If the GtkTextBTreeNode being split is the root
                * GtkTextBTreeNode, then make a new root GtkTextBTreeNode above
@@ -5752,10 +5901,10 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
               node->next = new_node;
               new_node->summary = NULL;
               new_node->level = node->level;
-              new_node->num_children = node->num_children - MIN_CHILDREN;
+              new_node->num_children = node->num_children - keep;
               if (node->level == 0)
                 {
-                  for (i = MIN_CHILDREN-1,
+                  for (i = keep-1,
                          line = node->children.line;
                        i > 0; i--, line = line->next)
                     {
@@ -5766,7 +5915,7 @@ gtk_text_btree_rebalance (GtkTextBTree *tree,
                 }
               else
                 {
-                  for (i = MIN_CHILDREN-1,
+                  for (i = keep-1,
                          child = node->children.node;
                        i > 0; i--, child = child->next)
                     {
@@ -109,6 +109,12 @@ gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
 void         _gtk_text_btree_validate_line     (GtkTextBTree      *tree,
                                                 GtkTextLine       *line,
                                                 gpointer           view_id);
+GtkTextLine *_gtk_text_btree_get_first_invalid_line (GtkTextBTree *tree,
+                                                     gpointer      view_id);
+void         _gtk_text_btree_lines_wrapped     (GtkTextBTree      *tree,
+                                                gpointer           view_id,
+                                                GtkTextLine      **lines,
+                                                gint               n_lines);
 
 /* Tag */
 
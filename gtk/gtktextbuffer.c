@@ -131,6 +131,9 @@ static void gtk_text_buffer_real_mark_set              (GtkTextBuffer     *buffe
 
 static GtkTextBTree* get_btree (GtkTextBuffer *buffer);
 static void          free_log_attr_cache (GtkTextLogAttrCache *cache);
+static void          invalidate_log_attrs (GtkTextBuffer     *buffer,
+                                           const GtkTextIter *start,
+                                           const GtkTextIter *end);
 
 static void remove_all_selection_clipboards       (GtkTextBuffer *buffer);
 static void update_selection_clipboards           (GtkTextBuffer *buffer);
@@ -865,6 +868,7 @@ gtk_text_buffer_real_insert_text (GtkTextBuffer *buffer,
   g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
   g_return_if_fail (iter != NULL);
   
+  invalidate_log_attrs (buffer, iter, iter);
   _gtk_text_btree_insert (iter, text, len);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -1580,6 +1584,7 @@ gtk_text_buffer_real_delete_range (GtkTextBuffer *buffer,
   g_return_if_fail (start != NULL);
   g_return_if_fail (end != NULL);
 
+  invalidate_log_attrs (buffer, start, end);
   _gtk_text_btree_delete (start, end);
 
   /* may have deleted the selection... */
@@ -1870,6 +1875,7 @@ gtk_text_buffer_real_insert_pixbuf (GtkTextBuffer *buffer,
                                     GtkTextIter   *iter,
                                     GdkPixbuf     *pixbuf)
 { 
+  invalidate_log_attrs (buffer, iter, iter);
   _gtk_text_btree_insert_pixbuf (iter, pixbuf);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -1914,6 +1920,7 @@ gtk_text_buffer_real_insert_anchor (GtkTextBuffer      *buffer,
                                     GtkTextIter        *iter,
                                     GtkTextChildAnchor *anchor)
 {
+  invalidate_log_attrs (buffer, iter, iter);
   _gtk_text_btree_insert_child_anchor (iter, anchor);
 
   g_signal_emit (buffer, signals[CHANGED], 0);
@@ -4228,48 +4235,116 @@ gtk_text_buffer_get_paste_target_list (GtkTextBuffer *buffer)
  * Logical attribute cache
  */
 
-#define ATTR_CACHE_SIZE 2
+/* Log attrs are kept for the ATTR_CACHE_SIZE most recently used
+ * lines. They are keyed by GtkTextLine, so edits elsewhere in the
+ * buffer leave them alone; the insert and delete handlers drop the
+ * entries of the lines they touch, before the btree changes. The
+ * language comes from the tags at the start of the line rather than
+ * from the text, so it is kept with the attrs and checked on lookup.
+ */
+#define ATTR_CACHE_SIZE 64
 
 typedef struct _CacheEntry CacheEntry;
 struct _CacheEntry
 {
-  gint line;
+  GtkTextLine *line;
+  PangoLanguage *language;
   gint char_len;
   PangoLogAttr *attrs;
 };
 
 struct _GtkTextLogAttrCache
 {
-  gint chars_changed_stamp;
-  CacheEntry entries[ATTR_CACHE_SIZE];
+  /* Most recently used first */
+  GQueue entries;
+  /* GtkTextLine -> GList link in entries */
+  GHashTable *links;
 };
 
+static void
+log_attr_cache_remove (GtkTextLogAttrCache *cache,
+                       GList               *link)
+{
+  CacheEntry *entry = link->data;
+
+  g_hash_table_remove (cache->links, entry->line);
+  g_queue_delete_link (&cache->entries, link);
+
+  g_free (entry->attrs);
+  g_slice_free (CacheEntry, entry);
+}
+
 static void
 free_log_attr_cache (GtkTextLogAttrCache *cache)
 {
-  gint i = 0;
-  while (i < ATTR_CACHE_SIZE)
-    {
-      g_free (cache->entries[i].attrs);
-      ++i;
-    }
+  while (cache->entries.head)
+    log_attr_cache_remove (cache, cache->entries.head);
+
+  g_hash_table_destroy (cache->links);
   g_free (cache);
 }
 
 static void
-clear_log_attr_cache (GtkTextLogAttrCache *cache)
+invalidate_log_attrs (GtkTextBuffer     *buffer,
+                      const GtkTextIter *start,
+                      const GtkTextIter *end)
 {
-  gint i = 0;
-  while (i < ATTR_CACHE_SIZE)
+  GtkTextLogAttrCache *cache = buffer->log_attr_cache;
+  GtkTextLine *line;
+  GtkTextLine *last_line;
+  gint first, last;
+  GList *link, *next;
+
+  if (cache == NULL || cache->entries.length == 0)
+    return;
+
+  first = gtk_text_iter_get_line (start);
+  last = gtk_text_iter_get_line (end);
+  if (first > last)
     {
-      g_free (cache->entries[i].attrs);
-      cache->entries[i].attrs = NULL;
-      ++i;
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+      first = last;
+      last = gtk_text_iter_get_line (end);
+    }
+
+  /* Walk whichever is shorter, the lines or the cache */
+  if ((guint) (last - first) < cache->entries.length)
+    {
+      line = _gtk_text_iter_get_text_line (start);
+      last_line = _gtk_text_iter_get_text_line (end);
+
+      while (line != NULL)
+        {
+          link = g_hash_table_lookup (cache->links, line);
+          if (link)
+            log_attr_cache_remove (cache, link);
+
+          if (line == last_line)
+            break;
+
+          line = _gtk_text_line_next (line);
+        }
+    }
+  else
+    {
+      for (link = cache->entries.head; link; link = next)
+        {
+          CacheEntry *entry = link->data;
+          gint number = _gtk_text_line_get_number (entry->line);
+
+          next = link->next;
+
+          if (number >= first && number <= last)
+            log_attr_cache_remove (cache, link);
+        }
     }
 }
 
 static PangoLogAttr*
 compute_log_attrs (const GtkTextIter *iter,
+                   PangoLanguage     *language,
                    gint              *char_lenp)
 {
   GtkTextIter start;
@@ -4299,7 +4374,7 @@ compute_log_attrs (const GtkTextIter *iter,
    * tags within the paragraph
    */
   pango_get_log_attrs (paragraph, byte_len, -1,
-		       gtk_text_iter_get_language (&start),
+		       language,
                        attrs,
                        char_len + 1);
   
@@ -4308,16 +4383,20 @@ compute_log_attrs (const GtkTextIter *iter,
   return attrs;
 }
 
-/* The return value from this is valid until you call this a second time.
+/* The return value from this is valid until the buffer is changed,
+ * or until you call this again for ATTR_CACHE_SIZE other lines.
  */
 const PangoLogAttr*
 _gtk_text_buffer_get_line_log_attrs (GtkTextBuffer     *buffer,
                                      const GtkTextIter *anywhere_in_line,
                                      gint              *char_len)
 {
-  gint line;
+  GtkTextLine *line;
   GtkTextLogAttrCache *cache;
-  gint i;
+  CacheEntry *entry;
+  GList *link;
+  GtkTextIter start;
+  PangoLanguage *language;
   
   g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
   g_return_val_if_fail (anywhere_in_line != NULL, NULL);
@@ -4331,52 +4410,58 @@ _gtk_text_buffer_get_line_log_attrs (GtkTextBuffer     *buffer,
       return NULL;
     }
   
-  /* FIXME we also need to recompute log attrs if the language tag at
-   * the start of a paragraph changes
-   */
-  
   if (buffer->log_attr_cache == NULL)
     {
       buffer->log_attr_cache = g_new0 (GtkTextLogAttrCache, 1);
-      buffer->log_attr_cache->chars_changed_stamp =
-        _gtk_text_btree_get_chars_changed_stamp (get_btree (buffer));
-    }
-  else if (buffer->log_attr_cache->chars_changed_stamp !=
-           _gtk_text_btree_get_chars_changed_stamp (get_btree (buffer)))
-    {
-      clear_log_attr_cache (buffer->log_attr_cache);
+      buffer->log_attr_cache->links = g_hash_table_new (NULL, NULL);
     }
   
   cache = buffer->log_attr_cache;
-  line = gtk_text_iter_get_line (anywhere_in_line);
+  line = _gtk_text_iter_get_text_line (anywhere_in_line);
 
-  i = 0;
-  while (i < ATTR_CACHE_SIZE)
+  start = *anywhere_in_line;
+  gtk_text_iter_set_line_offset (&start, 0);
+  language = gtk_text_iter_get_language (&start);
+
+  link = g_hash_table_lookup (cache->links, line);
+
+  /* A tag setting the language was applied or removed, or changed */
+  if (link && ((CacheEntry *) link->data)->language != language)
+    {
+      log_attr_cache_remove (cache, link);
+      link = NULL;
+    }
+
+  if (link)
     {
-      if (cache->entries[i].attrs &&
-          cache->entries[i].line == line)
+      if (link != cache->entries.head)
         {
-          if (char_len)
-            *char_len = cache->entries[i].char_len;
-          return cache->entries[i].attrs;
+          g_queue_unlink (&cache->entries, link);
+          g_queue_push_head_link (&cache->entries, link);
         }
-      ++i;
+
+      entry = link->data;
+      if (char_len)
+        *char_len = entry->char_len;
+      return entry->attrs;
     }
   
-  /* Not in cache; open up the first cache entry */
-  g_free (cache->entries[ATTR_CACHE_SIZE-1].attrs);
-  
-  g_memmove (cache->entries + 1, cache->entries,
-             sizeof (CacheEntry) * (ATTR_CACHE_SIZE - 1));
+  /* Not in cache; drop the least recently used entry */
+  if (cache->entries.length >= ATTR_CACHE_SIZE)
+    log_attr_cache_remove (cache, cache->entries.tail);
+
+  entry = g_slice_new (CacheEntry);
+  entry->line = line;
+  entry->language = language;
+  entry->attrs = compute_log_attrs (&start, language, &entry->char_len);
 
-  cache->entries[0].line = line;
-  cache->entries[0].attrs = compute_log_attrs (anywhere_in_line,
-                                               &cache->entries[0].char_len);
+  g_queue_push_head (&cache->entries, entry);
+  g_hash_table_insert (cache->links, line, cache->entries.head);
 
   if (char_len)
-    *char_len = cache->entries[0].char_len;
+    *char_len = entry->char_len;
   
-  return cache->entries[0].attrs;
+  return entry->attrs;
 }
 
 void
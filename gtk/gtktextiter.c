@@ -4409,107 +4409,6 @@ forward_chars_with_skipping (GtkTextIter *iter,
     }
 }
 
-static gboolean
-lines_match (const GtkTextIter *start,
-             const gchar **lines,
-             gboolean visible_only,
-             gboolean slice,
-             GtkTextIter *match_start,
-             GtkTextIter *match_end)
-{
-  GtkTextIter next;
-  gchar *line_text;
-  const gchar *found;
-  gint offset;
-
-  if (*lines == NULL || **lines == '\0')
-    {
-      if (match_start)
-        *match_start = *start;
-
-      if (match_end)
-        *match_end = *start;
-      return TRUE;
-    }
-
-  next = *start;
-  gtk_text_iter_forward_line (&next);
-
-  /* No more text in buffer, but *lines is nonempty */
-  if (gtk_text_iter_equal (start, &next))
-    {
-      return FALSE;
-    }
-
-  if (slice)
-    {
-      if (visible_only)
-        line_text = gtk_text_iter_get_visible_slice (start, &next);
-      else
-        line_text = gtk_text_iter_get_slice (start, &next);
-    }
-  else
-    {
-      if (visible_only)
-        line_text = gtk_text_iter_get_visible_text (start, &next);
-      else
-        line_text = gtk_text_iter_get_text (start, &next);
-    }
-
-  if (match_start) /* if this is the first line we're matching */
-    found = strstr (line_text, *lines);
-  else
-    {
-      /* If it's not the first line, we have to match from the
-       * start of the line.
-       */
-      if (strncmp (line_text, *lines, strlen (*lines)) == 0)
-        found = line_text;
-      else
-        found = NULL;
-    }
-
-  if (found == NULL)
-    {
-      g_free (line_text);
-      return FALSE;
-    }
-
-  /* Get offset to start of search string */
-  offset = g_utf8_strlen (line_text, found - line_text);
-
-  next = *start;
-
-  /* If match start needs to be returned, set it to the
-   * start of the search string.
-   */
-  if (match_start)
-    {
-      *match_start = next;
-
-      forward_chars_with_skipping (match_start, offset,
-                                   visible_only, !slice);
-    }
-
-  /* Go to end of search string */
-  offset += g_utf8_strlen (*lines, -1);
-
-  forward_chars_with_skipping (&next, offset,
-                               visible_only, !slice);
-
-  g_free (line_text);
-
-  ++lines;
-
-  if (match_end)
-    *match_end = next;
-
-  /* pass NULL for match_start, since we don't need to find the
-   * start again.
-   */
-  return lines_match (&next, lines, visible_only, slice, NULL, match_end);
-}
-
 /* strsplit () that retains the delimiter as part of the string. */
 static gchar **
 strbreakup (const char *string,
@@ -4566,6 +4465,533 @@ strbreakup (const char *string,
   return str_array;
 }
 
+/* Lowercases @text one character at a time. Unlike g_utf8_casefold(),
+ * this keeps the number of characters, so character offsets into the
+ * result are character offsets into @text.
+ */
+static gchar *
+utf8_fold (const gchar *text,
+           gssize       len)
+{
+  GString *str;
+  const gchar *p, *end;
+
+  if (len < 0)
+    len = strlen (text);
+
+  str = g_string_sized_new (len);
+
+  for (p = text, end = text + len; p < end; p = g_utf8_next_char (p))
+    {
+      if ((guchar) *p < 0x80)
+        g_string_append_c (str, g_ascii_tolower (*p));
+      else
+        g_string_append_unichar (str, g_unichar_tolower (g_utf8_get_char (p)));
+    }
+
+  return g_string_free (str, FALSE);
+}
+
+/* The forward search copies the text of whole lines, straight from the
+ * char segments of the btree, into a window of about SEARCH_WINDOW_SIZE
+ * bytes more than the needle and runs a Boyer-Moore-Horspool scan over
+ * it. Runs map the window back to (line, byte index) pairs. The tail of
+ * a window that could still begin a match is kept when the next lines
+ * are added, so matches may span lines and windows.
+ */
+#define SEARCH_WINDOW_SIZE 65536
+
+typedef struct _SearchRun SearchRun;
+typedef struct _TextSearch TextSearch;
+
+struct _SearchRun
+{
+  GtkTextLine *line;
+  gint line_byte;       /* byte index of the run in line */
+  gsize offset;         /* byte offset of the run in the window */
+  gint len;             /* bytes in the window */
+  gint orig_len;        /* bytes in the buffer; only differs from len
+                         * for a single character whose lowercase
+                         * form has another length */
+};
+
+struct _TextSearch
+{
+  GtkTextBTree *tree;
+  guint visible_only : 1;
+  guint slice : 1;
+  guint casefold : 1;
+  guint invisible : 1;
+  guint invisible_known : 1;
+
+  gchar *needle;
+  gsize needle_len;
+  gsize shift[256];
+
+  GString *window;
+  GArray *runs;
+  gsize pos;            /* where the next match may start */
+
+  GtkTextLine *line;    /* next line to add, or NULL when done */
+  gint line_byte;
+  GtkTextLine *limit_line;
+  gint limit_byte;
+};
+
+static void
+text_search_init (TextSearch        *search,
+                  const GtkTextIter *start,
+                  const GtkTextIter *limit,
+                  const gchar       *str,
+                  GtkTextSearchFlags flags)
+{
+  GtkTextIter end;
+  gsize i;
+
+  search->tree = _gtk_text_iter_get_btree (start);
+  search->visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
+  search->slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  search->casefold = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
+  search->invisible = FALSE;
+  search->invisible_known = FALSE;
+
+  if (search->casefold)
+    search->needle = utf8_fold (str, -1);
+  else
+    search->needle = g_strdup (str);
+  search->needle_len = strlen (search->needle);
+
+  for (i = 0; i < 256; i++)
+    search->shift[i] = search->needle_len;
+  for (i = 0; i + 1 < search->needle_len; i++)
+    search->shift[(guchar) search->needle[i]] = search->needle_len - 1 - i;
+
+  search->window = g_string_sized_new (SEARCH_WINDOW_SIZE);
+  search->runs = g_array_new (FALSE, FALSE, sizeof (SearchRun));
+  search->pos = 0;
+
+  search->line = _gtk_text_iter_get_text_line (start);
+  search->line_byte = gtk_text_iter_get_line_index (start);
+
+  if (limit == NULL)
+    {
+      _gtk_text_btree_get_end_iter (search->tree, &end);
+      limit = &end;
+    }
+
+  search->limit_line = _gtk_text_iter_get_text_line (limit);
+  search->limit_byte = gtk_text_iter_get_line_index (limit);
+}
+
+static void
+text_search_free (TextSearch *search)
+{
+  g_free (search->needle);
+  g_string_free (search->window, TRUE);
+  g_array_free (search->runs, TRUE);
+}
+
+/* Records the last @len bytes of the window as coming from @line */
+static void
+text_search_add_run (TextSearch  *search,
+                     GtkTextLine *line,
+                     gint         line_byte,
+                     gint         len,
+                     gint         orig_len)
+{
+  SearchRun run;
+  gsize offset;
+
+  if (len == 0)
+    return;
+
+  offset = search->window->len - len;
+
+  if (search->runs->len > 0 && len == orig_len)
+    {
+      SearchRun *last;
+
+      last = &g_array_index (search->runs, SearchRun, search->runs->len - 1);
+      if (last->line == line &&
+          last->len == last->orig_len &&
+          last->line_byte + last->len == line_byte &&
+          last->offset + last->len == offset)
+        {
+          last->len += len;
+          last->orig_len += len;
+          return;
+        }
+    }
+
+  run.line = line;
+  run.line_byte = line_byte;
+  run.offset = offset;
+  run.len = len;
+  run.orig_len = orig_len;
+  g_array_append_val (search->runs, run);
+}
+
+static void
+text_search_append (TextSearch  *search,
+                    GtkTextLine *line,
+                    gint         line_byte,
+                    const gchar *text,
+                    gint         len)
+{
+  const gchar *p, *end, *run_start;
+
+  if (!search->casefold)
+    {
+      g_string_append_len (search->window, text, len);
+      text_search_add_run (search, line, line_byte, len, len);
+      return;
+    }
+
+  run_start = text;
+  for (p = text, end = text + len; p < end; )
+    {
+      const gchar *next;
+      gchar buf[6];
+      gint n;
+
+      if ((guchar) *p < 0x80)
+        {
+          g_string_append_c (search->window, g_ascii_tolower (*p));
+          p++;
+          continue;
+        }
+
+      next = g_utf8_next_char (p);
+      n = g_unichar_to_utf8 (g_unichar_tolower (g_utf8_get_char (p)), buf);
+
+      if (n != next - p)
+        {
+          text_search_add_run (search, line, line_byte + (run_start - text),
+                               p - run_start, p - run_start);
+          g_string_append_len (search->window, buf, n);
+          text_search_add_run (search, line, line_byte + (p - text),
+                               n, next - p);
+          run_start = next;
+        }
+      else
+        g_string_append_len (search->window, buf, n);
+
+      p = next;
+    }
+
+  text_search_add_run (search, line, line_byte + (run_start - text),
+                       end - run_start, end - run_start);
+}
+
+/* Adds whole lines to the window until it is full or the limit is
+ * reached. The window has to be larger than the needle, or a search
+ * for a long needle would never move on.
+ */
+static void
+text_search_fill (TextSearch *search)
+{
+  while (search->line != NULL &&
+         search->window->len < search->needle_len + SEARCH_WINDOW_SIZE)
+    {
+      GtkTextLine *line = search->line;
+      GtkTextLineSegment *seg;
+      gint first, last, byte;
+
+      first = search->line_byte;
+      last = line == search->limit_line ? search->limit_byte : G_MAXINT;
+
+      for (seg = line->segments, byte = 0;
+           seg != NULL && byte < last;
+           byte += seg->byte_count, seg = seg->next)
+        {
+          const gchar *text;
+          gint lo, hi;
+
+          if (seg->type == &gtk_text_toggle_on_type ||
+              seg->type == &gtk_text_toggle_off_type)
+            {
+              if (seg->body.toggle.info->tag->invisible_set)
+                search->invisible_known = FALSE;
+              continue;
+            }
+
+          if (byte + seg->byte_count <= first)
+            continue;
+
+          if (seg->type == &gtk_text_char_type)
+            text = seg->body.chars;
+          else if (search->slice &&
+                   (seg->type == &gtk_text_pixbuf_type ||
+                    seg->type == &gtk_text_child_type))
+            text = gtk_text_unknown_char_utf8;
+          else
+            continue;
+
+          lo = MAX (byte, first);
+          hi = MIN (byte + seg->byte_count, last);
+
+          if (search->visible_only)
+            {
+              if (!search->invisible_known)
+                {
+                  GtkTextIter iter;
+
+                  _gtk_text_btree_get_iter_at_line (search->tree, &iter,
+                                                    line, lo);
+                  search->invisible = _gtk_text_btree_char_is_invisible (&iter);
+                  search->invisible_known = TRUE;
+                }
+
+              if (search->invisible)
+                continue;
+            }
+
+          text_search_append (search, line, lo, text + (lo - byte), hi - lo);
+        }
+
+      if (line == search->limit_line)
+        search->line = NULL;
+      else
+        search->line = _gtk_text_line_next (line);
+      search->line_byte = 0;
+    }
+}
+
+/* Drops the part of the window that can no longer begin a match */
+static void
+text_search_advance (TextSearch *search)
+{
+  gsize keep;
+  guint i;
+
+  keep = search->pos;
+  if (search->window->len >= search->needle_len)
+    keep = MAX (keep, search->window->len - (search->needle_len - 1));
+
+  for (i = 0; i < search->runs->len; i++)
+    {
+      SearchRun *run = &g_array_index (search->runs, SearchRun, i);
+
+      if (run->offset + run->len > keep)
+        {
+          if (run->len != run->orig_len)
+            keep = run->offset;
+          else if (keep > run->offset)
+            {
+              gsize d = keep - run->offset;
+
+              run->line_byte += d;
+              run->offset += d;
+              run->len -= d;
+              run->orig_len -= d;
+            }
+          break;
+        }
+    }
+
+  if (i == search->runs->len)
+    keep = search->window->len;
+
+  g_array_remove_range (search->runs, 0, i);
+  for (i = 0; i < search->runs->len; i++)
+    g_array_index (search->runs, SearchRun, i).offset -= keep;
+
+  g_string_erase (search->window, 0, keep);
+  search->pos -= keep;
+}
+
+static gboolean
+text_search_find (TextSearch *search,
+                  gsize      *match)
+{
+  const guchar *window = (const guchar *) search->window->str;
+  const guchar *needle = (const guchar *) search->needle;
+  gsize n = search->needle_len;
+  gsize len = search->window->len;
+  gsize i = search->pos;
+
+  if (i + n > len)
+    return FALSE;
+
+  if (n == 1)
+    {
+      const guchar *found = memchr (window + i, needle[0], len - i);
+
+      if (found == NULL)
+        return FALSE;
+
+      *match = found - window;
+      return TRUE;
+    }
+
+  while (i + n <= len)
+    {
+      guchar last = window[i + n - 1];
+
+      if (last == needle[n - 1] &&
+          memcmp (window + i, needle, n - 1) == 0)
+        {
+          *match = i;
+          return TRUE;
+        }
+
+      i += search->shift[last];
+    }
+
+  return FALSE;
+}
+
+/* @offset must be a character boundary in the window. The end of a
+ * match is found by moving past its last character, so that it lands
+ * right after that character rather than after any text that was
+ * skipped following it, and at the start of the next line after a
+ * paragraph delimiter.
+ */
+static void
+text_search_get_iter (TextSearch  *search,
+                      gsize        offset,
+                      gboolean     is_end,
+                      GtkTextIter *iter)
+{
+  SearchRun *run;
+  gsize key;
+  guint lo, hi;
+  gint byte;
+
+  if (is_end)
+    key = g_utf8_find_prev_char (search->window->str,
+                                 search->window->str + offset) - search->window->str;
+  else
+    key = offset;
+
+  lo = 0;
+  hi = search->runs->len;
+  while (hi - lo > 1)
+    {
+      guint mid = (lo + hi) / 2;
+
+      if (g_array_index (search->runs, SearchRun, mid).offset <= key)
+        lo = mid;
+      else
+        hi = mid;
+    }
+
+  run = &g_array_index (search->runs, SearchRun, lo);
+
+  if (run->len == run->orig_len)
+    byte = run->line_byte + (key - run->offset);
+  else
+    byte = run->line_byte;
+
+  _gtk_text_btree_get_iter_at_line (search->tree, iter, run->line, byte);
+
+  if (is_end)
+    gtk_text_iter_forward_char (iter);
+}
+
+/**
+ * gtk_text_iter_forward_search_all:
+ * @iter: start of search
+ * @str: a search string
+ * @flags: flags affecting how the search is done
+ * @limit: bound for the search, or %NULL for the end of the buffer
+ * @func: function called for each match
+ * @user_data: user data for @func
+ *
+ * Finds all non-overlapping occurrences of @str between @iter and
+ * @limit in a single pass, and calls @func on each of them in order.
+ * If @func returns %TRUE, the search stops. @flags has the same meaning
+ * as for gtk_text_iter_forward_search().
+ *
+ * This is much faster than repeated calls to
+ * gtk_text_iter_forward_search() on large buffers. @func may apply or
+ * remove tags, for instance to highlight all matches, but it must not
+ * change the text of the buffer.
+ *
+ * Return value: the number of matches passed to @func
+ *
+ * Since: 2.20
+ **/
+gint
+gtk_text_iter_forward_search_all (const GtkTextIter *iter,
+                                  const gchar       *str,
+                                  GtkTextSearchFlags flags,
+                                  const GtkTextIter *limit,
+                                  GtkTextSearchFunc  func,
+                                  gpointer           user_data)
+{
+  TextSearch search;
+  guint chars_changed_stamp;
+  gint n_matches = 0;
+
+  g_return_val_if_fail (iter != NULL, 0);
+  g_return_val_if_fail (str != NULL, 0);
+  g_return_val_if_fail (func != NULL, 0);
+
+  if (*str == '\0')
+    return 0;
+
+  if (limit &&
+      gtk_text_iter_compare (iter, limit) >= 0)
+    return 0;
+
+  text_search_init (&search, iter, limit, str, flags);
+  chars_changed_stamp =
+    _gtk_text_btree_get_chars_changed_stamp (search.tree);
+
+  text_search_fill (&search);
+
+  while (TRUE)
+    {
+      GtkTextIter match_start, match_end;
+      gsize offset;
+
+      if (!text_search_find (&search, &offset))
+        {
+          if (search.line == NULL)
+            break;
+
+          text_search_advance (&search);
+          text_search_fill (&search);
+          continue;
+        }
+
+      text_search_get_iter (&search, offset, FALSE, &match_start);
+      text_search_get_iter (&search, offset + search.needle_len, TRUE,
+                            &match_end);
+      search.pos = offset + search.needle_len;
+      n_matches++;
+
+      if ((* func) (&match_start, &match_end, user_data))
+        break;
+
+      if (chars_changed_stamp !=
+          _gtk_text_btree_get_chars_changed_stamp (search.tree))
+        {
+          g_warning ("%s: the text of the buffer was changed while "
+                     "searching it", G_STRLOC);
+          break;
+        }
+    }
+
+  text_search_free (&search);
+
+  return n_matches;
+}
+
+static gboolean
+first_match (const GtkTextIter *match_start,
+             const GtkTextIter *match_end,
+             gpointer           user_data)
+{
+  GtkTextIter *match = user_data;
+
+  match[0] = *match_start;
+  match[1] = *match_end;
+
+  return TRUE;
+}
+
 /**
  * gtk_text_iter_forward_search:
  * @iter: start of search
@@ -4589,6 +5015,8 @@ strbreakup (const char *string,
  * pixbufs or child widgets mixed inside the matched range. If these
  * flags are not given, the match must be exact; the special 0xFFFC
  * character in @str will match embedded pixbufs or child widgets.
+ * If #GTK_TEXT_SEARCH_CASE_INSENSITIVE is given, @str and the text are
+ * compared after converting both to lowercase.
  *
  * Return value: whether a match was found
  **/
@@ -4600,12 +5028,7 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
                               GtkTextIter       *match_end,
                               const GtkTextIter *limit)
 {
-  gchar **lines = NULL;
-  GtkTextIter match;
-  gboolean retval = FALSE;
-  GtkTextIter search;
-  gboolean visible_only;
-  gboolean slice;
+  GtkTextIter match[2];
   
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4617,69 +5040,34 @@ gtk_text_iter_forward_search (const GtkTextIter *iter,
   if (*str == '\0')
     {
       /* If we can move one char, return the empty string there */
-      match = *iter;
+      match[0] = *iter;
       
-      if (gtk_text_iter_forward_char (&match))
+      if (gtk_text_iter_forward_char (&match[0]))
         {
           if (limit &&
-              gtk_text_iter_equal (&match, limit))
+              gtk_text_iter_equal (&match[0], limit))
             return FALSE;
           
           if (match_start)
-            *match_start = match;
+            *match_start = match[0];
           if (match_end)
-            *match_end = match;
+            *match_end = match[0];
           return TRUE;
         }
       else
         return FALSE;
     }
 
-  visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
-  slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
-  
-  /* locate all lines */
-
-  lines = strbreakup (str, "\n", -1);
-
-  search = *iter;
-
-  do
-    {
-      /* This loop has an inefficient worst-case, where
-       * gtk_text_iter_get_text () is called repeatedly on
-       * a single line.
-       */
-      GtkTextIter end;
-
-      if (limit &&
-          gtk_text_iter_compare (&search, limit) >= 0)
-        break;
-      
-      if (lines_match (&search, (const gchar**)lines,
-                       visible_only, slice, &match, &end))
-        {
-          if (limit == NULL ||
-              (limit &&
-               gtk_text_iter_compare (&end, limit) <= 0))
-            {
-              retval = TRUE;
-              
-              if (match_start)
-                *match_start = match;
-              
-              if (match_end)
-                *match_end = end;
-            }
-          
-          break;
-        }
-    }
-  while (gtk_text_iter_forward_line (&search));
+  if (gtk_text_iter_forward_search_all (iter, str, flags, limit,
+                                        first_match, match) == 0)
+    return FALSE;
 
-  g_strfreev ((gchar**)lines);
+  if (match_start)
+    *match_start = match[0];
+  if (match_end)
+    *match_end = match[1];
 
-  return retval;
+  return TRUE;
 }
 
 static gboolean
@@ -4740,6 +5128,7 @@ struct _LinesWindow
   GtkTextIter first_line_end;
   gboolean slice;
   gboolean visible_only;
+  gboolean casefold;
 };
 
 static void
@@ -4799,6 +5188,13 @@ lines_window_init (LinesWindow       *win,
             line_text = gtk_text_iter_get_text (&line_start, &line_end);
         }
 
+      if (win->casefold)
+        {
+          gchar *folded = utf8_fold (line_text, -1);
+          g_free (line_text);
+          line_text = folded;
+        }
+
       win->lines[i] = line_text;
 
       line_end = line_start;
@@ -4845,6 +5241,13 @@ lines_window_back (LinesWindow *win)
                                             &win->first_line_end);
     }
 
+  if (win->casefold)
+    {
+      gchar *folded = utf8_fold (line_text, -1);
+      g_free (line_text);
+      line_text = folded;
+    }
+
   /* Move lines to make room for first line. */
   g_memmove (win->lines + 1, win->lines, win->n_lines * sizeof (gchar*));
 
@@ -4891,6 +5294,7 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
   gboolean retval = FALSE;
   gboolean visible_only;
   gboolean slice;
+  gboolean casefold;
   
   g_return_val_if_fail (iter != NULL, FALSE);
   g_return_val_if_fail (str != NULL, FALSE);
@@ -4921,10 +5325,18 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
 
   visible_only = (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY) != 0;
   slice = (flags & GTK_TEXT_SEARCH_TEXT_ONLY) == 0;
+  casefold = (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE) != 0;
   
   /* locate all lines */
 
-  lines = strbreakup (str, "\n", -1);
+  if (casefold)
+    {
+      gchar *folded = utf8_fold (str, -1);
+      lines = strbreakup (folded, "\n", -1);
+      g_free (folded);
+    }
+  else
+    lines = strbreakup (str, "\n", -1);
 
   l = lines;
   n_lines = 0;
@@ -4937,6 +5349,7 @@ gtk_text_iter_backward_search (const GtkTextIter *iter,
   win.n_lines = n_lines;
   win.slice = slice;
   win.visible_only = visible_only;
+  win.casefold = casefold;
 
   lines_window_init (&win, iter);
 
@@ -83,6 +83,7 @@
 #include "gtktextbtree.h"
 #include "gtktextiterprivate.h"
 #include "gtktextutil.h"
+#include "gtkpangothreads.h"
 #include "gtkintl.h"
 #include "gtkalias.h"
 
@@ -91,7 +92,16 @@
 
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), GTK_TYPE_TEXT_LAYOUT, GtkTextLayoutPrivate))
 
+/* Line displays are kept until their estimated size adds up to
+ * DISPLAY_CACHE_MAX_SIZE bytes. The estimate covers the structure and
+ * its PangoLayout, plus the glyphs and attributes for each byte of text.
+ */
+#define DISPLAY_CACHE_MAX_SIZE      (2 * 1024 * 1024)
+#define DISPLAY_CACHE_BASE_COST     512
+#define DISPLAY_CACHE_COST_PER_BYTE 32
+
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
+typedef struct _GtkTextWrapBatch     GtkTextWrapBatch;
 
 struct _GtkTextLayoutPrivate
 {
@@ -99,6 +109,16 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* Cached line displays, most recently used first, and the
+   * GtkTextLine -> GList link map used to find them.
+   */
+  GQueue display_queue;
+  GHashTable *display_links;
+  gsize display_cache_size;
+
+  /* Lines being wrapped in other threads */
+  GtkTextWrapBatch *wrap_batch;
 };
 
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
@@ -128,6 +148,8 @@ static void gtk_text_layout_emit_changed           (GtkTextLayout     *layout,
 						    gint               new_height);
 
 static void gtk_text_layout_invalidate_all (GtkTextLayout *layout);
+static void display_cache_clear            (GtkTextLayout *layout);
+static void gtk_text_layout_cancel_wrap    (GtkTextLayout *layout);
 
 static PangoAttribute *gtk_text_attr_appearance_new (const GtkTextAppearance *appearance);
 
@@ -233,7 +255,11 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->display_links = g_hash_table_new (NULL, NULL);
 }
 
 GtkTextLayout*
@@ -276,12 +302,9 @@ gtk_text_layout_finalize (GObject *object)
       layout->rtl_context = NULL;
     }
   
-  if (layout->one_display_cache) 
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  gtk_text_layout_cancel_wrap (layout);
+  display_cache_clear (layout);
+  g_hash_table_destroy (GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->display_links);
 
   if (layout->preedit_string)
     {
@@ -310,6 +333,8 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  display_cache_clear (layout);
+  gtk_text_layout_cancel_wrap (layout);
 
   if (layout->buffer)
     {
@@ -619,12 +644,68 @@ gtk_text_layout_invalidated (GtkTextLayout *layout)
   g_signal_emit (layout, signals[INVALIDATED], 0);
 }
 
+/* Moves the cached tops of the displays below a range whose height
+ * changed. Displays inside the range, or on its edge if it was empty,
+ * look theirs up again when needed.
+ */
+static void
+display_cache_shift (GtkTextLayout *layout,
+                     gint           y,
+                     gint           old_height,
+                     gint           new_height)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (old_height == new_height)
+    return;
+
+  for (link = priv->display_queue.head; link; link = link->next)
+    {
+      GtkTextLineDisplay *display = link->data;
+
+      if (display->y < 0)
+        continue;
+
+      if (display->y < y && display->y + display->height <= y)
+        continue;
+
+      if (display->y >= y + old_height && (old_height > 0 || display->y > y))
+        display->y += new_height - old_height;
+      else
+        display->y = -1;
+    }
+}
+
+static void
+display_cache_forget_tops (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  for (link = priv->display_queue.head; link; link = link->next)
+    ((GtkTextLineDisplay *) link->data)->y = -1;
+}
+
+static gint
+display_get_top (GtkTextLayout      *layout,
+                 GtkTextLineDisplay *display)
+{
+  if (display->y < 0)
+    display->y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
+                                                display->line, layout);
+
+  return display->y;
+}
+
 static void
 gtk_text_layout_emit_changed (GtkTextLayout *layout,
 			      gint           y,
 			      gint           old_height,
 			      gint           new_height)
 {
+  display_cache_shift (layout, y, old_height, new_height);
+
   g_signal_emit (layout, signals[CHANGED], 0, y, old_height, new_height);
 }
 
@@ -635,18 +716,21 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link, *next;
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so.
    */
-  if (layout->one_display_cache)
+  for (link = priv->display_queue.head; link; link = next)
     {
-      GtkTextLine *line = layout->one_display_cache->line;
-      gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      GtkTextLineDisplay *display = link->data;
+      gint cache_y = display_get_top (layout, display);
+
+      next = link->next;
 
-      if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+      if (cache_y + display->height > y && cache_y < y + old_height)
+	gtk_text_layout_invalidate_cache (layout, display->line, cursors_only);
     }
 
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
@@ -807,14 +891,104 @@ gtk_text_layout_invalidate_all (GtkTextLayout *layout)
   gtk_text_layout_invalidate (layout, &start, &end);
 }
 
+static guint
+line_display_cost (GtkTextLineDisplay *display)
+{
+  return DISPLAY_CACHE_BASE_COST +
+    strlen (pango_layout_get_text (display->layout)) * DISPLAY_CACHE_COST_PER_BYTE;
+}
+
+static gboolean
+line_display_is_cached (GtkTextLayout      *layout,
+                        GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_links, display->line);
+
+  return link != NULL && link->data == display;
+}
+
+static void
+display_cache_remove (GtkTextLayout *layout,
+                      GList         *link)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display = link->data;
+
+  g_hash_table_remove (priv->display_links, display->line);
+  g_queue_delete_link (&priv->display_queue, link);
+  priv->display_cache_size -= line_display_cost (display);
+
+  if (layout->one_display_cache == display)
+    layout->one_display_cache = NULL;
+
+  gtk_text_layout_free_line_display (layout, display);
+}
+
+static void
+display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->display_queue.head)
+    display_cache_remove (layout, priv->display_queue.head);
+}
+
+/* Size-only displays are put at the cold end of the cache, so that
+ * wrapping a long run of lines doesn't push out the displays of the
+ * lines being drawn; only the most recent one of them survives.  As
+ * they are never moved to the head, that one is always the tail.
+ */
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  if (display->size_only)
+    {
+      link = priv->display_queue.tail;
+      if (link && ((GtkTextLineDisplay *) link->data)->size_only)
+        display_cache_remove (layout, link);
+
+      g_queue_push_tail (&priv->display_queue, display);
+    }
+  else
+    g_queue_push_head (&priv->display_queue, display);
+
+  link = display->size_only ? priv->display_queue.tail : priv->display_queue.head;
+  g_hash_table_insert (priv->display_links, display->line, link);
+  priv->display_cache_size += line_display_cost (display);
+
+  layout->one_display_cache = display;
+
+  link = priv->display_queue.tail;
+  while (link && priv->display_cache_size > DISPLAY_CACHE_MAX_SIZE)
+    {
+      GList *prev = link->prev;
+
+      if (link->data != display)
+        display_cache_remove (layout, link);
+
+      link = prev;
+    }
+}
+
 static void
 gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_links, line);
+  if (link)
     {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+      GtkTextLineDisplay *display = link->data;
 
       if (cursors_only)
 	{
@@ -825,10 +999,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	  display->has_block_cursor = FALSE;
 	}
       else
-	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
-	}
+	display_cache_remove (layout, link);
     }
 }
 
@@ -865,10 +1036,24 @@ gtk_text_layout_update_cursor_line(GtkTextLayout *layout)
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextIter iter;
 
+  GtkTextLine *line;
+
   gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
                                     gtk_text_buffer_get_insert (layout->buffer));
 
-  priv->cursor_line = _gtk_text_iter_get_text_line (&iter);
+  line = _gtk_text_iter_get_text_line (&iter);
+
+  /* The base direction and preedit string of the cursor line
+   * are baked into its display.
+   */
+  if (line != priv->cursor_line)
+    {
+      if (priv->cursor_line)
+        gtk_text_layout_invalidate_cache (layout, priv->cursor_line, FALSE);
+      gtk_text_layout_invalidate_cache (layout, line, FALSE);
+    }
+
+  priv->cursor_line = line;
 }
 
 static void
@@ -894,6 +1079,9 @@ gtk_text_layout_real_invalidate (GtkTextLayout *layout,
   gtk_text_view_index_spew (end_index, "invalidate end");
 #endif
 
+  /* The snapshots taken for other threads may be out of date now */
+  gtk_text_layout_cancel_wrap (layout);
+
   last_line = _gtk_text_iter_get_text_line (end);
   line = _gtk_text_iter_get_text_line (start);
 
@@ -920,19 +1108,14 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  /* Invalidate the cursors of the cached lines the range touches.
    */
-  if (layout->one_display_cache)
+  if (priv->display_queue.head)
     {
-      GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
-
-      _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
-                                        &line_start, line, 0);
-      line_end = line_start;
-      if (!gtk_text_iter_ends_line (&line_end))
-	gtk_text_iter_forward_to_line_end (&line_end);
+      GtkTextLine *line;
+      GtkTextLine *last_line;
 
       if (gtk_text_iter_compare (start, end) > 0)
 	{
@@ -941,11 +1124,18 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 	  end = tmp;
 	}
 
-      if (gtk_text_iter_compare (&line_start, end) <= 0 &&
-	  gtk_text_iter_compare (start, &line_end) <= 0)
-	{
-	  gtk_text_layout_invalidate_cache (layout, line, TRUE);
-	}
+      line = _gtk_text_iter_get_text_line (start);
+      last_line = _gtk_text_iter_get_text_line (end);
+
+      while (line)
+        {
+          gtk_text_layout_invalidate_cache (layout, line, TRUE);
+
+          if (line == last_line)
+            break;
+
+          line = _gtk_text_line_next_excluding_last (line);
+        }
     }
 
   gtk_text_layout_invalidated (layout);
@@ -958,6 +1148,10 @@ gtk_text_layout_real_free_line_data (GtkTextLayout     *layout,
 {
   gtk_text_layout_invalidate_cache (layout, line, FALSE);
 
+  /* The lines below move up without a ::changed emission */
+  if (line_data->height > 0)
+    display_cache_forget_tops (layout);
+
   g_free (line_data);
 }
 
@@ -1297,41 +1491,19 @@ totally_invisible_line (GtkTextLayout *layout,
   return TRUE;
 }
 
+/* Sets up the paragraph-wide values of a layout. This must not
+ * touch anything but its arguments, since it's also used by the
+ * threads that wrap lines in the background.
+ */
 static void
-set_para_values (GtkTextLayout      *layout,
-                 PangoDirection      base_dir,
-                 GtkTextAttributes  *style,
-                 GtkTextLineDisplay *display)
+set_layout_para_values (PangoLayout       *pango_layout,
+                        PangoDirection     base_dir,
+                        GtkTextAttributes *style,
+                        gint               screen_width)
 {
   PangoAlignment pango_align = PANGO_ALIGN_LEFT;
   PangoWrapMode pango_wrap = PANGO_WRAP_WORD;
 
-  switch (base_dir)
-    {
-    /* If no base direction was found, then use the style direction */
-    case PANGO_DIRECTION_NEUTRAL :
-      display->direction = style->direction;
-
-      /* Override the base direction */
-      if (display->direction == GTK_TEXT_DIR_RTL)
-        base_dir = PANGO_DIRECTION_RTL;
-      else
-        base_dir = PANGO_DIRECTION_LTR;
-      
-      break;
-    case PANGO_DIRECTION_RTL :
-      display->direction = GTK_TEXT_DIR_RTL;
-      break;
-    default:
-      display->direction = GTK_TEXT_DIR_LTR;
-      break;
-    }
-  
-  if (display->direction == GTK_TEXT_DIR_RTL)
-    display->layout = pango_layout_new (layout->rtl_context);
-  else
-    display->layout = pango_layout_new (layout->ltr_context);
-
   switch (style->justification)
     {
     case GTK_JUSTIFY_LEFT:
@@ -1345,29 +1517,21 @@ set_para_values (GtkTextLayout      *layout,
       break;
     case GTK_JUSTIFY_FILL:
       pango_align = (base_dir == PANGO_DIRECTION_LTR) ? PANGO_ALIGN_LEFT : PANGO_ALIGN_RIGHT;
-      pango_layout_set_justify (display->layout, TRUE);
+      pango_layout_set_justify (pango_layout, TRUE);
       break;
     default:
       g_assert_not_reached ();
       break;
     }
 
-  pango_layout_set_alignment (display->layout, pango_align);
-  pango_layout_set_spacing (display->layout,
+  pango_layout_set_alignment (pango_layout, pango_align);
+  pango_layout_set_spacing (pango_layout,
                             style->pixels_inside_wrap * PANGO_SCALE);
 
   if (style->tabs)
-    pango_layout_set_tabs (display->layout, style->tabs);
+    pango_layout_set_tabs (pango_layout, style->tabs);
 
-  display->top_margin = style->pixels_above_lines;
-  display->height = style->pixels_above_lines + style->pixels_below_lines;
-  display->bottom_margin = style->pixels_below_lines;
-  display->left_margin = style->left_margin;
-  display->right_margin = style->right_margin;
-  
-  display->x_offset = display->left_margin;
-
-  pango_layout_set_indent (display->layout,
+  pango_layout_set_indent (pango_layout,
                            style->indent * PANGO_SCALE);
 
   switch (style->wrap_mode)
@@ -1389,10 +1553,54 @@ set_para_values (GtkTextLayout      *layout,
 
   if (style->wrap_mode != GTK_WRAP_NONE)
     {
-      int layout_width = (layout->screen_width - display->left_margin - display->right_margin);
-      pango_layout_set_width (display->layout, layout_width * PANGO_SCALE);
-      pango_layout_set_wrap (display->layout, pango_wrap);
+      int layout_width = (screen_width - style->left_margin - style->right_margin);
+      pango_layout_set_width (pango_layout, layout_width * PANGO_SCALE);
+      pango_layout_set_wrap (pango_layout, pango_wrap);
+    }
+}
+
+static void
+set_para_values (GtkTextLayout      *layout,
+                 PangoDirection      base_dir,
+                 GtkTextAttributes  *style,
+                 GtkTextLineDisplay *display)
+{
+  switch (base_dir)
+    {
+    /* If no base direction was found, then use the style direction */
+    case PANGO_DIRECTION_NEUTRAL :
+      display->direction = style->direction;
+
+      /* Override the base direction */
+      if (display->direction == GTK_TEXT_DIR_RTL)
+        base_dir = PANGO_DIRECTION_RTL;
+      else
+        base_dir = PANGO_DIRECTION_LTR;
+      
+      break;
+    case PANGO_DIRECTION_RTL :
+      display->direction = GTK_TEXT_DIR_RTL;
+      break;
+    default:
+      display->direction = GTK_TEXT_DIR_LTR;
+      break;
     }
+  
+  if (display->direction == GTK_TEXT_DIR_RTL)
+    display->layout = pango_layout_new (layout->rtl_context);
+  else
+    display->layout = pango_layout_new (layout->ltr_context);
+
+  set_layout_para_values (display->layout, base_dir, style,
+                          layout->screen_width);
+
+  display->top_margin = style->pixels_above_lines;
+  display->height = style->pixels_above_lines + style->pixels_below_lines;
+  display->bottom_margin = style->pixels_below_lines;
+  display->left_margin = style->left_margin;
+  display->right_margin = style->right_margin;
+  
+  display->x_offset = display->left_margin;
 
   display->total_width = MAX (layout->screen_width, layout->width) - display->left_margin - display->right_margin;
   
@@ -1987,6 +2195,7 @@ update_text_display_cursors (GtkTextLayout      *layout,
     return;
 
   display->cursors_invalid = FALSE;
+  display->insert_index = -1;
 
   _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
                                     &iter, line, 0);
@@ -2127,6 +2336,36 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
+/* Returns the length of @text without its trailing paragraph delimiter */
+static gint
+strip_paragraph_delimiter (const gchar *text,
+                           gint         len)
+{
+  /* Only one character has type G_UNICODE_PARAGRAPH_SEPARATOR in
+   * Unicode 3.0; update this if that changes.
+   */
+#define PARAGRAPH_SEPARATOR 0x2029
+  gunichar ch = 0;
+
+  if (len > 0)
+    {
+      const char *prev = g_utf8_prev_char (text + len);
+      ch = g_utf8_get_char (prev);
+      if (ch == PARAGRAPH_SEPARATOR || ch == '\r' || ch == '\n')
+        len = prev - text; /* chop off */
+
+      if (ch == '\n' && len > 0)
+        {
+          /* Possibly chop a CR as well */
+          prev = g_utf8_prev_char (text + len);
+          if (*prev == '\r')
+            --len;
+        }
+    }
+
+  return len;
+}
+
 GtkTextLineDisplay *
 gtk_text_layout_get_line_display (GtkTextLayout *layout,
                                   GtkTextLine   *line,
@@ -2134,6 +2373,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
+  GList *link;
   GtkTextLineSegment *seg;
   GtkTextIter iter;
   GtkTextAttributes *style;
@@ -2152,30 +2392,37 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   
   g_return_val_if_fail (line != NULL, NULL);
 
-  if (layout->one_display_cache)
+  link = g_hash_table_lookup (priv->display_links, line);
+  if (link)
     {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
+      display = link->data;
+
+      if (size_only || !display->size_only)
 	{
+	  if (!display->size_only && link != priv->display_queue.head)
+	    {
+	      g_queue_unlink (&priv->display_queue, link);
+	      g_queue_push_head_link (&priv->display_queue, link);
+	    }
+
 	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
+            update_text_display_cursors (layout, line, display);
+
+	  layout->one_display_cache = display;
+	  return display;
 	}
       else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
+	display_cache_remove (layout, link);
     }
 
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+  DV (g_print ("creating line display cache entry (%s)\n", G_STRLOC));
 
   display = g_new0 (GtkTextLineDisplay, 1);
 
   display->size_only = size_only;
   display->line = line;
   display->insert_index = -1;
+  display->y = -1;
 
   _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
                                     &iter, line, 0);
@@ -2417,30 +2664,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
     }
   
   /* Pango doesn't want the trailing paragraph delimiters */
-
-  {
-    /* Only one character has type G_UNICODE_PARAGRAPH_SEPARATOR in
-     * Unicode 3.0; update this if that changes.
-     */
-#define PARAGRAPH_SEPARATOR 0x2029
-    gunichar ch = 0;
-
-    if (layout_byte_offset > 0)
-      {
-        const char *prev = g_utf8_prev_char (text + layout_byte_offset);
-        ch = g_utf8_get_char (prev);
-        if (ch == PARAGRAPH_SEPARATOR || ch == '\r' || ch == '\n')
-          layout_byte_offset = prev - text; /* chop off */
-
-        if (ch == '\n' && layout_byte_offset > 0)
-          {
-            /* Possibly chop a CR as well */
-            prev = g_utf8_prev_char (text + layout_byte_offset);
-            if (*prev == '\r')
-              --layout_byte_offset;
-          }
-      }
-  }
+  layout_byte_offset = strip_paragraph_delimiter (text, layout_byte_offset);
   
   pango_layout_set_text (display->layout, text, layout_byte_offset);
   pango_layout_set_attributes (display->layout, attrs);
@@ -2491,7 +2715,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   if (tags != NULL)
     g_ptr_array_free (tags, TRUE);
 
-  layout->one_display_cache = display;
+  display_cache_insert (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2503,7 +2727,7 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  if (!line_display_is_cached (layout, display))
     {
       if (display->layout)
         g_object_unref (display->layout);
@@ -2522,6 +2746,446 @@ gtk_text_layout_free_line_display (GtkTextLayout      *layout,
     }
 }
 
+/*
+ * Background wrapping
+ */
+
+/* A batch takes up to WRAP_BATCH_LINES lines or WRAP_BATCH_BYTES
+ * bytes of text, and gives each thread at least WRAP_CHUNK_LINES
+ * lines of it.
+ */
+#define WRAP_BATCH_LINES 4096
+#define WRAP_BATCH_BYTES (1024 * 1024)
+#define WRAP_CHUNK_LINES 256
+
+typedef struct _GtkTextWrapLine  GtkTextWrapLine;
+typedef struct _GtkTextWrapChunk GtkTextWrapChunk;
+
+struct _GtkTextWrapLine
+{
+  GtkTextLine *line;
+  gsize text_offset;
+  gint text_len;
+  PangoDirection base_dir;
+
+  /* Filled in by the threads */
+  gint width;
+  gint height;
+};
+
+struct _GtkTextWrapChunk
+{
+  GtkTextWrapBatch *batch;
+  guint start;
+  guint end;
+};
+
+struct _GtkTextWrapBatch
+{
+  GtkTextLayout *layout;        /* NULL once cancelled */
+  volatile gint cancelled;
+
+  GArray *lines;
+  GString *text;
+
+  /* How the threads lay out the lines */
+  GtkTextAttributes *style;
+  PangoAttrList *attrs;
+  gint screen_width;
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+
+  GtkTextWrapChunk *chunks;
+  guint unmerged;               /* only used on the main thread */
+};
+
+static GThreadPool *wrap_pool = NULL;
+G_LOCK_DEFINE_STATIC (wrap_pool);
+
+static void
+wrap_batch_free (GtkTextWrapBatch *batch)
+{
+  g_array_free (batch->lines, TRUE);
+  g_string_free (batch->text, TRUE);
+  gtk_text_attributes_unref (batch->style);
+  pango_attr_list_unref (batch->attrs);
+  pango_font_description_free (batch->font_desc);
+  if (batch->font_options)
+    cairo_font_options_destroy (batch->font_options);
+  g_free (batch->chunks);
+  g_slice_free (GtkTextWrapBatch, batch);
+}
+
+/* The batch is freed when the threads are done with it. Its lines
+ * are still invalid, so they will be wrapped again later.
+ */
+static void
+gtk_text_layout_cancel_wrap (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextWrapBatch *batch = priv->wrap_batch;
+
+  if (batch == NULL)
+    return;
+
+  batch->layout = NULL;
+  g_atomic_int_set (&batch->cancelled, TRUE);
+  priv->wrap_batch = NULL;
+}
+
+static gboolean wrap_chunk_done (gpointer data);
+
+/* Runs in a thread of the pool. Computes the same size as
+ * gtk_text_layout_real_wrap() would for a line in the default style.
+ */
+static void
+wrap_chunk (gpointer data,
+            gpointer user_data)
+{
+  GtkTextWrapChunk *chunk = data;
+  GtkTextWrapBatch *batch = chunk->batch;
+  GtkTextAttributes *style = batch->style;
+  PangoContext *ltr_context = NULL;
+  PangoContext *rtl_context = NULL;
+  guint i;
+
+  for (i = chunk->start; i < chunk->end; i++)
+    {
+      GtkTextWrapLine *wl = &g_array_index (batch->lines, GtkTextWrapLine, i);
+      PangoLayout *pango_layout;
+      PangoAttrList *attrs;
+      PangoRectangle extents;
+
+      if (g_atomic_int_get (&batch->cancelled))
+        break;
+
+      if (wl->base_dir == PANGO_DIRECTION_RTL)
+        {
+          if (rtl_context == NULL)
+            rtl_context =
+              _gtk_pango_threads_context_new (batch->resolution,
+                                              batch->font_options,
+                                              batch->font_desc,
+                                              batch->language,
+                                              PANGO_DIRECTION_RTL);
+          pango_layout = pango_layout_new (rtl_context);
+        }
+      else
+        {
+          if (ltr_context == NULL)
+            ltr_context =
+              _gtk_pango_threads_context_new (batch->resolution,
+                                              batch->font_options,
+                                              batch->font_desc,
+                                              batch->language,
+                                              PANGO_DIRECTION_LTR);
+          pango_layout = pango_layout_new (ltr_context);
+        }
+
+      set_layout_para_values (pango_layout, wl->base_dir, style,
+                              batch->screen_width);
+
+      pango_layout_set_text (pango_layout,
+                             batch->text->str + wl->text_offset,
+                             wl->text_len);
+
+      attrs = pango_attr_list_copy (batch->attrs);
+      pango_layout_set_attributes (pango_layout, attrs);
+      pango_attr_list_unref (attrs);
+
+      pango_layout_get_extents (pango_layout, NULL, &extents);
+
+      wl->width = PIXEL_BOUND (extents.width) + style->left_margin + style->right_margin;
+      wl->height = style->pixels_above_lines + style->pixels_below_lines +
+        PANGO_PIXELS (extents.height);
+
+      g_object_unref (pango_layout);
+    }
+
+  if (ltr_context)
+    g_object_unref (ltr_context);
+  if (rtl_context)
+    g_object_unref (rtl_context);
+
+  gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE,
+                             wrap_chunk_done, chunk, NULL);
+}
+
+/* Puts the sizes of a chunk into the btree, on the main thread */
+static void
+wrap_chunk_merge (GtkTextLayout    *layout,
+                  GtkTextWrapChunk *chunk)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextWrapBatch *batch = chunk->batch;
+  GtkTextBTree *tree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextWrapLine *wl = NULL;
+  GtkTextLine **lines;
+  gint n_lines = 0;
+  gint delta_height = 0;
+  guint i;
+
+  lines = g_new (GtkTextLine *, chunk->end - chunk->start);
+
+  for (i = chunk->start; i < chunk->end; i++)
+    {
+      GtkTextLineData *line_data;
+
+      wl = &g_array_index (batch->lines, GtkTextWrapLine, i);
+
+      /* The cursor may have moved onto the line since */
+      if (wl->line == priv->cursor_line)
+        continue;
+
+      /* validated in the meantime */
+      line_data = _gtk_text_line_get_data (wl->line, layout);
+      if (line_data && line_data->valid)
+        continue;
+
+      if (line_data == NULL)
+        {
+          line_data = _gtk_text_line_data_new (layout, wl->line);
+          _gtk_text_line_add_data (wl->line, line_data);
+        }
+
+      delta_height += wl->height - line_data->height;
+
+      line_data->width = wl->width;
+      line_data->height = wl->height;
+      line_data->valid = TRUE;
+
+      lines[n_lines++] = wl->line;
+    }
+
+  if (n_lines > 0)
+    {
+      gint first_y, last_y;
+
+      _gtk_text_btree_lines_wrapped (tree, layout, lines, n_lines);
+      update_layout_size (layout);
+
+      first_y = _gtk_text_btree_find_line_top (tree, lines[0], layout);
+      last_y = _gtk_text_btree_find_line_top (tree, lines[n_lines - 1], layout) +
+        _gtk_text_line_get_data (lines[n_lines - 1], layout)->height;
+
+      gtk_text_layout_emit_changed (layout, first_y,
+                                    last_y - first_y - delta_height,
+                                    last_y - first_y);
+    }
+
+  g_free (lines);
+}
+
+static gboolean
+wrap_chunk_done (gpointer data)
+{
+  GtkTextWrapChunk *chunk = data;
+  GtkTextWrapBatch *batch = chunk->batch;
+  GtkTextLayout *layout = batch->layout;
+
+  if (layout)
+    wrap_chunk_merge (layout, chunk);
+
+  batch->unmerged -= 1;
+  if (batch->unmerged > 0)
+    return FALSE;
+
+  wrap_batch_free (batch);
+
+  if (layout)
+    {
+      GTK_TEXT_LAYOUT_GET_PRIVATE (layout)->wrap_batch = NULL;
+
+      /* Let the view pick up validation again */
+      gtk_text_layout_invalidated (layout);
+    }
+
+  return FALSE;
+}
+
+/* Whether a thread can wrap @line: plain text in the default style.
+ * The cursor line is left out, since its base direction and preedit
+ * string come from the layout.
+ */
+static gboolean
+line_can_wrap_in_background (GtkTextLayout *layout,
+                             GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *tree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextLineSegment *seg;
+  GtkTextTag **tags;
+  GtkTextIter iter;
+  gboolean has_text = FALSE;
+  gint n_tags;
+
+  if (line == priv->cursor_line || _gtk_text_line_is_last (line, tree))
+    return FALSE;
+
+  for (seg = line->segments; seg != NULL; seg = seg->next)
+    {
+      if (seg->type == &gtk_text_char_type)
+        has_text = TRUE;
+      else if (seg->type != &gtk_text_right_mark_type &&
+               seg->type != &gtk_text_left_mark_type)
+        return FALSE;
+    }
+
+  if (!has_text)
+    return FALSE;
+
+  _gtk_text_btree_get_iter_at_line (tree, &iter, line, 0);
+  tags = _gtk_text_btree_get_tags (&iter, &n_tags);
+  g_free (tags);
+
+  return n_tags == 0;
+}
+
+/**
+ * gtk_text_layout_validate_in_background:
+ * @layout: a #GtkTextLayout
+ *
+ * Wraps the run of invalid lines starting at the first one in other
+ * threads, from copies of their text. Only lines of plain text in the
+ * default style are wrapped this way; the run ends at the first line
+ * with tags, pixbufs or child widgets, and at the cursor line.
+ *
+ * The sizes are put into the btree on the main thread as parts of the
+ * run are done, and ::changed is emitted for each of them. Once the
+ * whole run is done, ::invalidated is emitted so that validation is
+ * picked up again. Invalidating any part of the layout in the
+ * meantime drops the pending results.
+ *
+ * Nothing is wrapped in other threads unless g_thread_init() has been
+ * called and Pango is at least 1.32, which can shape text in several
+ * threads at once.
+ *
+ * Return value: %TRUE if lines are being wrapped in other threads,
+ *   %FALSE if the next invalid line has to be wrapped with
+ *   gtk_text_layout_validate()
+ **/
+gboolean
+gtk_text_layout_validate_in_background (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv;
+  GtkTextWrapBatch *batch;
+  GtkTextWrapLine wl;
+  GtkTextBTree *tree;
+  GtkTextLine *line;
+  GThreadPool *pool;
+  const cairo_font_options_t *font_options;
+  guint n_threads, n_chunks, i;
+
+  g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), FALSE);
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->wrap_batch)
+    return TRUE;
+
+  if (!_gtk_pango_threads_supported () ||
+      layout->buffer == NULL ||
+      layout->ltr_context == NULL ||
+      layout->default_style == NULL ||
+      layout->default_style->invisible ||
+      GTK_TEXT_LAYOUT_GET_CLASS (layout)->wrap != gtk_text_layout_real_wrap)
+    return FALSE;
+
+  tree = _gtk_text_buffer_get_btree (layout->buffer);
+  line = _gtk_text_btree_get_first_invalid_line (tree, layout);
+  if (line == NULL || !line_can_wrap_in_background (layout, line))
+    return FALSE;
+
+  n_threads = _gtk_pango_threads_get_n_threads ();
+
+  G_LOCK (wrap_pool);
+  if (!wrap_pool)
+    wrap_pool = g_thread_pool_new (wrap_chunk, NULL,
+                                   n_threads, FALSE, NULL);
+  pool = wrap_pool;
+  G_UNLOCK (wrap_pool);
+
+  if (!pool)
+    return FALSE;
+
+  batch = g_slice_new0 (GtkTextWrapBatch);
+  batch->layout = layout;
+  batch->lines = g_array_new (FALSE, FALSE, sizeof (GtkTextWrapLine));
+  batch->text = g_string_new (NULL);
+
+  batch->style = gtk_text_attributes_copy (layout->default_style);
+  batch->attrs = pango_attr_list_new ();
+  add_generic_attrs (layout, &batch->style->appearance, G_MAXINT,
+                     batch->attrs, 0, TRUE, TRUE);
+  add_text_attrs (layout, batch->style, G_MAXINT, batch->attrs, 0, TRUE);
+  batch->screen_width = layout->screen_width;
+
+  batch->font_desc = pango_font_description_copy (pango_context_get_font_description (layout->ltr_context));
+  batch->language = pango_context_get_language (layout->ltr_context);
+  font_options = pango_cairo_context_get_font_options (layout->ltr_context);
+  if (font_options)
+    batch->font_options = cairo_font_options_copy (font_options);
+  batch->resolution = pango_cairo_context_get_resolution (layout->ltr_context);
+
+  do
+    {
+      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+      GtkTextLineSegment *seg;
+
+      if ((line_data && line_data->valid) ||
+          !line_can_wrap_in_background (layout, line))
+        break;
+
+      wl.line = line;
+      wl.text_offset = batch->text->len;
+
+      for (seg = line->segments; seg != NULL; seg = seg->next)
+        if (seg->type == &gtk_text_char_type)
+          g_string_append_len (batch->text, seg->body.chars, seg->byte_count);
+
+      wl.text_len = strip_paragraph_delimiter (batch->text->str + wl.text_offset,
+                                               batch->text->len - wl.text_offset);
+
+      /* Same as in gtk_text_layout_get_line_display() and set_para_values() */
+      wl.base_dir = line->dir_propagated_forward;
+      if (wl.base_dir == PANGO_DIRECTION_NEUTRAL)
+        wl.base_dir = line->dir_propagated_back;
+      if (wl.base_dir == PANGO_DIRECTION_NEUTRAL)
+        wl.base_dir = (batch->style->direction == GTK_TEXT_DIR_RTL) ?
+          PANGO_DIRECTION_RTL : PANGO_DIRECTION_LTR;
+
+      wl.width = 0;
+      wl.height = 0;
+      g_array_append_val (batch->lines, wl);
+
+      line = _gtk_text_line_next_excluding_last (line);
+    }
+  while (line != NULL &&
+         batch->lines->len < WRAP_BATCH_LINES &&
+         batch->text->len < WRAP_BATCH_BYTES);
+
+  n_chunks = (batch->lines->len + WRAP_CHUNK_LINES - 1) / WRAP_CHUNK_LINES;
+  n_chunks = CLAMP (n_chunks, 1, n_threads);
+
+  batch->chunks = g_new (GtkTextWrapChunk, n_chunks);
+  batch->unmerged = n_chunks;
+  priv->wrap_batch = batch;
+
+  for (i = 0; i < n_chunks; i++)
+    {
+      batch->chunks[i].batch = batch;
+      batch->chunks[i].start = (batch->lines->len * i) / n_chunks;
+      batch->chunks[i].end = (batch->lines->len * (i + 1)) / n_chunks;
+    }
+
+  for (i = 0; i < n_chunks; i++)
+    g_thread_pool_push (pool, &batch->chunks[i], NULL);
+
+  return TRUE;
+}
+
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
  * taking into account the preedit string and invisible text if necessary.
  */
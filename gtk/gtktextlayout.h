@@ -146,8 +146,8 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
+  /* The most recently used line display. The displays of other
+   * recently used lines are cached as well, in the private data.
    */
   GtkTextLineDisplay *one_display_cache;
 
@@ -263,6 +263,9 @@ struct _GtkTextLineDisplay
   guint cursors_invalid : 1;
   guint has_block_cursor : 1;
   guint cursor_at_line_end : 1;
+
+  /* Top of the line while the display is cached, or -1 if unknown */
+  gint y;
 };
 
 extern PangoAttrType gtk_text_attr_appearance_type;
@@ -352,6 +355,7 @@ void     gtk_text_layout_validate_yrange (GtkTextLayout *layout,
                                           gint           y1_);
 void     gtk_text_layout_validate        (GtkTextLayout *layout,
                                           gint           max_pixels);
+gboolean gtk_text_layout_validate_in_background (GtkTextLayout *layout);
 
 /* This function should return the passed-in line data,
  * OR remove the existing line data from the line, and
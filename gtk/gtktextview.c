@@ -109,6 +109,7 @@ struct _GtkTextViewPrivate
   guint blink_time;  /* time in msec the cursor has blinked since last user event */
   guint im_spot_idle;
   gchar *im_module;
+  guint threaded_validation : 1;
 };
 
 
@@ -159,7 +160,8 @@ enum
   PROP_OVERWRITE,
   PROP_ACCEPTS_TAB,
   PROP_IM_MODULE,
-  PROP_INDEPENDENT_CURSOR
+  PROP_INDEPENDENT_CURSOR,
+  PROP_THREADED_VALIDATION
 };
 
 static void gtk_text_view_destroy              (GtkObject        *object);
@@ -698,6 +700,22 @@ gtk_text_view_class_init (GtkTextViewClass *klass)
                                    FALSE,
                                    GTK_PARAM_READWRITE));
 
+  /**
+   * GtkTextView:threaded-validation:
+   *
+   * Whether lines outside of the visible area are wrapped in other
+   * threads. See gtk_text_view_set_threaded_validation().
+   *
+   * Since: 2.20
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_THREADED_VALIDATION,
+                                   g_param_spec_boolean ("threaded-validation",
+                                                         P_("Threaded Validation"),
+                                                         P_("Whether lines outside of the visible area are wrapped in other threads"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
+
   /*
    * Style properties
    */
@@ -3022,6 +3040,10 @@ gtk_text_view_set_property (GObject         *object,
       gtk_text_view_set_independent_cursor (text_view, g_value_get_boolean (value));
       break;
 
+    case PROP_THREADED_VALIDATION:
+      gtk_text_view_set_threaded_validation (text_view, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3106,6 +3128,10 @@ gtk_text_view_get_property (GObject         *object,
       g_value_set_boolean (value, text_view->independent_cursor);
       break;
 
+    case PROP_THREADED_VALIDATION:
+      g_value_set_boolean (value, priv->threaded_validation);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3624,9 +3650,21 @@ static gboolean
 incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
+  GtkTextViewPrivate *priv = GTK_TEXT_VIEW_GET_PRIVATE (text_view);
   gboolean result = TRUE;
 
   DV(g_print(G_STRLOC"\n"));
+
+  /* The layout emits ::invalidated once the lines are wrapped,
+   * which installs this idle again.
+   */
+  if (priv->threaded_validation &&
+      gtk_text_layout_validate_in_background (text_view->layout))
+    {
+      gtk_text_view_update_adjustments (text_view);
+      text_view->incremental_validate_idle = 0;
+      return FALSE;
+    }
   
   gtk_text_layout_validate (text_view->layout, 2000);
 
@@ -5891,6 +5929,66 @@ gtk_text_view_get_accepts_tab (GtkTextView *text_view)
   return text_view->accepts_tab;
 }
 
+/**
+ * gtk_text_view_set_threaded_validation:
+ * @text_view: a #GtkTextView
+ * @enable: %TRUE to wrap lines in other threads
+ *
+ * Enables or disables threaded validation. When it is enabled, the
+ * lines outside of the visible area are laid out in other threads,
+ * from copies of their text, and their sizes are put in the text view
+ * as they come in. This lets the scrollbar settle much sooner on very
+ * large buffers.
+ *
+ * Only lines of plain text are wrapped this way: lines with tags,
+ * pixbufs or child widgets are still wrapped in the main thread.
+ * This has no effect unless g_thread_init() has been called, and the
+ * GDK lock is set up with gdk_threads_init() if it is used.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_text_view_set_threaded_validation (GtkTextView *text_view,
+                                       gboolean     enable)
+{
+  GtkTextViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  priv = GTK_TEXT_VIEW_GET_PRIVATE (text_view);
+  enable = enable != FALSE;
+
+  if (priv->threaded_validation != enable)
+    {
+      priv->threaded_validation = enable;
+
+      g_object_notify (G_OBJECT (text_view), "threaded-validation");
+    }
+}
+
+/**
+ * gtk_text_view_get_threaded_validation:
+ * @text_view: a #GtkTextView
+ *
+ * Returns whether threaded validation is turned on for @text_view.
+ * See gtk_text_view_set_threaded_validation().
+ *
+ * Return value: %TRUE if lines are wrapped in other threads
+ *
+ * Since: 2.20
+ **/
+gboolean
+gtk_text_view_get_threaded_validation (GtkTextView *text_view)
+{
+  GtkTextViewPrivate *priv;
+
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (text_view), FALSE);
+
+  priv = GTK_TEXT_VIEW_GET_PRIVATE (text_view);
+
+  return priv->threaded_validation;
+}
+
 static void
 gtk_text_view_compat_move_focus (GtkTextView     *text_view,
                                  GtkDirectionType direction_type)
@@ -555,3 +555,322 @@ _gtk_tree_data_list_set_header (GList                  *header_list,
 
   return header_list;
 }
+
+/* Sorting on extracted keys
+ *
+ * With the default compare function every comparison fetches two
+ * GValues from the model and, for strings, collates them from scratch.
+ * Instead we fetch each row's value once, turn it into a key that
+ * compares with plain operators (a collation key for strings, an
+ * order-preserving unsigned integer for integral types) and sort the
+ * keys.  Long integer lists are radix sorted.
+ */
+
+#define RADIX_SORT_THRESHOLD 512
+
+#define SIGNED_KEY(v) ((guint64) (gint64) (v) ^ G_GUINT64_CONSTANT (0x8000000000000000))
+
+typedef enum
+{
+  SORT_KEY_UINT64,
+  SORT_KEY_DOUBLE,
+  SORT_KEY_STRING
+} SortKeyKind;
+
+typedef struct
+{
+  union {
+    guint64 v_uint64;
+    gdouble v_double;
+    gchar  *v_string;
+  } key;
+  gint index;
+} SortKey;
+
+struct _GtkTreeDataSortKeys
+{
+  GtkTreeModel *model;
+  gint column;
+  GType fundamental;
+  SortKeyKind kind;
+  gboolean descending;
+
+  SortKey *keys;
+  gint n_keys;
+  gint n_alloc;
+};
+
+/* Returns %NULL if @func is not the default compare function, or if
+ * the column it sorts on has no key representation.
+ */
+GtkTreeDataSortKeys *
+_gtk_tree_data_list_sort_keys_new (GtkTreeModel           *model,
+				   GtkTreeIterCompareFunc  func,
+				   gpointer                data,
+				   gint                    n_rows)
+{
+  GtkTreeDataSortKeys *keys;
+  SortKeyKind kind;
+  GType fundamental;
+  gint column;
+
+  if (func != _gtk_tree_data_list_compare_func)
+    return NULL;
+
+  column = GPOINTER_TO_INT (data);
+  if (column < 0 || column >= gtk_tree_model_get_n_columns (model))
+    return NULL;
+
+  fundamental = get_fundamental_type (gtk_tree_model_get_column_type (model, column));
+  switch (fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+    case G_TYPE_CHAR:
+    case G_TYPE_UCHAR:
+    case G_TYPE_INT:
+    case G_TYPE_UINT:
+    case G_TYPE_LONG:
+    case G_TYPE_ULONG:
+    case G_TYPE_INT64:
+    case G_TYPE_UINT64:
+    case G_TYPE_ENUM:
+    case G_TYPE_FLAGS:
+      kind = SORT_KEY_UINT64;
+      break;
+    case G_TYPE_FLOAT:
+    case G_TYPE_DOUBLE:
+      kind = SORT_KEY_DOUBLE;
+      break;
+    case G_TYPE_STRING:
+      kind = SORT_KEY_STRING;
+      break;
+    default:
+      return NULL;
+    }
+
+  keys = g_slice_new (GtkTreeDataSortKeys);
+  keys->model = model;
+  keys->column = column;
+  keys->fundamental = fundamental;
+  keys->kind = kind;
+  keys->descending = FALSE;
+  keys->keys = g_new (SortKey, MAX (n_rows, 1));
+  keys->n_keys = 0;
+  keys->n_alloc = n_rows;
+
+  return keys;
+}
+
+/* Extracts the key of the row at @iter.  Rows have to be added in the
+ * order of the positions they currently have.
+ */
+void
+_gtk_tree_data_list_sort_keys_add (GtkTreeDataSortKeys *keys,
+				   GtkTreeIter         *iter)
+{
+  GValue value = {0, };
+  SortKey *key;
+  const gchar *str;
+
+  g_return_if_fail (keys->n_keys < keys->n_alloc);
+
+  key = &keys->keys[keys->n_keys];
+  key->index = keys->n_keys++;
+
+  gtk_tree_model_get_value (keys->model, iter, keys->column, &value);
+
+  switch (keys->fundamental)
+    {
+    case G_TYPE_BOOLEAN:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_boolean (&value));
+      break;
+    case G_TYPE_CHAR:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_char (&value));
+      break;
+    case G_TYPE_UCHAR:
+      key->key.v_uint64 = g_value_get_uchar (&value);
+      break;
+    case G_TYPE_INT:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_int (&value));
+      break;
+    case G_TYPE_UINT:
+      key->key.v_uint64 = g_value_get_uint (&value);
+      break;
+    case G_TYPE_LONG:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_long (&value));
+      break;
+    case G_TYPE_ULONG:
+      key->key.v_uint64 = g_value_get_ulong (&value);
+      break;
+    case G_TYPE_INT64:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_int64 (&value));
+      break;
+    case G_TYPE_UINT64:
+      key->key.v_uint64 = g_value_get_uint64 (&value);
+      break;
+    case G_TYPE_ENUM:
+      key->key.v_uint64 = SIGNED_KEY (g_value_get_enum (&value));
+      break;
+    case G_TYPE_FLAGS:
+      key->key.v_uint64 = g_value_get_flags (&value);
+      break;
+    case G_TYPE_FLOAT:
+      key->key.v_double = g_value_get_float (&value);
+      break;
+    case G_TYPE_DOUBLE:
+      key->key.v_double = g_value_get_double (&value);
+      break;
+    case G_TYPE_STRING:
+      str = g_value_get_string (&value);
+      key->key.v_string = g_utf8_collate_key (str ? str : "", -1);
+      break;
+    default:
+      g_assert_not_reached ();
+      break;
+    }
+
+  g_value_unset (&value);
+}
+
+static gint
+sort_key_compare (gconstpointer a,
+		  gconstpointer b,
+		  gpointer      user_data)
+{
+  GtkTreeDataSortKeys *keys = user_data;
+  const SortKey *ka = a;
+  const SortKey *kb = b;
+  gint retval;
+
+  switch (keys->kind)
+    {
+    case SORT_KEY_UINT64:
+      /* descending keys have been complemented already */
+      if (ka->key.v_uint64 < kb->key.v_uint64)
+	retval = -1;
+      else if (ka->key.v_uint64 == kb->key.v_uint64)
+	retval = 0;
+      else
+	retval = 1;
+      break;
+    case SORT_KEY_DOUBLE:
+      if (ka->key.v_double < kb->key.v_double)
+	retval = -1;
+      else if (ka->key.v_double == kb->key.v_double)
+	retval = 0;
+      else
+	retval = 1;
+      if (keys->descending)
+	retval = -retval;
+      break;
+    case SORT_KEY_STRING:
+      retval = strcmp (ka->key.v_string, kb->key.v_string);
+      if (keys->descending)
+	retval = -retval;
+      break;
+    default:
+      g_assert_not_reached ();
+      retval = 0;
+      break;
+    }
+
+  /* keep rows that compare equal in their current order */
+  if (retval == 0)
+    retval = ka->index < kb->index ? -1 : (ka->index > kb->index);
+
+  return retval;
+}
+
+/* Least significant digit first, one byte per pass; passes in which
+ * all keys have the same byte are skipped.  Stable.
+ */
+static void
+sort_keys_radix (SortKey *keys,
+		 gint     n_keys)
+{
+  guint (*count)[256];
+  SortKey *tmp, *src, *dst;
+  gint pass, i;
+
+  count = g_malloc0 (8 * sizeof (*count));
+  for (i = 0; i < n_keys; i++)
+    {
+      guint64 v = keys[i].key.v_uint64;
+
+      for (pass = 0; pass < 8; pass++)
+	count[pass][(v >> (8 * pass)) & 0xff]++;
+    }
+
+  tmp = g_new (SortKey, n_keys);
+  src = keys;
+  dst = tmp;
+
+  for (pass = 0; pass < 8; pass++)
+    {
+      guint offset, c;
+      SortKey *swap;
+      gint shift = 8 * pass;
+
+      if (count[pass][(src[0].key.v_uint64 >> shift) & 0xff] == (guint) n_keys)
+	continue;
+
+      for (i = 0, offset = 0; i < 256; i++)
+	{
+	  c = count[pass][i];
+	  count[pass][i] = offset;
+	  offset += c;
+	}
+
+      for (i = 0; i < n_keys; i++)
+	dst[count[pass][(src[i].key.v_uint64 >> shift) & 0xff]++] = src[i];
+
+      swap = src;
+      src = dst;
+      dst = swap;
+    }
+
+  if (src != keys)
+    memcpy (keys, src, n_keys * sizeof (SortKey));
+
+  g_free (tmp);
+  g_free (count);
+}
+
+/* Sorts the keys added so far and fills @new_order, which must hold as
+ * many elements, with the old index of the row at each new position.
+ */
+void
+_gtk_tree_data_list_sort_keys_sort (GtkTreeDataSortKeys *keys,
+				    GtkSortType          order,
+				    gint                *new_order)
+{
+  gint i;
+
+  keys->descending = (order == GTK_SORT_DESCENDING);
+
+  if (keys->kind == SORT_KEY_UINT64 && keys->descending)
+    for (i = 0; i < keys->n_keys; i++)
+      keys->keys[i].key.v_uint64 = ~keys->keys[i].key.v_uint64;
+
+  if (keys->kind == SORT_KEY_UINT64 && keys->n_keys >= RADIX_SORT_THRESHOLD)
+    sort_keys_radix (keys->keys, keys->n_keys);
+  else
+    g_qsort_with_data (keys->keys, keys->n_keys, sizeof (SortKey),
+		       sort_key_compare, keys);
+
+  for (i = 0; i < keys->n_keys; i++)
+    new_order[i] = keys->keys[i].index;
+}
+
+void
+_gtk_tree_data_list_sort_keys_free (GtkTreeDataSortKeys *keys)
+{
+  gint i;
+
+  if (keys->kind == SORT_KEY_STRING)
+    for (i = 0; i < keys->n_keys; i++)
+      g_free (keys->keys[i].key.v_string);
+
+  g_free (keys->keys);
+  g_slice_free (GtkTreeDataSortKeys, keys);
+}
@@ -79,4 +79,18 @@ GList                 *_gtk_tree_data_list_set_header  (GList                  *
 							gpointer                data,
 							GDestroyNotify          destroy);
 
+/* Sorting on keys extracted once per row */
+typedef struct _GtkTreeDataSortKeys GtkTreeDataSortKeys;
+
+GtkTreeDataSortKeys   *_gtk_tree_data_list_sort_keys_new  (GtkTreeModel           *model,
+							   GtkTreeIterCompareFunc  func,
+							   gpointer                data,
+							   gint                    n_rows);
+void                   _gtk_tree_data_list_sort_keys_add  (GtkTreeDataSortKeys    *keys,
+							   GtkTreeIter            *iter);
+void                   _gtk_tree_data_list_sort_keys_sort (GtkTreeDataSortKeys    *keys,
+							   GtkSortType             order,
+							   gint                   *new_order);
+void                   _gtk_tree_data_list_sort_keys_free (GtkTreeDataSortKeys    *keys);
+
 #endif /* __GTK_TREE_DATA_LIST_H__ */
@@ -47,6 +47,7 @@ enum {
   ROW_HAS_CHILD_TOGGLED,
   ROW_DELETED,
   ROWS_REORDERED,
+  CHILDREN_RELOADED,
   LAST_SIGNAL
 };
 
@@ -84,6 +85,12 @@ static void      rows_reordered_marshal     (GClosure          *closure,
                                              const GValue      *param_values,
                                              gpointer           invocation_hint,
                                              gpointer           marshal_data);
+static void      children_reloaded_marshal  (GClosure          *closure,
+                                             GValue /* out */  *return_value,
+                                             guint              n_param_value,
+                                             const GValue      *param_values,
+                                             gpointer           invocation_hint,
+                                             gpointer           marshal_data);
 
 static void      gtk_tree_row_ref_inserted  (RowRefList        *refs,
                                              GtkTreePath       *path,
@@ -94,6 +101,8 @@ static void      gtk_tree_row_ref_reordered (RowRefList        *refs,
                                              GtkTreePath       *path,
                                              GtkTreeIter       *iter,
                                              gint              *new_order);
+static void      gtk_tree_row_ref_children_reloaded (RowRefList  *refs,
+                                                     GtkTreePath *path);
 
 GType
 gtk_tree_model_get_type (void)
@@ -136,6 +145,7 @@ gtk_tree_model_base_init (gpointer g_class)
       GType row_inserted_params[2];
       GType row_deleted_params[1];
       GType rows_reordered_params[3];
+      GType children_reloaded_params[2];
 
       row_inserted_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
       row_inserted_params[1] = GTK_TYPE_TREE_ITER;
@@ -146,6 +156,9 @@ gtk_tree_model_base_init (gpointer g_class)
       rows_reordered_params[1] = GTK_TYPE_TREE_ITER;
       rows_reordered_params[2] = G_TYPE_POINTER;
 
+      children_reloaded_params[0] = GTK_TYPE_TREE_PATH | G_SIGNAL_TYPE_STATIC_SCOPE;
+      children_reloaded_params[1] = GTK_TYPE_TREE_ITER;
+
       /**
        * GtkTreeModel::row-changed:
        * @tree_model: the #GtkTreeModel on which the signal is emitted
@@ -276,6 +289,45 @@ gtk_tree_model_base_init (gpointer g_class)
                        _gtk_marshal_VOID__BOXED_BOXED_POINTER,
                        G_TYPE_NONE, 3,
                        rows_reordered_params);
+
+      /**
+       * GtkTreeModel::children-reloaded:
+       * @tree_model: the #GtkTreeModel on which the signal is emitted
+       * @path: a #GtkTreePath identifying the tree node whose children
+       *        have been replaced
+       * @iter: a valid #GtkTreeIter pointing to that node, or %NULL if
+       *        the depth of @path is 0
+       *
+       * This signal is emitted when all the children of a node (or all
+       * the toplevel rows, if the depth of @path is 0) have been replaced
+       * at once, for example by gtk_list_store_append_bulk().  Listeners
+       * should drop everything they know about the previous children and
+       * read the new ones from the model, instead of expecting a
+       * "row-deleted" or "row-inserted" signal for every row.
+       *
+       * The model emits this signal <emphasis>after</emphasis> the old
+       * children have been removed, so references held on them with
+       * gtk_tree_model_ref_node() are gone as well and must not be
+       * released with gtk_tree_model_unref_node().  Row references
+       * pointing inside the reloaded level become invalid.
+       *
+       * If the node had no children before and has some now, or the
+       * other way round, the model emits
+       * #GtkTreeModel::row-has-child-toggled for it after this signal.
+       *
+       * Since: 2.20
+       */
+      closure = g_closure_new_simple (sizeof (GClosure), NULL);
+      g_closure_set_marshal (closure, children_reloaded_marshal);
+      tree_model_signals[CHILDREN_RELOADED] =
+        g_signal_newv (I_("children-reloaded"),
+                       GTK_TYPE_TREE_MODEL,
+                       G_SIGNAL_RUN_FIRST,
+                       closure,
+                       NULL, NULL,
+                       _gtk_marshal_VOID__BOXED_BOXED,
+                       G_TYPE_NONE, 2,
+                       children_reloaded_params);
       initialized = TRUE;
     }
 }
@@ -377,6 +429,24 @@ rows_reordered_marshal (GClosure          *closure,
     rows_reordered_callback (GTK_TREE_MODEL (model), path, iter, new_order);
 }
 
+static void
+children_reloaded_marshal (GClosure          *closure,
+                           GValue /* out */  *return_value,
+                           guint              n_param_values,
+                           const GValue      *param_values,
+                           gpointer           invocation_hint,
+                           gpointer           marshal_data)
+{
+  GObject *model = g_value_get_object (param_values + 0);
+  GtkTreePath *path = (GtkTreePath *)g_value_get_boxed (param_values + 1);
+
+  /* there is no ->children_reloaded slot in the interface structure,
+   * so all we have to do here is to update the row references.
+   */
+  gtk_tree_row_ref_children_reloaded ((RowRefList *)g_object_get_data (model, ROW_REF_DATA_STRING),
+                                      path);
+}
+
 /**
  * gtk_tree_path_new:
  *
@@ -1565,6 +1635,34 @@ gtk_tree_model_rows_reordered (GtkTreeModel *tree_model,
   g_signal_emit (tree_model, tree_model_signals[ROWS_REORDERED], 0, path, iter, new_order);
 }
 
+/**
+ * gtk_tree_model_children_reloaded:
+ * @tree_model: A #GtkTreeModel
+ * @path: A #GtkTreePath pointing to the tree node whose children have been
+ *      replaced
+ * @iter: A valid #GtkTreeIter pointing to the node whose children have been
+ *      replaced, or %NULL if the depth of @path is 0.
+ *
+ * Emits the "children-reloaded" signal on @tree_model.  This should be
+ * called by models after they replaced all the children of a node in one
+ * go, instead of emitting "row-deleted" and "row-inserted" for each row.
+ * If the node gained its first children or lost all of them, the model
+ * calls gtk_tree_model_row_has_child_toggled() afterwards, as usual.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_tree_model_children_reloaded (GtkTreeModel *tree_model,
+                                  GtkTreePath  *path,
+                                  GtkTreeIter  *iter)
+{
+  g_return_if_fail (GTK_IS_TREE_MODEL (tree_model));
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (gtk_tree_path_get_depth (path) == 0 || iter != NULL);
+
+  g_signal_emit (tree_model, tree_model_signals[CHILDREN_RELOADED], 0, path, iter);
+}
+
 
 static gboolean
 gtk_tree_model_foreach_helper (GtkTreeModel            *model,
@@ -1843,6 +1941,37 @@ gtk_tree_row_ref_reordered (RowRefList  *refs,
     }
 }
 
+static void
+gtk_tree_row_ref_children_reloaded (RowRefList  *refs,
+				    GtkTreePath *path)
+{
+  GSList *tmp_list;
+
+  if (refs == NULL)
+    return;
+
+  /* Every reference below @path pointed at a row that no longer
+   * exists.  The reloaded level went away together with the refs on
+   * it, so only the ancestors from @path upwards are unreffed.
+   */
+  for (tmp_list = refs->list; tmp_list; tmp_list = tmp_list->next)
+    {
+      GtkTreeRowReference *reference = tmp_list->data;
+
+      if (reference->path == NULL ||
+	  reference->path->depth <= path->depth)
+	continue;
+
+      if (path->depth > 0 &&
+	  !gtk_tree_path_is_ancestor (path, reference->path))
+	continue;
+
+      gtk_tree_row_reference_unref_path (reference->path, reference->model, path->depth);
+      gtk_tree_path_free (reference->path);
+      reference->path = NULL;
+    }
+}
+
 /* We do this recursively so that we can unref children nodes before their parent */
 static void
 gtk_tree_row_reference_unref_path_helper (GtkTreePath  *path,
@@ -2163,5 +2292,25 @@ gtk_tree_row_reference_reordered (GObject     *proxy,
   gtk_tree_row_ref_reordered ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path, iter, new_order);
 }
 
+/**
+ * gtk_tree_row_reference_children_reloaded:
+ * @proxy: A #GObject
+ * @path: The parent path of the reloaded signal
+ *
+ * Lets a set of row reference created by gtk_tree_row_reference_new_proxy()
+ * know that the model emitted the "children_reloaded" signal.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_tree_row_reference_children_reloaded (GObject     *proxy,
+					  GtkTreePath *path)
+{
+  g_return_if_fail (G_IS_OBJECT (proxy));
+  g_return_if_fail (path != NULL);
+
+  gtk_tree_row_ref_children_reloaded ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path);
+}
+
 #define __GTK_TREE_MODEL_C__
 #include "gtkaliasdef.c"
@@ -179,6 +179,8 @@ void                 gtk_tree_row_reference_reordered (GObject     *proxy,
 						       GtkTreePath *path,
 						       GtkTreeIter *iter,
 						       gint        *new_order);
+void                 gtk_tree_row_reference_children_reloaded (GObject     *proxy,
+							       GtkTreePath *path);
 
 /* GtkTreeIter operations */
 GtkTreeIter *     gtk_tree_iter_copy             (GtkTreeIter  *iter);
@@ -262,6 +264,9 @@ void gtk_tree_model_rows_reordered        (GtkTreeModel *tree_model,
 					   GtkTreePath  *path,
 					   GtkTreeIter  *iter,
 					   gint         *new_order);
+void gtk_tree_model_children_reloaded     (GtkTreeModel *tree_model,
+					   GtkTreePath  *path,
+					   GtkTreeIter  *iter);
 
 G_END_DECLS
 
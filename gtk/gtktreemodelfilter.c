@@ -73,6 +73,12 @@ struct _FilterLevel
   gint ref_count;
   gint visible_nodes;
 
+  /* Fenwick tree over the visible flags of the elements in array,
+   * mapping between array indices and visible positions.  It is built
+   * when needed and dropped when elements are added or removed.
+   */
+  gint *visible_index;
+
   gint parent_elt_index;
   FilterLevel *parent_level;
 };
@@ -113,6 +119,7 @@ struct _GtkTreeModelFilterPrivate
   guint has_child_toggled_id;
   guint deleted_id;
   guint reordered_id;
+  guint reloaded_id;
 };
 
 /* properties */
@@ -166,6 +173,10 @@ static void         gtk_tree_model_filter_rows_reordered                  (GtkTr
                                                                            GtkTreeIter            *c_iter,
                                                                            gint                   *new_order,
                                                                            gpointer                data);
+static void         gtk_tree_model_filter_children_reloaded               (GtkTreeModel           *c_model,
+                                                                           GtkTreePath            *c_path,
+                                                                           GtkTreeIter            *c_iter,
+                                                                           gpointer                data);
 
 /* GtkTreeModel interface */
 static GtkTreeModelFlags gtk_tree_model_filter_get_flags                       (GtkTreeModel           *model);
@@ -221,7 +232,8 @@ static void        gtk_tree_model_filter_build_level                      (GtkTr
                                                                            gboolean                emit_inserted);
 
 static void        gtk_tree_model_filter_free_level                       (GtkTreeModelFilter     *filter,
-                                                                           FilterLevel            *filter_level);
+                                                                           FilterLevel            *filter_level,
+                                                                           gboolean                unref);
 
 static GtkTreePath *gtk_tree_model_filter_elt_get_path                    (FilterLevel            *level,
                                                                            FilterElt              *elt,
@@ -378,7 +390,7 @@ gtk_tree_model_filter_finalize (GObject *object)
     gtk_tree_path_free (filter->priv->virtual_root);
 
   if (filter->priv->root)
-    gtk_tree_model_filter_free_level (filter, filter->priv->root);
+    gtk_tree_model_filter_free_level (filter, filter->priv->root, TRUE);
 
   g_free (filter->priv->modify_types);
   
@@ -507,6 +519,7 @@ gtk_tree_model_filter_build_level (GtkTreeModelFilter *filter,
                                         length);
   new_level->ref_count = 0;
   new_level->visible_nodes = 0;
+  new_level->visible_index = NULL;
   new_level->parent_elt_index = parent_elt_index;
   new_level->parent_level = parent_level;
 
@@ -606,12 +619,13 @@ gtk_tree_model_filter_build_level (GtkTreeModelFilter *filter,
       gtk_tree_model_filter_ref_node (GTK_TREE_MODEL (filter), &f_iter);
     }
   else if (new_level->array->len == 0)
-    gtk_tree_model_filter_free_level (filter, new_level);
+    gtk_tree_model_filter_free_level (filter, new_level, TRUE);
 }
 
 static void
 gtk_tree_model_filter_free_level (GtkTreeModelFilter *filter,
-                                  FilterLevel        *filter_level)
+                                  FilterLevel        *filter_level,
+                                  gboolean            unref)
 {
   gint i;
 
@@ -621,9 +635,11 @@ gtk_tree_model_filter_free_level (GtkTreeModelFilter *filter,
     {
       if (g_array_index (filter_level->array, FilterElt, i).children)
         gtk_tree_model_filter_free_level (filter,
-                                          FILTER_LEVEL (g_array_index (filter_level->array, FilterElt, i).children));
+                                          FILTER_LEVEL (g_array_index (filter_level->array, FilterElt, i).children),
+                                          unref);
 
-      if (filter_level->parent_level || filter->priv->virtual_root)
+      if (unref &&
+          (filter_level->parent_level || filter->priv->virtual_root))
         {
           GtkTreeIter f_iter;
 
@@ -659,6 +675,7 @@ gtk_tree_model_filter_free_level (GtkTreeModelFilter *filter,
 
   g_array_free (filter_level->array, TRUE);
   filter_level->array = NULL;
+  g_free (filter_level->visible_index);
 
   g_free (filter_level);
   filter_level = NULL;
@@ -803,11 +820,84 @@ gtk_tree_model_filter_clear_cache_helper (GtkTreeModelFilter *filter,
 
   if (level->ref_count == 0 && level != filter->priv->root)
     {
-      gtk_tree_model_filter_free_level (filter, level);
+      gtk_tree_model_filter_free_level (filter, level, TRUE);
       return;
     }
 }
 
+/* Has to be called whenever elements are added to or removed from
+ * the array of @level.
+ */
+static void
+gtk_tree_model_filter_level_invalidate_index (FilterLevel *level)
+{
+  g_free (level->visible_index);
+  level->visible_index = NULL;
+}
+
+static void
+gtk_tree_model_filter_level_ensure_index (FilterLevel *level)
+{
+  gint i, j, len;
+  gint *index;
+
+  if (level->visible_index)
+    return;
+
+  len = level->array->len;
+  index = g_new (gint, len + 1);
+
+  index[0] = 0;
+  for (i = 1; i <= len; i++)
+    index[i] = g_array_index (level->array, FilterElt, i - 1).visible ? 1 : 0;
+
+  for (i = 1; i <= len; i++)
+    {
+      j = i + (i & -i);
+      if (j <= len)
+        index[j] += index[i];
+    }
+
+  level->visible_index = index;
+}
+
+static void
+gtk_tree_model_filter_elt_set_visible (FilterLevel *level,
+                                       FilterElt   *elt,
+                                       gboolean     visible)
+{
+  gint i, len, delta;
+
+  if (elt->visible == visible)
+    return;
+
+  elt->visible = visible;
+
+  if (!level->visible_index)
+    return;
+
+  len = level->array->len;
+  delta = visible ? 1 : -1;
+
+  for (i = FILTER_LEVEL_ELT_INDEX (level, elt) + 1; i <= len; i += i & -i)
+    level->visible_index[i] += delta;
+}
+
+/* Returns the number of visible elements before @elt_index */
+static gint
+gtk_tree_model_filter_level_count_visible (FilterLevel *level,
+                                           gint         elt_index)
+{
+  gint i, count = 0;
+
+  gtk_tree_model_filter_level_ensure_index (level);
+
+  for (i = elt_index; i > 0; i -= i & -i)
+    count += level->visible_index[i];
+
+  return count;
+}
+
 static FilterElt *
 gtk_tree_model_filter_get_nth (GtkTreeModelFilter *filter,
                                FilterLevel        *level,
@@ -850,27 +940,31 @@ gtk_tree_model_filter_get_nth_visible (GtkTreeModelFilter *filter,
                                        FilterLevel        *level,
                                        int                 n)
 {
-  int i = 0;
-  FilterElt *elt;
+  gint len, pos, step;
 
   if (level->visible_nodes <= n)
     return NULL;
 
-  elt = FILTER_ELT (level->array->data);
-  while (!elt->visible)
-    elt++;
+  gtk_tree_model_filter_level_ensure_index (level);
 
-  while (i < n)
-    {
-      if (elt->visible)
-        i++;
-      elt++;
-    }
+  /* find the element with n visible elements before it */
+  len = level->array->len;
+  for (step = 1; step * 2 <= len; step *= 2)
+    ;
+
+  pos = 0;
+  n++;
+  for (; step > 0; step /= 2)
+    if (pos + step <= len && level->visible_index[pos + step] < n)
+      {
+        pos += step;
+        n -= level->visible_index[pos];
+      }
 
-  while (!elt->visible)
-    elt++;
+  if (pos >= len)
+    return NULL;
 
-  return elt;
+  return &g_array_index (level->array, FilterElt, pos);
 }
 
 static FilterElt *
@@ -966,9 +1060,10 @@ gtk_tree_model_filter_fetch_child (GtkTreeModelFilter *filter,
     i = 0;
 
   g_array_insert_val (level->array, i, elt);
+  gtk_tree_model_filter_level_invalidate_index (level);
   *index = i;
 
-  for (i = 0; i < level->array->len; i++)
+  for (i = *index; i < level->array->len; i++)
     {
       FilterElt *e = &(g_array_index (level->array, FilterElt, i));
       if (e->children)
@@ -1033,10 +1128,10 @@ gtk_tree_model_filter_remove_node (GtkTreeModelFilter *filter,
        */
 
       if (elt->children)
-        gtk_tree_model_filter_free_level (filter, elt->children);
+        gtk_tree_model_filter_free_level (filter, elt->children, TRUE);
 
       path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), iter);
-      elt->visible = FALSE;
+      gtk_tree_model_filter_elt_set_visible (level, elt, FALSE);
       gtk_tree_model_filter_increment_stamp (filter);
       iter->stamp = filter->priv->stamp;
       gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
@@ -1058,6 +1153,7 @@ gtk_tree_model_filter_remove_node (GtkTreeModelFilter *filter,
       if (tmp)
         {
           g_array_remove_index (level->array, i);
+          gtk_tree_model_filter_level_invalidate_index (level);
 
 	  i--;
           for (i = MAX (i, 0); i < level->array->len; i++)
@@ -1082,12 +1178,12 @@ gtk_tree_model_filter_remove_node (GtkTreeModelFilter *filter,
 
       if (elt->children)
         {
-          gtk_tree_model_filter_free_level (filter, elt->children);
+          gtk_tree_model_filter_free_level (filter, elt->children, TRUE);
           elt->children = NULL;
         }
 
       path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), iter);
-      elt->visible = FALSE;
+      gtk_tree_model_filter_elt_set_visible (level, elt, FALSE);
       gtk_tree_model_filter_increment_stamp (filter);
       gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
       gtk_tree_path_free (path);
@@ -1099,7 +1195,7 @@ gtk_tree_model_filter_remove_node (GtkTreeModelFilter *filter,
       /* Blow level away, including any child levels */
 
       path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), iter);
-      elt->visible = FALSE;
+      gtk_tree_model_filter_elt_set_visible (level, elt, FALSE);
       gtk_tree_model_filter_increment_stamp (filter);
       iter->stamp = filter->priv->stamp;
       gtk_tree_model_row_deleted (GTK_TREE_MODEL (filter), path);
@@ -1109,7 +1205,7 @@ gtk_tree_model_filter_remove_node (GtkTreeModelFilter *filter,
         gtk_tree_model_filter_real_unref_node (GTK_TREE_MODEL (filter),
                                                iter, FALSE);
 
-      gtk_tree_model_filter_free_level (filter, level);
+      gtk_tree_model_filter_free_level (filter, level, TRUE);
     }
 
   if (emit_child_toggled)
@@ -1350,7 +1446,7 @@ gtk_tree_model_filter_row_changed (GtkTreeModel *c_model,
   /* elt->visible can be TRUE at this point if it was pulled in above */
   if (!elt->visible)
     {
-      elt->visible = TRUE;
+      gtk_tree_model_filter_elt_set_visible (level, elt, TRUE);
       level->visible_nodes++;
     }
 
@@ -1409,6 +1505,7 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
   FilterLevel *parent_level;
 
   gint i = 0, offset;
+  gint start, end;
 
   gboolean free_c_path = FALSE;
 
@@ -1563,13 +1660,22 @@ gtk_tree_model_filter_row_inserted (GtkTreeModel *c_model,
       felt.visible = TRUE;
       felt.children = NULL;
 
-      for (i = 0; i < level->array->len; i++)
-        if (g_array_index (level->array, FilterElt, i).offset > offset)
-          break;
+      start = 0;
+      end = level->array->len;
+      while (start < end)
+        {
+          i = (start + end) / 2;
+          if (g_array_index (level->array, FilterElt, i).offset > offset)
+            end = i;
+          else
+            start = i + 1;
+        }
+      i = start;
 
       level->visible_nodes++;
 
       g_array_insert_val (level->array, i, felt);
+      gtk_tree_model_filter_level_invalidate_index (level);
 
       if (level->parent_level || filter->priv->virtual_root)
         {
@@ -1692,7 +1798,7 @@ gtk_tree_model_filter_row_has_child_toggled (GtkTreeModel *c_model,
     }
   else if (!elt->visible && requested_state)
     {
-      elt->visible = TRUE;
+      gtk_tree_model_filter_elt_set_visible (level, elt, TRUE);
       level->visible_nodes++;
 
       /* Only insert if the parent is visible in the target */
@@ -1771,7 +1877,7 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
         gtk_tree_model_row_deleted (GTK_TREE_MODEL (data), path);
 
       gtk_tree_path_free (path);
-      gtk_tree_model_filter_free_level (filter, filter->priv->root);
+      gtk_tree_model_filter_free_level (filter, filter->priv->root, TRUE);
 
       return;
     }
@@ -1920,7 +2026,7 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
   if (level->array->len == 1)
     {
       /* kill level */
-      gtk_tree_model_filter_free_level (filter, level);
+      gtk_tree_model_filter_free_level (filter, level, TRUE);
     }
   else
     {
@@ -1938,6 +2044,7 @@ gtk_tree_model_filter_row_deleted (GtkTreeModel *c_model,
 
       offset = tmp->offset;
       g_array_remove_index (level->array, i);
+      gtk_tree_model_filter_level_invalidate_index (level);
 
       i--;
       for (i = MAX (i, 0); i < level->array->len; i++)
@@ -2134,6 +2241,7 @@ gtk_tree_model_filter_rows_reordered (GtkTreeModel *c_model,
 
   g_array_free (level->array, TRUE);
   level->array = new_array;
+  gtk_tree_model_filter_level_invalidate_index (level);
 
   /* fix up stuff */
   for (i = 0; i < level->array->len; i++)
@@ -2162,6 +2270,107 @@ gtk_tree_model_filter_rows_reordered (GtkTreeModel *c_model,
   gtk_tree_path_free (path);
 }
 
+static void
+gtk_tree_model_filter_children_reloaded (GtkTreeModel *c_model,
+                                         GtkTreePath  *c_path,
+                                         GtkTreeIter  *c_iter,
+                                         gpointer      data)
+{
+  GtkTreeModelFilter *filter = GTK_TREE_MODEL_FILTER (data);
+  FilterLevel *level;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gboolean had_level, had_visible;
+
+  g_return_if_fail (c_path != NULL);
+
+  if (filter->priv->virtual_root_deleted)
+    return;
+
+  if (filter->priv->virtual_root &&
+      gtk_tree_path_is_ancestor (c_path, filter->priv->virtual_root))
+    {
+      GtkTreePath *ancestors;
+
+      /* the virtual root was one of the replaced rows; only the rows
+       * above the reloaded level still exist to be unreffed
+       */
+      ancestors = gtk_tree_path_copy (filter->priv->virtual_root);
+      while (gtk_tree_path_get_depth (ancestors) > gtk_tree_path_get_depth (c_path))
+        gtk_tree_path_up (ancestors);
+      gtk_tree_model_filter_unref_path (filter, ancestors);
+      gtk_tree_path_free (ancestors);
+      filter->priv->virtual_root_deleted = TRUE;
+
+      path = gtk_tree_path_new ();
+      level = FILTER_LEVEL (filter->priv->root);
+    }
+  else if (filter->priv->virtual_root &&
+           !gtk_tree_path_compare (c_path, filter->priv->virtual_root))
+    {
+      path = gtk_tree_path_new ();
+      level = FILTER_LEVEL (filter->priv->root);
+    }
+  else if (!filter->priv->virtual_root && gtk_tree_path_get_depth (c_path) == 0)
+    {
+      path = gtk_tree_path_new ();
+      level = FILTER_LEVEL (filter->priv->root);
+    }
+  else
+    {
+      path = gtk_real_tree_model_filter_convert_child_path_to_path (filter,
+                                                                    c_path,
+                                                                    FALSE,
+                                                                    FALSE);
+      if (!path)
+        return;
+
+      gtk_tree_model_filter_get_iter_full (GTK_TREE_MODEL (filter), &iter, path);
+      level = FILTER_ELT (iter.user_data2)->children;
+
+      /* get a path taking only visible nodes into account */
+      gtk_tree_path_free (path);
+      if (FILTER_ELT (iter.user_data2)->visible)
+        path = gtk_tree_model_get_path (GTK_TREE_MODEL (filter), &iter);
+      else
+        path = NULL;
+    }
+
+  /* The child model dropped the old rows together with every reference
+   * on them, so the level goes away without unreffing its elements.  It
+   * is built, and filtered, again the next time it is asked for.
+   */
+  had_level = level != NULL;
+  had_visible = level && level->visible_nodes > 0;
+
+  if (level)
+    gtk_tree_model_filter_free_level (filter, level, FALSE);
+
+  gtk_tree_model_filter_increment_stamp (filter);
+
+  /* nobody can see the children of a hidden row */
+  if (!path)
+    return;
+
+  if (gtk_tree_path_get_depth (path))
+    {
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (filter), &iter, path);
+      gtk_tree_model_children_reloaded (GTK_TREE_MODEL (filter), path, &iter);
+
+      /* When the child row gained or lost all its children, the child
+       * model emits ::row-has-child-toggled itself and it is passed on.
+       * Otherwise only the filter knows whether any of them are visible.
+       */
+      if (had_level && gtk_tree_model_iter_has_child (c_model, c_iter) &&
+          had_visible != gtk_tree_model_iter_has_child (GTK_TREE_MODEL (filter), &iter))
+        gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (filter), path, &iter);
+    }
+  else
+    gtk_tree_model_children_reloaded (GTK_TREE_MODEL (filter), path, NULL);
+
+  gtk_tree_path_free (path);
+}
+
 /* TreeModelIface implementation */
 static GtkTreeModelFlags
 gtk_tree_model_filter_get_flags (GtkTreeModel *model)
@@ -2364,18 +2573,10 @@ gtk_tree_model_filter_get_path (GtkTreeModel *model,
 
   while (level)
     {
-      int i = 0, index = 0;
+      g_assert (elt_index < level->array->len);
 
-      while (i < elt_index)
-        {
-          if (g_array_index (level->array, FilterElt, i).visible)
-            index++;
-          i++;
-
-          g_assert (i < level->array->len);
-        }
-
-      gtk_tree_path_prepend_index (retval, index);
+      gtk_tree_path_prepend_index (retval,
+                                   gtk_tree_model_filter_level_count_visible (level, elt_index));
       elt_index = level->parent_elt_index;
       level = level->parent_level;
     }
@@ -2854,10 +3055,12 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
                                    filter->priv->deleted_id);
       g_signal_handler_disconnect (filter->priv->child_model,
                                    filter->priv->reordered_id);
+      g_signal_handler_disconnect (filter->priv->child_model,
+                                   filter->priv->reloaded_id);
 
       /* reset our state */
       if (filter->priv->root)
-        gtk_tree_model_filter_free_level (filter, filter->priv->root);
+        gtk_tree_model_filter_free_level (filter, filter->priv->root, TRUE);
 
       filter->priv->root = NULL;
       g_object_unref (filter->priv->child_model);
@@ -2891,6 +3094,10 @@ gtk_tree_model_filter_set_model (GtkTreeModelFilter *filter,
         g_signal_connect (child_model, "rows-reordered",
                           G_CALLBACK (gtk_tree_model_filter_rows_reordered),
                           filter);
+      filter->priv->reloaded_id =
+        g_signal_connect (child_model, "children-reloaded",
+                          G_CALLBACK (gtk_tree_model_filter_children_reloaded),
+                          filter);
 
       filter->priv->child_flags = gtk_tree_model_get_flags (child_model);
       filter->priv->stamp = g_random_int ();
@@ -146,6 +146,10 @@ static void gtk_tree_model_sort_rows_reordered        (GtkTreeModel          *s_
 						       GtkTreeIter           *s_iter,
 						       gint                  *new_order,
 						       gpointer               data);
+static void gtk_tree_model_sort_children_reloaded     (GtkTreeModel          *s_model,
+						       GtkTreePath           *s_path,
+						       GtkTreeIter           *s_iter,
+						       gpointer               data);
 
 /* TreeModel interface */
 static GtkTreeModelFlags gtk_tree_model_sort_get_flags     (GtkTreeModel          *tree_model);
@@ -884,6 +888,85 @@ gtk_tree_model_sort_rows_reordered (GtkTreeModel *s_model,
   gtk_tree_path_free (path);
 }
 
+/* Drops every reference held on @level and the levels below it without
+ * passing the unrefs on to the child model, which already got rid of
+ * the rows.  Ancestors lose the references that were propagated to them.
+ */
+static void
+gtk_tree_model_sort_level_drop_refs (GtkTreeModelSort *tree_model_sort,
+				     SortLevel        *level)
+{
+  GtkTreeIter iter;
+  gint i;
+
+  iter.stamp = tree_model_sort->stamp;
+  iter.user_data = level;
+
+  for (i = 0; i < level->array->len; i++)
+    {
+      SortElt *elt = &g_array_index (level->array, SortElt, i);
+
+      if (elt->children)
+	gtk_tree_model_sort_level_drop_refs (tree_model_sort, elt->children);
+
+      iter.user_data2 = elt;
+      while (elt->ref_count > 0)
+	gtk_tree_model_sort_real_unref_node (GTK_TREE_MODEL (tree_model_sort), &iter, FALSE);
+    }
+}
+
+static void
+gtk_tree_model_sort_children_reloaded (GtkTreeModel *s_model,
+				       GtkTreePath  *s_path,
+				       GtkTreeIter  *s_iter,
+				       gpointer      data)
+{
+  GtkTreeModelSort *tree_model_sort = GTK_TREE_MODEL_SORT (data);
+  SortLevel *level;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  g_return_if_fail (s_path != NULL);
+
+  if (gtk_tree_path_get_depth (s_path) == 0)
+    {
+      path = gtk_tree_path_new ();
+      level = SORT_LEVEL (tree_model_sort->root);
+    }
+  else
+    {
+      path = gtk_real_tree_model_sort_convert_child_path_to_path (tree_model_sort, s_path, FALSE);
+      if (path == NULL)
+	return;
+
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path);
+      level = SORT_ELT (iter.user_data2)->children;
+    }
+
+  /* Unlike ::row-deleted we cannot emit first: our listeners read the
+   * new children from us while handling the signal, so the old level
+   * has to be gone by then.  It is built again, and sorted once, the
+   * first time somebody asks for it.
+   */
+  if (level)
+    {
+      gtk_tree_model_sort_level_drop_refs (tree_model_sort, level);
+      gtk_tree_model_sort_free_level (tree_model_sort, level);
+    }
+
+  gtk_tree_model_sort_increment_stamp (tree_model_sort);
+
+  if (gtk_tree_path_get_depth (path))
+    {
+      gtk_tree_model_get_iter (GTK_TREE_MODEL (data), &iter, path);
+      gtk_tree_model_children_reloaded (GTK_TREE_MODEL (data), path, &iter);
+    }
+  else
+    gtk_tree_model_children_reloaded (GTK_TREE_MODEL (data), path, NULL);
+
+  gtk_tree_path_free (path);
+}
+
 /* Fulfill our model requirements */
 static GtkTreeModelFlags
 gtk_tree_model_sort_get_flags (GtkTreeModel *tree_model)
@@ -1550,6 +1633,60 @@ gtk_tree_model_sort_offset_compare_func (gconstpointer a,
   return retval;
 }
 
+/* With the default compare function, the value of every row is fetched
+ * from the child model once and turned into a sort key, instead of twice
+ * per comparison.  Replaces *@sort_array by the sorted tuples.
+ */
+static gboolean
+gtk_tree_model_sort_sort_by_keys (GtkTreeModelSort  *tree_model_sort,
+				  SortData          *data,
+				  GArray           **sort_array)
+{
+  GtkTreeDataSortKeys *keys;
+  GArray *sorted_array;
+  GtkTreeIter iter;
+  gint *new_order;
+  gint length;
+  gint i;
+
+  length = (*sort_array)->len;
+  keys = _gtk_tree_data_list_sort_keys_new (tree_model_sort->child_model,
+					    data->sort_func, data->sort_data,
+					    length);
+  if (keys == NULL)
+    return FALSE;
+
+  for (i = 0; i < length; i++)
+    {
+      SortElt *elt = g_array_index (*sort_array, SortTuple, i).elt;
+
+      if (GTK_TREE_MODEL_SORT_CACHE_CHILD_ITERS (tree_model_sort))
+	iter = elt->iter;
+      else
+	{
+	  data->parent_path_indices [data->parent_path_depth-1] = elt->offset;
+	  gtk_tree_model_get_iter (tree_model_sort->child_model, &iter, data->parent_path);
+	}
+
+      _gtk_tree_data_list_sort_keys_add (keys, &iter);
+    }
+
+  new_order = g_new (gint, length);
+  _gtk_tree_data_list_sort_keys_sort (keys, tree_model_sort->order, new_order);
+  _gtk_tree_data_list_sort_keys_free (keys);
+
+  sorted_array = g_array_sized_new (FALSE, FALSE, sizeof (SortTuple), length);
+  for (i = 0; i < length; i++)
+    g_array_append_val (sorted_array,
+			g_array_index (*sort_array, SortTuple, new_order[i]));
+
+  g_free (new_order);
+  g_array_free (*sort_array, TRUE);
+  *sort_array = sorted_array;
+
+  return TRUE;
+}
+
 static void
 gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
 				SortLevel        *level,
@@ -1632,7 +1769,7 @@ gtk_tree_model_sort_sort_level (GtkTreeModelSort *tree_model_sort,
     g_array_sort_with_data (sort_array,
 			    gtk_tree_model_sort_offset_compare_func,
 			    &data);
-  else
+  else if (!gtk_tree_model_sort_sort_by_keys (tree_model_sort, &data, &sort_array))
     g_array_sort_with_data (sort_array,
 			    gtk_tree_model_sort_compare_func,
 			    &data);
@@ -1930,6 +2067,9 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
                                    tree_model_sort->deleted_id);
       g_signal_handler_disconnect (tree_model_sort->child_model,
 				   tree_model_sort->reordered_id);
+      g_signal_handlers_disconnect_by_func (tree_model_sort->child_model,
+					    gtk_tree_model_sort_children_reloaded,
+					    tree_model_sort);
 
       /* reset our state */
       if (tree_model_sort->root)
@@ -1967,6 +2107,10 @@ gtk_tree_model_sort_set_model (GtkTreeModelSort *tree_model_sort,
 	g_signal_connect (child_model, "rows-reordered",
 			  G_CALLBACK (gtk_tree_model_sort_rows_reordered),
 			  tree_model_sort);
+      /* there is no room for the handler id in the public structure */
+      g_signal_connect (child_model, "children-reloaded",
+			G_CALLBACK (gtk_tree_model_sort_children_reloaded),
+			tree_model_sort);
 
       tree_model_sort->child_flags = gtk_tree_model_get_flags (child_model);
       n_columns = gtk_tree_model_get_n_columns (child_model);
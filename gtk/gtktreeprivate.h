@@ -78,6 +78,21 @@ enum
 #define TREE_VIEW_COLUMN_DRAG_DEAD_MULTIPLIER(tree_view) (10*TREE_VIEW_HEADER_HEIGHT(tree_view))
 
 typedef struct _GtkTreeViewColumnReorder GtkTreeViewColumnReorder;
+typedef struct _GtkTreeViewMeasureBatch GtkTreeViewMeasureBatch;
+typedef struct _GtkCellRendererTextMeasure GtkCellRendererTextMeasure;
+
+/* The size of one cell for the cell data of a row. When the size of a
+ * text cell is determined in the background, @measure is set until
+ * @width and @height are filled in from it.
+ */
+typedef struct _GtkTreeViewCellSize GtkTreeViewCellSize;
+struct _GtkTreeViewCellSize
+{
+  gboolean visible;
+  gint width;
+  gint height;
+  GtkCellRendererTextMeasure *measure;
+};
 struct _GtkTreeViewColumnReorder
 {
   gint left_align;
@@ -129,6 +144,12 @@ struct _GtkTreeViewPrivate
   guint validate_rows_timer;
   guint scroll_sync_timer;
 
+  /* Rows whose text is being measured in other threads */
+  GtkTreeViewMeasureBatch *measure_batch;
+
+  /* Rendered rows, GtkRBNode -> GtkTreeViewRowRender */
+  GHashTable *row_renders;
+
   /* Focus code */
   GtkTreeViewColumn *focus_column;
 
@@ -238,6 +259,10 @@ struct _GtkTreeViewPrivate
 
   guint post_validation_flag : 1;
 
+  guint threaded_validation : 1;
+
+  guint render_cache : 1;
+
   /* Whether our key press handler is to avoid sending an unhandled binding to the search entry */
   guint search_entry_avoid_unhandled_binding : 1;
 
@@ -257,6 +282,9 @@ struct _GtkTreeViewPrivate
   guint search_entry_changed_id;
   guint typeselect_flush_timeout;
 
+  /* casefolded search column strings, keyed by GtkRBNode */
+  GHashTable *search_index;
+
   gint prev_width;
 
   GtkTreeViewRowSeparatorFunc row_separator_func;
@@ -373,6 +401,7 @@ void         _gtk_tree_view_queue_draw_node           (GtkTreeView       *tree_v
 						       GtkRBTree         *tree,
 						       GtkRBNode         *node,
 						       const GdkRectangle *clip_rect);
+void         _gtk_tree_view_reset_row_renders         (GtkTreeView       *tree_view);
 
 void _gtk_tree_view_column_realize_button   (GtkTreeViewColumn *column);
 void _gtk_tree_view_column_unrealize_button (GtkTreeViewColumn *column);
@@ -439,6 +468,21 @@ void              _gtk_tree_view_column_get_neighbor_sizes (GtkTreeViewColumn *c
 							    GtkCellRenderer   *cell,
 							    gint              *left,
 							    gint              *right);
+void              _gtk_tree_view_column_cell_measure      (GtkTreeViewColumn   *tree_column,
+							   GtkTreeViewCellSize *sizes);
+void              _gtk_tree_view_column_cell_get_measured_size (GtkTreeViewColumn   *tree_column,
+							        GtkTreeViewCellSize *sizes,
+							        gint                *width,
+							        gint                *height);
+
+GtkCellRendererTextMeasure *_gtk_cell_renderer_text_measure_new      (GtkCellRenderer            *cell,
+								      GtkWidget                  *widget);
+void                        _gtk_cell_renderer_text_measure_run      (GtkCellRendererTextMeasure *measure,
+								      PangoContext               *context);
+void                        _gtk_cell_renderer_text_measure_get_size (GtkCellRendererTextMeasure *measure,
+								      gint                       *width,
+								      gint                       *height);
+void                        _gtk_cell_renderer_text_measure_free     (GtkCellRendererTextMeasure *measure);
 
 
 G_END_DECLS
@@ -603,7 +603,7 @@ gtk_tree_selection_selected_foreach (GtkTreeSelection            *selection,
   GtkTreeIter iter;
   GtkTreeModel *model;
 
-  gulong inserted_id, deleted_id, reordered_id, changed_id;
+  gulong inserted_id, deleted_id, reordered_id, reloaded_id, changed_id;
   gboolean stop = FALSE;
 
   g_return_if_fail (GTK_IS_TREE_SELECTION (selection));
@@ -646,6 +646,9 @@ gtk_tree_selection_selected_foreach (GtkTreeSelection            *selection,
   reordered_id = g_signal_connect_swapped (model, "rows-reordered",
 					   G_CALLBACK (model_changed),
 				           &stop);
+  reloaded_id = g_signal_connect_swapped (model, "children-reloaded",
+					  G_CALLBACK (model_changed),
+					  &stop);
   changed_id = g_signal_connect_swapped (selection->tree_view, "notify::model",
 					 G_CALLBACK (model_changed), 
 					 &stop);
@@ -714,6 +717,7 @@ out:
   g_signal_handler_disconnect (model, inserted_id);
   g_signal_handler_disconnect (model, deleted_id);
   g_signal_handler_disconnect (model, reordered_id);
+  g_signal_handler_disconnect (model, reloaded_id);
   g_signal_handler_disconnect (selection->tree_view, changed_id);
   g_object_unref (model);
 
@@ -29,9 +29,34 @@
 #include "gtkalias.h"
 
 #define G_NODE(node) ((GNode *)node)
+#define GTK_TREE_STORE_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_TREE_STORE, GtkTreeStorePrivate))
 #define GTK_TREE_STORE_IS_SORTED(tree) (((GtkTreeStore*)(tree))->sort_column_id != GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID)
 #define VALID_ITER(iter, tree_store) ((iter)!= NULL && (iter)->user_data != NULL && ((GtkTreeStore*)(tree_store))->stamp == (iter)->stamp)
 
+/* Levels with fewer children than this are walked, longer ones get a
+ * GtkTreeStoreLevel the first time a position is looked up in them.
+ */
+#define GTK_TREE_STORE_LEVEL_MIN 256
+
+typedef struct _GtkTreeStorePrivate GtkTreeStorePrivate;
+typedef struct _GtkTreeStoreLevel   GtkTreeStoreLevel;
+
+struct _GtkTreeStorePrivate
+{
+  /* parent GNode -> GtkTreeStoreLevel */
+  GHashTable *levels;
+};
+
+/* Mirrors the children of one GNode, so that the nth child and the
+ * position of a child can be found without walking the sibling list.
+ */
+struct _GtkTreeStoreLevel
+{
+  GSequence *children;
+  /* child GNode -> GSequenceIter */
+  GHashTable *positions;
+};
+
 static void         gtk_tree_store_tree_model_init (GtkTreeModelIface *iface);
 static void         gtk_tree_store_drag_source_init(GtkTreeDragSourceIface *iface);
 static void         gtk_tree_store_drag_dest_init  (GtkTreeDragDestIface   *iface);
@@ -96,6 +121,8 @@ static gboolean gtk_tree_store_row_drop_possible  (GtkTreeDragDest   *drag_dest,
 /* Sortable Interfaces */
 
 static void     gtk_tree_store_sort                    (GtkTreeStore           *tree_store);
+static GArray  *gtk_tree_store_sort_children           (GtkTreeStore           *tree_store,
+							GNode                  *parent);
 static void     gtk_tree_store_sort_iter_changed       (GtkTreeStore           *tree_store,
 							GtkTreeIter            *iter,
 							gint                    column,
@@ -151,6 +178,239 @@ validate_tree (GtkTreeStore *tree_store)
     }
 }
 
+static void
+gtk_tree_store_level_free (gpointer data)
+{
+  GtkTreeStoreLevel *level = data;
+
+  g_sequence_free (level->children);
+  g_hash_table_destroy (level->positions);
+  g_slice_free (GtkTreeStoreLevel, level);
+}
+
+static GtkTreeStoreLevel *
+gtk_tree_store_level_lookup (GtkTreeStore *tree_store,
+			     GNode        *parent)
+{
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE_GET_PRIVATE (tree_store);
+
+  if (priv->levels == NULL)
+    return NULL;
+
+  return g_hash_table_lookup (priv->levels, parent);
+}
+
+static GtkTreeStoreLevel *
+gtk_tree_store_level_build (GtkTreeStore *tree_store,
+			    GNode        *parent)
+{
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE_GET_PRIVATE (tree_store);
+  GtkTreeStoreLevel *level;
+  GNode *node;
+
+  level = g_slice_new (GtkTreeStoreLevel);
+  level->children = g_sequence_new (NULL);
+  level->positions = g_hash_table_new (NULL, NULL);
+
+  for (node = parent->children; node; node = node->next)
+    g_hash_table_insert (level->positions, node,
+			 g_sequence_append (level->children, node));
+
+  if (priv->levels == NULL)
+    priv->levels = g_hash_table_new_full (NULL, NULL, NULL,
+					  gtk_tree_store_level_free);
+  g_hash_table_insert (priv->levels, parent, level);
+
+  return level;
+}
+
+/* Forgets the level of @parent after its children were rearranged */
+static void
+gtk_tree_store_level_drop (GtkTreeStore *tree_store,
+			   GNode        *parent)
+{
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE_GET_PRIVATE (tree_store);
+
+  if (priv->levels)
+    g_hash_table_remove (priv->levels, parent);
+}
+
+static gboolean
+level_drop_func (GNode    *node,
+		 gpointer  data)
+{
+  g_hash_table_remove ((GHashTable *) data, node);
+
+  return FALSE;
+}
+
+/* Forgets the levels of @node and all its descendants before they are
+ * freed, a new node might get the address of a dead one. Leaves are
+ * visited too, their children may all have been removed since their
+ * level was built.
+ */
+static void
+gtk_tree_store_level_drop_all (GtkTreeStore *tree_store,
+			       GNode        *node)
+{
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE_GET_PRIVATE (tree_store);
+
+  if (priv->levels == NULL || g_hash_table_size (priv->levels) == 0)
+    return;
+
+  g_node_traverse (node, G_PRE_ORDER, G_TRAVERSE_ALL, -1,
+		   level_drop_func, priv->levels);
+}
+
+/* Called after @node was linked into its parent */
+static void
+gtk_tree_store_level_link (GtkTreeStore *tree_store,
+			   GNode        *node)
+{
+  GtkTreeStoreLevel *level;
+  GSequenceIter *next;
+
+  level = gtk_tree_store_level_lookup (tree_store, node->parent);
+  if (level == NULL)
+    return;
+
+  if (node->next)
+    next = g_hash_table_lookup (level->positions, node->next);
+  else
+    next = g_sequence_get_end_iter (level->children);
+
+  g_hash_table_insert (level->positions, node,
+		       g_sequence_insert_before (next, node));
+}
+
+/* Called before @node is unlinked from its parent */
+static void
+gtk_tree_store_level_unlink (GtkTreeStore *tree_store,
+			     GNode        *node)
+{
+  GtkTreeStoreLevel *level;
+  GSequenceIter *pos;
+
+  level = gtk_tree_store_level_lookup (tree_store, node->parent);
+  if (level == NULL)
+    return;
+
+  pos = g_hash_table_lookup (level->positions, node);
+  g_hash_table_remove (level->positions, node);
+  g_sequence_remove (pos);
+}
+
+/* Returns the position of @node among its siblings, or -1 */
+static gint
+gtk_tree_store_node_position (GtkTreeStore *tree_store,
+			      GNode        *node)
+{
+  GtkTreeStoreLevel *level;
+  GSequenceIter *pos;
+  GNode *tmp_node;
+  gint i = 0;
+
+  level = gtk_tree_store_level_lookup (tree_store, node->parent);
+  if (level == NULL)
+    {
+      for (tmp_node = node->parent->children; tmp_node; tmp_node = tmp_node->next)
+	{
+	  if (tmp_node == node)
+	    return i;
+
+	  if (++i == GTK_TREE_STORE_LEVEL_MIN)
+	    break;
+	}
+
+      if (tmp_node == NULL)
+	return -1;
+
+      level = gtk_tree_store_level_build (tree_store, node->parent);
+    }
+
+  pos = g_hash_table_lookup (level->positions, node);
+  if (pos == NULL)
+    return -1;
+
+  return g_sequence_iter_get_position (pos);
+}
+
+static GNode *
+gtk_tree_store_nth_child (GtkTreeStore *tree_store,
+			  GNode        *parent,
+			  gint          n)
+{
+  GtkTreeStoreLevel *level;
+
+  if (n < 0)
+    return NULL;
+
+  level = gtk_tree_store_level_lookup (tree_store, parent);
+  if (level == NULL)
+    {
+      if (n < GTK_TREE_STORE_LEVEL_MIN)
+	return g_node_nth_child (parent, n);
+
+      level = gtk_tree_store_level_build (tree_store, parent);
+    }
+
+  if (n >= g_sequence_get_length (level->children))
+    return NULL;
+
+  return g_sequence_get (g_sequence_get_iter_at_pos (level->children, n));
+}
+
+static GNode *
+gtk_tree_store_last_child (GtkTreeStore *tree_store,
+			   GNode        *parent)
+{
+  GtkTreeStoreLevel *level;
+  GSequenceIter *end;
+  GNode *node;
+  gint i = 0;
+
+  level = gtk_tree_store_level_lookup (tree_store, parent);
+  if (level == NULL)
+    {
+      for (node = parent->children; node && node->next; node = node->next)
+	if (++i == GTK_TREE_STORE_LEVEL_MIN)
+	  break;
+
+      if (node == NULL || node->next == NULL)
+	return node;
+
+      level = gtk_tree_store_level_build (tree_store, parent);
+    }
+
+  end = g_sequence_get_end_iter (level->children);
+  if (g_sequence_iter_is_begin (end))
+    return NULL;
+
+  return g_sequence_get (g_sequence_iter_prev (end));
+}
+
+/* Like g_node_insert(), without walking long levels */
+static void
+gtk_tree_store_insert_node (GtkTreeStore *tree_store,
+			    GNode        *parent,
+			    gint          position,
+			    GNode        *node)
+{
+  GNode *sibling = NULL;
+
+  if (position >= 0)
+    sibling = gtk_tree_store_nth_child (tree_store, parent, position);
+
+  if (sibling)
+    g_node_insert_before (parent, sibling, node);
+  else
+    g_node_insert_after (parent,
+			 gtk_tree_store_last_child (tree_store, parent),
+			 node);
+
+  gtk_tree_store_level_link (tree_store, node);
+}
+
 G_DEFINE_TYPE_WITH_CODE (GtkTreeStore, gtk_tree_store, G_TYPE_OBJECT,
 			 G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
 						gtk_tree_store_tree_model_init)
@@ -171,6 +431,8 @@ gtk_tree_store_class_init (GtkTreeStoreClass *class)
   object_class = (GObjectClass *) class;
 
   object_class->finalize = gtk_tree_store_finalize;
+
+  g_type_class_add_private (object_class, sizeof (GtkTreeStorePrivate));
 }
 
 static void
@@ -413,6 +675,10 @@ static void
 gtk_tree_store_finalize (GObject *object)
 {
   GtkTreeStore *tree_store = GTK_TREE_STORE (object);
+  GtkTreeStorePrivate *priv = GTK_TREE_STORE_GET_PRIVATE (tree_store);
+
+  if (priv->levels)
+    g_hash_table_destroy (priv->levels);
 
   g_node_traverse (tree_store->root, G_POST_ORDER, G_TRAVERSE_ALL, -1,
 		   node_free, tree_store->column_headers);
@@ -508,8 +774,7 @@ gtk_tree_store_get_path (GtkTreeModel *tree_model,
 {
   GtkTreeStore *tree_store = (GtkTreeStore *) tree_model;
   GtkTreePath *retval;
-  GNode *tmp_node;
-  gint i = 0;
+  gint i;
 
   g_return_val_if_fail (iter->user_data != NULL, NULL);
   g_return_val_if_fail (iter->stamp == tree_store->stamp, NULL);
@@ -522,10 +787,7 @@ gtk_tree_store_get_path (GtkTreeModel *tree_model,
   g_assert (G_NODE (iter->user_data)->parent != NULL);
 
   if (G_NODE (iter->user_data)->parent == G_NODE (tree_store->root))
-    {
-      retval = gtk_tree_path_new ();
-      tmp_node = G_NODE (tree_store->root)->children;
-    }
+    retval = gtk_tree_path_new ();
   else
     {
       GtkTreeIter tmp_iter = *iter;
@@ -533,26 +795,14 @@ gtk_tree_store_get_path (GtkTreeModel *tree_model,
       tmp_iter.user_data = G_NODE (iter->user_data)->parent;
 
       retval = gtk_tree_store_get_path (tree_model, &tmp_iter);
-      tmp_node = G_NODE (iter->user_data)->parent->children;
     }
 
   if (retval == NULL)
     return NULL;
 
-  if (tmp_node == NULL)
-    {
-      gtk_tree_path_free (retval);
-      return NULL;
-    }
-
-  for (; tmp_node; tmp_node = tmp_node->next)
-    {
-      if (tmp_node == G_NODE (iter->user_data))
-	break;
-      i++;
-    }
+  i = gtk_tree_store_node_position (tree_store, G_NODE (iter->user_data));
 
-  if (tmp_node == NULL)
+  if (i < 0)
     {
       /* We couldn't find node, meaning it's prolly not ours */
       /* Perhaps I should do a g_return_if_fail here. */
@@ -659,16 +909,24 @@ static gint
 gtk_tree_store_iter_n_children (GtkTreeModel *tree_model,
 				GtkTreeIter  *iter)
 {
+  GtkTreeStore *tree_store = (GtkTreeStore *) tree_model;
+  GtkTreeStoreLevel *level;
+  GNode *parent;
   GNode *node;
   gint i = 0;
 
   g_return_val_if_fail (iter == NULL || iter->user_data != NULL, 0);
 
   if (iter == NULL)
-    node = G_NODE (GTK_TREE_STORE (tree_model)->root)->children;
+    parent = G_NODE (tree_store->root);
   else
-    node = G_NODE (iter->user_data)->children;
+    parent = G_NODE (iter->user_data);
+
+  level = gtk_tree_store_level_lookup (tree_store, parent);
+  if (level)
+    return g_sequence_get_length (level->children);
 
+  node = parent->children;
   while (node)
     {
       i++;
@@ -695,7 +953,7 @@ gtk_tree_store_iter_nth_child (GtkTreeModel *tree_model,
   else
     parent_node = parent->user_data;
 
-  child = g_node_nth_child (parent_node, n);
+  child = gtk_tree_store_nth_child (tree_store, parent_node, n);
 
   if (child)
     {
@@ -1120,6 +1378,8 @@ gtk_tree_store_remove (GtkTreeStore *tree_store,
 		     -1, node_free, tree_store->column_headers);
 
   path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
+  gtk_tree_store_level_unlink (tree_store, G_NODE (iter->user_data));
+  gtk_tree_store_level_drop_all (tree_store, G_NODE (iter->user_data));
   g_node_destroy (G_NODE (iter->user_data));
 
   gtk_tree_model_row_deleted (GTK_TREE_MODEL (tree_store), path);
@@ -1196,7 +1456,7 @@ gtk_tree_store_insert (GtkTreeStore *tree_store,
 
   iter->stamp = tree_store->stamp;
   iter->user_data = new_node;
-  g_node_insert (parent_node, position, new_node);
+  gtk_tree_store_insert_node (tree_store, parent_node, position, new_node);
 
   path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
   gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
@@ -1266,9 +1526,13 @@ gtk_tree_store_insert_before (GtkTreeStore *tree_store,
 
   new_node = g_node_new (NULL);
 
-  g_node_insert_before (parent_node,
-			sibling ? G_NODE (sibling->user_data) : NULL,
-                        new_node);
+  if (sibling)
+    g_node_insert_before (parent_node, G_NODE (sibling->user_data), new_node);
+  else
+    g_node_insert_after (parent_node,
+			 gtk_tree_store_last_child (tree_store, parent_node),
+			 new_node);
+  gtk_tree_store_level_link (tree_store, new_node);
 
   iter->stamp = tree_store->stamp;
   iter->user_data = new_node;
@@ -1350,6 +1614,7 @@ gtk_tree_store_insert_after (GtkTreeStore *tree_store,
   g_node_insert_after (parent_node,
 		       sibling ? G_NODE (sibling->user_data) : NULL,
                        new_node);
+  gtk_tree_store_level_link (tree_store, new_node);
 
   iter->stamp = tree_store->stamp;
   iter->user_data = new_node;
@@ -1439,7 +1704,7 @@ gtk_tree_store_insert_with_values (GtkTreeStore *tree_store,
 
   iter->stamp = tree_store->stamp;
   iter->user_data = new_node;
-  g_node_insert (parent_node, position, new_node);
+  gtk_tree_store_insert_node (tree_store, parent_node, position, new_node);
 
   va_start (var_args, position);
   gtk_tree_store_set_valist_internal (tree_store, iter,
@@ -1518,7 +1783,7 @@ gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
 
   iter->stamp = tree_store->stamp;
   iter->user_data = new_node;
-  g_node_insert (parent_node, position, new_node);
+  gtk_tree_store_insert_node (tree_store, parent_node, position, new_node);
 
   gtk_tree_store_set_vector_internal (tree_store, iter,
 				      &changed, &maybe_need_sort,
@@ -1583,6 +1848,7 @@ gtk_tree_store_prepend (GtkTreeStore *tree_store,
       iter->user_data = g_node_new (NULL);
 
       g_node_prepend (parent_node, G_NODE (iter->user_data));
+      gtk_tree_store_level_link (tree_store, G_NODE (iter->user_data));
 
       path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
       gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
@@ -1641,6 +1907,7 @@ gtk_tree_store_append (GtkTreeStore *tree_store,
       iter->user_data = g_node_new (NULL);
 
       g_node_append (parent_node, G_NODE (iter->user_data));
+      gtk_tree_store_level_link (tree_store, G_NODE (iter->user_data));
 
       path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), iter);
       gtk_tree_model_row_inserted (GTK_TREE_MODEL (tree_store), path, iter);
@@ -1660,6 +1927,114 @@ gtk_tree_store_append (GtkTreeStore *tree_store,
   validate_tree (tree_store);
 }
 
+/**
+ * gtk_tree_store_set_children_bulk:
+ * @tree_store: A #GtkTreeStore
+ * @parent: A valid #GtkTreeIter, or %NULL
+ * @n_rows: the number of rows to create
+ * @columns: an array of column numbers
+ * @values: an array of @n_values arrays, each holding the @n_rows
+ *     values of the matching column in @columns
+ * @n_values: the length of the @columns and @values arrays
+ *
+ * Replaces all the children of @parent, or all the toplevel rows if
+ * @parent is %NULL, with @n_rows new rows, taking the values column by
+ * column.  The old children are removed together with their own
+ * children.  If the store is sorted, the new rows are sorted once.
+ *
+ * Instead of a #GtkTreeModel::row-deleted signal for every old row and
+ * a #GtkTreeModel::row-inserted signal for every new one, this emits a
+ * single #GtkTreeModel::children-reloaded signal for @parent, so that
+ * views rebuild that level in one pass.  Row references, the selection
+ * and the cursor below @parent are lost.  Code that keeps its own state
+ * about the rows of the store must handle
+ * #GtkTreeModel::children-reloaded, as all the GTK+ widgets that show a
+ * model do.
+ *
+ * Since: 2.20
+ */
+void
+gtk_tree_store_set_children_bulk (GtkTreeStore  *tree_store,
+				  GtkTreeIter   *parent,
+				  gint           n_rows,
+				  gint          *columns,
+				  GValue       **values,
+				  gint           n_values)
+{
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GNode *parent_node;
+  GNode *prev;
+  gboolean had_children;
+  gint row;
+  gint i;
+
+  g_return_if_fail (GTK_IS_TREE_STORE (tree_store));
+  g_return_if_fail (parent == NULL || VALID_ITER (parent, tree_store));
+  g_return_if_fail (n_rows >= 0);
+  g_return_if_fail (n_values == 0 || (columns != NULL && values != NULL));
+
+  for (i = 0; i < n_values; i++)
+    g_return_if_fail (columns[i] >= 0 && columns[i] < tree_store->n_columns);
+
+  if (parent)
+    parent_node = parent->user_data;
+  else
+    parent_node = tree_store->root;
+
+  had_children = parent_node->children != NULL;
+  if (!had_children && n_rows == 0)
+    return;
+
+  tree_store->columns_dirty = TRUE;
+
+  gtk_tree_store_level_drop_all (tree_store, parent_node);
+
+  while (parent_node->children)
+    {
+      GNode *node = parent_node->children;
+
+      g_node_traverse (node, G_POST_ORDER, G_TRAVERSE_ALL,
+		       -1, node_free, tree_store->column_headers);
+      g_node_destroy (node);
+    }
+
+  /* g_node_append() walks the whole level, so keep track of the tail */
+  iter.stamp = tree_store->stamp;
+  prev = NULL;
+  for (row = 0; row < n_rows; row++)
+    {
+      iter.user_data = g_node_insert_after (parent_node, prev, g_node_new (NULL));
+      prev = iter.user_data;
+
+      for (i = 0; i < n_values; i++)
+	gtk_tree_store_real_set_value (tree_store, &iter,
+				       columns[i], &values[i][row],
+				       FALSE);
+    }
+
+  /* Nobody has seen the new order yet, so no ::rows-reordered */
+  if (GTK_TREE_STORE_IS_SORTED (tree_store))
+    g_array_free (gtk_tree_store_sort_children (tree_store, parent_node), TRUE);
+
+  if (parent)
+    {
+      path = gtk_tree_store_get_path (GTK_TREE_MODEL (tree_store), parent);
+      gtk_tree_model_children_reloaded (GTK_TREE_MODEL (tree_store), path, parent);
+
+      if (had_children != (n_rows > 0))
+	gtk_tree_model_row_has_child_toggled (GTK_TREE_MODEL (tree_store), path, parent);
+    }
+  else
+    {
+      path = gtk_tree_path_new ();
+      gtk_tree_model_children_reloaded (GTK_TREE_MODEL (tree_store), path, NULL);
+    }
+  gtk_tree_path_free (path);
+
+  validate_tree (tree_store);
+}
+
 /**
  * gtk_tree_store_is_ancestor:
  * @tree_store: A #GtkTreeStore
@@ -2210,6 +2585,7 @@ gtk_tree_store_reorder (GtkTreeStore *tree_store,
     G_NODE (parent->user_data)->children = sort_array[0].node;
   else
     G_NODE (tree_store->root)->children = sort_array[0].node;
+  gtk_tree_store_level_drop (tree_store, sort_array[0].node->parent);
 
   /* emit signal */
   if (parent)
@@ -2241,6 +2617,7 @@ gtk_tree_store_swap (GtkTreeStore *tree_store,
   GNode *tmp, *node_a, *node_b, *parent_node;
   GNode *a_prev, *a_next, *b_prev, *b_next;
   gint i, a_count, b_count, length, *order;
+  GtkTreeStoreLevel *level;
   GtkTreePath *path_a, *path_b;
   GtkTreeIter parent;
 
@@ -2348,6 +2725,11 @@ gtk_tree_store_swap (GtkTreeStore *tree_store,
   node_b->prev = a_prev;
   node_b->next = a_next;
 
+  level = gtk_tree_store_level_lookup (tree_store, parent_node);
+  if (level)
+    g_sequence_swap (g_hash_table_lookup (level->positions, node_a),
+		     g_hash_table_lookup (level->positions, node_b));
+
   /* emit signal */
   order = g_new (gint, length);
   for (i = 0; i < length; i++)
@@ -2540,6 +2922,7 @@ gtk_tree_store_move (GtkTreeStore *tree_store,
 
   /* remove node from list */
   node = G_NODE (iter->user_data);
+  gtk_tree_store_level_unlink (tree_store, node);
   tmp_a = node->prev;
   tmp_b = node->next;
 
@@ -2609,6 +2992,8 @@ gtk_tree_store_move (GtkTreeStore *tree_store,
         node->next = NULL;
     }
 
+  gtk_tree_store_level_link (tree_store, node);
+
   /* emit signal */
   if (position)
     new_pos = gtk_tree_path_get_indices (pos_path)[gtk_tree_path_get_depth (pos_path)-1];
@@ -2783,37 +3168,27 @@ gtk_tree_store_compare_func (gconstpointer a,
   return retval;
 }
 
-static void
-gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
-			    GNode        *parent,
-			    gboolean      recurse)
+/* Sorts and relinks the children of @parent without emitting anything.
+ * Returns the sorted tuples, their offsets being the old positions.
+ */
+static GArray *
+gtk_tree_store_sort_children (GtkTreeStore *tree_store,
+			      GNode        *parent)
 {
-  GtkTreeIter iter;
+  GtkTreeDataSortKeys *keys = NULL;
   GArray *sort_array;
-  GNode *node;
   GNode *tmp_node;
   gint list_length;
   gint i;
-  gint *new_order;
-  GtkTreePath *path;
-
-  node = parent->children;
-  if (node == NULL || node->next == NULL)
-    {
-      if (recurse && node && node->children)
-        gtk_tree_store_sort_helper (tree_store, node, TRUE);
-
-      return;
-    }
 
   list_length = 0;
-  for (tmp_node = node; tmp_node; tmp_node = tmp_node->next)
+  for (tmp_node = parent->children; tmp_node; tmp_node = tmp_node->next)
     list_length++;
 
   sort_array = g_array_sized_new (FALSE, FALSE, sizeof (SortTuple), list_length);
 
   i = 0;
-  for (tmp_node = node; tmp_node; tmp_node = tmp_node->next)
+  for (tmp_node = parent->children; tmp_node; tmp_node = tmp_node->next)
     {
       SortTuple tuple;
 
@@ -2823,8 +3198,53 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
       i++;
     }
 
-  /* Sort the array */
-  g_array_sort_with_data (sort_array, gtk_tree_store_compare_func, tree_store);
+  if (list_length < 2)
+    return sort_array;
+
+  if (tree_store->sort_column_id != -1)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (tree_store->sort_list,
+					       tree_store->sort_column_id);
+      if (header)
+	keys = _gtk_tree_data_list_sort_keys_new (GTK_TREE_MODEL (tree_store),
+						  header->func, header->data,
+						  list_length);
+    }
+
+  if (keys)
+    {
+      GArray *sorted_array;
+      GtkTreeIter iter;
+      gint *new_order;
+
+      /* extract every key once instead of comparing the rows */
+      iter.stamp = tree_store->stamp;
+      for (i = 0; i < list_length; i++)
+	{
+	  iter.user_data = g_array_index (sort_array, SortTuple, i).node;
+	  _gtk_tree_data_list_sort_keys_add (keys, &iter);
+	}
+
+      new_order = g_new (gint, list_length);
+      _gtk_tree_data_list_sort_keys_sort (keys, tree_store->order, new_order);
+      _gtk_tree_data_list_sort_keys_free (keys);
+
+      sorted_array = g_array_sized_new (FALSE, FALSE, sizeof (SortTuple), list_length);
+      for (i = 0; i < list_length; i++)
+	g_array_append_val (sorted_array,
+			    g_array_index (sort_array, SortTuple, new_order[i]));
+
+      g_free (new_order);
+      g_array_free (sort_array, TRUE);
+      sort_array = sorted_array;
+    }
+  else
+    {
+      /* Sort the array */
+      g_array_sort_with_data (sort_array, gtk_tree_store_compare_func, tree_store);
+    }
 
   for (i = 0; i < list_length - 1; i++)
     {
@@ -2836,6 +3256,36 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
   g_array_index (sort_array, SortTuple, list_length - 1).node->next = NULL;
   g_array_index (sort_array, SortTuple, 0).node->prev = NULL;
   parent->children = g_array_index (sort_array, SortTuple, 0).node;
+  gtk_tree_store_level_drop (tree_store, parent);
+
+  return sort_array;
+}
+
+static void
+gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
+			    GNode        *parent,
+			    gboolean      recurse)
+{
+  GtkTreeIter iter;
+  GArray *sort_array;
+  GNode *node;
+  GNode *tmp_node;
+  gint list_length;
+  gint i;
+  gint *new_order;
+  GtkTreePath *path;
+
+  node = parent->children;
+  if (node == NULL || node->next == NULL)
+    {
+      if (recurse && node && node->children)
+        gtk_tree_store_sort_helper (tree_store, node, TRUE);
+
+      return;
+    }
+
+  sort_array = gtk_tree_store_sort_children (tree_store, parent);
+  list_length = sort_array->len;
 
   /* Let the world know about our new order */
   new_order = g_new (gint, list_length);
@@ -2983,6 +3433,7 @@ gtk_tree_store_sort_iter_changed (GtkTreeStore *tree_store,
 
   /* We actually need to sort it */
   /* First, remove the old link. */
+  gtk_tree_store_level_unlink (tree_store, node);
 
   if (prev)
     prev->next = next;
@@ -3037,6 +3488,8 @@ gtk_tree_store_sort_iter_changed (GtkTreeStore *tree_store,
       G_NODE (iter->user_data)->parent->children = G_NODE (iter->user_data);
     }
 
+  gtk_tree_store_level_link (tree_store, G_NODE (iter->user_data));
+
   if (!emit_signal)
     return;
 
@@ -125,6 +125,12 @@ void          gtk_tree_store_insert_with_valuesv (GtkTreeStore *tree_store,
 						  gint         *columns,
 						  GValue       *values,
 						  gint          n_values);
+void          gtk_tree_store_set_children_bulk (GtkTreeStore  *tree_store,
+						GtkTreeIter   *parent,
+						gint           n_rows,
+						gint          *columns,
+						GValue       **values,
+						gint           n_values);
 void          gtk_tree_store_prepend          (GtkTreeStore *tree_store,
 					       GtkTreeIter  *iter,
 					       GtkTreeIter  *parent);
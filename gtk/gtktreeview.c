@@ -44,6 +44,7 @@
 #include "gtktreemodelsort.h"
 #include "gtktooltip.h"
 #include "gtkprivate.h"
+#include "gtkpangothreads.h"
 #include "gtkalias.h"
 
 #define GTK_TREE_VIEW_PRIORITY_VALIDATE (GDK_PRIORITY_REDRAW + 5)
@@ -144,7 +145,9 @@ enum {
   PROP_RUBBER_BANDING,
   PROP_ENABLE_GRID_LINES,
   PROP_ENABLE_TREE_LINES,
-  PROP_TOOLTIP_COLUMN
+  PROP_TOOLTIP_COLUMN,
+  PROP_THREADED_VALIDATION,
+  PROP_RENDER_CACHE
 };
 
 /* object signals */
@@ -286,6 +289,10 @@ static void gtk_tree_view_rows_reordered                  (GtkTreeModel    *mode
 							   GtkTreeIter     *iter,
 							   gint            *new_order,
 							   gpointer         data);
+static void gtk_tree_view_children_reloaded               (GtkTreeModel    *model,
+							   GtkTreePath     *parent,
+							   GtkTreeIter     *iter,
+							   gpointer         data);
 
 /* Incremental reflow */
 static gboolean validate_row             (GtkTreeView *tree_view,
@@ -300,6 +307,9 @@ static gboolean do_validate_rows         (GtkTreeView *tree_view,
 static gboolean validate_rows            (GtkTreeView *tree_view);
 static gboolean presize_handler_callback (gpointer     data);
 static void     install_presize_handler  (GtkTreeView *tree_view);
+static void     gtk_tree_view_cancel_measure       (GtkTreeView *tree_view);
+static void     gtk_tree_view_forget_measured_node (GtkTreeView *tree_view,
+						    GtkRBNode   *node);
 static void     install_scroll_sync_handler (GtkTreeView *tree_view);
 static void     gtk_tree_view_set_top_row   (GtkTreeView *tree_view,
 					     GtkTreePath *path,
@@ -436,6 +446,7 @@ static gboolean gtk_tree_view_search_iter               (GtkTreeModel     *model
 							 gint              n);
 static void     gtk_tree_view_search_init               (GtkWidget        *entry,
 							 GtkTreeView      *tree_view);
+static void     gtk_tree_view_search_index_free         (GtkTreeView      *tree_view);
 static void     gtk_tree_view_put                       (GtkTreeView      *tree_view,
 							 GtkWidget        *child_widget,
 							 gint              x,
@@ -764,6 +775,38 @@ gtk_tree_view_class_init (GtkTreeViewClass *class)
 						       -1,
 						       GTK_PARAM_READWRITE));
 
+    /**
+     * GtkTreeView:threaded-validation:
+     *
+     * Whether the text of rows that are not shown yet is measured
+     * in other threads. See gtk_tree_view_set_threaded_validation().
+     *
+     * Since: 2.20
+     **/
+    g_object_class_install_property (o_class,
+                                     PROP_THREADED_VALIDATION,
+                                     g_param_spec_boolean ("threaded-validation",
+                                                           P_("Threaded Validation"),
+                                                           P_("Whether the size of the rows is determined in other threads"),
+                                                           FALSE,
+                                                           GTK_PARAM_READWRITE));
+
+    /**
+     * GtkTreeView:render-cache:
+     *
+     * Whether drawn rows are kept and copied when they are exposed
+     * again. See gtk_tree_view_set_render_cache().
+     *
+     * Since: 2.20
+     **/
+    g_object_class_install_property (o_class,
+                                     PROP_RENDER_CACHE,
+                                     g_param_spec_boolean ("render-cache",
+                                                           P_("Render Cache"),
+                                                           P_("Whether drawn rows are kept to be copied on later exposes"),
+                                                           FALSE,
+                                                           GTK_PARAM_READWRITE));
+
   /* Style properties */
 #define _TREE_VIEW_EXPANDER_SIZE 12
 #define _TREE_VIEW_VERTICAL_SEPARATOR 2
@@ -1448,6 +1491,12 @@ gtk_tree_view_set_property (GObject         *object,
     case PROP_TOOLTIP_COLUMN:
       gtk_tree_view_set_tooltip_column (tree_view, g_value_get_int (value));
       break;
+    case PROP_THREADED_VALIDATION:
+      gtk_tree_view_set_threaded_validation (tree_view, g_value_get_boolean (value));
+      break;
+    case PROP_RENDER_CACHE:
+      gtk_tree_view_set_render_cache (tree_view, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1523,6 +1572,12 @@ gtk_tree_view_get_property (GObject    *object,
     case PROP_TOOLTIP_COLUMN:
       g_value_set_int (value, tree_view->priv->tooltip_column);
       break;
+    case PROP_THREADED_VALIDATION:
+      g_value_set_boolean (value, tree_view->priv->threaded_validation);
+      break;
+    case PROP_RENDER_CACHE:
+      g_value_set_boolean (value, tree_view->priv->render_cache);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1552,6 +1607,9 @@ gtk_tree_view_buildable_add_child (GtkBuildable *tree_view,
 static void
 gtk_tree_view_free_rbtree (GtkTreeView *tree_view)
 {
+  gtk_tree_view_cancel_measure (tree_view);
+  gtk_tree_view_search_index_free (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
   _gtk_rbtree_free (tree_view->priv->tree);
   
   tree_view->priv->tree = NULL;
@@ -1857,6 +1915,8 @@ gtk_tree_view_unrealize (GtkWidget *widget)
   GtkTreeViewPrivate *priv = tree_view->priv;
   GList *list;
 
+  _gtk_tree_view_reset_row_renders (tree_view);
+
   if (priv->scroll_timeout != 0)
     {
       g_source_remove (priv->scroll_timeout);
@@ -2301,6 +2361,8 @@ gtk_tree_view_size_allocate_columns (GtkWidget *widget,
 
       if (column->width > old_width)
         column_changed = TRUE;
+      if (column->width != old_width)
+	_gtk_tree_view_reset_row_renders (tree_view);
 
       gtk_widget_size_allocate (column->button, &allocation);
 
@@ -4183,6 +4245,167 @@ gtk_tree_view_draw_grid_lines (GtkTreeView    *tree_view,
     }
 }
 
+/* A row drawn into a pixmap by gtk_tree_view_bin_expose(), holding
+ * the backgrounds and the cells of all columns.  It can be copied as
+ * long as the row is drawn in the same state.
+ */
+typedef struct
+{
+  GdkPixmap *pixmap;
+  GtkRBTree *tree;
+  gint width;
+  gint height;
+  guint flags;
+  GtkStateType state;
+  guint parity : 1;
+  guint is_parent : 1;
+  guint is_expanded : 1;
+  guint rtl : 1;
+  guint has_focus : 1;
+} GtkTreeViewRowRender;
+
+enum
+{
+  ROW_PASS_ALL,     /* draw everything on the window */
+  ROW_PASS_PIXMAP,  /* draw backgrounds and cells on the row pixmap */
+  ROW_PASS_OVERLAY  /* draw everything else on the window */
+};
+
+static void
+gtk_tree_view_row_render_free (gpointer data)
+{
+  GtkTreeViewRowRender *render = data;
+
+  g_object_unref (render->pixmap);
+  g_slice_free (GtkTreeViewRowRender, render);
+}
+
+void
+_gtk_tree_view_reset_row_renders (GtkTreeView *tree_view)
+{
+  if (tree_view->priv->row_renders)
+    {
+      g_hash_table_destroy (tree_view->priv->row_renders);
+      tree_view->priv->row_renders = NULL;
+    }
+}
+
+static void
+gtk_tree_view_forget_row_render (GtkTreeView *tree_view,
+				 GtkRBNode   *node)
+{
+  if (tree_view->priv->row_renders)
+    g_hash_table_remove (tree_view->priv->row_renders, node);
+}
+
+/* Returns the render of @node if it can be used for drawing the row as
+ * described, otherwise a new render whose pixmap is still to be drawn.
+ * *@valid tells which one it is.
+ */
+static GtkTreeViewRowRender *
+gtk_tree_view_get_row_render (GtkTreeView *tree_view,
+			      GtkRBTree   *tree,
+			      GtkRBNode   *node,
+			      gint         width,
+			      gint         height,
+			      guint        flags,
+			      GtkStateType state,
+			      gboolean     parity,
+			      gboolean    *valid)
+{
+  GtkTreeViewRowRender *render = NULL;
+  gboolean is_parent = GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT);
+  gboolean is_expanded = node->children != NULL;
+  gboolean rtl = gtk_widget_get_direction (GTK_WIDGET (tree_view)) == GTK_TEXT_DIR_RTL;
+  gboolean has_focus;
+
+  /* The cell renderers draw selected rows in the SELECTED state only
+   * while the view has the focus, and in the ACTIVE state otherwise
+   */
+  has_focus = (flags & GTK_CELL_RENDERER_SELECTED) &&
+	      GTK_WIDGET_HAS_FOCUS (tree_view);
+
+  if (tree_view->priv->row_renders)
+    render = g_hash_table_lookup (tree_view->priv->row_renders, node);
+  else
+    tree_view->priv->row_renders =
+      g_hash_table_new_full (NULL, NULL, NULL, gtk_tree_view_row_render_free);
+
+  if (render &&
+      render->width == width &&
+      render->height == height &&
+      render->flags == flags &&
+      render->state == state &&
+      render->parity == (parity != FALSE) &&
+      render->is_parent == (is_parent != FALSE) &&
+      render->is_expanded == is_expanded &&
+      render->rtl == rtl &&
+      render->has_focus == has_focus)
+    {
+      *valid = TRUE;
+      return render;
+    }
+
+  if (render == NULL ||
+      render->width != width || render->height != height)
+    {
+      render = g_slice_new (GtkTreeViewRowRender);
+      render->pixmap = gdk_pixmap_new (tree_view->priv->bin_window,
+				       width, height, -1);
+      render->width = width;
+      render->height = height;
+      g_hash_table_insert (tree_view->priv->row_renders, node, render);
+    }
+
+  render->tree = tree;
+  render->flags = flags;
+  render->state = state;
+  render->parity = parity != FALSE;
+  render->is_parent = is_parent != FALSE;
+  render->is_expanded = is_expanded;
+  render->rtl = rtl;
+  render->has_focus = has_focus;
+
+  *valid = FALSE;
+  return render;
+}
+
+static gboolean
+row_render_is_far (gpointer key,
+		   gpointer value,
+		   gpointer data)
+{
+  GtkTreeView *tree_view = data;
+  GtkTreeViewRowRender *render = value;
+  gint page = tree_view->priv->vadjustment->page_size;
+  gint y;
+
+  y = _gtk_rbtree_node_find_offset (render->tree, key);
+
+  return (y + render->height < tree_view->priv->dy - page ||
+	  y > tree_view->priv->dy + 2 * page);
+}
+
+/* Keeps the renders of the rows around the visible area, so that
+ * scrolling back and forth does not draw them again.
+ */
+static void
+gtk_tree_view_prune_row_renders (GtkTreeView *tree_view,
+				 gint         row_height)
+{
+  gint max_rows;
+
+  if (tree_view->priv->row_renders == NULL)
+    return;
+
+  max_rows = 3 * (tree_view->priv->vadjustment->page_size / MAX (row_height, 1) + 1);
+  if (g_hash_table_size (tree_view->priv->row_renders) <= max_rows)
+    return;
+
+  g_hash_table_foreach_remove (tree_view->priv->row_renders,
+			       row_render_is_far, tree_view);
+}
+
 /* Warning: Very scary function.
  * Modify at your own risk
  *
@@ -4229,6 +4452,11 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
   gboolean got_pointer = FALSE;
   gboolean row_ending_details;
   gboolean draw_vgrid_lines, draw_hgrid_lines;
+  GtkTreeViewRowRender *row_render;
+  gboolean render_valid;
+  gint passes[2];
+  gint n_passes, pass;
+  gint row_width;
 
   rtl = (gtk_widget_get_direction (widget) == GTK_TEXT_DIR_RTL);
 
@@ -4315,11 +4543,13 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
     gtk_widget_style_get (widget, "grid-line-width", &grid_line_width, NULL);
   
   n_visible_columns = 0;
+  row_width = 0;
   for (list = tree_view->priv->columns; list; list = list->next)
     {
       if (! GTK_TREE_VIEW_COLUMN (list->data)->visible)
 	continue;
       n_visible_columns ++;
+      row_width += GTK_TREE_VIEW_COLUMN (list->data)->width;
     }
 
   /* Find the last column */
@@ -4345,12 +4575,16 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
       gboolean is_separator = FALSE;
       gboolean is_first = FALSE;
       gboolean is_last = FALSE;
+      gint row_pass;
+      GdkWindow *drawable;
+      GdkRectangle *expose_area;
+      GdkRectangle row_area;
+      gint draw_dy;
       
       is_separator = row_is_separator (tree_view, &iter, NULL);
 
       max_height = ROW_HEIGHT (tree_view, BACKGROUND_HEIGHT (node));
 
-      cell_offset = 0;
       highlight_x = 0; /* should match x coord of first cell */
       expander_cell_width = 0;
 
@@ -4367,23 +4601,92 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 
       parity = _gtk_rbtree_node_find_parity (tree, node);
 
+      /* With the render cache, the backgrounds and cells of a row are
+       * drawn into a pixmap once and copied from there afterwards.
+       * Lines, expanders and focus are still drawn on the window.  The
+       * cursor row is always drawn directly, as its focus depends on
+       * the cells.
+       */
+      row_render = NULL;
+      passes[0] = ROW_PASS_ALL;
+      n_passes = 1;
+
+      if (tree_view->priv->render_cache && node != cursor && row_width > 0)
+	{
+	  row_render = gtk_tree_view_get_row_render (tree_view, tree, node,
+						     row_width, max_height,
+						     flags, widget->state,
+						     parity, &render_valid);
+	  if (render_valid)
+	    passes[0] = ROW_PASS_OVERLAY;
+	  else
+	    {
+	      passes[0] = ROW_PASS_PIXMAP;
+	      passes[1] = ROW_PASS_OVERLAY;
+	      n_passes = 2;
+	    }
+	}
+
       /* we *need* to set cell data on all cells before the call
        * to _has_special_cell, else _has_special_cell() does not
-       * return a correct value.
+       * return a correct value.  It only matters for the cursor row,
+       * which is never taken from the cache.
        */
-      for (list = (rtl ? g_list_last (tree_view->priv->columns) : g_list_first (tree_view->priv->columns));
-	   list;
-	   list = (rtl ? list->prev : list->next))
-        {
-	  GtkTreeViewColumn *column = list->data;
-	  gtk_tree_view_column_cell_set_cell_data (column,
-						   tree_view->priv->model,
-						   &iter,
-						   GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
-						   node->children?TRUE:FALSE);
-        }
+      if (passes[0] == ROW_PASS_ALL)
+	{
+	  for (list = (rtl ? g_list_last (tree_view->priv->columns) : g_list_first (tree_view->priv->columns));
+	       list;
+	       list = (rtl ? list->prev : list->next))
+	    {
+	      GtkTreeViewColumn *column = list->data;
+	      gtk_tree_view_column_cell_set_cell_data (column,
+						       tree_view->priv->model,
+						       &iter,
+						       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+						       node->children?TRUE:FALSE);
+	    }
+
+	  has_special_cell = gtk_tree_view_has_special_cell (tree_view);
+	}
+      else
+	has_special_cell = FALSE;
+
+      /* Each pass goes through the columns below once, see ROW_PASS_ALL */
+      pass = 0;
+
+    next_pass:
+      row_pass = passes[pass];
+      drawable = event->window;
+      expose_area = &event->area;
+      draw_dy = 0;
 
-      has_special_cell = gtk_tree_view_has_special_cell (tree_view);
+      row_area.x = 0;
+      row_area.y = background_area.y;
+      row_area.width = row_width;
+      row_area.height = max_height;
+
+      if (row_pass == ROW_PASS_PIXMAP)
+	{
+	  /* draw as if the row was at the top of the window */
+	  drawable = row_render->pixmap;
+	  draw_dy = -background_area.y;
+	  row_area.y = 0;
+	  expose_area = &row_area;
+	}
+      else if (row_pass == ROW_PASS_OVERLAY)
+	{
+	  GdkRectangle copy_area;
+
+	  if (gdk_rectangle_intersect (&row_area, &event->area, &copy_area))
+	    gdk_draw_drawable (event->window,
+			       widget->style->fg_gc[GTK_STATE_NORMAL],
+			       row_render->pixmap,
+			       copy_area.x, copy_area.y - background_area.y,
+			       copy_area.x, copy_area.y,
+			       copy_area.width, copy_area.height);
+	}
+
+      cell_offset = 0;
 
       for (list = (rtl ? g_list_last (tree_view->priv->columns) : g_list_first (tree_view->priv->columns));
 	   list;
@@ -4392,12 +4695,15 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 	  GtkTreeViewColumn *column = list->data;
 	  const gchar *detail = NULL;
 	  GtkStateType state;
+	  GdkRectangle draw_background_area;
+	  GdkRectangle draw_cell_area;
 
 	  if (!column->visible)
             continue;
 
-	  if (cell_offset > event->area.x + event->area.width ||
-	      cell_offset + column->width < event->area.x)
+	  if (row_pass != ROW_PASS_PIXMAP &&
+	      (cell_offset > event->area.x + event->area.width ||
+	       cell_offset + column->width < event->area.x))
 	    {
 	      cell_offset += column->width;
 	      continue;
@@ -4446,17 +4752,19 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 	      cell_area.height -= grid_line_width;
 	    }
 
-	  if (gdk_region_rect_in (event->region, &background_area) == GDK_OVERLAP_RECTANGLE_OUT)
+	  if (row_pass != ROW_PASS_PIXMAP &&
+	      gdk_region_rect_in (event->region, &background_area) == GDK_OVERLAP_RECTANGLE_OUT)
 	    {
 	      cell_offset += column->width;
 	      continue;
 	    }
 
-	  gtk_tree_view_column_cell_set_cell_data (column,
-						   tree_view->priv->model,
-						   &iter,
-						   GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
-						   node->children?TRUE:FALSE);
+	  if (row_pass != ROW_PASS_OVERLAY)
+	    gtk_tree_view_column_cell_set_cell_data (column,
+						     tree_view->priv->model,
+						     &iter,
+						     GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+						     node->children?TRUE:FALSE);
 
           /* Select the detail for drawing the cell.  relevant
            * factors are parity, sortedness, and whether to
@@ -4508,14 +4816,19 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 	  else
 	    state = GTK_STATE_NORMAL;
 
+	  is_first = (rtl ? !list->next : !list->prev);
+	  is_last = (rtl ? !list->prev : !list->next);
+
+	  draw_background_area = background_area;
+	  draw_background_area.y += draw_dy;
+
 	  /* Draw background */
-	  if (row_ending_details)
+	  if (row_pass == ROW_PASS_OVERLAY)
+	    ;
+	  else if (row_ending_details)
 	    {
 	      char new_detail[128];
 
-	      is_first = (rtl ? !list->next : !list->prev);
-	      is_last = (rtl ? !list->prev : !list->next);
-
 	      /* (I don't like the snprintfs either, but couldn't find a
 	       * less messy way).
 	       */
@@ -4529,33 +4842,33 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 		g_snprintf (new_detail, 128, "%s_middle", detail);
 
 	      gtk_paint_flat_box (widget->style,
-				  event->window,
+				  drawable,
 				  state,
 				  GTK_SHADOW_NONE,
-				  &event->area,
+				  expose_area,
 				  widget,
 				  new_detail,
-				  background_area.x,
-				  background_area.y,
-				  background_area.width,
-				  background_area.height);
+				  draw_background_area.x,
+				  draw_background_area.y,
+				  draw_background_area.width,
+				  draw_background_area.height);
 	    }
 	  else
 	    {
 	      gtk_paint_flat_box (widget->style,
-				  event->window,
+				  drawable,
 				  state,
 				  GTK_SHADOW_NONE,
-				  &event->area,
+				  expose_area,
 				  widget,
 				  detail,
-				  background_area.x,
-				  background_area.y,
-				  background_area.width,
-				  background_area.height);
+				  draw_background_area.x,
+				  draw_background_area.y,
+				  draw_background_area.width,
+				  draw_background_area.height);
 	    }
 
-	  if (draw_hgrid_lines)
+	  if (draw_hgrid_lines && row_pass != ROW_PASS_PIXMAP)
 	    {
 	      if (background_area.y > 0)
 		gdk_draw_line (event->window,
@@ -4592,24 +4905,30 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
               highlight_x = cell_area.x;
 	      expander_cell_width = cell_area.width;
 
-	      if (is_separator)
+	      draw_cell_area = cell_area;
+	      draw_cell_area.y += draw_dy;
+
+	      if (row_pass == ROW_PASS_OVERLAY)
+		;
+	      else if (is_separator)
 		gtk_paint_hline (widget->style,
-				 event->window,
+				 drawable,
 				 state,
-				 &cell_area,
+				 &draw_cell_area,
 				 widget,
 				 NULL,
-				 cell_area.x,
-				 cell_area.x + cell_area.width,
-				 cell_area.y + cell_area.height / 2);
+				 draw_cell_area.x,
+				 draw_cell_area.x + draw_cell_area.width,
+				 draw_cell_area.y + draw_cell_area.height / 2);
 	      else
 		_gtk_tree_view_column_cell_render (column,
-						   event->window,
-						   &background_area,
-						   &cell_area,
-						   &event->area,
+						   drawable,
+						   &draw_background_area,
+						   &draw_cell_area,
+						   expose_area,
 						   flags);
-	      if (TREE_VIEW_DRAW_EXPANDERS(tree_view)
+	      if (row_pass != ROW_PASS_PIXMAP
+		  && TREE_VIEW_DRAW_EXPANDERS(tree_view)
 		  && (node->flags & GTK_RBNODE_IS_PARENT) == GTK_RBNODE_IS_PARENT)
 		{
 		  if (!got_pointer)
@@ -4627,26 +4946,32 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 	    }
 	  else
 	    {
-	      if (is_separator)
+	      draw_cell_area = cell_area;
+	      draw_cell_area.y += draw_dy;
+
+	      if (row_pass == ROW_PASS_OVERLAY)
+		;
+	      else if (is_separator)
 		gtk_paint_hline (widget->style,
-				 event->window,
+				 drawable,
 				 state,
-				 &cell_area,
+				 &draw_cell_area,
 				 widget,
 				 NULL,
-				 cell_area.x,
-				 cell_area.x + cell_area.width,
-				 cell_area.y + cell_area.height / 2);
+				 draw_cell_area.x,
+				 draw_cell_area.x + draw_cell_area.width,
+				 draw_cell_area.y + draw_cell_area.height / 2);
 	      else
 		_gtk_tree_view_column_cell_render (column,
-						   event->window,
-						   &background_area,
-						   &cell_area,
-						   &event->area,
+						   drawable,
+						   &draw_background_area,
+						   &draw_cell_area,
+						   expose_area,
 						   flags);
 	    }
 
-	  if (gtk_tree_view_is_expander_column (tree_view, column) &&
+	  if (row_pass != ROW_PASS_PIXMAP &&
+	      gtk_tree_view_is_expander_column (tree_view, column) &&
 	      tree_view->priv->tree_lines_enabled)
 	    {
 	      gint x = background_area.x;
@@ -4718,7 +5043,8 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 		}
 	    }
 
-	  if (node == cursor && has_special_cell &&
+	  if (row_pass != ROW_PASS_PIXMAP &&
+	      node == cursor && has_special_cell &&
 	      ((column == tree_view->priv->focus_column &&
 		GTK_TREE_VIEW_FLAG_SET (tree_view, GTK_TREE_VIEW_DRAW_KEYFOCUS) &&
 		GTK_WIDGET_HAS_FOCUS (widget)) ||
@@ -4735,6 +5061,9 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 	  cell_offset += column->width;
 	}
 
+      if (++pass < n_passes)
+	goto next_pass;
+
       if (node == drag_highlight)
         {
           /* Draw indicator for the drop
@@ -4917,6 +5246,9 @@ gtk_tree_view_bin_expose (GtkWidget      *widget,
 done:
   gtk_tree_view_draw_grid_lines (tree_view, event, n_visible_columns);
 
+  if (tree_view->priv->render_cache)
+    gtk_tree_view_prune_row_renders (tree_view, max_height);
+
  if (tree_view->priv->rubber_band_status == RUBBER_BAND_ACTIVE)
    {
      GdkRectangle *rectangles;
@@ -5576,14 +5908,19 @@ node_is_visible (GtkTreeView *tree_view,
   return FALSE;
 }
 
-/* Returns TRUE if it updated the size
+/* Returns TRUE if it updated the size. The cells are measured for
+ * @iter, unless @sizes is given, which then holds the sizes of the
+ * cells of all visible columns, as measured by
+ * _gtk_tree_view_column_cell_measure().
  */
 static gboolean
-validate_row (GtkTreeView *tree_view,
-	      GtkRBTree   *tree,
-	      GtkRBNode   *node,
-	      GtkTreeIter *iter,
-	      GtkTreePath *path)
+do_validate_row (GtkTreeView         *tree_view,
+		 GtkRBTree           *tree,
+		 GtkRBNode           *node,
+		 GtkTreeIter         *iter,
+		 gint                 depth,
+		 gboolean             is_separator,
+		 GtkTreeViewCellSize *sizes)
 {
   GtkTreeViewColumn *column;
   GList *list, *first_column, *last_column;
@@ -5591,22 +5928,13 @@ validate_row (GtkTreeView *tree_view,
   gint horizontal_separator;
   gint vertical_separator;
   gint focus_line_width;
-  gint depth = gtk_tree_path_get_depth (path);
   gboolean retval = FALSE;
-  gboolean is_separator = FALSE;
   gboolean draw_vgrid_lines, draw_hgrid_lines;
   gint focus_pad;
   gint grid_line_width;
   gboolean wide_separators;
   gint separator_height;
 
-  /* double check the row needs validating */
-  if (! GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) &&
-      ! GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
-    return FALSE;
-
-  is_separator = row_is_separator (tree_view, iter, NULL);
-
   gtk_widget_style_get (GTK_WIDGET (tree_view),
 			"focus-padding", &focus_pad,
 			"focus-line-width", &focus_line_width,
@@ -5644,15 +5972,24 @@ validate_row (GtkTreeView *tree_view,
       if (! column->visible)
 	continue;
 
-      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID) && !column->dirty)
-	continue;
+      if (sizes)
+	{
+	  _gtk_tree_view_column_cell_get_measured_size (column, sizes,
+							&tmp_width, &tmp_height);
+	  sizes += g_list_length (column->cell_list);
+	}
+      else
+	{
+	  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID) && !column->dirty)
+	    continue;
 
-      gtk_tree_view_column_cell_set_cell_data (column, tree_view->priv->model, iter,
-					       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
-					       node->children?TRUE:FALSE);
-      gtk_tree_view_column_cell_get_size (column,
-					  NULL, NULL, NULL,
-					  &tmp_width, &tmp_height);
+	  gtk_tree_view_column_cell_set_cell_data (column, tree_view->priv->model, iter,
+						   GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+						   node->children?TRUE:FALSE);
+	  gtk_tree_view_column_cell_get_size (column,
+					      NULL, NULL, NULL,
+					      &tmp_width, &tmp_height);
+	}
 
       if (!is_separator)
 	{
@@ -5707,6 +6044,26 @@ validate_row (GtkTreeView *tree_view,
   return retval;
 }
 
+/* Returns TRUE if it updated the size
+ */
+static gboolean
+validate_row (GtkTreeView *tree_view,
+	      GtkRBTree   *tree,
+	      GtkRBNode   *node,
+	      GtkTreeIter *iter,
+	      GtkTreePath *path)
+{
+  /* double check the row needs validating */
+  if (! GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) &&
+      ! GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+    return FALSE;
+
+  return do_validate_row (tree_view, tree, node, iter,
+			  gtk_tree_path_get_depth (path),
+			  row_is_separator (tree_view, iter, NULL),
+			  NULL);
+}
+
 
 static void
 validate_visible_area (GtkTreeView *tree_view)
@@ -6109,6 +6466,73 @@ initialize_fixed_height_mode (GtkTreeView *tree_view)
                                  tree_view->priv->fixed_height, TRUE);
 }
 
+/* Finds the left-most invalid node. The tree must have one.
+ */
+static void
+find_first_invalid_node (GtkTreeView  *tree_view,
+			 GtkRBTree   **tree_out,
+			 GtkRBNode   **node_out)
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+
+  tree = tree_view->priv->tree;
+  node = tree_view->priv->tree->root;
+
+  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  do
+    {
+      if (node->left != tree->nil &&
+	  GTK_RBNODE_FLAG_SET (node->left, GTK_RBNODE_DESCENDANTS_INVALID))
+	{
+	  node = node->left;
+	}
+      else if (node->right != tree->nil &&
+	       GTK_RBNODE_FLAG_SET (node->right, GTK_RBNODE_DESCENDANTS_INVALID))
+	{
+	  node = node->right;
+	}
+      else if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
+	       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+	{
+	  break;
+	}
+      else if (node->children != NULL)
+	{
+	  tree = node->children;
+	  node = tree->root;
+	}
+      else
+	/* RBTree corruption!  All bad */
+	g_assert_not_reached ();
+    }
+  while (TRUE);
+
+  *tree_out = tree;
+  *node_out = node;
+}
+
+static void
+update_size_after_validation (GtkTreeView *tree_view,
+			      gboolean     queue_resize)
+{
+  GtkRequisition requisition;
+
+  /* We temporarily guess a size, under the assumption that it will be the
+   * same when we get our next size_allocate.  If we don't do this, we'll be
+   * in an inconsistent state when we call top_row_to_dy. */
+
+  gtk_widget_size_request (GTK_WIDGET (tree_view), &requisition);
+  tree_view->priv->hadjustment->upper = MAX (tree_view->priv->hadjustment->upper, (gfloat)requisition.width);
+  tree_view->priv->vadjustment->upper = MAX (tree_view->priv->vadjustment->upper, (gfloat)requisition.height);
+  gtk_adjustment_changed (tree_view->priv->hadjustment);
+  gtk_adjustment_changed (tree_view->priv->vadjustment);
+
+  if (queue_resize)
+    gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+}
+
 /* Our strategy for finding nodes to validate is a little convoluted.  We find
  * the left-most uninvalidated node.  We then try walking right, validating
  * nodes.  Once we find a valid node, we repeat the previous process of finding
@@ -6171,38 +6595,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
       if (path == NULL)
 	{
-	  tree = tree_view->priv->tree;
-	  node = tree_view->priv->tree->root;
-
-	  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_INVALID));
-
-	  do
-	    {
-	      if (node->left != tree->nil &&
-		  GTK_RBNODE_FLAG_SET (node->left, GTK_RBNODE_DESCENDANTS_INVALID))
-		{
-		  node = node->left;
-		}
-	      else if (node->right != tree->nil &&
-		       GTK_RBNODE_FLAG_SET (node->right, GTK_RBNODE_DESCENDANTS_INVALID))
-		{
-		  node = node->right;
-		}
-	      else if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
-		       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
-		{
-		  break;
-		}
-	      else if (node->children != NULL)
-		{
-		  tree = node->children;
-		  node = tree->root;
-		}
-	      else
-		/* RBTree corruption!  All bad */
-		g_assert_not_reached ();
-	    }
-	  while (TRUE);
+	  find_first_invalid_node (tree_view, &tree, &node);
 	  path = _gtk_tree_view_find_path (tree_view, tree, node);
 	  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
 	}
@@ -6210,51 +6603,425 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
       validated_area = validate_row (tree_view, tree, node, &iter, path) ||
                        validated_area;
 
-      if (!tree_view->priv->fixed_height_check)
-        {
-	  gint height;
+      if (!tree_view->priv->fixed_height_check)
+        {
+	  gint height;
+
+	  height = ROW_HEIGHT (tree_view, GTK_RBNODE_GET_HEIGHT (node));
+	  if (prev_height < 0)
+	    prev_height = height;
+	  else if (prev_height != height)
+	    fixed_height = FALSE;
+	}
+
+      i++;
+    }
+  while (g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.);
+
+  if (!tree_view->priv->fixed_height_check)
+   {
+     if (fixed_height)
+       _gtk_rbtree_set_fixed_height (tree_view->priv->tree, prev_height, FALSE);
+
+     tree_view->priv->fixed_height_check = 1;
+   }
+  
+ done:
+  if (validated_area)
+    update_size_after_validation (tree_view, queue_resize);
+
+  if (path) gtk_tree_path_free (path);
+  g_timer_destroy (timer);
+
+  return retval;
+}
+
+/* Threaded validation: the cell data of a batch of invalid rows is set
+ * on the main thread, where the cells other than text are measured right
+ * away and the text cells are copied. The text is then shaped by a pool
+ * of threads, each with a font map of its own, and the sizes go into the
+ * tree once the whole batch is done. Until then the rows stay invalid,
+ * so anything that needs them sooner validates them as usual.
+ */
+#define GTK_TREE_VIEW_MEASURE_BATCH_ROWS 4096
+#define GTK_TREE_VIEW_MEASURE_CHUNK_CELLS 256
+
+typedef struct _GtkTreeViewMeasureRow GtkTreeViewMeasureRow;
+struct _GtkTreeViewMeasureRow
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  gint depth;
+  gboolean is_separator;
+  guint first_size;
+};
+
+typedef struct _GtkTreeViewMeasureChunk GtkTreeViewMeasureChunk;
+struct _GtkTreeViewMeasureChunk
+{
+  GtkTreeViewMeasureBatch *batch;
+  guint start;
+  guint end;
+};
+
+struct _GtkTreeViewMeasureBatch
+{
+  /* NULL once the batch has been cancelled */
+  GtkTreeView *tree_view;
+  volatile gint cancelled;
+
+  /* The visible columns, and the number of cells they have */
+  GPtrArray *columns;
+  guint n_cells;
+
+  GArray *rows;
+  GArray *sizes;
+
+  /* Rows that changed after their cell data was taken */
+  GHashTable *changed_nodes;
+
+  /* How the threads set up their contexts */
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  PangoDirection base_dir;
+  cairo_font_options_t *font_options;
+  gdouble resolution;
+
+  GtkTreeViewMeasureChunk *chunks;
+  volatile gint pending;
+};
+
+static GThreadPool *measure_pool = NULL;
+G_LOCK_DEFINE_STATIC (measure_pool);
+
+static void
+measure_batch_free (GtkTreeViewMeasureBatch *batch)
+{
+  guint i;
+
+  for (i = 0; i < batch->sizes->len; i++)
+    {
+      GtkTreeViewCellSize *size = &g_array_index (batch->sizes, GtkTreeViewCellSize, i);
+
+      if (size->measure)
+	_gtk_cell_renderer_text_measure_free (size->measure);
+    }
+
+  g_ptr_array_free (batch->columns, TRUE);
+  g_array_free (batch->rows, TRUE);
+  g_array_free (batch->sizes, TRUE);
+  if (batch->changed_nodes)
+    g_hash_table_destroy (batch->changed_nodes);
+  pango_font_description_free (batch->font_desc);
+  if (batch->font_options)
+    cairo_font_options_destroy (batch->font_options);
+  g_free (batch->chunks);
+  g_slice_free (GtkTreeViewMeasureBatch, batch);
+}
+
+/* The batch is freed when the threads are done with it. Its rows
+ * are still invalid, so they will be validated again later.
+ */
+static void
+gtk_tree_view_cancel_measure (GtkTreeView *tree_view)
+{
+  GtkTreeViewMeasureBatch *batch = tree_view->priv->measure_batch;
+
+  if (batch == NULL)
+    return;
+
+  batch->tree_view = NULL;
+  g_atomic_int_set (&batch->cancelled, TRUE);
+  tree_view->priv->measure_batch = NULL;
+}
+
+/* Called when the data of @node changed after it was taken */
+static void
+gtk_tree_view_forget_measured_node (GtkTreeView *tree_view,
+				    GtkRBNode   *node)
+{
+  GtkTreeViewMeasureBatch *batch = tree_view->priv->measure_batch;
+
+  if (batch == NULL)
+    return;
+
+  if (batch->changed_nodes == NULL)
+    batch->changed_nodes = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_insert (batch->changed_nodes, node, node);
+}
+
+static gboolean measure_batch_done (gpointer data);
+
+/* Runs in a thread of the pool */
+static void
+measure_chunk (gpointer data,
+	       gpointer user_data)
+{
+  GtkTreeViewMeasureChunk *chunk = data;
+  GtkTreeViewMeasureBatch *batch = chunk->batch;
+  PangoContext *context = NULL;
+  guint i;
+
+  for (i = chunk->start; i < chunk->end; i++)
+    {
+      GtkTreeViewCellSize *size = &g_array_index (batch->sizes, GtkTreeViewCellSize, i);
+
+      if (g_atomic_int_get (&batch->cancelled))
+	break;
+
+      if (size->measure == NULL)
+	continue;
+
+      if (context == NULL)
+	context = _gtk_pango_threads_context_new (batch->resolution,
+						  batch->font_options,
+						  batch->font_desc,
+						  batch->language,
+						  batch->base_dir);
+
+      _gtk_cell_renderer_text_measure_run (size->measure, context);
+    }
+
+  if (context)
+    g_object_unref (context);
+
+  if (g_atomic_int_dec_and_test (&batch->pending))
+    gdk_threads_add_idle_full (GTK_TREE_VIEW_PRIORITY_VALIDATE,
+			       measure_batch_done, batch, NULL);
+}
+
+static gboolean
+measure_batch_columns_unchanged (GtkTreeView             *tree_view,
+				 GtkTreeViewMeasureBatch *batch)
+{
+  GtkTreeViewColumn *column;
+  GList *list;
+  guint i = 0, n_cells = 0;
+
+  for (list = tree_view->priv->columns; list; list = list->next)
+    {
+      column = list->data;
+      if (! column->visible)
+	continue;
+
+      if (i == batch->columns->len || g_ptr_array_index (batch->columns, i) != column)
+	return FALSE;
+
+      n_cells += g_list_length (column->cell_list);
+      i++;
+    }
+
+  return i == batch->columns->len && n_cells == batch->n_cells;
+}
+
+/* Puts the sizes of a batch into the tree, on the main thread */
+static gboolean
+measure_batch_done (gpointer data)
+{
+  GtkTreeViewMeasureBatch *batch = data;
+  GtkTreeView *tree_view = batch->tree_view;
+  GtkTreeViewMeasureRow *row;
+  gboolean validated_area = FALSE;
+  gboolean fixed_height = TRUE;
+  gint prev_height = -1;
+  guint i;
+
+  if (tree_view == NULL)
+    {
+      measure_batch_free (batch);
+      return FALSE;
+    }
+
+  tree_view->priv->measure_batch = NULL;
+
+  if (measure_batch_columns_unchanged (tree_view, batch))
+    {
+      for (i = 0; i < batch->rows->len; i++)
+	{
+	  row = &g_array_index (batch->rows, GtkTreeViewMeasureRow, i);
+
+	  /* validated in the meantime */
+	  if (! GTK_RBNODE_FLAG_SET (row->node, GTK_RBNODE_INVALID) &&
+	      ! GTK_RBNODE_FLAG_SET (row->node, GTK_RBNODE_COLUMN_INVALID))
+	    continue;
+
+	  if (batch->changed_nodes &&
+	      g_hash_table_lookup (batch->changed_nodes, row->node))
+	    continue;
+
+	  validated_area = do_validate_row (tree_view, row->tree, row->node, NULL,
+					    row->depth, row->is_separator,
+					    &g_array_index (batch->sizes, GtkTreeViewCellSize,
+							    row->first_size)) ||
+			   validated_area;
+
+	  if (!tree_view->priv->fixed_height_check)
+	    {
+	      gint height;
+
+	      height = ROW_HEIGHT (tree_view, GTK_RBNODE_GET_HEIGHT (row->node));
+	      if (prev_height < 0)
+		prev_height = height;
+	      else if (prev_height != height)
+		fixed_height = FALSE;
+	    }
+	}
+
+      if (!tree_view->priv->fixed_height_check && prev_height >= 0)
+	{
+	  if (fixed_height)
+	    _gtk_rbtree_set_fixed_height (tree_view->priv->tree, prev_height, FALSE);
+
+	  tree_view->priv->fixed_height_check = 1;
+	}
+    }
+
+  measure_batch_free (batch);
+
+  if (validated_area)
+    update_size_after_validation (tree_view, TRUE);
+
+  if (tree_view->priv->tree &&
+      GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID))
+    install_presize_handler (tree_view);
+
+  return FALSE;
+}
+
+/* Takes the cell data of the next invalid rows and hands them to the
+ * thread pool. Returns whether validate_rows_handler() has to be
+ * called again; once the batch is done, it is installed again.
+ */
+static gboolean
+measure_rows_in_background (GtkTreeView *tree_view)
+{
+  GtkTreeViewMeasureBatch *batch;
+  GtkTreeViewMeasureRow row;
+  GtkTreeViewColumn *column;
+  GtkTreeViewCellSize *sizes;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  PangoContext *context;
+  const cairo_font_options_t *font_options;
+  GThreadPool *pool;
+  GTimer *timer;
+  GList *list;
+  guint n_threads, n_chunks, i;
+  gint depth;
+
+  if (tree_view->priv->measure_batch)
+    return FALSE;
+
+  if (tree_view->priv->tree == NULL ||
+      tree_view->priv->fixed_height_mode ||
+      ! GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID))
+    return do_validate_rows (tree_view, TRUE);
+
+  n_threads = _gtk_pango_threads_get_n_threads ();
+
+  G_LOCK (measure_pool);
+  if (!measure_pool)
+    measure_pool = g_thread_pool_new (measure_chunk, NULL,
+				      n_threads, FALSE, NULL);
+  pool = measure_pool;
+  G_UNLOCK (measure_pool);
+
+  if (!pool)
+    return do_validate_rows (tree_view, TRUE);
+
+  batch = g_slice_new0 (GtkTreeViewMeasureBatch);
+  batch->tree_view = tree_view;
+  batch->columns = g_ptr_array_new ();
+  batch->rows = g_array_new (FALSE, FALSE, sizeof (GtkTreeViewMeasureRow));
+  batch->sizes = g_array_new (FALSE, FALSE, sizeof (GtkTreeViewCellSize));
+
+  for (list = tree_view->priv->columns; list; list = list->next)
+    {
+      column = list->data;
+      if (! column->visible)
+	continue;
+
+      g_ptr_array_add (batch->columns, column);
+      batch->n_cells += g_list_length (column->cell_list);
+    }
+
+  context = gtk_widget_get_pango_context (GTK_WIDGET (tree_view));
+  batch->font_desc = pango_font_description_copy (pango_context_get_font_description (context));
+  batch->language = pango_context_get_language (context);
+  batch->base_dir = pango_context_get_base_dir (context);
+  font_options = pango_cairo_context_get_font_options (context);
+  if (font_options)
+    batch->font_options = cairo_font_options_copy (font_options);
+  batch->resolution = pango_cairo_context_get_resolution (context);
+
+  find_first_invalid_node (tree_view, &tree, &node);
+  path = _gtk_tree_view_find_path (tree_view, tree, node);
+  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+  depth = gtk_tree_path_get_depth (path);
+  gtk_tree_path_free (path);
+
+  timer = g_timer_new ();
+  g_timer_start (timer);
+
+  /* Take the following rows of the same level, until the batch is
+   * full or the time for this idle is used up */
+  do
+    {
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
+	  GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+	{
+	  row.tree = tree;
+	  row.node = node;
+	  row.depth = depth;
+	  row.is_separator = row_is_separator (tree_view, &iter, NULL);
+	  row.first_size = batch->sizes->len;
+	  g_array_append_val (batch->rows, row);
+
+	  g_array_set_size (batch->sizes, batch->sizes->len + batch->n_cells);
+	  sizes = &g_array_index (batch->sizes, GtkTreeViewCellSize, row.first_size);
 
-	  height = ROW_HEIGHT (tree_view, GTK_RBNODE_GET_HEIGHT (node));
-	  if (prev_height < 0)
-	    prev_height = height;
-	  else if (prev_height != height)
-	    fixed_height = FALSE;
+	  for (i = 0; i < batch->columns->len; i++)
+	    {
+	      column = g_ptr_array_index (batch->columns, i);
+
+	      gtk_tree_view_column_cell_set_cell_data (column, tree_view->priv->model, &iter,
+						       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+						       node->children?TRUE:FALSE);
+	      _gtk_tree_view_column_cell_measure (column, sizes);
+	      sizes += g_list_length (column->cell_list);
+	    }
 	}
 
-      i++;
+      node = _gtk_rbtree_next (tree, node);
+      if (node == NULL || !gtk_tree_model_iter_next (tree_view->priv->model, &iter))
+	break;
     }
-  while (g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.);
+  while (batch->rows->len < GTK_TREE_VIEW_MEASURE_BATCH_ROWS &&
+	 g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.);
 
-  if (!tree_view->priv->fixed_height_check)
-   {
-     if (fixed_height)
-       _gtk_rbtree_set_fixed_height (tree_view->priv->tree, prev_height, FALSE);
+  g_timer_destroy (timer);
 
-     tree_view->priv->fixed_height_check = 1;
-   }
-  
- done:
-  if (validated_area)
-    {
-      GtkRequisition requisition;
-      /* We temporarily guess a size, under the assumption that it will be the
-       * same when we get our next size_allocate.  If we don't do this, we'll be
-       * in an inconsistent state when we call top_row_to_dy. */
+  n_chunks = (batch->sizes->len + GTK_TREE_VIEW_MEASURE_CHUNK_CELLS - 1) / GTK_TREE_VIEW_MEASURE_CHUNK_CELLS;
+  n_chunks = CLAMP (n_chunks, 1, n_threads);
 
-      gtk_widget_size_request (GTK_WIDGET (tree_view), &requisition);
-      tree_view->priv->hadjustment->upper = MAX (tree_view->priv->hadjustment->upper, (gfloat)requisition.width);
-      tree_view->priv->vadjustment->upper = MAX (tree_view->priv->vadjustment->upper, (gfloat)requisition.height);
-      gtk_adjustment_changed (tree_view->priv->hadjustment);
-      gtk_adjustment_changed (tree_view->priv->vadjustment);
+  batch->chunks = g_new (GtkTreeViewMeasureChunk, n_chunks);
+  batch->pending = n_chunks;
+  tree_view->priv->measure_batch = batch;
 
-      if (queue_resize)
-        gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+  for (i = 0; i < n_chunks; i++)
+    {
+      batch->chunks[i].batch = batch;
+      batch->chunks[i].start = (batch->sizes->len * i) / n_chunks;
+      batch->chunks[i].end = (batch->sizes->len * (i + 1)) / n_chunks;
     }
 
-  if (path) gtk_tree_path_free (path);
-  g_timer_destroy (timer);
+  for (i = 0; i < n_chunks; i++)
+    g_thread_pool_push (pool, &batch->chunks[i], NULL);
 
-  return retval;
+  return FALSE;
 }
 
 static gboolean
@@ -6278,7 +7045,10 @@ validate_rows_handler (GtkTreeView *tree_view)
 {
   gboolean retval;
 
-  retval = do_validate_rows (tree_view, TRUE);
+  if (tree_view->priv->threaded_validation && _gtk_pango_threads_supported ())
+    retval = measure_rows_in_background (tree_view);
+  else
+    retval = do_validate_rows (tree_view, TRUE);
   if (! retval && tree_view->priv->validate_rows_timer)
     {
       g_source_remove (tree_view->priv->validate_rows_timer);
@@ -6293,6 +7063,7 @@ do_presize_handler (GtkTreeView *tree_view)
 {
   if (tree_view->priv->mark_rows_col_dirty)
     {
+      gtk_tree_view_cancel_measure (tree_view);
       if (tree_view->priv->tree)
 	_gtk_rbtree_column_invalid (tree_view->priv->tree);
       tree_view->priv->mark_rows_col_dirty = FALSE;
@@ -7675,6 +8446,124 @@ gtk_tree_view_get_fixed_height_mode (GtkTreeView *tree_view)
   return tree_view->priv->fixed_height_mode;
 }
 
+/**
+ * gtk_tree_view_set_threaded_validation:
+ * @tree_view: a #GtkTreeView
+ * @enable: %TRUE to measure rows in other threads
+ *
+ * Enables or disables threaded validation for @tree_view. With
+ * threaded validation, the text of the rows that are not visible
+ * is measured by a pool of threads instead of in idle handlers,
+ * which keeps large views responsive while their size is computed.
+ * The cell data of the rows is still set in the main thread, and
+ * cells other than #GtkCellRendererText are measured there as well.
+ *
+ * This has no effect unless g_thread_init() has been called, or
+ * in fixed height mode, or with a Pango older than 1.32, which
+ * can't be used from several threads at once.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_tree_view_set_threaded_validation (GtkTreeView *tree_view,
+                                       gboolean     enable)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  enable = enable != FALSE;
+
+  if (enable == tree_view->priv->threaded_validation)
+    return;
+
+  tree_view->priv->threaded_validation = enable;
+  if (!enable)
+    {
+      gtk_tree_view_cancel_measure (tree_view);
+      install_presize_handler (tree_view);
+    }
+
+  g_object_notify (G_OBJECT (tree_view), "threaded-validation");
+}
+
+/**
+ * gtk_tree_view_get_threaded_validation:
+ * @tree_view: a #GtkTreeView
+ *
+ * Returns whether threaded validation is turned on for @tree_view.
+ *
+ * Return value: %TRUE if the rows of @tree_view are measured in
+ *   other threads
+ *
+ * Since: 2.20
+ **/
+gboolean
+gtk_tree_view_get_threaded_validation (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->threaded_validation;
+}
+
+/**
+ * gtk_tree_view_set_render_cache:
+ * @tree_view: a #GtkTreeView
+ * @enable: %TRUE to keep drawn rows
+ *
+ * Enables or disables the render cache. With the cache on, the
+ * background and cells of each drawn row are kept in an offscreen
+ * pixmap and copied when the row is exposed again, instead of
+ * fetching its values from the model and rendering its cells. Tree
+ * lines, expanders, grid lines and the focus rectangle are always
+ * drawn directly, as is the whole cursor row.
+ *
+ * A kept row is dropped when the model reports it as changed, and all
+ * of them are dropped when the columns, their widths or the style of
+ * @tree_view change. Changing the properties of a cell renderer
+ * directly is not noticed; call gtk_tree_view_column_queue_resize()
+ * on its column afterwards.
+ *
+ * Since: 2.20
+ **/
+void
+gtk_tree_view_set_render_cache (GtkTreeView *tree_view,
+                                gboolean     enable)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  enable = enable != FALSE;
+
+  if (tree_view->priv->render_cache == enable)
+    return;
+
+  tree_view->priv->render_cache = enable;
+
+  if (!enable)
+    _gtk_tree_view_reset_row_renders (tree_view);
+
+  gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+
+  g_object_notify (G_OBJECT (tree_view), "render-cache");
+}
+
+/**
+ * gtk_tree_view_get_render_cache:
+ * @tree_view: a #GtkTreeView
+ *
+ * Returns whether the render cache is turned on for @tree_view.
+ * See gtk_tree_view_set_render_cache().
+ *
+ * Return value: %TRUE if drawn rows are kept
+ *
+ * Since: 2.20
+ **/
+gboolean
+gtk_tree_view_get_render_cache (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->render_cache;
+}
+
 /* Returns TRUE if the focus is within the headers, after the focus operation is
  * done
  */
@@ -7953,6 +8842,9 @@ gtk_tree_view_style_set (GtkWidget *widget,
       gtk_tree_view_set_enable_tree_lines (tree_view, tree_view->priv->tree_lines_enabled);
     }
 
+  gtk_tree_view_cancel_measure (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
+
   gtk_widget_style_get (widget,
 			"expander-size", &tree_view->priv->expander_size,
 			NULL);
@@ -8224,6 +9116,10 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
   if (tree == NULL)
     goto done;
 
+  if (tree_view->priv->search_index)
+    g_hash_table_remove (tree_view->priv->search_index, node);
+  gtk_tree_view_forget_row_render (tree_view, node);
+
   if (tree_view->priv->fixed_height_mode
       && tree_view->priv->fixed_height >= 0)
     {
@@ -8233,6 +9129,7 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
     }
   else
     {
+      gtk_tree_view_forget_measured_node (tree_view, node);
       _gtk_rbtree_node_mark_invalid (tree, node);
       for (list = tree_view->priv->columns; list; list = list->next)
         {
@@ -8407,6 +9304,8 @@ gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
   if (tree == NULL)
     goto done;
 
+  gtk_tree_view_cancel_measure (tree_view);
+
   has_child = gtk_tree_model_iter_has_child (model, &real_iter);
   /* Sanity check.
    */
@@ -8489,6 +9388,10 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
   if (tree == NULL)
     return;
 
+  gtk_tree_view_cancel_measure (tree_view);
+  gtk_tree_view_search_index_free (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
+
   /* check if the selection has been changed */
   _gtk_rbtree_traverse (tree, node, G_POST_ORDER,
                         check_selection_helper, &selection_changed);
@@ -8578,6 +9481,10 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
   if (tree == NULL)
     return;
 
+  gtk_tree_view_cancel_measure (tree_view);
+  gtk_tree_view_search_index_free (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
+
   if (tree_view->priv->edited_column)
     gtk_tree_view_stop_editing (tree_view, TRUE);
 
@@ -8594,6 +9501,130 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
   gtk_tree_view_dy_to_top_row (tree_view);
 }
 
+static void
+any_selected_helper (GtkRBTree *tree,
+		     GtkRBNode *node,
+		     gpointer   data)
+{
+  gboolean *selected = (gboolean *)data;
+
+  if (*selected)
+    return;
+
+  if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_SELECTED))
+    *selected = TRUE;
+  else if (node->children)
+    _gtk_rbtree_traverse (node->children, node->children->root, G_PRE_ORDER, any_selected_helper, data);
+}
+
+/* The model replaced all children of @parent in one go.  Rather than
+ * deleting and inserting the rows one by one, we throw the whole
+ * subtree away and build it again from the model.  The model dropped
+ * its refs on the old children itself, so they are not unreffed here.
+ * If @parent gained or lost all its children, the model follows up
+ * with ::row-has-child-toggled, which updates the parent's flags.
+ */
+static void
+gtk_tree_view_children_reloaded (GtkTreeModel *model,
+				 GtkTreePath  *parent,
+				 GtkTreeIter  *iter,
+				 gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *)data;
+  GtkRBTree *tree = NULL;
+  GtkRBNode *node = NULL;
+  GtkRBTree *old_tree;
+  GtkTreeIter child;
+  GList *list;
+  gboolean selection_changed = FALSE;
+  gint depth;
+
+  g_return_if_fail (parent != NULL);
+
+  gtk_tree_row_reference_children_reloaded (G_OBJECT (data), parent);
+
+  depth = gtk_tree_path_get_depth (parent);
+  if (depth == 0)
+    old_tree = tree_view->priv->tree;
+  else
+    {
+      if (_gtk_tree_view_find_node (tree_view, parent, &tree, &node))
+	return;
+      if (tree == NULL)
+	return;
+
+      old_tree = node->children;
+    }
+
+  gtk_tree_view_cancel_measure (tree_view);
+  gtk_tree_view_search_index_free (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
+
+  if (old_tree)
+    {
+      _gtk_rbtree_traverse (old_tree, old_tree->root, G_PRE_ORDER,
+			    any_selected_helper, &selection_changed);
+
+      for (list = tree_view->priv->columns; list; list = list->next)
+	if (((GtkTreeViewColumn *)list->data)->visible &&
+	    ((GtkTreeViewColumn *)list->data)->column_type == GTK_TREE_VIEW_COLUMN_AUTOSIZE)
+	  _gtk_tree_view_column_cell_set_dirty ((GtkTreeViewColumn *)list->data, TRUE);
+
+      ensure_unprelighted (tree_view);
+      gtk_tree_view_stop_editing (tree_view, TRUE);
+      remove_expand_collapse_timeout (tree_view);
+      cancel_arrow_animation (tree_view);
+
+      if (tree_view->priv->destroy_count_func)
+	{
+	  gint child_count = 0;
+	  _gtk_rbtree_traverse (old_tree, old_tree->root, G_POST_ORDER, count_children_helper, &child_count);
+	  tree_view->priv->destroy_count_func (tree_view, parent, child_count, tree_view->priv->destroy_count_data);
+	}
+
+      if (depth == 0)
+	gtk_tree_view_free_rbtree (tree_view);
+      else
+	_gtk_rbtree_remove (old_tree);
+    }
+
+  /* Build the new level.  A reloaded root is always shown; children of
+   * a row are only shown again if the row was expanded before.
+   */
+  if (depth == 0)
+    {
+      if (gtk_tree_model_iter_children (model, &child, NULL))
+	{
+	  tree_view->priv->tree = _gtk_rbtree_new ();
+	  gtk_tree_view_build_tree (tree_view, tree_view->priv->tree, &child, 1, FALSE);
+	}
+    }
+  else
+    {
+      if (old_tree && gtk_tree_model_iter_children (model, &child, iter))
+	{
+	  node->children = _gtk_rbtree_new ();
+	  node->children->parent_tree = tree;
+	  node->children->parent_node = node;
+	  gtk_tree_view_build_tree (tree_view, node->children, &child, depth + 1, FALSE);
+	}
+    }
+
+  if (! gtk_tree_row_reference_valid (tree_view->priv->top_row))
+    {
+      gtk_tree_row_reference_free (tree_view->priv->top_row);
+      tree_view->priv->top_row = NULL;
+    }
+
+  install_presize_handler (tree_view);
+  install_scroll_sync_handler (tree_view);
+
+  gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+
+  if (selection_changed)
+    g_signal_emit_by_name (tree_view->priv->selection, "changed");
+}
+
 
 /* Internal tree functions
  */
@@ -10642,6 +11673,9 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_rows_reordered,
 					    tree_view);
+      g_signal_handlers_disconnect_by_func (tree_view->priv->model,
+					    gtk_tree_view_children_reloaded,
+					    tree_view);
 
       for (; tmplist; tmplist = tmplist->next)
 	_gtk_tree_view_column_unset_model (tmplist->data,
@@ -10719,6 +11753,10 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"rows-reordered",
 			G_CALLBACK (gtk_tree_view_rows_reordered),
 			tree_view);
+      g_signal_connect (tree_view->priv->model,
+			"children-reloaded",
+			G_CALLBACK (gtk_tree_view_children_reloaded),
+			tree_view);
 
       flags = gtk_tree_model_get_flags (tree_view->priv->model);
       if ((flags & GTK_TREE_MODEL_LIST_ONLY) == GTK_TREE_MODEL_LIST_ONLY)
@@ -11027,6 +12065,7 @@ gtk_tree_view_set_rules_hint (GtkTreeView  *tree_view,
   if (tree_view->priv->has_rules != setting)
     {
       tree_view->priv->has_rules = setting;
+      _gtk_tree_view_reset_row_renders (tree_view);
       gtk_widget_queue_draw (GTK_WIDGET (tree_view));
     }
 
@@ -11134,6 +12173,7 @@ gtk_tree_view_remove_column (GtkTreeView       *tree_view,
     }
 
   g_object_unref (column);
+  _gtk_tree_view_reset_row_renders (tree_view);
   g_signal_emit (tree_view, tree_view_signals[COLUMNS_CHANGED], 0);
 
   return tree_view->priv->n_columns;
@@ -11198,6 +12238,7 @@ gtk_tree_view_insert_column (GtkTreeView       *tree_view,
       gtk_widget_queue_resize (GTK_WIDGET (tree_view));
     }
 
+  _gtk_tree_view_reset_row_renders (tree_view);
   g_signal_emit (tree_view, tree_view_signals[COLUMNS_CHANGED], 0);
 
   return tree_view->priv->n_columns;
@@ -11399,6 +12440,7 @@ gtk_tree_view_move_column_after (GtkTreeView       *tree_view,
       gtk_tree_view_size_allocate_columns (GTK_WIDGET (tree_view), NULL);
     }
 
+  _gtk_tree_view_reset_row_renders (tree_view);
   g_signal_emit (tree_view, tree_view_signals[COLUMNS_CHANGED], 0);
 }
 
@@ -11435,6 +12477,7 @@ gtk_tree_view_set_expander_column (GtkTreeView       *tree_view,
 	}
 
       tree_view->priv->expander_column = column;
+      _gtk_tree_view_reset_row_renders (tree_view);
       g_object_notify (G_OBJECT (tree_view), "expander-column");
     }
 }
@@ -12188,6 +13231,9 @@ gtk_tree_view_real_collapse_row (GtkTreeView *tree_view,
     }
 
   remove_expand_collapse_timeout (tree_view);
+  gtk_tree_view_cancel_measure (tree_view);
+  gtk_tree_view_search_index_free (tree_view);
+  _gtk_tree_view_reset_row_renders (tree_view);
 
   if (gtk_tree_view_unref_and_check_selection_tree (tree_view, node->children))
     {
@@ -13903,6 +14949,7 @@ gtk_tree_view_set_search_column (GtkTreeView *tree_view,
     return;
 
   tree_view->priv->search_column = column;
+  gtk_tree_view_search_index_free (tree_view);
   g_object_notify (G_OBJECT (tree_view), "search-column");
 }
 
@@ -13951,6 +14998,8 @@ gtk_tree_view_set_search_equal_func (GtkTreeView                *tree_view,
   tree_view->priv->search_destroy = search_destroy;
   if (tree_view->priv->search_equal_func == NULL)
     tree_view->priv->search_equal_func = gtk_tree_view_search_equal_func;
+
+  gtk_tree_view_search_index_free (tree_view);
 }
 
 /**
@@ -14110,6 +15159,8 @@ gtk_tree_view_search_dialog_hide (GtkWidget   *search_dialog,
       g_source_remove (tree_view->priv->typeselect_flush_timeout);
       tree_view->priv->typeselect_flush_timeout = 0;
     }
+
+  gtk_tree_view_search_index_free (tree_view);
 	
   if (GTK_WIDGET_VISIBLE (search_dialog))
     {
@@ -14426,19 +15477,32 @@ gtk_tree_view_search_move (GtkWidget   *window,
     }
 }
 
-static gboolean
-gtk_tree_view_search_equal_func (GtkTreeModel *model,
-				 gint          column,
-				 const gchar  *key,
-				 GtkTreeIter  *iter,
-				 gpointer      search_data)
+/* Returns the normalized, casefolded form of @str that the default
+ * search compares, or %NULL if @str is not valid UTF-8.
+ */
+static gchar *
+gtk_tree_view_search_fold (const gchar *str)
+{
+  gchar *normalized;
+  gchar *folded;
+
+  normalized = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
+  if (!normalized)
+    return NULL;
+
+  folded = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return folded;
+}
+
+static gchar *
+gtk_tree_view_search_fold_row (GtkTreeModel *model,
+			       gint          column,
+			       GtkTreeIter  *iter)
 {
-  gboolean retval = TRUE;
   const gchar *str;
-  gchar *normalized_string;
-  gchar *normalized_key;
-  gchar *case_normalized_string = NULL;
-  gchar *case_normalized_key = NULL;
+  gchar *folded = NULL;
   GValue value = {0,};
   GValue transformed = {0,};
 
@@ -14446,42 +15510,87 @@ gtk_tree_view_search_equal_func (GtkTreeModel *model,
 
   g_value_init (&transformed, G_TYPE_STRING);
 
-  if (!g_value_transform (&value, &transformed))
+  if (g_value_transform (&value, &transformed))
     {
-      g_value_unset (&value);
-      return TRUE;
+      str = g_value_get_string (&transformed);
+      if (str)
+	folded = gtk_tree_view_search_fold (str);
     }
 
   g_value_unset (&value);
+  g_value_unset (&transformed);
 
-  str = g_value_get_string (&transformed);
-  if (!str)
-    {
-      g_value_unset (&transformed);
-      return TRUE;
-    }
+  return folded;
+}
 
-  normalized_string = g_utf8_normalize (str, -1, G_NORMALIZE_ALL);
-  normalized_key = g_utf8_normalize (key, -1, G_NORMALIZE_ALL);
+static gboolean
+gtk_tree_view_search_equal_func (GtkTreeModel *model,
+				 gint          column,
+				 const gchar  *key,
+				 GtkTreeIter  *iter,
+				 gpointer      search_data)
+{
+  gboolean retval = TRUE;
+  gchar *case_normalized_string;
+  gchar *case_normalized_key;
 
-  if (normalized_string && normalized_key)
-    {
-      case_normalized_string = g_utf8_casefold (normalized_string, -1);
-      case_normalized_key = g_utf8_casefold (normalized_key, -1);
+  case_normalized_key = gtk_tree_view_search_fold (key);
+  if (!case_normalized_key)
+    return TRUE;
 
-      if (strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
-        retval = FALSE;
-    }
+  case_normalized_string = gtk_tree_view_search_fold_row (model, column, iter);
+
+  if (case_normalized_string &&
+      strncmp (case_normalized_key, case_normalized_string, strlen (case_normalized_key)) == 0)
+    retval = FALSE;
 
-  g_value_unset (&transformed);
-  g_free (normalized_key);
-  g_free (normalized_string);
   g_free (case_normalized_key);
   g_free (case_normalized_string);
 
   return retval;
 }
 
+/* While the default equal func is in use, the search does not call it
+ * but compares against the search index instead.  The index holds the
+ * casefolded string of each row visited so far, so typing another
+ * character does not fetch and fold the whole column again.  Entries
+ * are keyed by the row's node.  A row-changed drops one entry; anything
+ * that frees or reorders nodes drops the whole index, as does hiding
+ * the search dialog.
+ */
+static const gchar *
+gtk_tree_view_search_index_lookup (GtkTreeView *tree_view,
+				   GtkRBNode   *node,
+				   GtkTreeIter *iter)
+{
+  gpointer folded;
+
+  if (tree_view->priv->search_index == NULL)
+    tree_view->priv->search_index = g_hash_table_new_full (NULL, NULL,
+							   NULL, g_free);
+
+  if (!g_hash_table_lookup_extended (tree_view->priv->search_index,
+				     node, NULL, &folded))
+    {
+      folded = gtk_tree_view_search_fold_row (tree_view->priv->model,
+					      tree_view->priv->search_column,
+					      iter);
+      g_hash_table_insert (tree_view->priv->search_index, node, folded);
+    }
+
+  return folded;
+}
+
+static void
+gtk_tree_view_search_index_free (GtkTreeView *tree_view)
+{
+  if (tree_view->priv->search_index)
+    {
+      g_hash_table_destroy (tree_view->priv->search_index);
+      tree_view->priv->search_index = NULL;
+    }
+}
+
 static gboolean
 gtk_tree_view_search_iter (GtkTreeModel     *model,
 			   GtkTreeSelection *selection,
@@ -14493,15 +15602,39 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
   GtkRBTree *tree = NULL;
   GtkRBNode *node = NULL;
   GtkTreePath *path;
+  gboolean use_index;
+  gchar *folded_text = NULL;
+  gsize folded_len = 0;
+  gboolean match;
 
   GtkTreeView *tree_view = gtk_tree_selection_get_tree_view (selection);
 
   path = gtk_tree_model_get_path (model, iter);
   _gtk_tree_view_find_node (tree_view, path, &tree, &node);
 
+  use_index = tree_view->priv->search_equal_func == gtk_tree_view_search_equal_func;
+  if (use_index)
+    {
+      folded_text = gtk_tree_view_search_fold (text);
+      if (folded_text)
+	folded_len = strlen (folded_text);
+    }
+
   do
     {
-      if (! tree_view->priv->search_equal_func (model, tree_view->priv->search_column, text, iter, tree_view->priv->search_user_data))
+      if (use_index)
+	{
+	  const gchar *folded = NULL;
+
+	  if (folded_text)
+	    folded = gtk_tree_view_search_index_lookup (tree_view, node, iter);
+
+	  match = folded && strncmp (folded_text, folded, folded_len) == 0;
+	}
+      else
+	match = ! tree_view->priv->search_equal_func (model, tree_view->priv->search_column, text, iter, tree_view->priv->search_user_data);
+
+      if (match)
         {
           (*count)++;
           if (*count == n)
@@ -14513,6 +15646,7 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
 
 	      if (path)
 		gtk_tree_path_free (path);
+	      g_free (folded_text);
 
               return TRUE;
             }
@@ -14568,6 +15702,7 @@ gtk_tree_view_search_iter (GtkTreeModel     *model,
 		    {
 		      if (path)
 			gtk_tree_path_free (path);
+		      g_free (folded_text);
 
 		      /* we've run out of tree, done with this func */
 		      return FALSE;
@@ -15015,6 +16150,8 @@ gtk_tree_view_set_row_separator_func (GtkTreeView                 *tree_view,
   tree_view->priv->row_separator_data = data;
   tree_view->priv->row_separator_destroy = destroy;
 
+  _gtk_tree_view_reset_row_renders (tree_view);
+
   /* Have the tree recalculate heights */
   _gtk_rbtree_mark_invalid (tree_view->priv->tree);
   gtk_widget_queue_resize (GTK_WIDGET (tree_view));
@@ -15097,6 +16234,9 @@ gtk_tree_view_set_grid_lines (GtkTreeView           *tree_view,
 
   old_grid_lines = priv->grid_lines;
   priv->grid_lines = grid_lines;
+
+  if (old_grid_lines != grid_lines)
+    _gtk_tree_view_reset_row_renders (tree_view);
   
   if (GTK_WIDGET_REALIZED (widget))
     {
@@ -15256,7 +16396,10 @@ gtk_tree_view_set_show_expanders (GtkTreeView *tree_view,
     GTK_TREE_VIEW_UNSET_FLAG (tree_view, GTK_TREE_VIEW_SHOW_EXPANDERS);
 
   if (enabled != was_enabled)
-    gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+    {
+      _gtk_tree_view_reset_row_renders (tree_view);
+      gtk_widget_queue_draw (GTK_WIDGET (tree_view));
+    }
 }
 
 /**
@@ -15297,6 +16440,7 @@ gtk_tree_view_set_level_indentation (GtkTreeView *tree_view,
 {
   tree_view->priv->level_indentation = indentation;
 
+  _gtk_tree_view_reset_row_renders (tree_view);
   gtk_widget_queue_draw (GTK_WIDGET (tree_view));
 }
 
@@ -2467,6 +2467,8 @@ gtk_tree_view_column_set_sort_indicator (GtkTreeViewColumn     *tree_column,
     return;
 
   tree_column->show_sort_indicator = setting;
+  if (tree_column->tree_view)
+    _gtk_tree_view_reset_row_renders (GTK_TREE_VIEW (tree_column->tree_view));
   gtk_tree_view_column_update_button (tree_column);
   g_object_notify (G_OBJECT (tree_column), "sort-indicator");
 }
@@ -2659,6 +2661,80 @@ gtk_tree_view_column_cell_get_size (GtkTreeViewColumn  *tree_column,
     }
 }
 
+/* Like gtk_tree_view_column_cell_get_size() with the cell data of a
+ * row, in two steps: the sizes of the cells are stored in @sizes,
+ * which needs room for one entry per cell, and combined later by
+ * _gtk_tree_view_column_cell_get_measured_size(). The text cells are
+ * only prepared for measuring in between.
+ */
+void
+_gtk_tree_view_column_cell_measure (GtkTreeViewColumn   *tree_column,
+				    GtkTreeViewCellSize *sizes)
+{
+  GList *list;
+
+  for (list = tree_column->cell_list; list; list = list->next, sizes++)
+    {
+      GtkTreeViewColumnCellInfo *info = (GtkTreeViewColumnCellInfo *) list->data;
+
+      g_object_get (info->cell, "visible", &sizes->visible, NULL);
+
+      sizes->width = 0;
+      sizes->height = 0;
+      sizes->measure = NULL;
+
+      if (sizes->visible == FALSE)
+	continue;
+
+      sizes->measure = _gtk_cell_renderer_text_measure_new (info->cell,
+							    tree_column->tree_view);
+      if (sizes->measure == NULL)
+	gtk_cell_renderer_get_size (info->cell,
+				    tree_column->tree_view,
+				    NULL, NULL, NULL,
+				    &sizes->width,
+				    &sizes->height);
+    }
+}
+
+void
+_gtk_tree_view_column_cell_get_measured_size (GtkTreeViewColumn   *tree_column,
+					      GtkTreeViewCellSize *sizes,
+					      gint                *width,
+					      gint                *height)
+{
+  GList *list;
+  gboolean first_cell = TRUE;
+  gint focus_line_width;
+
+  *height = 0;
+  *width = 0;
+
+  gtk_widget_style_get (tree_column->tree_view, "focus-line-width", &focus_line_width, NULL);
+
+  for (list = tree_column->cell_list; list; list = list->next, sizes++)
+    {
+      GtkTreeViewColumnCellInfo *info = (GtkTreeViewColumnCellInfo *) list->data;
+      gint new_width = sizes->width;
+      gint new_height = sizes->height;
+
+      if (sizes->visible == FALSE)
+	continue;
+
+      if (first_cell == FALSE)
+	*width += tree_column->spacing;
+
+      if (sizes->measure)
+	_gtk_cell_renderer_text_measure_get_size (sizes->measure,
+						  &new_width, &new_height);
+
+      *height = MAX (*height, new_height + focus_line_width * 2);
+      info->requested_width = MAX (info->requested_width, new_width + focus_line_width * 2);
+      *width += info->requested_width;
+      first_cell = FALSE;
+    }
+}
+
 /* rendering, event handling and rendering focus are somewhat complicated, and
  * quite a bit of code.  Rather than duplicate them, we put them together to
  * keep the code in one place.
@@ -3620,6 +3696,8 @@ _gtk_tree_view_column_cell_set_dirty (GtkTreeViewColumn *tree_column,
   if (tree_column->tree_view &&
       GTK_WIDGET_REALIZED (tree_column->tree_view))
     {
+      _gtk_tree_view_reset_row_renders (GTK_TREE_VIEW (tree_column->tree_view));
+
       if (install_handler)
 	_gtk_tree_view_install_mark_rows_col_dirty (GTK_TREE_VIEW (tree_column->tree_view));
       else
@@ -0,0 +1,769 @@
+/* GtkColumnStore tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* Unlike GtkListStore, a GtkColumnStore moves its rows around in the
+ * column arrays, so iters only survive appends. The tests therefore
+ * check the contents of the store by value, and record the signals
+ * that are emitted as a string.
+ */
+
+#include <string.h>
+#include <gtk/gtk.h>
+
+enum
+{
+  COLUMN_ID,
+  COLUMN_NAME
+};
+
+/*
+ * Signal log
+ */
+
+static void
+log_row_inserted (GtkTreeModel *model,
+                  GtkTreePath  *path,
+                  GtkTreeIter  *iter,
+                  GString      *log)
+{
+  gchar *str = gtk_tree_path_to_string (path);
+
+  g_string_append_printf (log, "inserted %s;", str);
+  g_free (str);
+}
+
+static void
+log_row_deleted (GtkTreeModel *model,
+                 GtkTreePath  *path,
+                 GString      *log)
+{
+  gchar *str = gtk_tree_path_to_string (path);
+
+  g_string_append_printf (log, "deleted %s;", str);
+  g_free (str);
+}
+
+static void
+log_row_changed (GtkTreeModel *model,
+                 GtkTreePath  *path,
+                 GtkTreeIter  *iter,
+                 GString      *log)
+{
+  gchar *str = gtk_tree_path_to_string (path);
+
+  g_string_append_printf (log, "changed %s;", str);
+  g_free (str);
+}
+
+static void
+log_rows_reordered (GtkTreeModel *model,
+                    GtkTreePath  *path,
+                    GtkTreeIter  *iter,
+                    gint         *new_order,
+                    GString      *log)
+{
+  gint i;
+
+  g_assert_cmpint (gtk_tree_path_get_depth (path), ==, 0);
+  g_assert (iter == NULL);
+
+  g_string_append (log, "reordered");
+  for (i = 0; i < gtk_tree_model_iter_n_children (model, NULL); i++)
+    g_string_append_printf (log, " %d", new_order[i]);
+  g_string_append (log, ";");
+}
+
+/*
+ * Fixture
+ */
+typedef struct
+{
+  GtkColumnStore *store;
+  GString *log;
+} ColumnStore;
+
+static void
+column_store_setup (ColumnStore   *fixture,
+                    gconstpointer  test_data)
+{
+  GtkTreeIter iter;
+  gchar *name;
+  int i;
+
+  fixture->store = gtk_column_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+
+  for (i = 0; i < 5; i++)
+    {
+      name = g_strdup_printf ("row %d", i);
+      gtk_column_store_insert (fixture->store, &iter, i);
+      gtk_column_store_set (fixture->store, &iter,
+                            COLUMN_ID, i,
+                            COLUMN_NAME, name,
+                            -1);
+      g_free (name);
+    }
+
+  fixture->log = g_string_new (NULL);
+
+  g_signal_connect (fixture->store, "row-inserted",
+                    G_CALLBACK (log_row_inserted), fixture->log);
+  g_signal_connect (fixture->store, "row-deleted",
+                    G_CALLBACK (log_row_deleted), fixture->log);
+  g_signal_connect (fixture->store, "row-changed",
+                    G_CALLBACK (log_row_changed), fixture->log);
+  g_signal_connect (fixture->store, "rows-reordered",
+                    G_CALLBACK (log_rows_reordered), fixture->log);
+}
+
+static void
+column_store_teardown (ColumnStore   *fixture,
+                       gconstpointer  test_data)
+{
+  g_object_unref (fixture->store);
+  g_string_free (fixture->log, TRUE);
+}
+
+/* Checks the ids of the rows, given as a string like "0 1 2" */
+static void
+check_ids (GtkColumnStore *store,
+           const gchar    *expected)
+{
+  GtkTreeIter iter;
+  GString *ids;
+  gboolean valid;
+  gint id;
+
+  ids = g_string_new (NULL);
+
+  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  while (valid)
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_ID, &id, -1);
+      g_string_append_printf (ids, ids->len ? " %d" : "%d", id);
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter);
+    }
+
+  g_assert_cmpstr (ids->str, ==, expected);
+  g_string_free (ids, TRUE);
+}
+
+/* Checks that the names moved along with the ids */
+static void
+check_names (GtkColumnStore *store)
+{
+  GtkTreeIter iter;
+  gchar *name, *expected;
+  gboolean valid;
+  gint id;
+
+  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  while (valid)
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                          COLUMN_ID, &id,
+                          COLUMN_NAME, &name,
+                          -1);
+
+      expected = g_strdup_printf ("row %d", id);
+      g_assert_cmpstr (name, ==, expected);
+      g_free (expected);
+      g_free (name);
+
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter);
+    }
+}
+
+static void
+check_log (ColumnStore *fixture,
+           const gchar *expected)
+{
+  g_assert_cmpstr (fixture->log->str, ==, expected);
+  g_string_truncate (fixture->log, 0);
+}
+
+static gint
+iter_position (GtkColumnStore *store,
+               GtkTreeIter    *iter)
+{
+  GtkTreePath *path;
+  gint n;
+
+  g_assert (gtk_column_store_iter_is_valid (store, iter));
+
+  path = gtk_tree_model_get_path (GTK_TREE_MODEL (store), iter);
+  n = gtk_tree_path_get_indices (path)[0];
+  gtk_tree_path_free (path);
+
+  return n;
+}
+
+static void
+get_nth (GtkColumnStore *store,
+         GtkTreeIter    *iter,
+         gint            n)
+{
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), iter, NULL, n));
+}
+
+/*
+ * The actual tests.
+ */
+
+/* insertion */
+static void
+column_store_test_insert (ColumnStore   *fixture,
+                          gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+
+  gtk_column_store_prepend (fixture->store, &iter);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 0);
+  gtk_column_store_set (fixture->store, &iter, COLUMN_ID, -1, -1);
+  check_log (fixture, "inserted 0;changed 0;");
+
+  gtk_column_store_insert (fixture->store, &iter, 3);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 3);
+  gtk_column_store_set (fixture->store, &iter, COLUMN_ID, -2, -1);
+  check_log (fixture, "inserted 3;changed 3;");
+
+  gtk_column_store_append (fixture->store, &iter);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 7);
+  gtk_column_store_set (fixture->store, &iter, COLUMN_ID, -3, -1);
+  check_log (fixture, "inserted 7;changed 7;");
+
+  /* Positions past the end append */
+  gtk_column_store_insert (fixture->store, &iter, 100);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 8);
+  gtk_column_store_set (fixture->store, &iter, COLUMN_ID, -4, -1);
+  check_log (fixture, "inserted 8;changed 8;");
+
+  /* Only row-inserted, with the values already set */
+  gtk_column_store_insert_with_values (fixture->store, &iter, 1,
+                                       COLUMN_ID, 5,
+                                       COLUMN_NAME, "row 5",
+                                       -1);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 1);
+  check_log (fixture, "inserted 1;");
+
+  check_ids (fixture->store, "-1 5 0 1 -2 2 3 4 -3 -4");
+}
+
+/* removal */
+static void
+column_store_test_remove (ColumnStore   *fixture,
+                          gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+
+  get_nth (fixture->store, &iter, 0);
+  g_assert (gtk_column_store_remove (fixture->store, &iter));
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 0);
+  check_log (fixture, "deleted 0;");
+  check_ids (fixture->store, "1 2 3 4");
+
+  get_nth (fixture->store, &iter, 1);
+  g_assert (gtk_column_store_remove (fixture->store, &iter));
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 1);
+  check_log (fixture, "deleted 1;");
+  check_ids (fixture->store, "1 3 4");
+
+  /* Removing the last row invalidates the iter */
+  get_nth (fixture->store, &iter, 2);
+  g_assert (!gtk_column_store_remove (fixture->store, &iter));
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+  check_log (fixture, "deleted 2;");
+  check_ids (fixture->store, "1 3");
+
+  gtk_column_store_clear (fixture->store);
+  check_log (fixture, "deleted 1;deleted 0;");
+  check_ids (fixture->store, "");
+}
+
+/* reordering */
+static void
+column_store_test_reorder (ColumnStore   *fixture,
+                           gconstpointer  user_data)
+{
+  gint new_order[5] = { 4, 1, 0, 2, 3 };
+
+  gtk_column_store_reorder (fixture->store, new_order);
+  check_log (fixture, "reordered 4 1 0 2 3;");
+  check_ids (fixture->store, "4 1 0 2 3");
+  check_names (fixture->store);
+}
+
+static void
+column_store_test_swap (ColumnStore   *fixture,
+                        gconstpointer  user_data)
+{
+  GtkTreeIter a, b;
+
+  get_nth (fixture->store, &a, 0);
+  get_nth (fixture->store, &b, 3);
+  gtk_column_store_swap (fixture->store, &a, &b);
+  check_log (fixture, "reordered 3 1 2 0 4;");
+  check_ids (fixture->store, "3 1 2 0 4");
+
+  check_names (fixture->store);
+
+  /* The iters follow their rows */
+  g_assert_cmpint (iter_position (fixture->store, &a), ==, 3);
+  g_assert_cmpint (iter_position (fixture->store, &b), ==, 0);
+
+  /* Swapping a row with itself does nothing */
+  gtk_column_store_swap (fixture->store, &a, &a);
+  check_log (fixture, "");
+}
+
+static void
+column_store_test_move (ColumnStore   *fixture,
+                        gconstpointer  user_data)
+{
+  GtkTreeIter iter, position;
+
+  /* Down, before a row */
+  get_nth (fixture->store, &iter, 1);
+  get_nth (fixture->store, &position, 3);
+  gtk_column_store_move_before (fixture->store, &iter, &position);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 2);
+  check_log (fixture, "reordered 0 2 1 3 4;");
+  check_ids (fixture->store, "0 2 1 3 4");
+
+  /* Up, before a row */
+  get_nth (fixture->store, &iter, 4);
+  get_nth (fixture->store, &position, 0);
+  gtk_column_store_move_before (fixture->store, &iter, &position);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 0);
+  check_log (fixture, "reordered 4 0 1 2 3;");
+  check_ids (fixture->store, "4 0 2 1 3");
+
+  /* To the end */
+  get_nth (fixture->store, &iter, 0);
+  gtk_column_store_move_before (fixture->store, &iter, NULL);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 4);
+  check_log (fixture, "reordered 1 2 3 4 0;");
+  check_ids (fixture->store, "0 2 1 3 4");
+
+  /* Down, after a row */
+  get_nth (fixture->store, &iter, 0);
+  get_nth (fixture->store, &position, 2);
+  gtk_column_store_move_after (fixture->store, &iter, &position);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 2);
+  check_log (fixture, "reordered 1 2 0 3 4;");
+  check_ids (fixture->store, "2 1 0 3 4");
+
+  /* Up, after a row */
+  get_nth (fixture->store, &iter, 4);
+  get_nth (fixture->store, &position, 1);
+  gtk_column_store_move_after (fixture->store, &iter, &position);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 2);
+  check_log (fixture, "reordered 0 1 4 2 3;");
+  check_ids (fixture->store, "2 1 4 0 3");
+
+  /* To the start */
+  get_nth (fixture->store, &iter, 3);
+  gtk_column_store_move_after (fixture->store, &iter, NULL);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 0);
+  check_log (fixture, "reordered 3 0 1 2 4;");
+  check_ids (fixture->store, "0 2 1 4 3");
+
+  /* Onto itself */
+  get_nth (fixture->store, &iter, 2);
+  position = iter;
+  gtk_column_store_move_before (fixture->store, &iter, &position);
+  check_log (fixture, "");
+  check_ids (fixture->store, "0 2 1 4 3");
+  check_names (fixture->store);
+}
+
+/* iters */
+static void
+column_store_test_iter_stamps (ColumnStore   *fixture,
+                               gconstpointer  user_data)
+{
+  GtkTreeIter iter, other;
+  gint *new_order;
+  gint id, i, n;
+
+  /* Appending does not move any row */
+  get_nth (fixture->store, &iter, 3);
+  gtk_column_store_append (fixture->store, &other);
+  gtk_column_store_insert_with_values (fixture->store, &other, -1,
+                                       COLUMN_ID, 6, -1);
+  g_assert (gtk_column_store_iter_is_valid (fixture->store, &iter));
+  gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, COLUMN_ID, &id, -1);
+  g_assert_cmpint (id, ==, 3);
+
+  /* Neither does changing a value of an unsorted store */
+  gtk_column_store_set (fixture->store, &other, COLUMN_ID, 7, -1);
+  g_assert (gtk_column_store_iter_is_valid (fixture->store, &iter));
+
+  /* Inserting before it does */
+  gtk_column_store_insert (fixture->store, &other, 1);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+  g_assert (gtk_column_store_iter_is_valid (fixture->store, &other));
+
+  get_nth (fixture->store, &iter, 3);
+  gtk_column_store_insert_with_values (fixture->store, &other, 0,
+                                       COLUMN_ID, 8, -1);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+
+  /* Removing */
+  get_nth (fixture->store, &iter, 3);
+  get_nth (fixture->store, &other, 5);
+  gtk_column_store_remove (fixture->store, &other);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+
+  /* Moving */
+  get_nth (fixture->store, &iter, 3);
+  get_nth (fixture->store, &other, 0);
+  gtk_column_store_move_before (fixture->store, &other, NULL);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+  g_assert (gtk_column_store_iter_is_valid (fixture->store, &other));
+
+  n = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), NULL);
+  new_order = g_new (gint, n);
+  for (i = 0; i < n; i++)
+    new_order[i] = n - 1 - i;
+
+  get_nth (fixture->store, &iter, 3);
+  gtk_column_store_reorder (fixture->store, new_order);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+  g_free (new_order);
+
+  /* Sorting */
+  get_nth (fixture->store, &iter, 3);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_ID, GTK_SORT_ASCENDING);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+
+  /* Clearing */
+  get_nth (fixture->store, &iter, 0);
+  gtk_column_store_clear (fixture->store);
+  g_assert (!gtk_column_store_iter_is_valid (fixture->store, &iter));
+}
+
+/* sorting */
+static gint
+compare_ids_reversed (GtkTreeModel *model,
+                      GtkTreeIter  *a,
+                      GtkTreeIter  *b,
+                      gpointer      data)
+{
+  gint id_a, id_b;
+
+  gtk_tree_model_get (model, a, COLUMN_ID, &id_a, -1);
+  gtk_tree_model_get (model, b, COLUMN_ID, &id_b, -1);
+
+  return id_b - id_a;
+}
+
+static void
+column_store_test_sort (ColumnStore   *fixture,
+                        gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+  gint i, collate;
+
+  /* Names with ties, case differences and no name at all */
+  const gchar *names[] = { "beta", NULL, "Alpha", "beta", "alpha" };
+
+  gtk_column_store_clear (fixture->store);
+  for (i = 0; i < 5; i++)
+    gtk_column_store_insert_with_values (fixture->store, NULL, -1,
+                                         COLUMN_ID, i,
+                                         COLUMN_NAME, names[i],
+                                         -1);
+  g_string_truncate (fixture->log, 0);
+
+  collate = g_utf8_collate ("alpha", "Alpha");
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_ID, GTK_SORT_DESCENDING);
+  check_log (fixture, "reordered 4 3 2 1 0;");
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_ID, GTK_SORT_ASCENDING);
+  check_log (fixture, "reordered 4 3 2 1 0;");
+
+  /* The string keys: NULL sorts as "", and ties keep their order */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_NAME, GTK_SORT_ASCENDING);
+  if (collate < 0)
+    check_log (fixture, "reordered 1 4 2 0 3;");
+  else
+    check_log (fixture, "reordered 1 2 4 0 3;");
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_ID, GTK_SORT_ASCENDING);
+  g_string_truncate (fixture->log, 0);
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_NAME, GTK_SORT_DESCENDING);
+  if (collate > 0)
+    check_log (fixture, "reordered 0 3 4 2 1;");
+  else
+    check_log (fixture, "reordered 0 3 2 4 1;");
+
+  /* A compare function of our own */
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (fixture->store),
+                                   COLUMN_ID, compare_ids_reversed,
+                                   NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        COLUMN_ID, GTK_SORT_ASCENDING);
+  check_ids (fixture->store, "4 3 2 1 0");
+  g_string_truncate (fixture->log, 0);
+
+  /* New rows go to their sorted position right away, after their ties */
+  gtk_column_store_insert_with_values (fixture->store, &iter, 0,
+                                       COLUMN_ID, 2, -1);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 3);
+  check_log (fixture, "inserted 3;");
+
+  /* Changed rows move */
+  gtk_column_store_set (fixture->store, &iter, COLUMN_ID, 10, -1);
+  g_assert_cmpint (iter_position (fixture->store, &iter), ==, 0);
+  check_log (fixture, "changed 3;reordered 3 0 1 2 4 5;");
+  check_ids (fixture->store, "10 4 3 2 1 0");
+}
+
+/* strings */
+static void
+column_store_test_string_compaction (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  gchar *name, *expected;
+  gint i, round;
+
+  store = gtk_column_store_new (2, G_TYPE_INT, G_TYPE_STRING);
+
+  for (i = 0; i < 200; i++)
+    gtk_column_store_insert_with_values (store, NULL, -1, COLUMN_ID, i, -1);
+
+  /* Overwrite and remove strings until most of the arena is garbage
+   * several times over, so that it is compacted more than once.
+   */
+  for (round = 0; round < 50; round++)
+    {
+      for (i = 0; i < 200; i++)
+        {
+          name = g_strdup_printf ("%d %d %0*d", round, i, 100 + i % 50, 0);
+          get_nth (store, &iter, i);
+          gtk_column_store_set (store, &iter, COLUMN_NAME, name, -1);
+          g_free (name);
+        }
+
+      get_nth (store, &iter, round % 200);
+      gtk_column_store_remove (store, &iter);
+      gtk_column_store_insert_with_values (store, NULL, round % 200,
+                                           COLUMN_ID, round % 200 + 1000,
+                                           COLUMN_NAME, "reinserted",
+                                           -1);
+
+      for (i = 0; i < 200; i++)
+        {
+          get_nth (store, &iter, i);
+          gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                              COLUMN_NAME, &name, -1);
+
+          if (i == round % 200)
+            expected = g_strdup ("reinserted");
+          else
+            expected = g_strdup_printf ("%d %d %0*d", round, i, 100 + i % 50, 0);
+
+          g_assert_cmpstr (name, ==, expected);
+          g_free (name);
+          g_free (expected);
+        }
+    }
+
+  /* Setting NULL frees the string */
+  get_nth (store, &iter, 0);
+  gtk_column_store_set (store, &iter, COLUMN_NAME, NULL, -1);
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, COLUMN_NAME, &name, -1);
+  g_assert (name == NULL);
+
+  g_object_unref (store);
+}
+
+/* values */
+static void
+column_store_test_values (void)
+{
+  GtkColumnStore *store;
+  GtkTreeIter iter;
+  GObject *object, *object_out;
+  GdkColor color = { 0, 1, 2, 3 }, *color_out;
+  gboolean v_boolean;
+  gchar v_char;
+  guchar v_uchar;
+  gint v_int;
+  guint v_uint;
+  glong v_long;
+  gulong v_ulong;
+  gint64 v_int64;
+  guint64 v_uint64;
+  gfloat v_float;
+  gdouble v_double;
+  GtkSortType v_enum;
+  GtkAttachOptions v_flags;
+  gchar *v_string;
+  gpointer v_pointer;
+
+  store = gtk_column_store_new (17,
+                                G_TYPE_BOOLEAN,
+                                G_TYPE_CHAR,
+                                G_TYPE_UCHAR,
+                                G_TYPE_INT,
+                                G_TYPE_UINT,
+                                G_TYPE_LONG,
+                                G_TYPE_ULONG,
+                                G_TYPE_INT64,
+                                G_TYPE_UINT64,
+                                G_TYPE_FLOAT,
+                                G_TYPE_DOUBLE,
+                                GTK_TYPE_SORT_TYPE,
+                                GTK_TYPE_ATTACH_OPTIONS,
+                                G_TYPE_STRING,
+                                G_TYPE_POINTER,
+                                G_TYPE_OBJECT,
+                                GDK_TYPE_COLOR);
+
+  object = g_object_new (G_TYPE_OBJECT, NULL);
+
+  gtk_column_store_insert_with_values (store, &iter, 0,
+                                       0, TRUE,
+                                       1, -5,
+                                       2, 250,
+                                       3, G_MININT,
+                                       4, G_MAXUINT,
+                                       5, G_MINLONG,
+                                       6, G_MAXULONG,
+                                       7, G_MININT64,
+                                       8, G_MAXUINT64,
+                                       9, 1.5f,
+                                       10, -2.25,
+                                       11, GTK_SORT_DESCENDING,
+                                       12, GTK_EXPAND | GTK_FILL,
+                                       13, "string",
+                                       14, &color,
+                                       15, object,
+                                       16, &color,
+                                       -1);
+
+  /* The store holds a reference and a copy */
+  g_assert_cmpint (object->ref_count, ==, 2);
+
+  gtk_tree_model_get (GTK_TREE_MODEL (store), &iter,
+                      0, &v_boolean,
+                      1, &v_char,
+                      2, &v_uchar,
+                      3, &v_int,
+                      4, &v_uint,
+                      5, &v_long,
+                      6, &v_ulong,
+                      7, &v_int64,
+                      8, &v_uint64,
+                      9, &v_float,
+                      10, &v_double,
+                      11, &v_enum,
+                      12, &v_flags,
+                      13, &v_string,
+                      14, &v_pointer,
+                      15, &object_out,
+                      16, &color_out,
+                      -1);
+
+  g_assert (v_boolean == TRUE);
+  g_assert_cmpint (v_char, ==, -5);
+  g_assert_cmpint (v_uchar, ==, 250);
+  g_assert_cmpint (v_int, ==, G_MININT);
+  g_assert_cmpuint (v_uint, ==, G_MAXUINT);
+  g_assert (v_long == G_MINLONG);
+  g_assert (v_ulong == G_MAXULONG);
+  g_assert (v_int64 == G_MININT64);
+  g_assert (v_uint64 == G_MAXUINT64);
+  g_assert_cmpfloat (v_float, ==, 1.5f);
+  g_assert_cmpfloat (v_double, ==, -2.25);
+  g_assert_cmpint (v_enum, ==, GTK_SORT_DESCENDING);
+  g_assert_cmpint (v_flags, ==, GTK_EXPAND | GTK_FILL);
+  g_assert_cmpstr (v_string, ==, "string");
+  g_assert (v_pointer == &color);
+  g_assert (object_out == object);
+  g_assert (color_out != &color);
+  g_assert (gdk_color_equal (color_out, &color));
+
+  g_free (v_string);
+  g_object_unref (object_out);
+  gdk_color_free (color_out);
+
+  /* Overwriting and removing release the object */
+  gtk_column_store_set (store, &iter, 15, NULL, -1);
+  g_assert_cmpint (object->ref_count, ==, 1);
+
+  gtk_column_store_set (store, &iter, 15, object, -1);
+  g_assert_cmpint (object->ref_count, ==, 2);
+
+  gtk_column_store_remove (store, &iter);
+  g_assert_cmpint (object->ref_count, ==, 1);
+
+  g_object_unref (object);
+  g_object_unref (store);
+}
+
+/* main */
+
+int
+main (int    argc,
+      char **argv)
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add ("/column-store/insert", ColumnStore, NULL,
+              column_store_setup, column_store_test_insert,
+              column_store_teardown);
+  g_test_add ("/column-store/remove", ColumnStore, NULL,
+              column_store_setup, column_store_test_remove,
+              column_store_teardown);
+
+  g_test_add ("/column-store/reorder", ColumnStore, NULL,
+              column_store_setup, column_store_test_reorder,
+              column_store_teardown);
+  g_test_add ("/column-store/swap", ColumnStore, NULL,
+              column_store_setup, column_store_test_swap,
+              column_store_teardown);
+  g_test_add ("/column-store/move", ColumnStore, NULL,
+              column_store_setup, column_store_test_move,
+              column_store_teardown);
+
+  g_test_add ("/column-store/iter-stamps", ColumnStore, NULL,
+              column_store_setup, column_store_test_iter_stamps,
+              column_store_teardown);
+
+  g_test_add ("/column-store/sort", ColumnStore, NULL,
+              column_store_setup, column_store_test_sort,
+              column_store_teardown);
+
+  g_test_add_func ("/column-store/string-compaction",
+                   column_store_test_string_compaction);
+  g_test_add_func ("/column-store/values",
+                   column_store_test_values);
+
+  return g_test_run ();
+}
@@ -2821,6 +2821,184 @@ specific_bug_549287 (void)
     }
 }
 
+/* The visible nodes of each level are indexed. Check the index against
+ * a walk over the child model after visibility changes, inserts,
+ * removals and reorders, in levels long enough for the index to matter.
+ */
+
+static void
+check_visible_index (GtkTreeModel *filter,
+                     GtkTreeModel *child,
+                     GtkTreeIter  *child_parent,
+                     GtkTreeIter  *filter_parent)
+{
+  GtkTreeIter child_iter, filter_iter, converted;
+  GtkTreePath *path, *expected;
+  gboolean visible;
+  gint i, n_visible = 0;
+
+  if (!gtk_tree_model_iter_children (child, &child_iter, child_parent))
+    {
+      g_assert_cmpint (gtk_tree_model_iter_n_children (filter, filter_parent), ==, 0);
+      return;
+    }
+
+  do
+    {
+      gtk_tree_model_get (child, &child_iter, 0, &visible, -1);
+      if (!visible)
+        continue;
+
+      g_assert (gtk_tree_model_iter_nth_child (filter, &filter_iter,
+                                               filter_parent, n_visible));
+
+      gtk_tree_model_filter_convert_iter_to_child_iter (GTK_TREE_MODEL_FILTER (filter),
+                                                        &converted, &filter_iter);
+      path = gtk_tree_model_get_path (child, &converted);
+      expected = gtk_tree_model_get_path (child, &child_iter);
+      g_assert (gtk_tree_path_compare (path, expected) == 0);
+      gtk_tree_path_free (path);
+      gtk_tree_path_free (expected);
+
+      path = gtk_tree_model_get_path (filter, &filter_iter);
+      i = gtk_tree_path_get_depth (path);
+      g_assert_cmpint (gtk_tree_path_get_indices (path)[i - 1], ==, n_visible);
+      gtk_tree_path_free (path);
+
+      check_visible_index (filter, child, &child_iter, &filter_iter);
+
+      n_visible++;
+    }
+  while (gtk_tree_model_iter_next (child, &child_iter));
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (filter, filter_parent), ==, n_visible);
+  g_assert (!gtk_tree_model_iter_nth_child (filter, &filter_iter,
+                                            filter_parent, n_visible));
+}
+
+/* Picks a random row, and returns its parent in @parent, or %NULL for
+ * the root level
+ */
+static gboolean
+random_row (GtkTreeStore *store,
+            GtkTreeIter  *iter,
+            GtkTreeIter  *parent_iter,
+            GtkTreeIter **parent)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  gint n;
+
+  *parent = NULL;
+
+  n = gtk_tree_model_iter_n_children (model, NULL);
+  if (n == 0)
+    return FALSE;
+
+  gtk_tree_model_iter_nth_child (model, iter, NULL, g_test_rand_int_range (0, n));
+
+  n = gtk_tree_model_iter_n_children (model, iter);
+  if (n > 0 && g_test_rand_bit ())
+    {
+      *parent_iter = *iter;
+      *parent = parent_iter;
+      gtk_tree_model_iter_nth_child (model, iter, *parent, g_test_rand_int_range (0, n));
+    }
+
+  return TRUE;
+}
+
+static void
+visible_index_random_operations (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *filter;
+  GtkWidget *tree_view;
+  GtkTreeIter iter, parent_iter, child_iter, *parent;
+  gboolean visible;
+  gint *new_order;
+  gint i, j, n;
+
+  store = gtk_tree_store_new (1, G_TYPE_BOOLEAN);
+
+  for (i = 0; i < 300; i++)
+    {
+      gtk_tree_store_insert_with_values (store, &iter, NULL, -1,
+                                         0, g_test_rand_bit (), -1);
+      if (i % 10 == 0)
+        for (j = 0; j < 300; j++)
+          gtk_tree_store_insert_with_values (store, &child_iter, &iter, -1,
+                                             0, g_test_rand_bit (), -1);
+    }
+
+  filter = gtk_tree_model_filter_new (GTK_TREE_MODEL (store), NULL);
+  gtk_tree_model_filter_set_visible_column (GTK_TREE_MODEL_FILTER (filter), 0);
+
+  /* Keep all levels of the filter model alive */
+  tree_view = gtk_tree_view_new_with_model (filter);
+  gtk_tree_view_expand_all (GTK_TREE_VIEW (tree_view));
+
+  check_visible_index (filter, GTK_TREE_MODEL (store), NULL, NULL);
+
+  for (i = 0; i < 500; i++)
+    {
+      switch (g_test_rand_int_range (0, 4))
+        {
+        case 0:
+          /* Toggle visibility */
+          if (!random_row (store, &iter, &parent_iter, &parent))
+            break;
+          gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &visible, -1);
+          gtk_tree_store_set (store, &iter, 0, !visible, -1);
+          break;
+
+        case 1:
+          /* Insert */
+          if (!random_row (store, &iter, &parent_iter, &parent))
+            parent = NULL;
+          n = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), parent);
+          gtk_tree_store_insert_with_values (store, &iter, parent,
+                                             g_test_rand_int_range (0, n + 1),
+                                             0, g_test_rand_bit (), -1);
+          break;
+
+        case 2:
+          /* Remove */
+          if (random_row (store, &iter, &parent_iter, &parent))
+            gtk_tree_store_remove (store, &iter);
+          break;
+
+        case 3:
+          /* Reorder the children of a level */
+          if (!random_row (store, &iter, &parent_iter, &parent))
+            break;
+          n = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), parent);
+          new_order = g_new (gint, n);
+          for (j = 0; j < n; j++)
+            new_order[j] = j;
+          for (j = n - 1; j > 0; j--)
+            {
+              gint k = g_test_rand_int_range (0, j + 1);
+              gint tmp = new_order[j];
+
+              new_order[j] = new_order[k];
+              new_order[k] = tmp;
+            }
+          gtk_tree_store_reorder (store, parent, new_order);
+          g_free (new_order);
+          break;
+        }
+
+      if (i % 10 == 0)
+        gtk_tree_view_expand_all (GTK_TREE_VIEW (tree_view));
+
+      check_visible_index (filter, GTK_TREE_MODEL (store), NULL, NULL);
+    }
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (filter);
+  g_object_unref (store);
+}
+
 /* main */
 
 int
@@ -2996,5 +3174,8 @@ main (int    argc,
   g_test_add_func ("/FilterModel/specific/bug-549287",
                    specific_bug_549287);
 
+  g_test_add_func ("/FilterModel/visible-index/random-operations",
+                   visible_index_random_operations);
+
   return g_test_run ();
 }
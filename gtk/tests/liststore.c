@@ -916,6 +916,161 @@ list_store_test_iter_parent_invalid (ListStore     *fixture,
 }
 
 
+/* bulk appending */
+
+static void
+count_signal (gint *count)
+{
+  (*count)++;
+}
+
+static void
+append_bulk_ids (GtkListStore *store,
+                 gint          first,
+                 gint          n_rows)
+{
+  GValue *ids;
+  gint column = 0;
+  int i;
+
+  ids = g_new0 (GValue, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_value_init (&ids[i], G_TYPE_INT);
+      g_value_set_int (&ids[i], first + i);
+    }
+
+  gtk_list_store_append_bulk (store, n_rows, &column, &ids, 1);
+
+  for (i = 0; i < n_rows; i++)
+    g_value_unset (&ids[i]);
+  g_free (ids);
+}
+
+static void
+list_store_test_append_bulk (ListStore     *fixture,
+                             gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+  gint inserted = 0, reloaded = 0;
+  int i, id;
+
+  g_signal_connect_swapped (fixture->store, "row-inserted",
+                            G_CALLBACK (count_signal), &inserted);
+  g_signal_connect_swapped (fixture->store, "children-reloaded",
+                            G_CALLBACK (count_signal), &reloaded);
+
+  append_bulk_ids (fixture->store, 5, 100);
+
+  g_assert_cmpint (inserted, ==, 0);
+  g_assert_cmpint (reloaded, ==, 1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), NULL), ==, 105);
+
+  /* The old rows stay where they were */
+  for (i = 0; i < 5; i++)
+    {
+      g_assert (gtk_list_store_iter_is_valid (fixture->store, &fixture->iter[i]));
+      g_assert (iter_position (fixture->store, &fixture->iter[i], i));
+    }
+
+  i = 0;
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (fixture->store), &iter);
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, 0, &id, -1);
+      g_assert_cmpint (id, ==, i);
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (fixture->store), &iter));
+  g_assert_cmpint (i, ==, 105);
+
+  /* Nothing to append, nothing to emit */
+  append_bulk_ids (fixture->store, 0, 0);
+  g_assert_cmpint (reloaded, ==, 1);
+}
+
+static void
+list_store_test_append_bulk_sorted (ListStore     *fixture,
+                                    gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+  int i, id, last;
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        0, GTK_SORT_DESCENDING);
+
+  append_bulk_ids (fixture->store, -50, 100);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), NULL), ==, 105);
+
+  i = 0;
+  last = G_MAXINT;
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (fixture->store), &iter);
+  do
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, 0, &id, -1);
+      g_assert_cmpint (id, <=, last);
+      last = id;
+      i++;
+    }
+  while (gtk_tree_model_iter_next (GTK_TREE_MODEL (fixture->store), &iter));
+  g_assert_cmpint (i, ==, 105);
+}
+
+static void
+list_store_test_append_bulk_icon_view (ListStore     *fixture,
+                                       gconstpointer  user_data)
+{
+  GtkWidget *icon_view;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+
+  icon_view = gtk_icon_view_new_with_model (GTK_TREE_MODEL (fixture->store));
+  g_object_ref_sink (icon_view);
+
+  append_bulk_ids (fixture->store, 5, 10);
+
+  /* The icon view has items for the new rows */
+  path = gtk_tree_path_new_from_indices (12, -1);
+  gtk_icon_view_select_path (GTK_ICON_VIEW (icon_view), path);
+  g_assert (gtk_icon_view_path_is_selected (GTK_ICON_VIEW (icon_view), path));
+
+  /* and can follow changes to them */
+  gtk_tree_model_get_iter (GTK_TREE_MODEL (fixture->store), &iter, path);
+  gtk_list_store_set (fixture->store, &iter, 0, -1, -1);
+  gtk_list_store_remove (fixture->store, &iter);
+  g_assert (!gtk_icon_view_path_is_selected (GTK_ICON_VIEW (icon_view), path));
+  gtk_tree_path_free (path);
+
+  gtk_widget_destroy (icon_view);
+  g_object_unref (icon_view);
+}
+
+static void
+list_store_test_append_bulk_combo_box (ListStore     *fixture,
+                                       gconstpointer  user_data)
+{
+  GtkWidget *combo_box;
+  gint changed = 0;
+
+  combo_box = gtk_combo_box_new_with_model (GTK_TREE_MODEL (fixture->store));
+  g_object_ref_sink (combo_box);
+
+  gtk_combo_box_set_active (GTK_COMBO_BOX (combo_box), 2);
+  g_signal_connect_swapped (combo_box, "changed",
+                            G_CALLBACK (count_signal), &changed);
+
+  /* Row references into the list do not survive a reload */
+  append_bulk_ids (fixture->store, 5, 10);
+  g_assert_cmpint (changed, ==, 1);
+  g_assert_cmpint (gtk_combo_box_get_active (GTK_COMBO_BOX (combo_box)), ==, -1);
+
+  gtk_combo_box_set_active (GTK_COMBO_BOX (combo_box), 12);
+  g_assert_cmpint (gtk_combo_box_get_active (GTK_COMBO_BOX (combo_box)), ==, 12);
+
+  gtk_widget_destroy (combo_box);
+  g_object_unref (combo_box);
+}
+
 /* main */
 
 int
@@ -957,6 +1112,20 @@ main (int    argc,
 	      list_store_setup, list_store_test_clear,
 	      list_store_teardown);
 
+  /* bulk appending */
+  g_test_add ("/list-store/append-bulk", ListStore, NULL,
+	      list_store_setup, list_store_test_append_bulk,
+	      list_store_teardown);
+  g_test_add ("/list-store/append-bulk-sorted", ListStore, NULL,
+	      list_store_setup, list_store_test_append_bulk_sorted,
+	      list_store_teardown);
+  g_test_add ("/list-store/append-bulk-icon-view", ListStore, NULL,
+	      list_store_setup, list_store_test_append_bulk_icon_view,
+	      list_store_teardown);
+  g_test_add ("/list-store/append-bulk-combo-box", ListStore, NULL,
+	      list_store_setup, list_store_test_append_bulk_combo_box,
+	      list_store_teardown);
+
   /* reordering */
   g_test_add ("/list-store/reorder", ListStore, NULL,
 	      list_store_setup, list_store_test_reorder,
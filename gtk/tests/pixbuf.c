@@ -0,0 +1,416 @@
+/* GdkPixbuf file loading tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gdk-pixbuf/gdk-pixdata.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <unistd.h>
+
+/* Creates a temporary file name ending in @suffix, without keeping
+ * the file open
+ */
+static gchar *
+temp_file_name (const gchar *suffix)
+{
+  gchar *template, *filename;
+  GError *error = NULL;
+  gint fd;
+
+  template = g_strconcat ("gtk-test-pixbuf-XXXXXX", suffix, NULL);
+  fd = g_file_open_tmp (template, &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+  g_free (template);
+
+  return filename;
+}
+
+static GdkPixbuf *
+create_pixbuf (gint     width,
+               gint     height,
+               gboolean has_alpha,
+               guint    seed)
+{
+  GdkPixbuf *pixbuf;
+  guchar *pixels;
+  gint rowstride, n_channels;
+  gint x, y, c;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, width, height);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      for (c = 0; c < n_channels; c++)
+        pixels[y * rowstride + x * n_channels + c] = (x * 7 + y * 13 + c * 61 + seed) & 0xff;
+
+  return pixbuf;
+}
+
+/* gdk_pixbuf_new_from_files_at_size_async() */
+
+#define N_BATCH_FILES 6
+
+typedef struct {
+  gchar      *filenames[N_BATCH_FILES + 2];
+  gint        calls[N_BATCH_FILES + 1];
+  gint        n_calls;
+  gint        n_notified;
+  GMainLoop  *loop;
+} BatchTest;
+
+static void
+batch_test_init (BatchTest *test)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gint i;
+
+  memset (test, 0, sizeof (BatchTest));
+
+  for (i = 0; i < N_BATCH_FILES; i++)
+    {
+      test->filenames[i] = temp_file_name (".png");
+      pixbuf = create_pixbuf (32 + i * 8, 24, i % 2, i * 40);
+      gdk_pixbuf_save (pixbuf, test->filenames[i], "png", &error, NULL);
+      g_assert_no_error (error);
+      g_object_unref (pixbuf);
+    }
+
+  /* A file that does not exist, next to the others */
+  test->filenames[N_BATCH_FILES] = g_strconcat (test->filenames[0], ".missing", NULL);
+
+  test->loop = g_main_loop_new (NULL, FALSE);
+}
+
+static void
+batch_test_finish (BatchTest *test)
+{
+  gint i;
+
+  for (i = 0; i < N_BATCH_FILES; i++)
+    g_unlink (test->filenames[i]);
+  for (i = 0; i <= N_BATCH_FILES; i++)
+    g_free (test->filenames[i]);
+
+  g_main_loop_unref (test->loop);
+}
+
+static void
+batch_loaded (const gchar  *filename,
+              GdkPixbuf    *pixbuf,
+              const GError *error,
+              gpointer      user_data)
+{
+  BatchTest *test = user_data;
+  gint i;
+
+  g_assert_cmpint (test->n_notified, ==, 0);
+
+  for (i = 0; i <= N_BATCH_FILES; i++)
+    if (strcmp (filename, test->filenames[i]) == 0)
+      break;
+  g_assert_cmpint (i, <=, N_BATCH_FILES);
+
+  test->calls[i]++;
+  test->n_calls++;
+
+  if (i == N_BATCH_FILES)
+    {
+      g_assert (pixbuf == NULL);
+      g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+      return;
+    }
+
+  g_assert_no_error (error);
+  g_assert (GDK_IS_PIXBUF (pixbuf));
+
+  /* Scaled down to fit 16x16, keeping the aspect ratio */
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, 16);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, (gint) (0.5 + 24.0 * 16 / (32 + i * 8)));
+  g_assert_cmpint (gdk_pixbuf_get_has_alpha (pixbuf), ==, i % 2);
+}
+
+static void
+batch_done (gpointer user_data)
+{
+  BatchTest *test = user_data;
+
+  test->n_notified++;
+  g_main_loop_quit (test->loop);
+}
+
+static void
+test_batch_load (void)
+{
+  static const gint max_threads[] = { 1, 3, 0, -1 };
+  BatchTest test;
+  guint t;
+  gint i;
+
+  batch_test_init (&test);
+
+  for (t = 0; t < G_N_ELEMENTS (max_threads); t++)
+    {
+      memset (test.calls, 0, sizeof (test.calls));
+      test.n_calls = 0;
+      test.n_notified = 0;
+
+      gdk_pixbuf_new_from_files_at_size_async ((const gchar * const *) test.filenames,
+                                               16, 16, max_threads[t], NULL,
+                                               batch_loaded, &test, batch_done);
+      g_main_loop_run (test.loop);
+
+      /* Every file, the missing one too, is reported exactly once */
+      for (i = 0; i <= N_BATCH_FILES; i++)
+        g_assert_cmpint (test.calls[i], ==, 1);
+      g_assert_cmpint (test.n_calls, ==, N_BATCH_FILES + 1);
+      g_assert_cmpint (test.n_notified, ==, 1);
+    }
+
+  batch_test_finish (&test);
+}
+
+static void
+test_batch_load_empty (void)
+{
+  const gchar *filenames[] = { NULL };
+  BatchTest test;
+
+  memset (&test, 0, sizeof (BatchTest));
+  test.loop = g_main_loop_new (NULL, FALSE);
+
+  gdk_pixbuf_new_from_files_at_size_async (filenames, 16, 16, 0, NULL,
+                                           batch_loaded, &test, batch_done);
+  g_main_loop_run (test.loop);
+
+  g_assert_cmpint (test.n_calls, ==, 0);
+  g_assert_cmpint (test.n_notified, ==, 1);
+
+  g_main_loop_unref (test.loop);
+}
+
+static void
+test_batch_load_cancelled (void)
+{
+  GCancellable *cancellable;
+  BatchTest test;
+
+  batch_test_init (&test);
+
+  cancellable = g_cancellable_new ();
+  g_cancellable_cancel (cancellable);
+
+  gdk_pixbuf_new_from_files_at_size_async ((const gchar * const *) test.filenames,
+                                           16, 16, 2, cancellable,
+                                           batch_loaded, &test, batch_done);
+  g_object_unref (cancellable);
+  g_main_loop_run (test.loop);
+
+  g_assert_cmpint (test.n_calls, ==, 0);
+  g_assert_cmpint (test.n_notified, ==, 1);
+
+  batch_test_finish (&test);
+}
+
+/* gdk_pixbuf_new_from_pixdata_file() */
+
+static void
+assert_pixbufs_equal (GdkPixbuf *pixbuf,
+                      GdkPixbuf *expected)
+{
+  gint width, height, n_channels, y;
+
+  width = gdk_pixbuf_get_width (expected);
+  height = gdk_pixbuf_get_height (expected);
+  n_channels = gdk_pixbuf_get_n_channels (expected);
+
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, height);
+  g_assert_cmpint (gdk_pixbuf_get_n_channels (pixbuf), ==, n_channels);
+  g_assert_cmpint (gdk_pixbuf_get_has_alpha (pixbuf), ==,
+                   gdk_pixbuf_get_has_alpha (expected));
+
+  for (y = 0; y < height; y++)
+    g_assert (memcmp (gdk_pixbuf_get_pixels (pixbuf) + y * gdk_pixbuf_get_rowstride (pixbuf),
+                      gdk_pixbuf_get_pixels (expected) + y * gdk_pixbuf_get_rowstride (expected),
+                      width * n_channels) == 0);
+}
+
+/* Part of the image is a single colour, so that run-length encoding
+ * has runs as well as literal stretches to write
+ */
+static GdkPixbuf *
+create_pixdata_pixbuf (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf, *area;
+
+  pixbuf = create_pixbuf (67, 45, has_alpha, 11);
+  area = gdk_pixbuf_new_subpixbuf (pixbuf, 10, 5, 40, 20);
+  gdk_pixbuf_fill (area, 0x204080c0);
+  g_object_unref (area);
+
+  return pixbuf;
+}
+
+/* Writes the first @length bytes of the serialized @pixbuf to a new
+ * file, or all of them if @length is -1
+ */
+static gchar *
+write_pixdata_file (GdkPixbuf *pixbuf,
+                    gboolean   use_rle,
+                    gssize     length)
+{
+  GdkPixdata pixdata;
+  gpointer free_me;
+  guint8 *stream;
+  guint stream_length;
+  gchar *filename;
+  GError *error = NULL;
+
+  free_me = gdk_pixdata_from_pixbuf (&pixdata, pixbuf, use_rle);
+  stream = gdk_pixdata_serialize (&pixdata, &stream_length);
+  g_free (free_me);
+
+  if (length < 0)
+    length = stream_length;
+  g_assert_cmpint (length, <=, stream_length);
+
+  filename = temp_file_name (".pixdata");
+  g_file_set_contents (filename, (gchar *) stream, length, &error);
+  g_assert_no_error (error);
+  g_free (stream);
+
+  return filename;
+}
+
+static void
+test_pixdata_file (void)
+{
+  GdkPixbuf *expected, *pixbuf;
+  GError *error = NULL;
+  gchar *filename;
+  gint has_alpha, use_rle;
+
+  for (has_alpha = 0; has_alpha <= 1; has_alpha++)
+    for (use_rle = 0; use_rle <= 1; use_rle++)
+      {
+        expected = create_pixdata_pixbuf (has_alpha);
+        filename = write_pixdata_file (expected, use_rle, -1);
+
+        pixbuf = gdk_pixbuf_new_from_pixdata_file (filename, &error);
+        g_assert_no_error (error);
+        assert_pixbufs_equal (pixbuf, expected);
+
+        /* The pixels stay usable after the file is unlinked */
+        g_unlink (filename);
+        assert_pixbufs_equal (pixbuf, expected);
+
+        g_object_unref (pixbuf);
+        g_object_unref (expected);
+        g_free (filename);
+      }
+}
+
+static void
+assert_pixdata_file_fails (const gchar *filename,
+                           gint         code)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+
+  pixbuf = gdk_pixbuf_new_from_pixdata_file (filename, &error);
+  g_assert (pixbuf == NULL);
+  g_assert_error (error, GDK_PIXBUF_ERROR, code);
+  g_error_free (error);
+}
+
+static void
+test_pixdata_file_corrupt (void)
+{
+  GdkPixbuf *expected, *pixbuf;
+  GError *error = NULL;
+  gchar *filename, *contents;
+  gsize length;
+  gint use_rle;
+
+  expected = create_pixdata_pixbuf (TRUE);
+
+  for (use_rle = 0; use_rle <= 1; use_rle++)
+    {
+      /* Cut off inside the header */
+      filename = write_pixdata_file (expected, use_rle, GDK_PIXDATA_HEADER_LENGTH - 4);
+      assert_pixdata_file_fails (filename, GDK_PIXBUF_ERROR_CORRUPT_IMAGE);
+      g_unlink (filename);
+      g_free (filename);
+
+      /* Cut off inside the pixel data */
+      filename = write_pixdata_file (expected, use_rle, -1);
+      g_file_get_contents (filename, &contents, &length, &error);
+      g_assert_no_error (error);
+      g_file_set_contents (filename, contents, length - 10, &error);
+      g_assert_no_error (error);
+      assert_pixdata_file_fails (filename, GDK_PIXBUF_ERROR_CORRUPT_IMAGE);
+
+      /* A broken magic number */
+      contents[0] ^= 0xff;
+      g_file_set_contents (filename, contents, length, &error);
+      g_assert_no_error (error);
+      assert_pixdata_file_fails (filename, GDK_PIXBUF_ERROR_CORRUPT_IMAGE);
+
+      g_unlink (filename);
+      g_free (contents);
+      g_free (filename);
+    }
+
+  g_object_unref (expected);
+
+  /* A file that does not exist */
+  filename = temp_file_name (".pixdata");
+  g_unlink (filename);
+  pixbuf = gdk_pixbuf_new_from_pixdata_file (filename, &error);
+  g_assert (pixbuf == NULL);
+  g_assert_error (error, G_FILE_ERROR, G_FILE_ERROR_NOENT);
+  g_error_free (error);
+  g_free (filename);
+}
+
+extern void pixbuf_init (void);
+
+int
+main (int    argc,
+      char **argv)
+{
+  /* The batch loader only uses threads when they are initialized */
+  g_thread_init (NULL);
+  g_type_init ();
+  g_test_init (&argc, &argv, NULL);
+  pixbuf_init ();
+
+  g_test_add_func ("/pixbuf/batch/load", test_batch_load);
+  g_test_add_func ("/pixbuf/batch/empty", test_batch_load_empty);
+  g_test_add_func ("/pixbuf/batch/cancelled", test_batch_load_cancelled);
+  g_test_add_func ("/pixbuf/pixdata/file", test_pixdata_file);
+  g_test_add_func ("/pixbuf/pixdata/corrupt", test_pixdata_file_corrupt);
+
+  return g_test_run ();
+}
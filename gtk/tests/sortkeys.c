@@ -0,0 +1,490 @@
+/* Tests for sorting on extracted keys.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+/* When a sortable model sorts with the default compare function, it
+ * extracts one key per row and sorts the keys instead, with a radix
+ * sort for long lists of integers.  These tests sort columns of every
+ * supported type, full of ties and extreme values, and check the
+ * result against a stable sort with the compare function semantics.
+ * The order has to be exactly the same, since rows that compare equal
+ * keep their current order in both directions.
+ *
+ * The same columns are also sorted with a custom compare function,
+ * which does not go through the keys, and the sorted values have to
+ * match as well.  The order of ties is not checked there, since the
+ * models do not promise a stable sort in that case.
+ */
+
+#include <gtk/gtk.h>
+
+typedef enum
+{
+  LIST_STORE,
+  TREE_STORE,
+  COLUMN_STORE,
+  MODEL_SORT
+} ModelKind;
+
+static const gchar *model_names[] = {
+  "list-store",
+  "tree-store",
+  "column-store",
+  "model-sort"
+};
+
+typedef struct
+{
+  ModelKind kind;
+  GType type;
+} SortTest;
+
+/* Below and above the radix sort threshold */
+static const gint n_rows[] = { 200, 1500 };
+
+static const gchar *strings[] = {
+  NULL, "", "a", "A", "b", "ab", "a b",
+  "e", "\xc3\xa9", "e\xcc\x81", "f",
+  "\xc3\xa4", "z", "Z", "10", "9"
+};
+
+static void
+make_value (GType   type,
+            gint    choice,
+            GValue *value)
+{
+  static const gint ints[] = { G_MININT, -65536, -256, -1, 0, 1, 256, G_MAXINT };
+  static const guint uints[] = { 0, 1, 255, 256, G_MAXINT, (guint) G_MAXINT + 1, G_MAXUINT };
+  static const glong longs[] = { G_MINLONG, -256, -1, 0, 1, 256, G_MAXLONG };
+  static const gulong ulongs[] = { 0, 1, 256, G_MAXLONG, (gulong) G_MAXLONG + 1, G_MAXULONG };
+  static const gint64 int64s[] = {
+    G_MININT64, -G_GINT64_CONSTANT (1099511627776), -1, 0, 1,
+    G_GINT64_CONSTANT (1099511627776), G_MAXINT64
+  };
+  static const guint64 uint64s[] = {
+    0, 1, 256, G_GUINT64_CONSTANT (1099511627776),
+    G_MAXINT64, (guint64) G_MAXINT64 + 1, G_MAXUINT64
+  };
+  static const gdouble doubles[] = { -G_MAXDOUBLE, -1.5, -0.0, 0.0, 1e-300, 1.5, 1e300, G_MAXDOUBLE };
+
+  g_value_init (value, type);
+
+  switch (G_TYPE_FUNDAMENTAL (type))
+    {
+    case G_TYPE_BOOLEAN:
+      g_value_set_boolean (value, choice % 2);
+      break;
+    case G_TYPE_CHAR:
+      g_value_set_char (value, (gchar) (choice * 37));
+      break;
+    case G_TYPE_UCHAR:
+      g_value_set_uchar (value, (guchar) (choice * 37));
+      break;
+    case G_TYPE_INT:
+      g_value_set_int (value, ints[choice % G_N_ELEMENTS (ints)]);
+      break;
+    case G_TYPE_UINT:
+      g_value_set_uint (value, uints[choice % G_N_ELEMENTS (uints)]);
+      break;
+    case G_TYPE_LONG:
+      g_value_set_long (value, longs[choice % G_N_ELEMENTS (longs)]);
+      break;
+    case G_TYPE_ULONG:
+      g_value_set_ulong (value, ulongs[choice % G_N_ELEMENTS (ulongs)]);
+      break;
+    case G_TYPE_INT64:
+      g_value_set_int64 (value, int64s[choice % G_N_ELEMENTS (int64s)]);
+      break;
+    case G_TYPE_UINT64:
+      g_value_set_uint64 (value, uint64s[choice % G_N_ELEMENTS (uint64s)]);
+      break;
+    case G_TYPE_ENUM:
+      g_value_set_enum (value, choice % 4);
+      break;
+    case G_TYPE_FLAGS:
+      g_value_set_flags (value, choice % 8);
+      break;
+    case G_TYPE_FLOAT:
+      g_value_set_float (value, choice % 2 ? choice * 0.25f : -choice * 0.5f);
+      break;
+    case G_TYPE_DOUBLE:
+      g_value_set_double (value, doubles[choice % G_N_ELEMENTS (doubles)]);
+      break;
+    case G_TYPE_STRING:
+      g_value_set_string (value, strings[choice % G_N_ELEMENTS (strings)]);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+#define COMPARE(a, b) ((a) < (b) ? -1 : ((a) > (b) ? 1 : 0))
+
+/* The semantics of the default compare function */
+static gint
+compare_values (const GValue *a,
+                const GValue *b)
+{
+  const gchar *stra, *strb;
+
+  switch (G_TYPE_FUNDAMENTAL (G_VALUE_TYPE (a)))
+    {
+    case G_TYPE_BOOLEAN:
+      return COMPARE (g_value_get_boolean (a), g_value_get_boolean (b));
+    case G_TYPE_CHAR:
+      return COMPARE (g_value_get_char (a), g_value_get_char (b));
+    case G_TYPE_UCHAR:
+      return COMPARE (g_value_get_uchar (a), g_value_get_uchar (b));
+    case G_TYPE_INT:
+      return COMPARE (g_value_get_int (a), g_value_get_int (b));
+    case G_TYPE_UINT:
+      return COMPARE (g_value_get_uint (a), g_value_get_uint (b));
+    case G_TYPE_LONG:
+      return COMPARE (g_value_get_long (a), g_value_get_long (b));
+    case G_TYPE_ULONG:
+      return COMPARE (g_value_get_ulong (a), g_value_get_ulong (b));
+    case G_TYPE_INT64:
+      return COMPARE (g_value_get_int64 (a), g_value_get_int64 (b));
+    case G_TYPE_UINT64:
+      return COMPARE (g_value_get_uint64 (a), g_value_get_uint64 (b));
+    case G_TYPE_ENUM:
+      return COMPARE (g_value_get_enum (a), g_value_get_enum (b));
+    case G_TYPE_FLAGS:
+      return COMPARE (g_value_get_flags (a), g_value_get_flags (b));
+    case G_TYPE_FLOAT:
+      return COMPARE (g_value_get_float (a), g_value_get_float (b));
+    case G_TYPE_DOUBLE:
+      return COMPARE (g_value_get_double (a), g_value_get_double (b));
+    case G_TYPE_STRING:
+      stra = g_value_get_string (a);
+      strb = g_value_get_string (b);
+      return g_utf8_collate (stra ? stra : "", strb ? strb : "");
+    default:
+      g_assert_not_reached ();
+      return 0;
+    }
+}
+
+#undef COMPARE
+
+typedef struct
+{
+  GValue *values;
+  GtkSortType order;
+} ReferenceData;
+
+static gint
+compare_reference (gconstpointer a,
+                   gconstpointer b,
+                   gpointer      user_data)
+{
+  ReferenceData *data = user_data;
+  gint index_a = *(const gint *) a;
+  gint index_b = *(const gint *) b;
+  gint retval;
+
+  retval = compare_values (&data->values[index_a], &data->values[index_b]);
+  if (data->order == GTK_SORT_DESCENDING)
+    retval = -retval;
+
+  /* stable */
+  if (retval == 0)
+    retval = index_a < index_b ? -1 : (index_a > index_b);
+
+  return retval;
+}
+
+static gint
+compare_func (GtkTreeModel *model,
+              GtkTreeIter  *a,
+              GtkTreeIter  *b,
+              gpointer      user_data)
+{
+  GValue value_a = { 0, };
+  GValue value_b = { 0, };
+  gint retval;
+
+  gtk_tree_model_get_value (model, a, 0, &value_a);
+  gtk_tree_model_get_value (model, b, 0, &value_b);
+
+  retval = compare_values (&value_a, &value_b);
+
+  g_value_unset (&value_a);
+  g_value_unset (&value_b);
+
+  return retval;
+}
+
+/* Creates a model with the values in column 0, and the index of each
+ * row in column 1.
+ */
+static GtkTreeModel *
+create_model (ModelKind  kind,
+              GType      type,
+              GValue    *values,
+              gint       n)
+{
+  GtkTreeModel *model, *child;
+  gint columns[2] = { 0, 1 };
+  GValue row[2] = { { 0, }, { 0, } };
+  gint i;
+
+  switch (kind)
+    {
+    case LIST_STORE:
+    case MODEL_SORT:
+      model = GTK_TREE_MODEL (gtk_list_store_new (2, type, G_TYPE_INT));
+      break;
+    case TREE_STORE:
+      model = GTK_TREE_MODEL (gtk_tree_store_new (2, type, G_TYPE_INT));
+      break;
+    case COLUMN_STORE:
+      model = GTK_TREE_MODEL (gtk_column_store_new (2, type, G_TYPE_INT));
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  g_value_init (&row[1], G_TYPE_INT);
+
+  for (i = 0; i < n; i++)
+    {
+      g_value_init (&row[0], type);
+      g_value_copy (&values[i], &row[0]);
+      g_value_set_int (&row[1], i);
+
+      switch (kind)
+        {
+        case LIST_STORE:
+        case MODEL_SORT:
+          gtk_list_store_insert_with_valuesv (GTK_LIST_STORE (model), NULL, i,
+                                              columns, row, 2);
+          break;
+        case TREE_STORE:
+          gtk_tree_store_insert_with_valuesv (GTK_TREE_STORE (model), NULL, NULL, i,
+                                              columns, row, 2);
+          break;
+        case COLUMN_STORE:
+          gtk_column_store_insert_with_valuesv (GTK_COLUMN_STORE (model), NULL, i,
+                                                columns, row, 2);
+          break;
+        }
+
+      g_value_unset (&row[0]);
+    }
+
+  if (kind == MODEL_SORT)
+    {
+      child = model;
+      model = gtk_tree_model_sort_new_with_model (child);
+      g_object_unref (child);
+    }
+
+  return model;
+}
+
+/* Returns the index column of the rows, in the order of the model */
+static gint *
+get_order (GtkTreeModel *model,
+           gint          n)
+{
+  GtkTreeIter iter;
+  gint *order;
+  gint i;
+
+  order = g_new (gint, n);
+
+  g_assert (gtk_tree_model_get_iter_first (model, &iter));
+  for (i = 0; i < n; i++)
+    {
+      gtk_tree_model_get (model, &iter, 1, &order[i], -1);
+      g_assert (gtk_tree_model_iter_next (model, &iter) == (i + 1 < n));
+    }
+
+  return order;
+}
+
+static void
+check_sort (ModelKind    kind,
+            GType        type,
+            gint         n,
+            GtkSortType  order)
+{
+  ReferenceData data;
+  GtkTreeModel *model;
+  gint *expected, *result;
+  gint i;
+
+  data.values = g_new0 (GValue, n);
+  data.order = order;
+  for (i = 0; i < n; i++)
+    make_value (type, g_test_rand_int_range (0, 64), &data.values[i]);
+
+  expected = g_new (gint, n);
+  for (i = 0; i < n; i++)
+    expected[i] = i;
+  g_qsort_with_data (expected, n, sizeof (gint), compare_reference, &data);
+
+  /* The default compare function, sorting on keys */
+  model = create_model (kind, type, data.values, n);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model), 0, order);
+  result = get_order (model, n);
+  g_object_unref (model);
+
+  for (i = 0; i < n; i++)
+    {
+      if (result[i] != expected[i])
+        g_error ("%s %s %s, %d rows: row %d has index %d instead of %d",
+                 model_names[kind], g_type_name (type),
+                 order == GTK_SORT_ASCENDING ? "ascending" : "descending",
+                 n, i, result[i], expected[i]);
+    }
+  g_free (result);
+
+  /* A compare function of our own, which does not use keys */
+  model = create_model (kind, type, data.values, n);
+  gtk_tree_sortable_set_sort_func (GTK_TREE_SORTABLE (model), 0,
+                                   compare_func, NULL, NULL);
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model), 0, order);
+  result = get_order (model, n);
+  g_object_unref (model);
+
+  for (i = 0; i < n; i++)
+    g_assert_cmpint (compare_values (&data.values[result[i]],
+                                     &data.values[expected[i]]), ==, 0);
+  g_free (result);
+
+  for (i = 0; i < n; i++)
+    g_value_unset (&data.values[i]);
+  g_free (data.values);
+  g_free (expected);
+}
+
+static void
+test_sort_keys (gconstpointer user_data)
+{
+  const SortTest *test = user_data;
+  gint i;
+
+  for (i = 0; i < G_N_ELEMENTS (n_rows); i++)
+    {
+      check_sort (test->kind, test->type, n_rows[i], GTK_SORT_ASCENDING);
+      check_sort (test->kind, test->type, n_rows[i], GTK_SORT_DESCENDING);
+    }
+}
+
+/* Collation ties: strings that differ but collate the same, like NULL
+ * and "", or a precomposed and a decomposed character, keep their
+ * order in both directions.
+ */
+static void
+test_collation_ties (void)
+{
+  const gchar *tied[] = { "\xc3\xa9", NULL, "e\xcc\x81", "", "\xc3\xa9", "e\xcc\x81", NULL, "" };
+  GtkListStore *store;
+  GtkTreeModel *model;
+  gint *order;
+  gint i;
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_INT);
+  for (i = 0; i < G_N_ELEMENTS (tied); i++)
+    gtk_list_store_insert_with_values (store, NULL, i, 0, tied[i], 1, i, -1);
+  model = GTK_TREE_MODEL (store);
+
+  /* Only test what the collation of the current locale promises */
+  g_assert_cmpint (g_utf8_collate ("", "\xc3\xa9"), <, 0);
+  if (g_utf8_collate ("\xc3\xa9", "e\xcc\x81") != 0)
+    {
+      g_object_unref (store);
+      return;
+    }
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model), 0,
+                                        GTK_SORT_ASCENDING);
+  order = get_order (model, G_N_ELEMENTS (tied));
+  g_assert_cmpint (order[0], ==, 1);
+  g_assert_cmpint (order[1], ==, 3);
+  g_assert_cmpint (order[2], ==, 6);
+  g_assert_cmpint (order[3], ==, 7);
+  g_assert_cmpint (order[4], ==, 0);
+  g_assert_cmpint (order[5], ==, 2);
+  g_assert_cmpint (order[6], ==, 4);
+  g_assert_cmpint (order[7], ==, 5);
+  g_free (order);
+
+  /* Sorting again keeps the current order of the ties */
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model), 0,
+                                        GTK_SORT_DESCENDING);
+  order = get_order (model, G_N_ELEMENTS (tied));
+  g_assert_cmpint (order[0], ==, 0);
+  g_assert_cmpint (order[1], ==, 2);
+  g_assert_cmpint (order[2], ==, 4);
+  g_assert_cmpint (order[3], ==, 5);
+  g_assert_cmpint (order[4], ==, 1);
+  g_assert_cmpint (order[5], ==, 3);
+  g_assert_cmpint (order[6], ==, 6);
+  g_assert_cmpint (order[7], ==, 7);
+  g_free (order);
+
+  g_object_unref (store);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  GType types[15];
+  gint i, kind;
+
+  gtk_test_init (&argc, &argv, NULL);
+
+  types[0] = G_TYPE_BOOLEAN;
+  types[1] = G_TYPE_CHAR;
+  types[2] = G_TYPE_UCHAR;
+  types[3] = G_TYPE_INT;
+  types[4] = G_TYPE_UINT;
+  types[5] = G_TYPE_LONG;
+  types[6] = G_TYPE_ULONG;
+  types[7] = G_TYPE_INT64;
+  types[8] = G_TYPE_UINT64;
+  types[9] = GTK_TYPE_JUSTIFICATION;
+  types[10] = GTK_TYPE_ATTACH_OPTIONS;
+  types[11] = G_TYPE_FLOAT;
+  types[12] = G_TYPE_DOUBLE;
+  types[13] = G_TYPE_STRING;
+  types[14] = G_TYPE_INVALID;
+
+  for (kind = LIST_STORE; kind <= MODEL_SORT; kind++)
+    for (i = 0; types[i] != G_TYPE_INVALID; i++)
+      {
+        SortTest *test;
+        gchar *path;
+
+        test = g_new (SortTest, 1);
+        test->kind = kind;
+        test->type = types[i];
+
+        path = g_strdup_printf ("/sort-keys/%s/%s",
+                                model_names[kind], g_type_name (types[i]));
+        g_test_add_data_func (path, test, test_sort_keys);
+        g_free (path);
+      }
+
+  g_test_add_func ("/sort-keys/collation-ties", test_collation_ties);
+
+  return g_test_run ();
+}
@@ -1320,8 +1320,664 @@ test_tag (void)
   g_object_unref (buffer);
 }
 
+/* Searching, checked against a search in the slices of the buffer */
+
+/* Matches are compared as lines and byte indexes, which are cheap to
+ * get even on very long lines
+ */
+typedef struct
+{
+  gint line;
+  gint index;
+} SearchPos;
+
+typedef struct
+{
+  GString *text;
+  GArray *starts;       /* where the character of each byte of text */
+  GArray *ends;         /* begins and ends in the buffer */
+} SearchReference;
+
+static void
+search_pos_init (SearchPos         *pos,
+                 const GtkTextIter *iter)
+{
+  pos->line = gtk_text_iter_get_line (iter);
+  pos->index = gtk_text_iter_get_line_index (iter);
+}
+
+static gchar *
+fold_search_text (const gchar *str)
+{
+  GString *folded;
+  const gchar *p;
+
+  folded = g_string_new (NULL);
+  for (p = str; *p; p = g_utf8_next_char (p))
+    g_string_append_unichar (folded, g_unichar_tolower (g_utf8_get_char (p)));
+
+  return g_string_free (folded, FALSE);
+}
+
+/* The searched text between @start and @limit, one character at a time */
+static void
+search_reference_init (SearchReference    *ref,
+                       const GtkTextIter  *start,
+                       const GtkTextIter  *limit,
+                       GtkTextSearchFlags  flags)
+{
+  GtkTextIter iter, next;
+
+  ref->text = g_string_new (NULL);
+  ref->starts = g_array_new (FALSE, FALSE, sizeof (SearchPos));
+  ref->ends = g_array_new (FALSE, FALSE, sizeof (SearchPos));
+
+  for (iter = *start; gtk_text_iter_compare (&iter, limit) < 0; iter = next)
+    {
+      SearchPos char_start, char_end;
+      gchar *slice;
+      gsize i;
+
+      next = iter;
+      gtk_text_iter_forward_char (&next);
+
+      if ((flags & GTK_TEXT_SEARCH_TEXT_ONLY) &&
+          (gtk_text_iter_get_pixbuf (&iter) ||
+           gtk_text_iter_get_child_anchor (&iter)))
+        continue;
+
+      if (flags & GTK_TEXT_SEARCH_VISIBLE_ONLY)
+        slice = gtk_text_iter_get_visible_slice (&iter, &next);
+      else
+        slice = gtk_text_iter_get_slice (&iter, &next);
+
+      i = ref->text->len;
+      if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+        {
+          gchar *folded = fold_search_text (slice);
+
+          g_string_append (ref->text, folded);
+          g_free (folded);
+        }
+      else
+        g_string_append (ref->text, slice);
+
+      search_pos_init (&char_start, &iter);
+      search_pos_init (&char_end, &next);
+      for (; i < ref->text->len; i++)
+        {
+          g_array_append_val (ref->starts, char_start);
+          g_array_append_val (ref->ends, char_end);
+        }
+
+      g_free (slice);
+    }
+}
+
+static void
+search_reference_free (SearchReference *ref)
+{
+  g_string_free (ref->text, TRUE);
+  g_array_free (ref->starts, TRUE);
+  g_array_free (ref->ends, TRUE);
+}
+
+/* Starts and ends of the non-overlapping matches of @str */
+static GArray *
+search_reference_find (SearchReference    *ref,
+                       const gchar        *str,
+                       GtkTextSearchFlags  flags)
+{
+  GArray *matches;
+  gchar *needle;
+  const gchar *p, *found;
+  gsize n;
+
+  if (flags & GTK_TEXT_SEARCH_CASE_INSENSITIVE)
+    needle = fold_search_text (str);
+  else
+    needle = g_strdup (str);
+  n = strlen (needle);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (SearchPos));
+
+  for (p = ref->text->str; (found = strstr (p, needle)) != NULL; p = found + n)
+    {
+      gsize byte = found - ref->text->str;
+
+      g_array_append_val (matches, g_array_index (ref->starts, SearchPos, byte));
+      g_array_append_val (matches, g_array_index (ref->ends, SearchPos, byte + n - 1));
+    }
+
+  g_free (needle);
+
+  return matches;
+}
+
+static gboolean
+collect_match (const GtkTextIter *match_start,
+               const GtkTextIter *match_end,
+               gpointer           user_data)
+{
+  GArray *matches = user_data;
+  SearchPos pos[2];
+
+  search_pos_init (&pos[0], match_start);
+  search_pos_init (&pos[1], match_end);
+  g_array_append_vals (matches, pos, 2);
+
+  return FALSE;
+}
+
+static void
+assert_search_pos (const GtkTextIter *iter,
+                   const SearchPos   *expected)
+{
+  g_assert_cmpint (gtk_text_iter_get_line (iter), ==, expected->line);
+  g_assert_cmpint (gtk_text_iter_get_line_index (iter), ==, expected->index);
+}
+
+static void
+check_search (SearchReference    *ref,
+              const GtkTextIter  *start,
+              const GtkTextIter  *limit,
+              const gchar        *str,
+              GtkTextSearchFlags  flags)
+{
+  GArray *expected, *matches;
+  GtkTextIter match_start, match_end;
+  gint n_matches;
+  guint i;
+
+  expected = search_reference_find (ref, str, flags);
+
+  matches = g_array_new (FALSE, FALSE, sizeof (SearchPos));
+  n_matches = gtk_text_iter_forward_search_all (start, str, flags,
+                                                gtk_text_iter_is_end (limit) ? NULL : limit,
+                                                collect_match, matches);
+
+  g_assert_cmpint (n_matches * 2, ==, matches->len);
+  g_assert_cmpint (matches->len, ==, expected->len);
+  for (i = 0; i < expected->len; i++)
+    {
+      SearchPos *pos = &g_array_index (matches, SearchPos, i);
+      SearchPos *expected_pos = &g_array_index (expected, SearchPos, i);
+
+      g_assert_cmpint (pos->line, ==, expected_pos->line);
+      g_assert_cmpint (pos->index, ==, expected_pos->index);
+    }
+
+  if (gtk_text_iter_forward_search (start, str, flags,
+                                    &match_start, &match_end, limit))
+    {
+      g_assert_cmpint (expected->len, >, 0);
+      assert_search_pos (&match_start, &g_array_index (expected, SearchPos, 0));
+      assert_search_pos (&match_end, &g_array_index (expected, SearchPos, 1));
+    }
+  else
+    g_assert_cmpint (expected->len, ==, 0);
+
+  g_array_free (expected, TRUE);
+  g_array_free (matches, TRUE);
+}
+
+static void
+check_search_all (GtkTextBuffer      *buffer,
+                  gint                start_offset,
+                  gint                limit_offset,
+                  const gchar       **needles,
+                  GtkTextSearchFlags  flags)
+{
+  SearchReference ref;
+  GtkTextIter start, limit;
+  gint i;
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, &limit, limit_offset);
+
+  search_reference_init (&ref, &start, &limit, flags);
+  for (i = 0; needles[i]; i++)
+    check_search (&ref, &start, &limit, needles[i], flags);
+  search_reference_free (&ref);
+}
+
+/* Checks @needles under every combination of @flags */
+static void
+check_search_flags (GtkTextBuffer      *buffer,
+                    const gchar       **needles,
+                    GtkTextSearchFlags  flags)
+{
+  gint n_chars = gtk_text_buffer_get_char_count (buffer);
+  GtkTextSearchFlags subset;
+
+  subset = 0;
+  do
+    {
+      check_search_all (buffer, 0, n_chars, needles, subset);
+      check_search_all (buffer, 2, n_chars - 3, needles, subset);
+
+      subset = (subset - flags) & flags;
+    }
+  while (subset != 0);
+}
+
+static void
+assert_first_match (GtkTextBuffer      *buffer,
+                    const gchar        *str,
+                    GtkTextSearchFlags  flags,
+                    gint                start_offset,
+                    gint                end_offset)
+{
+  GtkTextIter start, match_start, match_end;
+
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  g_assert (gtk_text_iter_forward_search (&start, str, flags,
+                                          &match_start, &match_end, NULL));
+  g_assert_cmpint (gtk_text_iter_get_offset (&match_start), ==, start_offset);
+  g_assert_cmpint (gtk_text_iter_get_offset (&match_end), ==, end_offset);
+}
+
+static void
+test_search_multi_line (void)
+{
+  static const gchar *needles[] = {
+    "two\nthree", "\n\n", "e\n", "one", "\nfour", "r one\ntwo three\nfour",
+    "TWO\nThree", "four", "\n", NULL
+  };
+  GtkTextBuffer *buffer;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "one two\nthree\n\nfour one\ntwo three\nfour", -1);
+
+  assert_first_match (buffer, "two\nthree", 0, 4, 13);
+  assert_first_match (buffer, "e\n\nf", 0, 12, 16);
+
+  check_search_flags (buffer, needles, GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+
+  g_object_unref (buffer);
+}
+
+static void
+apply_tag_at_offsets (GtkTextBuffer *buffer,
+                      const gchar   *name,
+                      gint           start_offset,
+                      gint           end_offset)
+{
+  GtkTextIter start, end;
+
+  gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, &end, end_offset);
+  gtk_text_buffer_apply_tag_by_name (buffer, name, &start, &end);
+}
+
+static void
+test_search_invisible (void)
+{
+  static const gchar *needles[] = {
+    "cdef", "cXYZd", "f\nghi", "ij", "i\nmno", "XYZ", "mno  pqr",
+    "CDEF", "xyz", NULL
+  };
+  GtkTextBuffer *buffer;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_create_tag (buffer, "invisible", "invisible", TRUE, NULL);
+  gtk_text_buffer_create_tag (buffer, "bold", "weight", PANGO_WEIGHT_BOLD, NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "abcXYZdef\nghiXYZjkl\nXYZ\nmno XYZ pqr", -1);
+
+  apply_tag_at_offsets (buffer, "invisible", 3, 6);
+  apply_tag_at_offsets (buffer, "invisible", 13, 16);
+  /* across lines, overlapping a tag */
+  apply_tag_at_offsets (buffer, "invisible", 16, 24);
+  apply_tag_at_offsets (buffer, "invisible", 28, 31);
+  /* a toggle of a tag that doesn't hide text */
+  apply_tag_at_offsets (buffer, "bold", 1, 8);
+
+  assert_first_match (buffer, "cdef", GTK_TEXT_SEARCH_VISIBLE_ONLY, 2, 9);
+  assert_first_match (buffer, "ghimno", GTK_TEXT_SEARCH_VISIBLE_ONLY, 10, 27);
+
+  check_search_flags (buffer, needles,
+                      GTK_TEXT_SEARCH_VISIBLE_ONLY |
+                      GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+
+  g_object_unref (buffer);
+}
+
+static void
+test_search_text_only (void)
+{
+  static const gchar *needles[] = {
+    "abcd", "b\357\277\274c", "d\nef", "fg", "\357\277\274", "h\ni",
+    "gh\n\357\277\274i", "\357\277\274\n", "BCD", NULL
+  };
+  GtkTextBuffer *buffer;
+  GtkTextIter iter;
+  GdkPixbuf *pixbuf;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_create_tag (buffer, "invisible", "invisible", TRUE, NULL);
+  gtk_text_buffer_set_text (buffer, "abcd\nefgh\nij\nk", -1);
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, 1, 1);
+
+  /* "ab<pixbuf>cd\ne<anchor>fgh\n<pixbuf>ij\n<anchor>k" */
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 2);
+  gtk_text_buffer_insert_pixbuf (buffer, &iter, pixbuf);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 7);
+  gtk_text_buffer_create_child_anchor (buffer, &iter);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 12);
+  gtk_text_buffer_insert_pixbuf (buffer, &iter, pixbuf);
+  gtk_text_buffer_get_iter_at_offset (buffer, &iter, 16);
+  gtk_text_buffer_create_child_anchor (buffer, &iter);
+
+  /* an invisible pixbuf */
+  apply_tag_at_offsets (buffer, "invisible", 12, 13);
+
+  g_object_unref (pixbuf);
+
+  assert_first_match (buffer, "abcd", GTK_TEXT_SEARCH_TEXT_ONLY, 0, 5);
+  assert_first_match (buffer, "b\357\277\274c", 0, 1, 4);
+
+  check_search_flags (buffer, needles,
+                      GTK_TEXT_SEARCH_TEXT_ONLY |
+                      GTK_TEXT_SEARCH_VISIBLE_ONLY |
+                      GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+
+  g_object_unref (buffer);
+}
+
+/* U+212A KELVIN SIGN and U+0130 LATIN CAPITAL LETTER I WITH DOT ABOVE
+ * get shorter in lowercase, U+023A LATIN CAPITAL LETTER A WITH STROKE
+ * gets longer.
+ */
+#define KELVIN "\342\204\252"
+#define I_DOT "\304\260"
+#define A_STROKE "\310\272"
+#define A_STROKE_LOWER "\342\261\245"
+
+static void
+test_search_case_folding (void)
+{
+  static const gchar *needles[] = {
+    "k", "kk", KELVIN, KELVIN " " A_STROKE, A_STROKE_LOWER, A_STROKE A_STROKE,
+    "istanbul", I_DOT "STANBUL", "n\n" KELVIN, "l " A_STROKE_LOWER "x",
+    "stra\303\237e", NULL
+  };
+  GtkTextBuffer *buffer;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "Kelvin " KELVIN " " A_STROKE "\n"
+                            I_DOT "stanbul ISTANBUL istanbul " A_STROKE "x\n"
+                            "Stra\303\237e KK" KELVIN "k\n"
+                            A_STROKE A_STROKE_LOWER A_STROKE "\n"
+                            "in\n" KELVIN, -1);
+
+  assert_first_match (buffer, "istanbul", GTK_TEXT_SEARCH_CASE_INSENSITIVE, 11, 19);
+  assert_first_match (buffer, "kk", GTK_TEXT_SEARCH_CASE_INSENSITIVE, 48, 50);
+
+  check_search_flags (buffer, needles, GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+
+  g_object_unref (buffer);
+}
+
+static gsize
+next_char_boundary (const gchar *text,
+                    gsize        byte)
+{
+  while ((text[byte] & 0xc0) == 0x80)
+    byte++;
+
+  return byte;
+}
+
+/* Matches that begin in one window of the search and end in the next,
+ * and needles longer than a window
+ */
+static void
+test_search_window_boundary (void)
+{
+  static const gchar *words[] = {
+    "lorem", "ipsum", "dolor", I_DOT, KELVIN, A_STROKE, "\n"
+  };
+  GtkTextBuffer *buffer;
+  GtkTextIter start, limit;
+  SearchReference ref[2];
+  GString *text;
+  GPtrArray *needles;
+  guint debug_flags;
+  gsize byte, len;
+  gssize pos;
+  gint i, j, n_chars;
+
+  /* The iterator checks walk whole lines, which takes too long on the
+   * long lines of this buffer
+   */
+  debug_flags = gtk_debug_flags;
+  gtk_debug_flags &= ~GTK_DEBUG_TEXT;
+
+  text = g_string_new (NULL);
+  while (text->len < 400000)
+    {
+      /* mostly short lines, some longer than a window */
+      len = g_test_rand_int_range (0, 20) == 0 ? 70000 : g_test_rand_int_range (0, 300);
+      for (byte = text->len; text->len - byte < len; )
+        {
+          g_string_append (text, words[g_test_rand_int_range (0, G_N_ELEMENTS (words) - 1)]);
+          g_string_append_c (text, ' ');
+        }
+      g_string_append_c (text, '\n');
+      if (g_test_rand_int_range (0, 4) == 0)
+        g_string_append (text, words[g_test_rand_int_range (0, G_N_ELEMENTS (words))]);
+    }
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer, text->str, text->len);
+  n_chars = gtk_text_buffer_get_char_count (buffer);
+
+  /* Pieces of the text around multiples of the window size, and a few
+   * longer than a window
+   */
+  needles = g_ptr_array_new ();
+  for (i = 0; i < 40; i++)
+    {
+      if (i < 4)
+        len = g_test_rand_int_range (65536, 140000);
+      else
+        len = g_test_rand_int_range (1, 300);
+
+      pos = g_test_rand_int_range (1, 6) * 65536 - (gssize) len / 2 +
+        g_test_rand_int_range (-100, 100);
+      byte = next_char_boundary (text->str, CLAMP (pos, 0, (gssize) (text->len - len)));
+      len = next_char_boundary (text->str, byte + len) - byte;
+
+      g_ptr_array_add (needles, g_strndup (text->str + byte, len));
+    }
+
+  gtk_text_buffer_get_bounds (buffer, &start, &limit);
+  search_reference_init (&ref[0], &start, &limit, 0);
+  search_reference_init (&ref[1], &start, &limit,
+                         GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+
+  for (i = 0; i < needles->len; i++)
+    {
+      check_search (&ref[0], &start, &limit,
+                    g_ptr_array_index (needles, i), 0);
+      check_search (&ref[1], &start, &limit,
+                    g_ptr_array_index (needles, i),
+                    GTK_TEXT_SEARCH_CASE_INSENSITIVE);
+    }
+
+  search_reference_free (&ref[0]);
+  search_reference_free (&ref[1]);
+
+  /* and within parts of the buffer */
+  for (j = 0; j < 3; j++)
+    {
+      gint start_offset = g_test_rand_int_range (0, n_chars / 2);
+      gint limit_offset = g_test_rand_int_range (start_offset + 1, n_chars);
+
+      gtk_text_buffer_get_iter_at_offset (buffer, &start, start_offset);
+      gtk_text_buffer_get_iter_at_offset (buffer, &limit, limit_offset);
+      search_reference_init (&ref[0], &start, &limit, 0);
+
+      for (i = 0; i < needles->len; i++)
+        check_search (&ref[0], &start, &limit,
+                      g_ptr_array_index (needles, i), 0);
+
+      search_reference_free (&ref[0]);
+    }
+
+  g_ptr_array_foreach (needles, (GFunc) g_free, NULL);
+  g_ptr_array_free (needles, TRUE);
+  g_string_free (text, TRUE);
+  g_object_unref (buffer);
+
+  gtk_debug_flags = debug_flags;
+}
+
 extern void pixbuf_init (void);
 
+/* Word motion, checked against log attrs computed for each line */
+
+static void
+check_word_motion (GtkTextBuffer *buffer)
+{
+  GtkTextIter iter, line_end;
+  gboolean *starts, *ends;
+  gint n_chars, offset, len, i;
+
+  n_chars = gtk_text_buffer_get_char_count (buffer);
+  starts = g_new0 (gboolean, n_chars + 1);
+  ends = g_new0 (gboolean, n_chars + 1);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  while (!gtk_text_iter_is_end (&iter))
+    {
+      PangoLogAttr *attrs;
+      gchar *text;
+
+      line_end = iter;
+      gtk_text_iter_forward_line (&line_end);
+
+      text = gtk_text_iter_get_slice (&iter, &line_end);
+      len = g_utf8_strlen (text, -1);
+      attrs = g_new (PangoLogAttr, len + 1);
+      pango_get_log_attrs (text, strlen (text), -1,
+                           gtk_text_iter_get_language (&iter),
+                           attrs, len + 1);
+
+      offset = gtk_text_iter_get_offset (&iter);
+      for (i = 0; i < len; i++)
+        {
+          starts[offset + i] = attrs[i].is_word_start;
+          ends[offset + i] = attrs[i].is_word_end;
+        }
+
+      g_free (attrs);
+      g_free (text);
+
+      iter = line_end;
+    }
+
+  for (i = 0; i < n_chars; i++)
+    {
+      gtk_text_buffer_get_iter_at_offset (buffer, &iter, i);
+      g_assert_cmpint (gtk_text_iter_starts_word (&iter), ==, starts[i]);
+      g_assert_cmpint (gtk_text_iter_ends_word (&iter), ==, ends[i]);
+    }
+
+  /* Every stop is a boundary, and no boundary is skipped */
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  offset = 0;
+  while (gtk_text_iter_forward_word_end (&iter))
+    {
+      for (i = offset + 1; i < gtk_text_iter_get_offset (&iter); i++)
+        g_assert (!ends[i]);
+      offset = gtk_text_iter_get_offset (&iter);
+      g_assert (offset == n_chars || ends[offset]);
+    }
+
+  gtk_text_buffer_get_end_iter (buffer, &iter);
+  offset = n_chars;
+  while (gtk_text_iter_backward_word_start (&iter))
+    {
+      for (i = gtk_text_iter_get_offset (&iter) + 1; i < offset; i++)
+        g_assert (!starts[i]);
+      offset = gtk_text_iter_get_offset (&iter);
+      g_assert (starts[offset]);
+    }
+
+  g_free (starts);
+  g_free (ends);
+}
+
+static void
+test_word_motion (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  GtkTextTag *tag;
+
+  buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (buffer,
+                            "alpha beta gamma\n"
+                            "delta, epsilon zeta\n"
+                            "eta theta-iota kappa\n"
+                            "lambda mu",
+                            -1);
+
+  /* The first pass fills the log attr cache, the second one uses it */
+  check_word_motion (buffer);
+  check_word_motion (buffer);
+
+  /* Split a word in the first line; the others stay cached */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 0, 8);
+  gtk_text_buffer_insert (buffer, &start, " ", -1);
+  check_word_motion (buffer);
+
+  /* Join two words in the third line */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 2, 3);
+  end = start;
+  gtk_text_iter_forward_char (&end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  check_word_motion (buffer);
+
+  /* Split a line, then join two */
+  gtk_text_buffer_get_iter_at_line_offset (buffer, &start, 1, 7);
+  gtk_text_buffer_insert (buffer, &start, "nu\nxi ", -1);
+  check_word_motion (buffer);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 2);
+  gtk_text_iter_forward_to_line_end (&start);
+  end = start;
+  gtk_text_iter_forward_line (&end);
+  gtk_text_buffer_delete (buffer, &start, &end);
+  check_word_motion (buffer);
+
+  /* The language comes from tags, which leave the text alone */
+  tag = gtk_text_buffer_create_tag (buffer, NULL,
+                                    "language", "th",
+                                    NULL);
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 1);
+  end = start;
+  gtk_text_iter_forward_line (&end);
+  gtk_text_buffer_apply_tag (buffer, tag, &start, &end);
+  check_word_motion (buffer);
+
+  g_object_set (tag, "language", "ja", NULL);
+  check_word_motion (buffer);
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, 1);
+  end = start;
+  gtk_text_iter_forward_line (&end);
+  gtk_text_buffer_remove_tag (buffer, tag, &start, &end);
+  check_word_motion (buffer);
+
+  g_object_unref (buffer);
+}
+
 int
 main (int argc, char** argv)
 {
@@ -1335,11 +1991,18 @@ main (int argc, char** argv)
   g_test_add_func ("/TextBuffer/Line separator", test_line_separator);
   g_test_add_func ("/TextBuffer/Backspace", test_backspace);
   g_test_add_func ("/TextBuffer/Logical motion", test_logical_motion);
+  g_test_add_func ("/TextBuffer/Word motion", test_word_motion);
   g_test_add_func ("/TextBuffer/Marks", test_marks);
   g_test_add_func ("/TextBuffer/Empty buffer", test_empty_buffer);
   g_test_add_func ("/TextBuffer/Get and Set", test_get_set);
   g_test_add_func ("/TextBuffer/Fill and Empty", test_fill_empty);
   g_test_add_func ("/TextBuffer/Tag", test_tag);
+  g_test_add_func ("/TextBuffer/Search multi-line", test_search_multi_line);
+  g_test_add_func ("/TextBuffer/Search invisible", test_search_invisible);
+  g_test_add_func ("/TextBuffer/Search text only", test_search_text_only);
+  g_test_add_func ("/TextBuffer/Search case folding", test_search_case_folding);
+  g_test_add_func ("/TextBuffer/Search window boundary",
+                   test_search_window_boundary);
   
   return g_test_run();
 }
@@ -0,0 +1,169 @@
+/* Basic GtkTextView unit tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+
+/* Paragraphs of different lengths, so that they wrap to a different
+ * number of lines, with some right-to-left and empty ones
+ */
+static GtkTextBuffer *
+create_wrap_buffer (void)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter end;
+  GString *text;
+  gint i, j;
+
+  buffer = gtk_text_buffer_new (NULL);
+  text = g_string_new (NULL);
+
+  for (i = 0; i < 3000; i++)
+    {
+      if (i % 13 == 0)
+        g_string_assign (text, "");
+      else if (i % 5 == 0)
+        g_string_printf (text, "\327\251\327\234\327\225\327\235 %d", i);
+      else
+        g_string_printf (text, "Paragraph %d", i);
+
+      for (j = 0; j < i % 9; j++)
+        g_string_append (text, " lorem ipsum dolor sit amet");
+      g_string_append_c (text, '\n');
+
+      gtk_text_buffer_get_end_iter (buffer, &end);
+      gtk_text_buffer_insert (buffer, &end, text->str, text->len);
+    }
+
+  g_string_free (text, TRUE);
+
+  /* Keep the cursor line, which is always wrapped in the main
+   * thread, out of the way
+   */
+  gtk_text_buffer_get_end_iter (buffer, &end);
+  gtk_text_buffer_place_cursor (buffer, &end);
+
+  return buffer;
+}
+
+static GtkWidget *
+create_wrap_view (GtkTextBuffer *buffer,
+                  gboolean       threaded)
+{
+  GtkWidget *view, *scrolled;
+
+  view = gtk_text_view_new_with_buffer (buffer);
+  gtk_text_view_set_threaded_validation (GTK_TEXT_VIEW (view), threaded);
+  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), GTK_WRAP_WORD);
+  gtk_text_view_set_pixels_above_lines (GTK_TEXT_VIEW (view), 2);
+  gtk_text_view_set_pixels_below_lines (GTK_TEXT_VIEW (view), 1);
+  gtk_text_view_set_left_margin (GTK_TEXT_VIEW (view), 4);
+  gtk_text_view_set_right_margin (GTK_TEXT_VIEW (view), 6);
+
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled),
+                                  GTK_POLICY_NEVER, GTK_POLICY_ALWAYS);
+  gtk_container_add (GTK_CONTAINER (scrolled), view);
+
+  return view;
+}
+
+static gboolean
+quit_loop (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+
+  return FALSE;
+}
+
+static void
+test_threaded_validation (void)
+{
+  GtkTextBuffer *buffer;
+  GtkWidget *window, *box, *sync_view, *threaded_view;
+  GtkAdjustment *sync_adj, *threaded_adj;
+  GtkTextIter iter;
+  gint sync_y, sync_height, threaded_y, threaded_height;
+  gboolean timed_out = FALSE;
+  guint timeout;
+  gint i;
+
+  buffer = create_wrap_buffer ();
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 600, 300);
+  box = gtk_hbox_new (TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+
+  sync_view = create_wrap_view (buffer, FALSE);
+  gtk_box_pack_start (GTK_BOX (box), gtk_widget_get_parent (sync_view),
+                      TRUE, TRUE, 0);
+  threaded_view = create_wrap_view (buffer, TRUE);
+  gtk_box_pack_start (GTK_BOX (box), gtk_widget_get_parent (threaded_view),
+                      TRUE, TRUE, 0);
+
+  gtk_widget_show_all (window);
+
+  /* The synchronous view is done when no idle is left. The lines of
+   * the threaded one come back from the threads, so wait until it has
+   * the same height.
+   */
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  sync_adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (gtk_widget_get_parent (sync_view)));
+  threaded_adj = gtk_scrolled_window_get_vadjustment (GTK_SCROLLED_WINDOW (gtk_widget_get_parent (threaded_view)));
+
+  timeout = g_timeout_add (10000, quit_loop, &timed_out);
+  while (!timed_out && threaded_adj->upper != sync_adj->upper)
+    g_main_context_iteration (NULL, TRUE);
+  if (!timed_out)
+    g_source_remove (timeout);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert_cmpfloat (threaded_adj->upper, ==, sync_adj->upper);
+
+  for (i = 0; i < gtk_text_buffer_get_line_count (buffer); i++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, i);
+      gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (sync_view), &iter,
+                                     &sync_y, &sync_height);
+      gtk_text_view_get_line_yrange (GTK_TEXT_VIEW (threaded_view), &iter,
+                                     &threaded_y, &threaded_height);
+
+      g_assert_cmpint (threaded_y, ==, sync_y);
+      g_assert_cmpint (threaded_height, ==, sync_height);
+    }
+
+  gtk_widget_destroy (window);
+  g_object_unref (buffer);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_thread_init (NULL);
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/TextView/sizing/threaded-validation",
+                   test_threaded_validation);
+
+  return g_test_run ();
+}
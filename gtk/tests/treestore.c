@@ -919,6 +919,441 @@ tree_store_test_iter_parent_invalid (TreeStore     *fixture,
 }
 
 
+/* bulk setting */
+
+static void
+record_path (GtkTreeModel *model,
+             GtkTreePath  *path,
+             GtkTreeIter  *iter,
+             GString      *log)
+{
+  gchar *str = gtk_tree_path_to_string (path);
+
+  g_string_append_printf (log, "%s;", str ? str : "");
+  g_free (str);
+}
+
+static void
+record_deleted_path (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GString      *log)
+{
+  record_path (model, path, NULL, log);
+}
+
+static void
+set_children_bulk_ids (GtkTreeStore *store,
+                       GtkTreeIter  *parent,
+                       gint          first,
+                       gint          n_rows)
+{
+  GValue *ids;
+  gint column = 0;
+  int i;
+
+  ids = g_new0 (GValue, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_value_init (&ids[i], G_TYPE_INT);
+      g_value_set_int (&ids[i], first + i);
+    }
+
+  gtk_tree_store_set_children_bulk (store, parent, n_rows, &column, &ids, 1);
+
+  for (i = 0; i < n_rows; i++)
+    g_value_unset (&ids[i]);
+  g_free (ids);
+}
+
+static void
+check_children (TreeStore   *fixture,
+                GtkTreeIter *parent,
+                gint         first,
+                gint         n_rows)
+{
+  GtkTreeIter iter;
+  int i, id;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), parent), ==, n_rows);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &iter, parent, i));
+      gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, 0, &id, -1);
+      g_assert_cmpint (id, ==, first + i);
+    }
+}
+
+static void
+tree_store_test_set_children_bulk (TreeStore     *fixture,
+                                   gconstpointer  user_data)
+{
+  GtkTreeIter child, grandchild;
+  GString *reloaded, *toggled, *inserted, *deleted;
+
+  reloaded = g_string_new (NULL);
+  toggled = g_string_new (NULL);
+  inserted = g_string_new (NULL);
+  deleted = g_string_new (NULL);
+
+  g_signal_connect (fixture->store, "children-reloaded",
+                    G_CALLBACK (record_path), reloaded);
+  g_signal_connect (fixture->store, "row-has-child-toggled",
+                    G_CALLBACK (record_path), toggled);
+  g_signal_connect (fixture->store, "row-inserted",
+                    G_CALLBACK (record_path), inserted);
+  g_signal_connect (fixture->store, "row-deleted",
+                    G_CALLBACK (record_deleted_path), deleted);
+
+  /* New children */
+  set_children_bulk_ids (fixture->store, &fixture->iter[2], 10, 300);
+  check_children (fixture, &fixture->iter[2], 10, 300);
+  g_assert_cmpstr (reloaded->str, ==, "2;");
+  g_assert_cmpstr (toggled->str, ==, "2;");
+
+  /* Grandchildren are removed with the children they belong to */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &child,
+                                 &fixture->iter[2], 1);
+  gtk_tree_store_append (fixture->store, &grandchild, &child);
+  g_string_truncate (inserted, 0);
+  g_string_truncate (toggled, 0);
+
+  set_children_bulk_ids (fixture->store, &fixture->iter[2], 20, 3);
+  check_children (fixture, &fixture->iter[2], 20, 3);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &child,
+                                 &fixture->iter[2], 1);
+  g_assert (!gtk_tree_model_iter_has_child (GTK_TREE_MODEL (fixture->store), &child));
+  g_assert_cmpstr (reloaded->str, ==, "2;2;");
+  g_assert_cmpstr (toggled->str, ==, "");
+
+  /* No children anymore */
+  set_children_bulk_ids (fixture->store, &fixture->iter[2], 0, 0);
+  check_children (fixture, &fixture->iter[2], 0, 0);
+  g_assert_cmpstr (reloaded->str, ==, "2;2;2;");
+  g_assert_cmpstr (toggled->str, ==, "2;");
+
+  /* and nothing to do for a childless row */
+  set_children_bulk_ids (fixture->store, &fixture->iter[2], 0, 0);
+  g_assert_cmpstr (reloaded->str, ==, "2;2;2;");
+
+  /* The toplevel rows */
+  set_children_bulk_ids (fixture->store, NULL, 100, 7);
+  check_children (fixture, NULL, 100, 7);
+  g_assert_cmpstr (reloaded->str, ==, "2;2;2;;");
+
+  g_assert_cmpstr (inserted->str, ==, "");
+  g_assert_cmpstr (deleted->str, ==, "");
+
+  g_string_free (reloaded, TRUE);
+  g_string_free (toggled, TRUE);
+  g_string_free (inserted, TRUE);
+  g_string_free (deleted, TRUE);
+}
+
+static void
+tree_store_test_set_children_bulk_sorted (TreeStore     *fixture,
+                                          gconstpointer  user_data)
+{
+  GtkTreeIter iter;
+  int i, id, last;
+
+  gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (fixture->store),
+                                        0, GTK_SORT_DESCENDING);
+
+  set_children_bulk_ids (fixture->store, &fixture->iter[1], -50, 100);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), &fixture->iter[1]), ==, 100);
+
+  last = G_MAXINT;
+  for (i = 0; i < 100; i++)
+    {
+      gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &iter,
+                                     &fixture->iter[1], i);
+      gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, 0, &id, -1);
+      g_assert_cmpint (id, <, last);
+      last = id;
+    }
+}
+
+static void
+tree_store_test_set_children_bulk_tree_view (TreeStore     *fixture,
+                                             gconstpointer  user_data)
+{
+  GtkWidget *tree_view;
+  GtkTreeSelection *selection;
+  GtkTreePath *path;
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (fixture->store));
+  g_object_ref_sink (tree_view);
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (tree_view));
+
+  set_children_bulk_ids (fixture->store, &fixture->iter[3], 0, 50);
+
+  path = gtk_tree_path_new_from_indices (3, 49, -1);
+  g_assert (gtk_tree_view_expand_row (GTK_TREE_VIEW (tree_view), path, FALSE) == FALSE);
+  gtk_tree_path_up (path);
+  g_assert (gtk_tree_view_expand_row (GTK_TREE_VIEW (tree_view), path, FALSE));
+  gtk_tree_path_down (path);
+  gtk_tree_path_next (path);
+  gtk_tree_selection_select_path (selection, path);
+  g_assert (gtk_tree_selection_path_is_selected (selection, path));
+
+  /* The expanded level is built again, without the selection */
+  set_children_bulk_ids (fixture->store, &fixture->iter[3], 0, 60);
+  g_assert (!gtk_tree_selection_path_is_selected (selection, path));
+  g_assert_cmpint (gtk_tree_selection_count_selected_rows (selection), ==, 0);
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (3, 59, -1);
+  gtk_tree_selection_select_path (selection, path);
+  g_assert (gtk_tree_selection_path_is_selected (selection, path));
+  gtk_tree_path_free (path);
+
+  gtk_widget_destroy (tree_view);
+  g_object_unref (tree_view);
+}
+
+/* long levels, the store indexes levels from 256 children on */
+
+static void
+check_long_level (GtkTreeStore *store,
+                  GtkTreeIter  *parent,
+                  GArray       *ids)
+{
+  GtkTreeModel *model = GTK_TREE_MODEL (store);
+  GtkTreeIter iter, walk, path_iter;
+  GtkTreePath *path;
+  gint depth, i, id;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (model, parent), ==, ids->len);
+
+  depth = parent ? 2 : 1;
+  g_assert (gtk_tree_model_iter_children (model, &walk, parent) == (ids->len > 0));
+
+  for (i = 0; i < ids->len; i++)
+    {
+      g_assert (gtk_tree_model_iter_nth_child (model, &iter, parent, i));
+      g_assert (iters_equal (&iter, &walk));
+      gtk_tree_model_get (model, &iter, 0, &id, -1);
+      g_assert_cmpint (id, ==, g_array_index (ids, gint, i));
+
+      path = gtk_tree_model_get_path (model, &iter);
+      g_assert_cmpint (gtk_tree_path_get_depth (path), ==, depth);
+      g_assert_cmpint (gtk_tree_path_get_indices (path)[depth - 1], ==, i);
+      g_assert (gtk_tree_model_get_iter (model, &path_iter, path));
+      g_assert (iters_equal (&iter, &path_iter));
+      gtk_tree_path_free (path);
+
+      g_assert (gtk_tree_model_iter_next (model, &walk) == (i + 1 < ids->len));
+    }
+
+  g_assert (!gtk_tree_model_iter_nth_child (model, &iter, parent, ids->len));
+}
+
+static void
+long_level_nth (GtkTreeStore *store,
+                GtkTreeIter  *parent,
+                gint          n,
+                GtkTreeIter  *iter)
+{
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), iter, parent, n));
+}
+
+/* Inserts or removes one row, picking the function and position at
+ * random, and updates @ids to match
+ */
+static void
+long_level_resize (GtkTreeStore *store,
+                   GtkTreeIter  *parent,
+                   GArray       *ids,
+                   gboolean      grow,
+                   gint         *next_id)
+{
+  GtkTreeIter iter, sibling;
+  gint n, pos;
+
+  if (!grow)
+    {
+      n = g_test_rand_int_range (0, ids->len);
+      long_level_nth (store, parent, n, &iter);
+      gtk_tree_store_remove (store, &iter);
+      g_array_remove_index (ids, n);
+      return;
+    }
+
+  n = g_test_rand_int_range (-1, ids->len);
+  switch (g_test_rand_int_range (0, 3))
+    {
+    case 0:
+      /* before NULL appends */
+      if (n >= 0)
+        long_level_nth (store, parent, n, &sibling);
+      gtk_tree_store_insert_before (store, &iter, parent, n >= 0 ? &sibling : NULL);
+      pos = n >= 0 ? n : ids->len;
+      break;
+
+    case 1:
+      /* after NULL prepends */
+      if (n >= 0)
+        long_level_nth (store, parent, n, &sibling);
+      gtk_tree_store_insert_after (store, &iter, parent, n >= 0 ? &sibling : NULL);
+      pos = n + 1;
+      break;
+
+    default:
+      /* positions past the end append */
+      n = g_test_rand_int_range (0, ids->len + 10);
+      gtk_tree_store_insert (store, &iter, parent, n);
+      pos = MIN (n, ids->len);
+      break;
+    }
+
+  gtk_tree_store_set (store, &iter, 0, *next_id, -1);
+  g_array_insert_val (ids, pos, *next_id);
+  (*next_id)++;
+}
+
+/* Moves or swaps two rows at random and updates @ids to match */
+static void
+long_level_shuffle (GtkTreeStore *store,
+                    GtkTreeIter  *parent,
+                    GArray       *ids)
+{
+  GtkTreeIter a, b;
+  gint from, to, id;
+
+  if (ids->len < 2)
+    return;
+
+  from = g_test_rand_int_range (0, ids->len);
+  to = g_test_rand_int_range (-1, ids->len);
+  if (to == from)
+    return;
+
+  long_level_nth (store, parent, from, &a);
+  if (to >= 0)
+    long_level_nth (store, parent, to, &b);
+
+  id = g_array_index (ids, gint, from);
+
+  switch (g_test_rand_int_range (0, 3))
+    {
+    case 0:
+      /* before NULL moves to the end */
+      gtk_tree_store_move_before (store, &a, to >= 0 ? &b : NULL);
+      g_array_remove_index (ids, from);
+      if (to < 0)
+        to = ids->len;
+      else if (to > from)
+        to--;
+      g_array_insert_val (ids, to, id);
+      break;
+
+    case 1:
+      /* after NULL moves to the start */
+      gtk_tree_store_move_after (store, &a, to >= 0 ? &b : NULL);
+      g_array_remove_index (ids, from);
+      if (to < from)
+        to++;
+      g_array_insert_val (ids, to, id);
+      break;
+
+    default:
+      if (to < 0)
+        return;
+      gtk_tree_store_swap (store, &a, &b);
+      g_array_index (ids, gint, from) = g_array_index (ids, gint, to);
+      g_array_index (ids, gint, to) = id;
+      break;
+    }
+}
+
+static void
+long_level_reorder (GtkTreeStore *store,
+                    GtkTreeIter  *parent,
+                    GArray       *ids)
+{
+  GArray *old_ids;
+  gint *new_order;
+  gint i, j, tmp;
+
+  new_order = g_new (gint, ids->len);
+  for (i = 0; i < ids->len; i++)
+    new_order[i] = i;
+  for (i = ids->len - 1; i > 0; i--)
+    {
+      j = g_test_rand_int_range (0, i + 1);
+      tmp = new_order[i];
+      new_order[i] = new_order[j];
+      new_order[j] = tmp;
+    }
+
+  gtk_tree_store_reorder (store, parent, new_order);
+
+  old_ids = g_array_sized_new (FALSE, FALSE, sizeof (gint), ids->len);
+  g_array_append_vals (old_ids, ids->data, ids->len);
+  for (i = 0; i < ids->len; i++)
+    g_array_index (ids, gint, i) = g_array_index (old_ids, gint, new_order[i]);
+
+  g_array_free (old_ids, TRUE);
+  g_free (new_order);
+}
+
+static void
+tree_store_test_long_level (gconstpointer data)
+{
+  /* Sizes to grow or shrink to, crossing 256 children both ways */
+  static const gint targets[] = { 250, 300, 200, 260, 255, 257, 256 };
+  gboolean child_level = GPOINTER_TO_INT (data);
+  GtkTreeStore *store;
+  GtkTreeIter parent_iter, *parent;
+  GArray *ids;
+  gint next_id = 0;
+  gint i;
+
+  store = gtk_tree_store_new (1, G_TYPE_INT);
+  ids = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  if (child_level)
+    {
+      gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, -1, -1);
+      gtk_tree_store_insert_with_values (store, &parent_iter, NULL, -1, 0, -2, -1);
+      gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, -3, -1);
+      parent = &parent_iter;
+    }
+  else
+    parent = NULL;
+
+  for (i = 0; i < G_N_ELEMENTS (targets); i++)
+    {
+      while (ids->len != targets[i])
+        {
+          long_level_resize (store, parent, ids, ids->len < targets[i], &next_id);
+          long_level_shuffle (store, parent, ids);
+
+          /* The walked and the indexed lookups near the threshold */
+          if (ids->len >= 250 && ids->len <= 262)
+            check_long_level (store, parent, ids);
+        }
+
+      check_long_level (store, parent, ids);
+
+      long_level_reorder (store, parent, ids);
+      check_long_level (store, parent, ids);
+    }
+
+  /* A new level must not pick up the index of a freed one */
+  gtk_tree_store_clear (store);
+  g_array_set_size (ids, 0);
+  if (child_level)
+    gtk_tree_store_insert_with_values (store, &parent_iter, NULL, -1, 0, -2, -1);
+  while (ids->len < 270)
+    long_level_resize (store, parent, ids, TRUE, &next_id);
+  check_long_level (store, parent, ids);
+
+  g_array_free (ids, TRUE);
+  g_object_unref (store);
+}
+
 /* main */
 
 int
@@ -960,6 +1395,17 @@ main (int    argc,
 	      tree_store_setup, tree_store_test_clear,
 	      tree_store_teardown);
 
+  /* bulk setting */
+  g_test_add ("/tree-store/set-children-bulk", TreeStore, NULL,
+	      tree_store_setup, tree_store_test_set_children_bulk,
+	      tree_store_teardown);
+  g_test_add ("/tree-store/set-children-bulk-sorted", TreeStore, NULL,
+	      tree_store_setup, tree_store_test_set_children_bulk_sorted,
+	      tree_store_teardown);
+  g_test_add ("/tree-store/set-children-bulk-tree-view", TreeStore, NULL,
+	      tree_store_setup, tree_store_test_set_children_bulk_tree_view,
+	      tree_store_teardown);
+
   /* reordering */
   g_test_add ("/tree-store/reorder", TreeStore, NULL,
 	      tree_store_setup, tree_store_test_reorder,
@@ -1027,6 +1473,11 @@ main (int    argc,
   g_test_add_func ("/tree-store/move-before-single",
 		   tree_store_test_move_before_single);
 
+  g_test_add_data_func ("/tree-store/long-level-root", GINT_TO_POINTER (FALSE),
+                        tree_store_test_long_level);
+  g_test_add_data_func ("/tree-store/long-level-child", GINT_TO_POINTER (TRUE),
+                        tree_store_test_long_level);
+
   /* iter invalidation */
   g_test_add ("/tree-store/iter-next-invalid", TreeStore, NULL,
               tree_store_setup, tree_store_test_iter_next_invalid,
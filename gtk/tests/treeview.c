@@ -17,6 +17,7 @@
  * Boston, MA 02111-1307, USA.
  */
 
+#include <string.h>
 #include <gtk/gtk.h>
 
 static void
@@ -150,16 +151,477 @@ test_select_collapsed_row (void)
   gtk_tree_path_free (path);
 }
 
+/* Types @text into the custom search entry of @view and returns the
+ * path of the row the search selected, or %NULL
+ */
+static gchar *
+search_for (GtkTreeView *view,
+            GtkEntry    *entry,
+            const gchar *text)
+{
+  GtkTreeSelection *selection;
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+
+  /* The entry does not emit ::changed for the text it already has */
+  gtk_entry_set_text (entry, "");
+  gtk_entry_set_text (entry, text);
+
+  selection = gtk_tree_view_get_selection (view);
+  if (!gtk_tree_selection_get_selected (selection, &model, &iter))
+    return NULL;
+
+  return gtk_tree_model_get_string_from_iter (model, &iter);
+}
+
+static void
+assert_search (GtkTreeView *view,
+               GtkEntry    *entry,
+               const gchar *text,
+               const gchar *expected)
+{
+  gchar *path;
+
+  path = search_for (view, entry, text);
+  g_assert_cmpstr (path, ==, expected);
+  g_free (path);
+}
+
+static void
+test_search_index (void)
+{
+  GtkTreeStore *store;
+  GtkTreeIter iter, parent, child;
+  GtkTreePath *path;
+  GtkTreeView *view;
+  GtkEntry *entry;
+
+  store = gtk_tree_store_new (1, G_TYPE_STRING);
+  gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, "apple", -1);
+  gtk_tree_store_insert_with_values (store, &parent, NULL, -1, 0, "banana", -1);
+  gtk_tree_store_insert_with_values (store, NULL, &parent, -1,
+                                     0, "blueberry", -1);
+  gtk_tree_store_insert_with_values (store, NULL, &parent, -1,
+                                     0, "blackberry", -1);
+  gtk_tree_store_insert_with_values (store, NULL, NULL, -1, 0, "cherry", -1);
+
+  view = GTK_TREE_VIEW (gtk_tree_view_new_with_model (GTK_TREE_MODEL (store)));
+  g_object_ref_sink (view);
+  gtk_tree_view_insert_column_with_attributes (view, -1, "Fruit",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_set_search_column (view, 0);
+  entry = GTK_ENTRY (gtk_entry_new ());
+  g_object_ref_sink (entry);
+  gtk_tree_view_set_search_entry (view, entry);
+  gtk_tree_view_expand_all (view);
+
+  /* Fill the index */
+  assert_search (view, entry, "ch", "2");
+  assert_search (view, entry, "B", "1");
+  assert_search (view, entry, "bl", "1:0");
+  assert_search (view, entry, "bla", "1:1");
+  assert_search (view, entry, "x", NULL);
+
+  /* A changed row is found under its new text only */
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (store), &iter, "2");
+  gtk_tree_store_set (store, &iter, 0, "date", -1);
+  assert_search (view, entry, "ch", NULL);
+  assert_search (view, entry, "da", "2");
+
+  /* Inserted rows are found and shift the paths of the others */
+  gtk_tree_store_insert_with_values (store, NULL, NULL, 0,
+                                     0, "cantaloupe", -1);
+  assert_search (view, entry, "ca", "0");
+  assert_search (view, entry, "da", "3");
+  assert_search (view, entry, "bla", "2:1");
+
+  /* A removed row is gone, also for a row that may reuse its node */
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (store), &iter, "1");
+  gtk_tree_store_remove (store, &iter);
+  gtk_tree_store_insert_with_values (store, NULL, NULL, -1,
+                                     0, "eggplant", -1);
+  assert_search (view, entry, "ap", NULL);
+  assert_search (view, entry, "eg", "3");
+  assert_search (view, entry, "da", "2");
+
+  /* Rows of a collapsed parent are not searched. Change a child while
+   * it has no node, then check that the new nodes of the expanded row
+   * do not inherit the old text.
+   */
+  path = gtk_tree_path_new_from_indices (1, -1);
+  gtk_tree_view_collapse_row (view, path);
+  assert_search (view, entry, "bl", NULL);
+
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (store), &child, "1:0");
+  gtk_tree_store_set (store, &child, 0, "boysenberry", -1);
+  gtk_tree_view_expand_row (view, path, FALSE);
+  gtk_tree_path_free (path);
+
+  assert_search (view, entry, "bo", "1:0");
+  assert_search (view, entry, "blu", NULL);
+  assert_search (view, entry, "bla", "1:1");
+
+  /* Reordered rows are found at their new position */
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (store), &iter, "0");
+  gtk_tree_model_get_iter_from_string (GTK_TREE_MODEL (store), &parent, "2");
+  gtk_tree_store_swap (store, &iter, &parent);
+  assert_search (view, entry, "da", "0");
+  assert_search (view, entry, "ca", "2");
+  assert_search (view, entry, "bo", "1:0");
+
+  gtk_tree_view_set_search_entry (view, NULL);
+  gtk_widget_destroy (GTK_WIDGET (view));
+  g_object_unref (view);
+  gtk_widget_destroy (GTK_WIDGET (entry));
+  g_object_unref (entry);
+  g_object_unref (store);
+}
+
+/* Rows of one to four lines in different sizes, so that a row measured
+ * with the wrong font or not at all gets a different height
+ */
+static GtkTreeModel *
+create_measure_model (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  GString *text;
+  gint i, j;
+
+  store = gtk_list_store_new (2, G_TYPE_STRING, G_TYPE_DOUBLE);
+  text = g_string_new (NULL);
+
+  for (i = 0; i < 3000; i++)
+    {
+      g_string_printf (text, "Row %d", i);
+      for (j = 0; j < i % 4; j++)
+        g_string_append_printf (text, "\nline %d", j);
+
+      gtk_list_store_insert_with_values (store, &iter, -1,
+                                         0, text->str,
+                                         1, 0.8 + (i % 7) * 0.1,
+                                         -1);
+    }
+
+  g_string_free (text, TRUE);
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkWidget *
+create_measure_view (GtkTreeModel *model,
+                     gboolean      threaded)
+{
+  GtkWidget *view;
+  GtkCellRenderer *renderer;
+
+  view = gtk_tree_view_new_with_model (model);
+  gtk_tree_view_set_threaded_validation (GTK_TREE_VIEW (view), threaded);
+
+  renderer = gtk_cell_renderer_text_new ();
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Text", renderer,
+                                               "text", 0,
+                                               "scale", 1,
+                                               NULL);
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "family", "Monospace", NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Mono", renderer,
+                                               "text", 0,
+                                               NULL);
+
+  return view;
+}
+
+static gboolean
+quit_loop (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+
+  return FALSE;
+}
+
+static void
+test_threaded_validation (void)
+{
+  GtkTreeModel *model;
+  GtkWidget *window, *box, *scrolled, *sync_view, *threaded_view;
+  GtkAdjustment *sync_adj, *threaded_adj;
+  GdkRectangle sync_rect, threaded_rect;
+  GtkTreePath *path;
+  gboolean timed_out = FALSE;
+  guint timeout;
+  gint i;
+
+  model = create_measure_model ();
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 400, 300);
+  box = gtk_hbox_new (TRUE, 0);
+  gtk_container_add (GTK_CONTAINER (window), box);
+
+  sync_view = create_measure_view (model, FALSE);
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (scrolled), sync_view);
+  gtk_box_pack_start (GTK_BOX (box), scrolled, TRUE, TRUE, 0);
+
+  threaded_view = create_measure_view (model, TRUE);
+  scrolled = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (scrolled), threaded_view);
+  gtk_box_pack_start (GTK_BOX (box), scrolled, TRUE, TRUE, 0);
+
+  gtk_widget_show_all (window);
+
+  /* The synchronous view is done when no idle is left. The batches of
+   * the threaded one come back from the threads, so wait until it has
+   * the same height.
+   */
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  sync_adj = gtk_tree_view_get_vadjustment (GTK_TREE_VIEW (sync_view));
+  threaded_adj = gtk_tree_view_get_vadjustment (GTK_TREE_VIEW (threaded_view));
+
+  timeout = g_timeout_add (10000, quit_loop, &timed_out);
+  while (!timed_out && threaded_adj->upper != sync_adj->upper)
+    g_main_context_iteration (NULL, TRUE);
+  if (!timed_out)
+    g_source_remove (timeout);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert_cmpfloat (threaded_adj->upper, ==, sync_adj->upper);
+
+  for (i = 0; i < gtk_tree_model_iter_n_children (model, NULL); i++)
+    {
+      path = gtk_tree_path_new_from_indices (i, -1);
+      gtk_tree_view_get_background_area (GTK_TREE_VIEW (sync_view), path,
+                                         NULL, &sync_rect);
+      gtk_tree_view_get_background_area (GTK_TREE_VIEW (threaded_view), path,
+                                         NULL, &threaded_rect);
+      gtk_tree_path_free (path);
+
+      g_assert_cmpint (threaded_rect.y, ==, sync_rect.y);
+      g_assert_cmpint (threaded_rect.height, ==, sync_rect.height);
+    }
+
+  gtk_widget_destroy (window);
+  g_object_unref (model);
+}
+
+/* Returns what @widget looks like right now as a pixbuf */
+static GdkPixbuf *
+get_snapshot (GtkWidget *widget)
+{
+  GdkPixmap *pixmap;
+  GdkPixbuf *pixbuf;
+  gint width, height;
+
+  pixmap = gtk_widget_get_snapshot (widget, NULL);
+  g_assert (pixmap != NULL);
+
+  gdk_drawable_get_size (pixmap, &width, &height);
+  pixbuf = gdk_pixbuf_get_from_drawable (NULL, pixmap, NULL,
+                                         0, 0, 0, 0, width, height);
+  g_object_unref (pixmap);
+
+  return pixbuf;
+}
+
+static void
+assert_snapshots_equal (GdkPixbuf *cached,
+                        GdkPixbuf *direct)
+{
+  guchar *cached_pixels, *direct_pixels;
+  gint width, height, y;
+
+  width = gdk_pixbuf_get_width (cached);
+  height = gdk_pixbuf_get_height (cached);
+  g_assert_cmpint (gdk_pixbuf_get_width (direct), ==, width);
+  g_assert_cmpint (gdk_pixbuf_get_height (direct), ==, height);
+  g_assert_cmpint (gdk_pixbuf_get_n_channels (direct), ==,
+                   gdk_pixbuf_get_n_channels (cached));
+
+  cached_pixels = gdk_pixbuf_get_pixels (cached);
+  direct_pixels = gdk_pixbuf_get_pixels (direct);
+
+  for (y = 0; y < height; y++)
+    {
+      g_assert (memcmp (cached_pixels + y * gdk_pixbuf_get_rowstride (cached),
+                        direct_pixels + y * gdk_pixbuf_get_rowstride (direct),
+                        width * gdk_pixbuf_get_n_channels (cached)) == 0);
+    }
+}
+
+/* Draws @view with the rows it kept from the last draw, and again with
+ * the render cache off, and checks that both look the same. The last
+ * draw fills the cache again for the next check.
+ */
+static void
+assert_render_cache_valid (GtkWidget *view)
+{
+  GdkPixbuf *cached, *direct;
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  g_assert (gtk_tree_view_get_render_cache (GTK_TREE_VIEW (view)));
+  cached = get_snapshot (view);
+
+  gtk_tree_view_set_render_cache (GTK_TREE_VIEW (view), FALSE);
+  direct = get_snapshot (view);
+
+  assert_snapshots_equal (cached, direct);
+
+  gtk_tree_view_set_render_cache (GTK_TREE_VIEW (view), TRUE);
+  g_object_unref (cached);
+  cached = get_snapshot (view);
+
+  assert_snapshots_equal (cached, direct);
+
+  g_object_unref (cached);
+  g_object_unref (direct);
+}
+
+static void
+send_focus_change (GtkWidget *window,
+                   gboolean   in)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (GDK_FOCUS_CHANGE);
+  event->focus_change.window = g_object_ref (window->window);
+  event->focus_change.send_event = TRUE;
+  event->focus_change.in = in;
+
+  gtk_widget_event (window, event);
+
+  gdk_event_free (event);
+}
+
+static void
+test_render_cache (void)
+{
+  GtkTreeStore *store;
+  GtkTreeSelection *selection;
+  GtkTreeIter iter, parent;
+  GtkTreePath *path;
+  GtkWidget *window, *view;
+  GdkColor color;
+  gint i;
+
+  /* The expanders are drawn directly, keep them from animating
+   * between the snapshots
+   */
+  g_object_set (gtk_settings_get_default (),
+                "gtk-enable-animations", FALSE,
+                NULL);
+
+  store = gtk_tree_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 6; i++)
+    {
+      gchar *text = g_strdup_printf ("Row %d", i);
+
+      gtk_tree_store_insert_with_values (store, &parent, NULL, -1,
+                                         0, text,
+                                         -1);
+      gtk_tree_store_insert_with_values (store, &iter, &parent, -1,
+                                         0, "Child",
+                                         -1);
+      g_free (text);
+    }
+
+  view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (view), -1,
+                                               "Text",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_set_render_cache (GTK_TREE_VIEW (view), TRUE);
+
+  window = gtk_window_new (GTK_WINDOW_TOPLEVEL);
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 300);
+  gtk_container_add (GTK_CONTAINER (window), view);
+  gtk_widget_show_all (window);
+
+  /* The cursor row is never kept, so keep it away from the rows that
+   * change below
+   */
+  path = gtk_tree_path_new_from_indices (5, -1);
+  gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
+  gtk_tree_path_free (path);
+
+  assert_render_cache_valid (view);
+
+  /* row-changed */
+  gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  gtk_tree_store_set (store, &iter, 0, "Changed row", -1);
+  assert_render_cache_valid (view);
+
+  /* Expanding and collapsing moves the rows below */
+  path = gtk_tree_path_new_from_indices (1, -1);
+  gtk_tree_view_expand_row (GTK_TREE_VIEW (view), path, FALSE);
+  assert_render_cache_valid (view);
+
+  gtk_tree_view_collapse_row (GTK_TREE_VIEW (view), path);
+  assert_render_cache_valid (view);
+  gtk_tree_path_free (path);
+
+  /* Selection */
+  selection = gtk_tree_view_get_selection (GTK_TREE_VIEW (view));
+  path = gtk_tree_path_new_from_indices (2, -1);
+  gtk_tree_selection_select_path (selection, path);
+  gtk_tree_path_free (path);
+  assert_render_cache_valid (view);
+
+  path = gtk_tree_path_new_from_indices (3, -1);
+  gtk_tree_selection_select_path (selection, path);
+  gtk_tree_path_free (path);
+  assert_render_cache_valid (view);
+
+  /* Selected rows look different with the focus in the view */
+  send_focus_change (window, TRUE);
+  gtk_widget_grab_focus (view);
+  g_assert (GTK_WIDGET_HAS_FOCUS (view));
+  assert_render_cache_valid (view);
+
+  send_focus_change (window, FALSE);
+  g_assert (!GTK_WIDGET_HAS_FOCUS (view));
+  assert_render_cache_valid (view);
+
+  /* Style */
+  gdk_color_parse ("#3060a0", &color);
+  gtk_widget_modify_base (view, GTK_STATE_NORMAL, &color);
+  assert_render_cache_valid (view);
+
+  gdk_color_parse ("#f0f0f0", &color);
+  gtk_widget_modify_text (view, GTK_STATE_NORMAL, &color);
+  assert_render_cache_valid (view);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
 int
 main (int    argc,
       char **argv)
 {
+  g_thread_init (NULL);
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/TreeView/cursor/bug-546005", test_bug_546005);
   g_test_add_func ("/TreeView/cursor/bug-539377", test_bug_539377);
   g_test_add_func ("/TreeView/cursor/select-collapsed_row",
                    test_select_collapsed_row);
+  g_test_add_func ("/TreeView/sizing/threaded-validation",
+                   test_threaded_validation);
+  g_test_add_func ("/TreeView/search/index", test_search_index);
+  g_test_add_func ("/TreeView/drawing/render-cache", test_render_cache);
 
   return g_test_run ();
 }
@@ -220,6 +220,10 @@ static void             model_rows_reordered            (GtkTreeModel
                                                          GtkTreeIter            *iter,
                                                          gint                   *new_order,
                                                          gpointer               user_data);
+static void             model_children_reloaded         (GtkTreeModel           *tree_model,
+                                                         GtkTreePath            *path,
+                                                         GtkTreeIter            *iter,
+                                                         gpointer               user_data);
 static void             adjustment_changed              (GtkAdjustment          *adjustment,
                                                          GtkTreeView            *tree_view);
 
@@ -3023,6 +3027,36 @@ model_rows_reordered (GtkTreeModel *tree_model,
   g_signal_emit_by_name (atk_obj, "row_reordered");
 }
 
+static void
+model_children_reloaded (GtkTreeModel *tree_model,
+                         GtkTreePath  *path,
+                         GtkTreeIter  *iter,
+                         gpointer     user_data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *)user_data;
+  AtkObject *atk_obj = gtk_widget_get_accessible (GTK_WIDGET (tree_view));
+  GailTreeView *gailview = GAIL_TREE_VIEW (atk_obj);
+
+  if (gailview->idle_expand_id)
+    {
+      g_source_remove (gailview->idle_expand_id);
+      gtk_tree_path_free (gailview->idle_expand_path);
+      gailview->idle_expand_id = 0;
+    }
+
+  /*
+   * A whole level has been replaced without row_inserted and row_deleted
+   * signals, so forget about the cached rows and cells as if the model
+   * had changed.
+   */
+  clear_cached_data (gailview);
+
+  g_object_freeze_notify (G_OBJECT (atk_obj));
+  g_signal_emit_by_name (atk_obj, "model_changed");
+  g_signal_emit_by_name (atk_obj, "visible_data_changed");
+  g_object_thaw_notify (G_OBJECT (atk_obj));
+}
+
 static void
 adjustment_changed (GtkAdjustment *adjustment, 
                     GtkTreeView   *tree_view)
@@ -4257,6 +4291,9 @@ connect_model_signals (GtkTreeView  *view,
   g_signal_connect_data (obj, "rows-reordered",
                          (GCallback) model_rows_reordered, view, NULL, 
                          G_CONNECT_AFTER);
+  g_signal_connect_data (obj, "children-reloaded",
+                         (GCallback) model_children_reloaded, view, NULL,
+                         G_CONNECT_AFTER);
 }
 
 static void
@@ -4271,6 +4308,7 @@ disconnect_model_signals (GailTreeView *view)
   g_signal_handlers_disconnect_by_func (obj, (gpointer) model_row_inserted, widget);
   g_signal_handlers_disconnect_by_func (obj, (gpointer) model_row_deleted, widget);
   g_signal_handlers_disconnect_by_func (obj, (gpointer) model_rows_reordered, widget);
+  g_signal_handlers_disconnect_by_func (obj, (gpointer) model_children_reloaded, widget);
 }
 
 static void
@@ -0,0 +1,123 @@
+/* childmove.c - time moving one child window among many siblings
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Creates a toplevel with N client side children laid out in a grid,
+ * like a big tool palette, and moves one of them around, processing
+ * the updates after each move. Every move makes GDK recalculate the
+ * clip regions of the siblings that the moved child overlapped before
+ * or overlaps afterwards.
+ *
+ * Usage: childmove [ITERATIONS]
+ */
+
+#include <stdlib.h>
+#include <gdk/gdk.h>
+
+#define CHILD_SIZE 16
+
+static GdkWindow *
+create_window (GdkWindow     *parent,
+               GdkWindowType  type,
+               gint           x,
+               gint           y,
+               gint           width,
+               gint           height)
+{
+  GdkWindowAttr attributes;
+
+  attributes.window_type = type;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.x = x;
+  attributes.y = y;
+  attributes.width = width;
+  attributes.height = height;
+  attributes.event_mask = GDK_EXPOSURE_MASK;
+
+  return gdk_window_new (parent, &attributes, GDK_WA_X | GDK_WA_Y);
+}
+
+static void
+bench (gint n_children,
+       gint iterations)
+{
+  GdkWindow *toplevel, *child, *moved;
+  GdkColor color = { 0, 0xffff, 0xffff, 0xffff };
+  GTimer *timer;
+  gint columns, size, i;
+  gdouble elapsed;
+
+  columns = 1;
+  while (columns * columns < n_children)
+    columns++;
+  size = columns * CHILD_SIZE;
+
+  toplevel = create_window (NULL, GDK_WINDOW_TOPLEVEL, 0, 0, size, size);
+
+  moved = NULL;
+  for (i = 0; i < n_children; i++)
+    {
+      child = create_window (toplevel, GDK_WINDOW_CHILD,
+                             (i % columns) * CHILD_SIZE,
+                             (i / columns) * CHILD_SIZE,
+                             CHILD_SIZE, CHILD_SIZE);
+      gdk_window_set_background (child, &color);
+      gdk_window_show (child);
+
+      if (i == n_children / 2)
+        moved = child;
+    }
+
+  gdk_window_show (toplevel);
+  gdk_window_process_all_updates ();
+  gdk_flush ();
+
+  timer = g_timer_new ();
+  for (i = 0; i < iterations; i++)
+    {
+      gdk_window_move (moved,
+                       g_random_int_range (0, size - CHILD_SIZE),
+                       g_random_int_range (0, size - CHILD_SIZE));
+      gdk_window_process_all_updates ();
+    }
+  gdk_flush ();
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_print ("%6d\t%10.2f\n", n_children, elapsed * 1e6 / iterations);
+
+  g_timer_destroy (timer);
+  gdk_window_destroy (toplevel);
+}
+
+int
+main (int argc, char **argv)
+{
+  gint iterations = 1000;
+  gint n_children;
+
+  gdk_init (&argc, &argv);
+
+  if (argc > 1)
+    iterations = MAX (atoi (argv[1]), 1);
+
+  g_random_set_seed (42);
+
+  g_print ("children\tusecs per move\n");
+  for (n_children = 10; n_children <= 10000; n_children *= 10)
+    bench (n_children, iterations);
+
+  return 0;
+}
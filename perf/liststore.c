@@ -0,0 +1,178 @@
+/* liststore.c - compare GtkListStore and GtkColumnStore on long lists
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Fills a list with N rows of an integer, a double and a short string,
+ * then sorts it on the integer column and on the string column through
+ * GtkTreeSortable, and walks all rows with gtk_tree_model_get(). Each
+ * store runs in a child process so that the peak resident set size of
+ * each one can be reported separately.
+ *
+ * Usage: liststore [ROWS]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <gtk/gtk.h>
+
+enum {
+  COLUMN_INT,
+  COLUMN_DOUBLE,
+  COLUMN_STRING,
+  N_COLUMNS
+};
+
+static GtkTreeModel *
+fill_list_store (gint n_rows)
+{
+  GtkListStore *store;
+  gchar buf[32];
+  gint i;
+
+  store = gtk_list_store_new (N_COLUMNS, G_TYPE_INT, G_TYPE_DOUBLE, G_TYPE_STRING);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_snprintf (buf, sizeof (buf), "row %u", g_random_int ());
+      gtk_list_store_insert_with_values (store, NULL, i,
+                                         COLUMN_INT, g_random_int (),
+                                         COLUMN_DOUBLE, g_random_double (),
+                                         COLUMN_STRING, buf,
+                                         -1);
+    }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static GtkTreeModel *
+fill_column_store (gint n_rows)
+{
+  GtkColumnStore *store;
+  gchar buf[32];
+  gint i;
+
+  store = gtk_column_store_new (N_COLUMNS, G_TYPE_INT, G_TYPE_DOUBLE, G_TYPE_STRING);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_snprintf (buf, sizeof (buf), "row %u", g_random_int ());
+      gtk_column_store_insert_with_values (store, NULL, i,
+                                           COLUMN_INT, g_random_int (),
+                                           COLUMN_DOUBLE, g_random_double (),
+                                           COLUMN_STRING, buf,
+                                           -1);
+    }
+
+  return GTK_TREE_MODEL (store);
+}
+
+static void
+walk (GtkTreeModel *model)
+{
+  GtkTreeIter iter;
+  gboolean valid;
+  gint value;
+  gdouble d;
+
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    gtk_tree_model_get (model, &iter, COLUMN_INT, &value, COLUMN_DOUBLE, &d, -1);
+}
+
+static void
+run (const gchar *name,
+     GtkTreeModel *(*fill) (gint),
+     gint n_rows)
+{
+  struct rusage usage;
+  int status;
+  pid_t pid;
+
+  fflush (stdout);
+
+  pid = fork ();
+  if (pid < 0)
+    {
+      perror ("fork");
+      exit (EXIT_FAILURE);
+    }
+
+  if (pid == 0)
+    {
+      GtkTreeModel *model;
+      GTimer *timer;
+      gdouble t_fill, t_walk, t_sort_int, t_sort_string;
+
+      g_random_set_seed (42);
+
+      timer = g_timer_new ();
+      model = fill (n_rows);
+      t_fill = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      walk (model);
+      t_walk = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+                                            COLUMN_INT, GTK_SORT_ASCENDING);
+      t_sort_int = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (model),
+                                            COLUMN_STRING, GTK_SORT_ASCENDING);
+      t_sort_string = g_timer_elapsed (timer, NULL);
+
+      g_print ("%-14s %8.2f %8.2f %8.2f %8.2f",
+               name, t_fill, t_walk, t_sort_int, t_sort_string);
+      fflush (stdout);
+      _exit (EXIT_SUCCESS);
+    }
+
+  if (wait4 (pid, &status, 0, &usage) < 0)
+    {
+      perror ("wait4");
+      exit (EXIT_FAILURE);
+    }
+
+  if (WIFEXITED (status) && WEXITSTATUS (status) == EXIT_SUCCESS)
+    g_print (" %10ld\n", usage.ru_maxrss);
+  else
+    g_print ("  failed\n");
+}
+
+int
+main (int argc, char **argv)
+{
+  gint n_rows = 1000000;
+
+  g_type_init ();
+
+  if (argc > 1)
+    n_rows = MAX (atoi (argv[1]), 1);
+
+  g_print ("%d rows, seconds and kB\n", n_rows);
+  g_print ("%-14s %8s %8s %8s %8s %10s\n",
+           "store", "fill", "walk", "sort int", "sort str", "max RSS");
+  run ("GtkListStore", fill_list_store, n_rows);
+  run ("GtkColumnStore", fill_column_store, n_rows);
+
+  return 0;
+}
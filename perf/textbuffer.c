@@ -0,0 +1,142 @@
+/* textbuffer.c - time loading large texts into a GtkTextBuffer
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Builds a text of about MEGABYTES megabytes of short lines, loads it
+ * into a buffer with gtk_text_buffer_set_text(), inserts it a second
+ * time in the middle of the buffer, and reads it back with
+ * gtk_text_buffer_get_text(). This is done once with "\n" and once with
+ * "\r\n" line ends, which go through pango_find_paragraph_boundary().
+ * Each run happens in a child process so that the peak resident set
+ * size of each one can be reported separately.
+ *
+ * Usage: textbuffer [MEGABYTES]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <gtk/gtk.h>
+
+static gchar *
+make_text (gint         megabytes,
+           const gchar *line_end,
+           gsize       *len)
+{
+  GString *text;
+  gsize size = (gsize) megabytes * 1024 * 1024;
+  gint i;
+
+  text = g_string_sized_new (size + 128);
+  for (i = 0; text->len < size; i++)
+    g_string_append_printf (text, "%8d The quick brown fox jumps over the lazy dog %u%s",
+                            i, g_random_int (), line_end);
+
+  *len = text->len;
+
+  return g_string_free (text, FALSE);
+}
+
+static void
+run (const gchar *name,
+     const gchar *line_end,
+     gint         megabytes)
+{
+  struct rusage usage;
+  int status;
+  pid_t pid;
+
+  fflush (stdout);
+
+  pid = fork ();
+  if (pid < 0)
+    {
+      perror ("fork");
+      exit (EXIT_FAILURE);
+    }
+
+  if (pid == 0)
+    {
+      GtkTextBuffer *buffer;
+      GtkTextIter start, end;
+      GTimer *timer;
+      gchar *text, *copy;
+      gsize len;
+      gdouble t_set, t_insert, t_get;
+
+      g_random_set_seed (42);
+      text = make_text (megabytes, line_end, &len);
+      buffer = gtk_text_buffer_new (NULL);
+
+      timer = g_timer_new ();
+      gtk_text_buffer_set_text (buffer, text, len);
+      t_set = g_timer_elapsed (timer, NULL);
+
+      g_timer_start (timer);
+      gtk_text_buffer_get_iter_at_line (buffer, &start,
+                                        gtk_text_buffer_get_line_count (buffer) / 2);
+      gtk_text_buffer_insert (buffer, &start, text, len);
+      t_insert = g_timer_elapsed (timer, NULL);
+
+      g_free (text);
+
+      g_timer_start (timer);
+      gtk_text_buffer_get_bounds (buffer, &start, &end);
+      copy = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+      t_get = g_timer_elapsed (timer, NULL);
+      g_free (copy);
+
+      g_print ("%-8s %8d %8.2f %8.2f %8.2f",
+               name, gtk_text_buffer_get_line_count (buffer),
+               t_set, t_insert, t_get);
+      fflush (stdout);
+      _exit (EXIT_SUCCESS);
+    }
+
+  if (wait4 (pid, &status, 0, &usage) < 0)
+    {
+      perror ("wait4");
+      exit (EXIT_FAILURE);
+    }
+
+  if (WIFEXITED (status) && WEXITSTATUS (status) == EXIT_SUCCESS)
+    g_print (" %10ld\n", usage.ru_maxrss);
+  else
+    g_print ("  failed\n");
+}
+
+int
+main (int argc, char **argv)
+{
+  gint megabytes = 100;
+
+  g_type_init ();
+
+  if (argc > 1)
+    megabytes = MAX (atoi (argv[1]), 1);
+
+  g_print ("%d MB, seconds and kB\n", megabytes);
+  g_print ("%-8s %8s %8s %8s %8s %10s\n",
+           "line end", "lines", "set", "insert", "get", "max RSS");
+  run ("LF", "\n", megabytes);
+  run ("CRLF", "\r\n", megabytes);
+
+  return 0;
+}
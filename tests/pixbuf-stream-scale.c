@@ -0,0 +1,369 @@
+/* -*- Mode: C; c-basic-offset: 2; -*- */
+/* GdkPixbuf library - compare scaling while loading with scaling after
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307, USA.
+ */
+
+/* Loads each file at a reduced size, once by loading it at full size
+ * and scaling the result with gdk_pixbuf_scale_simple(), and once with
+ * gdk_pixbuf_new_from_file_at_size(), which lets the PNG and JPEG
+ * loaders reduce the rows while decoding. Every run happens in a
+ * child process so that the peak resident set size of each method
+ * can be reported separately.
+ *
+ * Each file is also checked: the reduced image must match the output
+ * of gdk_pixbuf_scale_simple() with GDK_INTERP_TILES, which averages
+ * the same source area, within the tolerance of its filter. Without
+ * files, the check runs on generated PNG and JPEG images, and the exit
+ * status tells whether it passed.
+ */
+
+#include "config.h"
+#include "gdk-pixbuf/gdk-pixbuf.h"
+#include <glib/gstdio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+static gint size = 128;
+static gint iterations = 5;
+
+static GdkPixbuf *
+load_then_scale_with (const gchar  *filename,
+                      GdkInterpType interp_type,
+                      GError      **error)
+{
+  GdkPixbuf *pixbuf, *scaled;
+  gint width, height;
+
+  pixbuf = gdk_pixbuf_new_from_file (filename, error);
+  if (!pixbuf)
+    return NULL;
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  /* the same size gdk_pixbuf_new_from_file_at_size () picks */
+  if ((gdouble) height * size > (gdouble) width * size)
+    {
+      width = 0.5 + (gdouble) width * size / height;
+      height = size;
+    }
+  else
+    {
+      height = 0.5 + (gdouble) height * size / width;
+      width = size;
+    }
+
+  scaled = gdk_pixbuf_scale_simple (pixbuf, MAX (width, 1), MAX (height, 1),
+                                    interp_type);
+  g_object_unref (pixbuf);
+
+  return scaled;
+}
+
+static GdkPixbuf *
+load_then_scale (const gchar *filename,
+                 GError     **error)
+{
+  return load_then_scale_with (filename, GDK_INTERP_BILINEAR, error);
+}
+
+static GdkPixbuf *
+load_at_size (const gchar *filename,
+              GError     **error)
+{
+  return gdk_pixbuf_new_from_file_at_size (filename, size, size, error);
+}
+
+static void
+run (const gchar *name,
+     GdkPixbuf *(*load) (const gchar *, GError **),
+     const gchar *filename)
+{
+  struct rusage usage;
+  int status;
+  pid_t pid;
+
+  fflush (stdout);
+
+  pid = fork ();
+  if (pid < 0)
+    {
+      perror ("fork");
+      exit (EXIT_FAILURE);
+    }
+
+  if (pid == 0)
+    {
+      GTimer *timer;
+      GdkPixbuf *pixbuf;
+      GError *error = NULL;
+      gint i;
+
+      timer = g_timer_new ();
+      for (i = 0; i < iterations; i++)
+        {
+          pixbuf = load (filename, &error);
+          if (!pixbuf)
+            {
+              g_printerr ("%s: %s\n", filename, error->message);
+              _exit (EXIT_FAILURE);
+            }
+
+          if (i == 0)
+            g_print ("%-16s %4dx%-4d", name,
+                     gdk_pixbuf_get_width (pixbuf),
+                     gdk_pixbuf_get_height (pixbuf));
+
+          g_object_unref (pixbuf);
+        }
+
+      g_print ("  %8.2f ms", g_timer_elapsed (timer, NULL) * 1000 / iterations);
+      fflush (stdout);
+      _exit (EXIT_SUCCESS);
+    }
+
+  if (wait4 (pid, &status, 0, &usage) < 0)
+    {
+      perror ("wait4");
+      exit (EXIT_FAILURE);
+    }
+
+  if (WIFEXITED (status) && WEXITSTATUS (status) == EXIT_SUCCESS)
+    g_print ("  %8ld kB max RSS\n", usage.ru_maxrss);
+  else
+    g_print ("  failed\n");
+}
+
+/* GDK_INTERP_TILES samples the filter at 1/16 pixel, so single pixels
+ * at sharp edges may differ noticeably, but the image as a whole must
+ * agree. libjpeg scales in the DCT domain before the rows are reduced,
+ * which is only close to an area average.
+ */
+#define MAX_MEAN_DIFFERENCE       1.0
+#define MAX_MEAN_DIFFERENCE_JPEG  3.0
+#define MAX_DIFFERENCE            32
+
+static gboolean
+check (const gchar *filename)
+{
+  GdkPixbuf *streamed, *scaled = NULL;
+  GdkPixbufFormat *format;
+  GError *error = NULL;
+  const guchar *a, *b;
+  gint x, y, width, height, n_channels;
+  gint max_diff = 0;
+  guint64 sum = 0;
+  gdouble mean, max_mean;
+  gboolean ok;
+
+  streamed = load_at_size (filename, &error);
+  if (streamed)
+    scaled = load_then_scale_with (filename, GDK_INTERP_TILES, &error);
+  if (!streamed || !scaled)
+    {
+      g_printerr ("%s: %s\n", filename, error->message);
+      g_clear_error (&error);
+      if (streamed)
+        g_object_unref (streamed);
+      return FALSE;
+    }
+
+  width = gdk_pixbuf_get_width (streamed);
+  height = gdk_pixbuf_get_height (streamed);
+  n_channels = gdk_pixbuf_get_n_channels (streamed);
+
+  if (width != gdk_pixbuf_get_width (scaled) ||
+      height != gdk_pixbuf_get_height (scaled) ||
+      n_channels != gdk_pixbuf_get_n_channels (scaled))
+    {
+      g_print ("%-16s size or format differs\n", "check");
+      g_object_unref (streamed);
+      g_object_unref (scaled);
+      return FALSE;
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      a = gdk_pixbuf_get_pixels (streamed) + y * gdk_pixbuf_get_rowstride (streamed);
+      b = gdk_pixbuf_get_pixels (scaled) + y * gdk_pixbuf_get_rowstride (scaled);
+
+      for (x = 0; x < width * n_channels; x++)
+        {
+          gint diff = ABS (a[x] - b[x]);
+
+          sum += diff;
+          max_diff = MAX (max_diff, diff);
+        }
+    }
+
+  mean = (gdouble) sum / ((gdouble) width * height * n_channels);
+
+  format = gdk_pixbuf_get_file_info (filename, NULL, NULL);
+  if (format && strcmp (gdk_pixbuf_format_get_name (format), "jpeg") == 0)
+    {
+      max_mean = MAX_MEAN_DIFFERENCE_JPEG;
+      ok = mean <= max_mean;
+    }
+  else
+    {
+      max_mean = MAX_MEAN_DIFFERENCE;
+      ok = mean <= max_mean && max_diff <= MAX_DIFFERENCE;
+    }
+
+  g_print ("%-16s mean difference %.2f (max %.1f), largest %d  %s\n",
+           "check", mean, max_mean, max_diff, ok ? "ok" : "FAILED");
+
+  g_object_unref (streamed);
+  g_object_unref (scaled);
+
+  return ok;
+}
+
+/* Smooth gradients with some sharp edges and noise, with alpha for
+ * the PNG
+ */
+static GdkPixbuf *
+make_test_image (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf;
+  guchar *row;
+  gint x, y, n_channels;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, 1021, 677);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  for (y = 0; y < 677; y++)
+    {
+      row = gdk_pixbuf_get_pixels (pixbuf) + y * gdk_pixbuf_get_rowstride (pixbuf);
+
+      for (x = 0; x < 1021; x++)
+        {
+          guchar *p = row + x * n_channels;
+
+          p[0] = x * 255 / 1020;
+          p[1] = y * 255 / 676;
+          p[2] = ((x / 37 + y / 29) % 2) ? 230 : 20;
+          if (has_alpha)
+            p[3] = 128 + (g_random_int () % 128);
+        }
+    }
+
+  return pixbuf;
+}
+
+static gboolean
+check_generated (const gchar *type,
+                 gboolean     has_alpha)
+{
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gchar *filename;
+  gboolean ok;
+  gint fd;
+
+  fd = g_file_open_tmp ("pixbuf-stream-scale-XXXXXX", &filename, &error);
+  if (fd < 0)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return FALSE;
+    }
+  close (fd);
+
+  pixbuf = make_test_image (has_alpha);
+  if (strcmp (type, "jpeg") == 0)
+    ok = gdk_pixbuf_save (pixbuf, filename, type, &error, "quality", "95", NULL);
+  else
+    ok = gdk_pixbuf_save (pixbuf, filename, type, &error, NULL);
+  g_object_unref (pixbuf);
+
+  if (!ok)
+    {
+      g_printerr ("%s: %s\n", type, error->message);
+      g_error_free (error);
+    }
+  else
+    {
+      g_print ("generated %s, %d pixels\n", type, size);
+      ok = check (filename);
+    }
+
+  g_unlink (filename);
+  g_free (filename);
+
+  return ok;
+}
+
+static void
+usage (void)
+{
+  g_print ("usage: pixbuf-stream-scale [--size N] [--iterations N] [files]\n");
+  exit (EXIT_FAILURE);
+}
+
+int
+main (int argc, char **argv)
+{
+  gboolean ok = TRUE;
+  gint i;
+
+  g_type_init ();
+
+  for (i = 1; i < argc && argv[i][0] == '-'; i++)
+    {
+      if (strcmp (argv[i], "--size") == 0 && i + 1 < argc)
+        size = atoi (argv[++i]);
+      else if (strcmp (argv[i], "--iterations") == 0 && i + 1 < argc)
+        iterations = atoi (argv[++i]);
+      else
+        usage ();
+    }
+
+  if (size <= 0 || iterations <= 0)
+    usage ();
+
+  if (i == argc)
+    {
+      gint sizes[] = { 128, 333, 1000 };
+      gint j;
+
+      for (j = 0; j < G_N_ELEMENTS (sizes); j++)
+        {
+          size = sizes[j];
+          if (!check_generated ("png", TRUE))
+            ok = FALSE;
+          if (!check_generated ("jpeg", FALSE))
+            ok = FALSE;
+        }
+    }
+
+  for (; i < argc; i++)
+    {
+      g_print ("%s\n", argv[i]);
+      run ("load then scale", load_then_scale, argv[i]);
+      run ("load at size", load_at_size, argv[i]);
+      if (!check (argv[i]))
+        ok = FALSE;
+    }
+
+  return ok ? 0 : 1;
+}
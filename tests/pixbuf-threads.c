@@ -26,6 +26,11 @@
 
 static gboolean verbose = FALSE;
 
+/* benchmark mode */
+static GMutex *done_mutex;
+static GCond *done_cond;
+static gint n_done;
+
 static void
 load_image (gpointer  data, 
 	    gpointer user_data)
@@ -72,12 +77,82 @@ load_image (gpointer  data,
     }
 
   g_object_unref (loader);
+
+  if (done_mutex)
+    {
+      g_mutex_lock (done_mutex);
+      n_done++;
+      g_cond_signal (done_cond);
+      g_mutex_unlock (done_mutex);
+    }
+}
+
+/* Loads every file @rounds times with @n_threads threads and returns
+ * the number of images loaded per second.
+ */
+static gdouble
+measure (gchar **files,
+         gint    n_files,
+         gint    n_threads,
+         gint    rounds)
+{
+  GThreadPool *pool;
+  GTimer *timer;
+  gdouble elapsed;
+  gint i, j;
+
+  n_done = 0;
+  timer = g_timer_new ();
+  pool = g_thread_pool_new (load_image, NULL, n_threads, TRUE, NULL);
+
+  for (j = 0; j < rounds; j++)
+    for (i = 0; i < n_files; i++)
+      g_thread_pool_push (pool, files[i], NULL);
+
+  g_mutex_lock (done_mutex);
+  while (n_done < n_files * rounds)
+    g_cond_wait (done_cond, done_mutex);
+  g_mutex_unlock (done_mutex);
+
+  elapsed = g_timer_elapsed (timer, NULL);
+  g_thread_pool_free (pool, FALSE, TRUE);
+  g_timer_destroy (timer);
+
+  return n_files * rounds / elapsed;
+}
+
+/* Shows how loading scales with the number of threads */
+static void
+benchmark (gchar **files,
+           gint    n_files,
+           gint    max_threads,
+           gint    rounds)
+{
+  gdouble base = 0, rate;
+  gint n_threads;
+
+  done_mutex = g_mutex_new ();
+  done_cond = g_cond_new ();
+
+  /* warm up the module cache */
+  measure (files, n_files, 1, 1);
+
+  g_print ("threads\timages/s\tspeedup\n");
+  for (n_threads = 1; n_threads <= max_threads; n_threads *= 2)
+    {
+      rate = measure (files, n_files, n_threads, rounds);
+      if (n_threads == 1)
+        base = rate;
+
+      g_print ("%d\t%.1f\t\t%.2f\n", n_threads, rate, rate / base);
+    }
 }
 
 static void
 usage (void)
 {
-  g_print ("usage: pixbuf-threads [--verbose] <files>\n");
+  g_print ("usage: pixbuf-threads [--verbose] <files>\n"
+           "       pixbuf-threads --benchmark [--threads N] [--rounds N] <files>\n");
   exit (EXIT_FAILURE);
 }
 
@@ -86,6 +161,9 @@ main (int argc, char **argv)
 {
   int i, start;
   GThreadPool *pool;
+  gboolean run_benchmark = FALSE;
+  gint max_threads = 8;
+  gint rounds = 10;
   
   g_type_init ();
 
@@ -97,11 +175,27 @@ main (int argc, char **argv)
   if (argc == 1)
     usage();
 
-  start = 1;
-  if (strcmp (argv[1], "--verbose") == 0)
+  for (start = 1; start < argc && argv[start][0] == '-'; start++)
+    {
+      if (strcmp (argv[start], "--verbose") == 0)
+        verbose = TRUE;
+      else if (strcmp (argv[start], "--benchmark") == 0)
+        run_benchmark = TRUE;
+      else if (strcmp (argv[start], "--threads") == 0 && start + 1 < argc)
+        max_threads = atoi (argv[++start]);
+      else if (strcmp (argv[start], "--rounds") == 0 && start + 1 < argc)
+        rounds = atoi (argv[++start]);
+      else
+        usage ();
+    }
+
+  if (start == argc || max_threads < 1 || rounds < 1)
+    usage ();
+
+  if (run_benchmark)
     {
-      verbose = TRUE;
-      start = 2;
+      benchmark (argv + start, argc - start, max_threads, rounds);
+      return 0;
     }
   
   pool = g_thread_pool_new (load_image, NULL, 20, FALSE, NULL);
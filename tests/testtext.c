@@ -2272,6 +2272,19 @@ buffer_filename_set (Buffer *buffer)
     }
 }
 
+static gboolean
+mark_found_text (const GtkTextIter *match_start,
+                 const GtkTextIter *match_end,
+                 gpointer           data)
+{
+  Buffer *buffer = data;
+
+  gtk_text_buffer_apply_tag (buffer->buffer, buffer->found_text_tag,
+                             match_start, match_end);
+
+  return FALSE;
+}
+
 static void
 buffer_search (Buffer     *buffer,
                const char *str,
@@ -2299,18 +2312,10 @@ buffer_search (Buffer     *buffer,
 
       if (forward)
         {
-          while (gtk_text_iter_forward_search (&iter, str,
-                                               GTK_TEXT_SEARCH_VISIBLE_ONLY |
-                                               GTK_TEXT_SEARCH_TEXT_ONLY,
-                                               &match_start, &match_end,
-                                               NULL))
-            {
-              ++i;
-              gtk_text_buffer_apply_tag (buffer->buffer, buffer->found_text_tag,
-                                         &match_start, &match_end);
-              
-              iter = match_end;
-            }
+          i = gtk_text_iter_forward_search_all (&iter, str,
+                                                GTK_TEXT_SEARCH_VISIBLE_ONLY |
+                                                GTK_TEXT_SEARCH_TEXT_ONLY,
+                                                NULL, mark_found_text, buffer);
         }
       else
         {